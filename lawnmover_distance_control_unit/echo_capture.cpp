@@ -0,0 +1,80 @@
+#include "echo_capture.h"
+
+#include <serial_logger.h>
+
+// ISO C++ forbids in-class initialization of non-const static members
+EchoCapture::Slot EchoCapture::_slots[MAX_ECHO_CAPTURE_PINS];
+volatile uint8_t EchoCapture::_amountSlots = 0;
+volatile uint8_t *EchoCapture::_inputRegisters[3] = {nullptr, nullptr, nullptr};
+
+int EchoCapture::attach(const int pin) {
+	if (_amountSlots >= MAX_ECHO_CAPTURE_PINS) {
+		SERIAL_LOGGER_ERROR(F("Cannot capture echoes of pin %d. All %d slots are taken"), pin,
+							MAX_ECHO_CAPTURE_PINS);
+		return -1;
+	} else if (digitalPinToPCICR(pin) == nullptr) {
+		SERIAL_LOGGER_ERROR(F("Cannot capture echoes of pin %d. It has no pin change interrupt"), pin);
+		return -1;
+	}
+
+	const uint8_t slot = _amountSlots;
+	_slots[slot].port = digitalPinToPCICRbit(pin);
+	_slots[slot].mask = digitalPinToBitMask(pin);
+	_slots[slot].level = digitalRead(pin) == HIGH ? _slots[slot].mask : 0;
+	_inputRegisters[_slots[slot].port] = portInputRegister(digitalPinToPort(pin));
+	_slots[slot].state = IDLE;
+	// the interrupt routine must see the complete slot
+	_amountSlots = slot + 1;
+
+	*digitalPinToPCMSK(pin) |= bit(digitalPinToPCMSKbit(pin));
+	*digitalPinToPCICR(pin) |= bit(digitalPinToPCICRbit(pin));
+	return slot;
+}
+
+void EchoCapture::arm(const int slot) {
+	_slots[slot].state = ARMED;
+}
+
+bool EchoCapture::takePulse(const int slot, unsigned long &durationMicroseconds) {
+	Slot &s = _slots[slot];
+	if (s.state == PULSE_COMPLETE) {
+		durationMicroseconds = s.fall_micros - s.rise_micros;
+		s.state = IDLE;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+void EchoCapture::captureEdges(const uint8_t port) {
+	const unsigned long now = micros();
+	const uint8_t levels = *_inputRegisters[port];
+	for (uint8_t i = 0; i < _amountSlots; i++) {
+		Slot &s = _slots[i];
+		if (s.port == port) {
+			const uint8_t level = levels & s.mask;
+			if (level != s.level) {
+				s.level = level;
+				if (level != 0 && s.state == ARMED) {
+					s.rise_micros = now;
+					s.state = PULSE_STARTED;
+				} else if (level == 0 && s.state == PULSE_STARTED) {
+					s.fall_micros = now;
+					s.state = PULSE_COMPLETE;
+				}
+			}
+		}
+	}
+}
+
+ISR (PCINT0_vect) {
+		EchoCapture::captureEdges(PCIE0);
+}
+
+ISR (PCINT1_vect) {
+		EchoCapture::captureEdges(PCIE1);
+}
+
+ISR (PCINT2_vect) {
+		EchoCapture::captureEdges(PCIE2);
+}
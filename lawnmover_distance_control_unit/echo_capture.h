@@ -0,0 +1,83 @@
+#ifndef ECHO_CAPTURE_H
+#define ECHO_CAPTURE_H
+
+#include <Arduino.h>
+
+#define MAX_ECHO_CAPTURE_PINS 8
+
+/**
+ * Interrupt driven capture of echo pulses (e. g. of ultrasonic sensors). Each attached pin raises a pin change
+ * interrupt whose routine does nothing but timestamping the rising and the falling edge of the pulse the pin was armed
+ * for. Evaluating the pulse is up to the loop, thus, nobody busy waits for an echo (as pulseIn does) and the echoes of
+ * all attached pins are captured at the same time.
+ *
+ * The ATmega328P has one pin change interrupt routine per port, thus, this is a singleton just like SpiSlave. The
+ * routine samples the input register of its port (e. g. PIND) once, i. e. it sees the levels of all pins of the port at
+ * the very same instant and costs the same no matter how many echoes end at once.
+ * Handing a pulse from the interrupt routine to the loop is lock-free: The routine only writes the timestamps of a slot
+ * before it sets its state to PULSE_COMPLETE and the loop only reads them afterwards.
+ */
+class EchoCapture {
+public:
+	enum SlotState {
+		// not waiting for a pulse
+		IDLE,
+		// waiting for the rising edge
+		ARMED,
+		// waiting for the falling edge
+		PULSE_STARTED,
+		PULSE_COMPLETE
+	};
+
+	EchoCapture() = delete;
+
+	/**
+	 * Enable the pin change interrupt of the given pin
+	 *
+	 * @return the slot of the pin or -1 if it cannot be captured
+	 */
+	static int attach(const int pin);
+
+	/**
+	 * Drop any pulse of the slot and capture the next one
+	 */
+	static void arm(const int slot);
+
+	static SlotState getState(const int slot) {
+		return static_cast<SlotState>(_slots[slot].state);
+	};
+
+	// Note: only valid from PULSE_STARTED on
+	static unsigned long getPulseStartMicros(const int slot) {
+		return _slots[slot].rise_micros;
+	};
+
+	/**
+	 * Take the complete pulse of the slot (if any); the slot is idle afterwards
+	 *
+	 * @return whether there was a complete pulse
+	 */
+	static bool takePulse(const int slot, unsigned long &durationMicroseconds);
+
+	// called by the pin change interrupt routines
+	static void captureEdges(const uint8_t port);
+
+private:
+	struct Slot {
+		// index of the pin change interrupt (see digitalPinToPCICRbit)
+		uint8_t port;
+		// of the pin in the input register of the port
+		uint8_t mask;
+		uint8_t level;
+		volatile uint8_t state;
+		volatile unsigned long rise_micros;
+		volatile unsigned long fall_micros;
+	};
+
+	static Slot _slots[MAX_ECHO_CAPTURE_PINS];
+	static volatile uint8_t _amountSlots;
+	// by index of the pin change interrupt
+	static volatile uint8_t *_inputRegisters[3];
+};
+
+#endif // ECHO_CAPTURE_H
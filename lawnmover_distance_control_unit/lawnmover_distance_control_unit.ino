@@ -29,45 +29,43 @@ auto _timer = timer_create_default();
 UltrasonicSensors *_ultrasonicSensors;
 Led3Service *_ledService;
 
-int k_amount_data_push_commands = 0;
-bool (*_data_push_commands[])(int16_t, int16_t) = {};
-
 // TODO add GYRO commands
-int k_amount_data_request_commands = 1;
-
-bool (*_data_request_commands[])(int16_t, uint8_t *) = {
-		[](int16_t id, uint8_t *value_bytes_buffer) -> bool {
-			const float latestDistance = _ultrasonicSensors->getLatestDistanceFromSensorById(id);
-			if (latestDistance >= 0.0f) {
-				memcpy(value_bytes_buffer, &latestDistance, sizeof(latestDistance));
-				return true;
-			} else {
-				// id not known
-				return false;
-			}
-		}
-};
+bool put_distance_sample(int16_t id, uint8_t *value_bytes_buffer) {
+	float latestDistance;
+	unsigned long latestDistanceMillis;
+	if (_ultrasonicSensors->getLatestSampleFromSensorById(id, latestDistance, latestDistanceMillis)) {
+		const DistanceSample sample = DistanceSample::from(latestDistance, millis() - latestDistanceMillis);
+		memcpy(value_bytes_buffer, &sample, sizeof(sample));
+		return true;
+	} else {
+		// id not known
+		return false;
+	}
+}
 
 void setup() {
 	SerialLogger::init(9600, SerialLogger::LOG_LEVEL::INFO);
 
     _ledService = new Led3Service(LED_BUNDLE_1, LED_BUNDLE_2, LED_BUNDLE_3, _timer);
     
-	// Note: Order matters. We alternate rear and front to reduce risiking receiving the echo of a previous tx if sensoring_frequency_delay was choosen too thin.
+	// Note: Order matters for round robin only. We alternate rear and front to reduce risiking receiving the echo of a previous tx if sensoring_frequency_delay was choosen too thin.
 	const int sensorsRxPinList[] = {ULTRA_RX_FRONT_LEFT, ULTRA_RX_REAR_RIGHT, ULTRA_RX_FRONT, ULTRA_RX_REAR_LEFT,
 									ULTRA_RX_FRONT_RIGHT};
-	const int sensorsSpiIdList[] = {OBSTACLE_FRONT_LEFT_COMMAND, OBSTACLE_BACK_RIGHT_COMMAND, OBSTACLE_FRONT_COMMAND,
-									OBSTACLE_BACK_LEFT_COMMAND, OBSTACLE_FRONT_RIGHT_COMMAND};
+	const int16_t sensorsSpiIdList[] = {OBSTACLE_FRONT_LEFT_COMMAND, OBSTACLE_BACK_RIGHT_COMMAND, OBSTACLE_FRONT_COMMAND,
+										OBSTACLE_BACK_LEFT_COMMAND, OBSTACLE_FRONT_RIGHT_COMMAND};
 	_ultrasonicSensors = UltrasonicSensors::getFromScheduled(ULTRA_TX_PIN, sensorsRxPinList, sensorsSpiIdList,
 															 AMOUNT_ULTRA_SENSORS, PULSE_MAX_TIMEOUT_MICROSECONDS,
-															 _timer);
+															 _timer, SENSORING_FREQUENCY_DELAY,
+															 UltrasonicSensors::PARALLEL);
 
 	if (SerialLogger::isBelow(SerialLogger::DEBUG)) {
 		_ultrasonicSensors->addStatusPrinting(_timer, DEBUG_PRINT_DISTANCE_DELAY);
 	}
 
-	SpiSlave::ISRfromArgs(SCK_PIN_ORANGE, MISO_PIN_YELLOW, MOSI_PIN_GREEN, SS_PIN_BLUE, _data_push_commands,
-						  k_amount_data_push_commands, _data_request_commands, k_amount_data_request_commands,
+	for (int i = 0; i < AMOUNT_ULTRA_SENSORS; i++) {
+		SpiSlave::putDataRequestCallback(sensorsSpiIdList[i], put_distance_sample);
+	}
+	SpiSlave::ISRfromArgs(SCK_PIN_ORANGE, MISO_PIN_YELLOW, MOSI_PIN_GREEN, SS_PIN_BLUE,
 						  OBSTACLE_COMMANDS * COMMAND_FRAME_SIZE + GYRO_COMMANDS * COMMAND_FRAME_SIZE);
 
     SpiSlave::addDebugSlavePrinting(_timer, 1000);
@@ -76,4 +74,10 @@ void setup() {
 void loop() {
 	// tick timers
 	auto ticks = _timer.tick();
+	// take the echoes captured by interrupts meanwhile
+	_ultrasonicSensors->updateDistancesFromEchoes();
+	// stage the answer to the latest pipelined spi frame (if any) with the distances just taken
+	SpiSlave::processDataPushCommands();
+	// hand buffered binary log records to Serial (if any)
+	SerialLogger::flush();
 }
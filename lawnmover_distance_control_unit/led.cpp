@@ -22,7 +22,7 @@ Led3Service::Led3Service(const int led1Pin, const int led2Pin, const int led3Pin
 	_led3Pin = kLed3Pin;
 
 	__nextState = _nextState;
-	SerialLogger::info(F("Scheduling blinking rotation at %d %s %d, %d, %d"), LED_INTRA_ROTATION_TIME_DELAY,
+	SERIAL_LOGGER_INFO(F("Scheduling blinking rotation at %d %s %d, %d, %d"), LED_INTRA_ROTATION_TIME_DELAY,
 					   "ms for Pin:", _led1Pin, _led2Pin, _led3Pin);
 
 	timer.every(LED_INTRA_ROTATION_TIME_DELAY, [](void *) -> bool {
@@ -32,45 +32,45 @@ Led3Service::Led3Service(const int led1Pin, const int led2Pin, const int led3Pin
 				digitalWrite(_led2Pin, HIGH);
 				digitalWrite(_led3Pin, LOW);
 				__nextState++;
-				SerialLogger::trace(F("Led turn: 1/6"));
+				SERIAL_LOGGER_TRACE(F("Led turn: 1/6"));
 				break;
 			case 1:
 				digitalWrite(_led1Pin, HIGH);
 				digitalWrite(_led2Pin, LOW);
 				digitalWrite(_led3Pin, LOW);
 				__nextState++;
-				SerialLogger::trace(F("Led turn: 2/6"));
+				SERIAL_LOGGER_TRACE(F("Led turn: 2/6"));
 				break;
 			case 2:
 				digitalWrite(_led1Pin, LOW);
 				digitalWrite(_led2Pin, LOW);
 				digitalWrite(_led3Pin, LOW);
 				__nextState++;
-				SerialLogger::trace(F("Led turn: 3/6"));
+				SERIAL_LOGGER_TRACE(F("Led turn: 3/6"));
 				break;
 			case 3:
 				digitalWrite(_led1Pin, LOW);
 				digitalWrite(_led2Pin, LOW);
 				digitalWrite(_led3Pin, HIGH);
 				__nextState++;
-				SerialLogger::trace(F("Led turn: 4/6"));
+				SERIAL_LOGGER_TRACE(F("Led turn: 4/6"));
 				break;
 			case 4:
 				digitalWrite(_led1Pin, LOW);
 				digitalWrite(_led2Pin, HIGH);
 				digitalWrite(_led3Pin, HIGH);
 				__nextState++;
-				SerialLogger::trace(F("Led turn: 5/6"));
+				SERIAL_LOGGER_TRACE(F("Led turn: 5/6"));
 				break;
 			case 5:
 				digitalWrite(_led1Pin, HIGH);
 				digitalWrite(_led2Pin, HIGH);
 				digitalWrite(_led3Pin, HIGH);
 				__nextState = 0;
-				SerialLogger::trace(F("Led turn: 6/6"));
+				SERIAL_LOGGER_TRACE(F("Led turn: 6/6"));
 				break;
 			default:
-				SerialLogger::warn(F("Unwanted default entered. Led turn: %d/6"), __nextState);
+				SERIAL_LOGGER_WARN(F("Unwanted default entered. Led turn: %d/6"), __nextState);
 		}
 		return true; // to repeat the action - false to stop
 	});
@@ -8,15 +8,84 @@ void UltrasonicSensor::triggerTx(const int txPin) {
 	digitalWrite(txPin, LOW);
 }
 
+void UltrasonicSensor::arm() {
+	if (_echoSlot < 0) {
+		return;
+	}
+	EchoCapture::arm(_echoSlot);
+	// Note: The trigger follows within microseconds
+	_triggerMicros = micros();
+	_awaitingEcho = true;
+}
+
+void UltrasonicSensor::updateLatestDistanceFromEcho() {
+	if (!_awaitingEcho) {
+		return;
+	}
+	unsigned long duration_microseconds;
+	if (EchoCapture::takePulse(_echoSlot, duration_microseconds)) {
+		if (duration_microseconds > (unsigned long) k_pulseMaxTimeoutMicroSeconds) {
+			// the sensor reports no echo by a pulse much longer than the timeout
+			duration_microseconds = k_pulseMaxTimeoutMicroSeconds;
+		}
+	} else {
+		// Note: The same timeouts as pulseIn has (up to the pulse and of the pulse itself)
+		const unsigned long now = micros();
+		const EchoCapture::SlotState state = EchoCapture::getState(_echoSlot);
+		if ((state == EchoCapture::ARMED && now - _triggerMicros < (unsigned long) k_pulseMaxTimeoutMicroSeconds) ||
+			(state == EchoCapture::PULSE_STARTED &&
+			 now - EchoCapture::getPulseStartMicros(_echoSlot) < (unsigned long) k_pulseMaxTimeoutMicroSeconds)) {
+			// still waiting
+			return;
+		}
+		// no echo read before timeout
+		duration_microseconds = k_pulseMaxTimeoutMicroSeconds;
+	}
+	_awaitingEcho = false;
+	updateLatestDistance(duration_microseconds);
+}
+
+void UltrasonicSensor::updateLatestDistance(const unsigned long durationMicroseconds) {
+	// The signal went back and forth but we do only need one distance
+	const float new_distance = (durationMicroseconds / ULTRASONIC_CM_PER_MICROSECOND_AIR) / 2.0f;
+	// SERIAL_LOGGER_DEBUG(F("new %f vs. old %f (q1: %d, q2: %d)"), new_distance, _latestDistance,
+	//                    _latestDistance < NO_ECHO_DISTANCE, _latestDistance >= k_maxDistance);
+	if (k_rejectCrossTalk && new_distance + CROSS_TALK_TOLERANCE_CM < _latestDistance &&
+		(_unconfirmedDistance < 0.0f || fabs(new_distance - _unconfirmedDistance) > CROSS_TALK_TOLERANCE_CM)) {
+		// much closer at once; wait for the next echo to tell an obstacle from cross-talk
+		_unconfirmedDistance = new_distance;
+		return;
+	}
+	_unconfirmedDistance = -1.0f;
+	float distance;
+	if (_latestDistance < NO_ECHO_DISTANCE && new_distance >= k_maxDistance) {
+		// The object got closer to the robot and is now probably "at" the robot leading to no echo due to the object. Setting to zero!
+		distance = 0.0f;
+		SERIAL_LOGGER_DEBUG(F("Setting distance of sensor=%s with id %d at rx pin %d to zero"), SpiCommands::getNameFromId(k_id), k_id, k_rxPin);
+	} else {
+		distance = (_latestDistance + new_distance) / 2.0f;
+	}
+	const unsigned long now = millis();
+	noInterrupts();
+	_latestDistance = distance;
+	_latestDistanceMillis = now;
+	interrupts();
+}
+
 UltrasonicSensors *UltrasonicSensors::getFromScheduled(const int txPin, const int rxPins[], const int16_t ids[],
 													   const int amountSensors, const int pulseMaxTimeoutMicroSeconds,
-													   Timer<> &timer, const int sensoring_frequency_delay) {
+													   Timer<> &timer, const int sensoring_frequency_delay,
+													   const AcquisitionMode mode) {
 	UltrasonicSensors *ultrasonicSensors = new UltrasonicSensors(txPin, rxPins, ids, amountSensors,
-																 pulseMaxTimeoutMicroSeconds);
-	timer.every(sensoring_frequency_delay, [](UltrasonicSensors *ultrasonicSensors) -> bool {
+																 pulseMaxTimeoutMicroSeconds, mode);
+	timer.every(sensoring_frequency_delay, [](void *opaque) -> bool {
+		UltrasonicSensors *ultrasonicSensors = static_cast<UltrasonicSensors *>(opaque);
 		if (ultrasonicSensors == nullptr) {
-			SerialLogger::error(F("UltrasonicSensor is nullptr. Something wrong, stopping timer iteration"));
+			SERIAL_LOGGER_ERROR(F("UltrasonicSensor is nullptr. Something wrong, stopping timer iteration"));
 			return false;
+		} else if (ultrasonicSensors->getAcquisitionMode() == PARALLEL) {
+			ultrasonicSensors->updateAllDistancesFromSensors();
+			return true;
 		} else {
 			ultrasonicSensors->updateNextDistanceFromSensors();
 			return true; // to repeat the action - false to stop
@@ -26,22 +95,27 @@ UltrasonicSensors *UltrasonicSensors::getFromScheduled(const int txPin, const in
 }
 
 UltrasonicSensors::UltrasonicSensors(const int txPin, const int rxPins[], const int16_t ids[], const int amountSensors,
-									 const int pulseMaxTimeoutMicroSeconds) :
-		k_txPin(txPin), k_amountSensors(amountSensors) {
+									 const int pulseMaxTimeoutMicroSeconds, const AcquisitionMode mode) :
+		k_txPin(txPin), k_amountSensors(amountSensors), k_mode(mode) {
 
 	_ultrasonicSensors = (UltrasonicSensor **) malloc(k_amountSensors * sizeof _ultrasonicSensors);
-	int16_t ids_check[k_amountSensors] = {-1};
-	int rxPins_check[k_amountSensors] = {-1};
+	// variable length arrays cannot be initialized by an initializer list
+	int16_t ids_check[k_amountSensors];
+	int rxPins_check[k_amountSensors];
+	for (int i = 0; i < k_amountSensors; i++) {
+		ids_check[i] = -1;
+		rxPins_check[i] = -1;
+	}
 
 	for (int i = 0; i < k_amountSensors; i++) {
 		const int rxPin = rxPins[i];
 		const int16_t id = ids[i];
-		SerialLogger::info(F("Creating sensor %d/%d with rxPin=%d and id=%d"), i + 1, k_amountSensors, rxPin, id);
+		SERIAL_LOGGER_INFO(F("Creating sensor %d/%d with rxPin=%d and id=%d"), i + 1, k_amountSensors, rxPin, id);
 
 		bool duplicate = false;
 		for (int j = 0; j < k_amountSensors; j++) {
 			if (ids_check[j] == id || rxPins_check[j] == rxPin) {
-				SerialLogger::error(F("Attempt to add the same sensor twice with id %d on rx pin %d where at index %d"
+				SERIAL_LOGGER_ERROR(F("Attempt to add the same sensor twice with id %d on rx pin %d where at index %d"
 									  " of the check arrays the same value already exists with id=%d and rxpin=%d"), id,
 									rxPin, j, ids_check[j], rxPins_check[j]);
 				duplicate = true;
@@ -53,9 +127,10 @@ UltrasonicSensors::UltrasonicSensors(const int txPin, const int rxPins[], const
 			rxPins_check[i] = rxPin;
 			if (rxPin <= MAX_ARDUINO_PINS && rxPin >= 2) {
 				_ultrasonicSensors[_registeredSensors++] = new UltrasonicSensor(id, k_txPin, rxPin,
-																				pulseMaxTimeoutMicroSeconds);
+																				pulseMaxTimeoutMicroSeconds,
+																				k_mode == PARALLEL);
 			} else {
-				SerialLogger::warn(F("Cannot add sensor %d/%d at rx pin %d which is out of range. Max Pin is %d. "
+				SERIAL_LOGGER_WARN(F("Cannot add sensor %d/%d at rx pin %d which is out of range. Max Pin is %d. "
 									 "Assuming a bad malfunctioning and stopping..."), i + 1, k_amountSensors,
 								   rxPin, MAX_ARDUINO_PINS);
 				break;
@@ -63,9 +138,10 @@ UltrasonicSensors::UltrasonicSensors(const int txPin, const int rxPins[], const
 		}
 	}
 	if (_registeredSensors == k_amountSensors) {
-		SerialLogger::info(F("Scheduling ultrasonic sonic distance sensoring from pin %d to echo pins"), k_txPin);
+		SERIAL_LOGGER_INFO(F("Scheduling ultrasonic sonic distance sensoring from pin %d to echo pins (%s)"), k_txPin,
+						   k_mode == PARALLEL ? "parallel" : "round robin");
 	} else {
-		SerialLogger::error(F("Could only add %d/%d sensors. Expect issues."), _registeredSensors, k_amountSensors);
+		SERIAL_LOGGER_ERROR(F("Could only add %d/%d sensors. Expect issues."), _registeredSensors, k_amountSensors);
 	}
 }
 
@@ -74,31 +150,41 @@ UltrasonicSensors::~UltrasonicSensors() {
 	for (int i = 0; i < _registeredSensors; i++) {
 		delete _ultrasonicSensors[i];
 	}
-	delete _ultrasonicSensors;
+	free(_ultrasonicSensors);
 }
 
 void UltrasonicSensors::updateNextDistanceFromSensors() {
-	/* Note: updateDistanceFromSensors performs a round-robin. This has the drawback of imposing a delay of up to
-	  n x pulseMaxTimeoutMicroSeconds at worst where n is the amount of sensors to update distance from. Given the
-	  fact that we might operate in a timer callback function, we cannot delay this execution or other callbacks
-	  might get broken by it. Hence, we still perform a round robin but release the timer after one sensors was caputured
-	  to allow other callbacks to get executed without (or smaller) delay.
+	/* Note: All sensors share the tx pin. Hence, we still perform a round-robin and capture the echo of one sensor per
+	  trigger only. Otherwise, a sensor might receive the echo of another one. The echo is captured by interrupts, i. e.
+	  neither the timer nor any other callback waits up to pulseMaxTimeoutMicroSeconds for it.
 	*/
 	if (_registeredSensors > 0) {
 		UltrasonicSensor *sensor = _ultrasonicSensors[_nextSensorIndex];
-		sensor->updateLatestDistanceWithTx();
+		sensor->trigger();
 		_nextSensorIndex = (_nextSensorIndex + 1) % _registeredSensors;
 	}
 }
 
-void UltrasonicSensors::updateDistanceFromSensors() {
-	/* Note: We need to make a round-robin or the distance of one sensor will be incorrect if one update call takes too long
-	  (e. g. if pulseMaxTimeoutMicroSeconds was reached). This has the drawback of imposing a delay of up to
-	  n x pulseMaxTimeoutMicroSeconds at worst where n is the amount of sensors to update distance from.
+void UltrasonicSensors::updateAllDistancesFromSensors() {
+	/* Note: One trigger fires all sensors anyway; listening to all of them makes a sweep as fast as the round robin
+	  step. Thereby, the echo of one sensor may reach another one (cross-talk), see rejectCrossTalk of UltrasonicSensor.
 	*/
+	bool armed = false;
 	for (int i = 0; i < _registeredSensors; i++) {
 		UltrasonicSensor *sensor = _ultrasonicSensors[i];
-		sensor->updateLatestDistanceWithTx();
+		if (!sensor->isAwaitingEcho()) {
+			sensor->arm();
+			armed = true;
+		}
+	}
+	if (armed) {
+		UltrasonicSensor::triggerTx(k_txPin);
+	}
+}
+
+void UltrasonicSensors::updateDistancesFromEchoes() {
+	for (int i = 0; i < _registeredSensors; i++) {
+		_ultrasonicSensors[i]->updateLatestDistanceFromEcho();
 	}
 }
 
@@ -112,7 +198,7 @@ float UltrasonicSensors::getLatestDistanceFromSensorByPin(const int sensorPin) c
 		}
 	}
 	if (distance < 0) {
-		SerialLogger::warn(F("Could not find ultrasonic sensor on rx pin %d"), sensorPin);
+		SERIAL_LOGGER_WARN(F("Could not find ultrasonic sensor on rx pin %d"), sensorPin);
 	}
 	return distance;
 }
@@ -127,7 +213,19 @@ float UltrasonicSensors::getLatestDistanceFromSensorById(const int16_t id) const
 		}
 	}
 	if (distance < 0) {
-		SerialLogger::warn(F("Could not find ultrasonic sensor from id %d"), id);
+		SERIAL_LOGGER_WARN(F("Could not find ultrasonic sensor from id %d"), id);
 	}
 	return distance;
 }
+
+bool UltrasonicSensors::getLatestSampleFromSensorById(const int16_t id, float &distance,
+													  unsigned long &sampleMillis) const {
+	for (int i = 0; i < _registeredSensors; i++) {
+		const UltrasonicSensor *sensor = _ultrasonicSensors[i];
+		if (id == sensor->getId()) {
+			sensor->getLatestSample(distance, sampleMillis);
+			return true;
+		}
+	}
+	return false;
+}
@@ -6,27 +6,38 @@
 #include <serial_logger.h>
 #include <spi_commands.h>
 
+#include "echo_capture.h"
+
 #define SENSORING_FREQUENCY_DELAY 45
 #define MAX_ARDUINO_PINS 13
 #define ULTRASONIC_CM_PER_MICROSECOND_AIR 29
 #define NO_ECHO_DISTANCE 7.5f
+// a jump towards the robot of more than this must be confirmed by the next echo (see rejectCrossTalk)
+#define CROSS_TALK_TOLERANCE_CM 10.0f
 
 class UltrasonicSensor {
 public:
-	UltrasonicSensor(const int16_t id, const int txPin, const int rxPin, const int pulseMaxTimeoutMicroSeconds) :
+	/**
+	 * @param rejectCrossTalk whether to drop single echoes much closer than the distance so far. Such an echo might
+	 * be the burst of another sensor fired by the same trigger. It is taken once the next echo confirms it.
+	 */
+	UltrasonicSensor(const int16_t id, const int txPin, const int rxPin, const int pulseMaxTimeoutMicroSeconds,
+					 const bool rejectCrossTalk = false) :
 			k_id(id), k_txPin(txPin), k_rxPin(rxPin), k_pulseMaxTimeoutMicroSeconds(pulseMaxTimeoutMicroSeconds),
-			k_maxDistance((k_pulseMaxTimeoutMicroSeconds / ULTRASONIC_CM_PER_MICROSECOND_AIR) / 2.0f) {
-		SerialLogger::debug(F("Initiating ultrasonic sensor %s on rxPin=%d with id=%d with txPin=%d and max "
+			k_maxDistance((k_pulseMaxTimeoutMicroSeconds / ULTRASONIC_CM_PER_MICROSECOND_AIR) / 2.0f),
+			k_rejectCrossTalk(rejectCrossTalk) {
+		SERIAL_LOGGER_DEBUG(F("Initiating ultrasonic sensor %s on rxPin=%d with id=%d with txPin=%d and max "
 		                      "possible distance at %f"), SpiCommands::getNameFromId(id), k_rxPin, k_id, k_txPin, 
 		                      k_maxDistance);
 		pinMode(k_txPin, OUTPUT);
 		digitalWrite(k_txPin, LOW);
 		pinMode(k_rxPin, INPUT);
 		_latestDistance = k_maxDistance;
+		_echoSlot = EchoCapture::attach(k_rxPin);
 	}
 
 	// having const values is more valuable than this copy-assignment; if you need to move use (smart) pointers
-	UltrasonicSensor &UltrasonicSensor::operator=(const UltrasonicSensor &ultrasonicSensor) = delete;
+	UltrasonicSensor &operator=(const UltrasonicSensor &ultrasonicSensor) = delete;
 
 	~UltrasonicSensor() {
 		digitalWrite(k_txPin, LOW);
@@ -44,31 +55,37 @@ public:
 		return _latestDistance;
 	};
 
+	/**
+	 * Get the latest distance together with the millis it was measured at (e. g. from the spi interrupt routine)
+	 */
+	void getLatestSample(float &distance, unsigned long &sampleMillis) const {
+		distance = _latestDistance;
+		sampleMillis = _latestDistanceMillis;
+	};
+
+	bool isAwaitingEcho() const {
+		return _awaitingEcho;
+	};
+
 	static void triggerTx(const int txPin);
 
-	void updateLatestDistanceWithTx() {
+	/**
+	 * Capture the echo of the next trigger (e. g. of a trigger shared with other sensors) in the background
+	 */
+	void arm();
+
+	/**
+	 * Fire the tx pin and capture the echo in the background. Call updateLatestDistanceFromEcho afterwards to evaluate it.
+	 */
+	void trigger() {
+		arm();
 		triggerTx(k_txPin);
-		updateLatestDistanceWithoutTx();
 	};
 
-	void updateLatestDistanceWithoutTx() {
-		long duration_microseconds = pulseIn(k_rxPin, HIGH, k_pulseMaxTimeoutMicroSeconds);
-		if (duration_microseconds == 0) {
-			// no echo read before timeout
-			duration_microseconds = k_pulseMaxTimeoutMicroSeconds;
-		}
-		// The signal went back and forth but we do only need one distance
-		const float new_distance = (duration_microseconds / ULTRASONIC_CM_PER_MICROSECOND_AIR) / 2.0f;
-		// SerialLogger::debug(F("new %f vs. old %f (q1: %d, q2: %d)"), new_distance, _latestDistance,
-		//                    _latestDistance < NO_ECHO_DISTANCE, _latestDistance >= k_maxDistance);
-		if (_latestDistance < NO_ECHO_DISTANCE && new_distance >= k_maxDistance) {
-			// The object got closer to the robot and is now probably "at" the robot leading to no echo due to the object. Setting to zero!
-			_latestDistance = 0.0f;
-			SerialLogger::debug(F("Setting distance of sensor=%s with id %d at rx pin %d to zero"), SpiCommands::getNameFromId(k_id), k_id, k_rxPin);
-		} else {
-			_latestDistance = (_latestDistance + new_distance) / 2.0f;
-		}
-	};
+	/**
+	 * Take the distance from the echo captured since the last trigger (if complete or timed out). Never blocks.
+	 */
+	void updateLatestDistanceFromEcho();
 
 private:
 	const int k_txPin;
@@ -76,20 +93,37 @@ private:
 	const int16_t k_id;
 	const int k_pulseMaxTimeoutMicroSeconds;
 	const float k_maxDistance;
-	// Note: Assuming there is one writer and multiple readers, i. e. volatile is enough
+	const bool k_rejectCrossTalk;
+	// Note: Written by the loop and read by the spi interrupt routine, too. Neither is atomic on 8 bit mcus, thus,
+	// interrupts are disabled while writing both.
 	volatile float _latestDistance;
+	volatile unsigned long _latestDistanceMillis = 0;
+	int _echoSlot;
+	unsigned long _triggerMicros = 0;
+	bool _awaitingEcho = false;
+	// a much closer distance waiting for its confirmation (negative if none)
+	float _unconfirmedDistance = -1.0f;
+
+	void updateLatestDistance(unsigned long durationMicroseconds);
 };
 
 class UltrasonicSensors {
 public:
+	enum AcquisitionMode {
+		// one sensor per trigger, i. e. a sweep over all sensors takes amount sensors x sensoring_frequency_delay
+		ROUND_ROBIN,
+		// all sensors at once per trigger with cross-talk rejection
+		PARALLEL
+	};
 
 	static UltrasonicSensors *getFromScheduled(const int txPin, const int rxPins[], const int16_t ids[],
 											   const int amountSensors, const int pulseMaxTimeoutMicroSeconds,
 											   Timer<> &timer,
-											   const int sensoring_frequency_delay = SENSORING_FREQUENCY_DELAY);
+											   const int sensoring_frequency_delay = SENSORING_FREQUENCY_DELAY,
+											   const AcquisitionMode mode = ROUND_ROBIN);
 
 	UltrasonicSensors(const int txPin, const int *rxPins, const int16_t ids[], const int amountSensors,
-					  const int pulseMaxTimeoutMicroSeconds);
+					  const int pulseMaxTimeoutMicroSeconds, const AcquisitionMode mode = ROUND_ROBIN);
 
 	~UltrasonicSensors();
 
@@ -97,13 +131,18 @@ public:
 		return k_amountSensors;
 	};
 
+	AcquisitionMode getAcquisitionMode() const {
+		return k_mode;
+	};
+
 	void addStatusPrinting(Timer<> &timer, const int frequency) const {
-		timer.every(frequency, [](UltrasonicSensors *ultrasonicSensors) -> bool {
+		timer.every(frequency, [](void *opaque) -> bool {
+			const UltrasonicSensors *ultrasonicSensors = static_cast<const UltrasonicSensors *>(opaque);
 			if (ultrasonicSensors == nullptr) {
-				SerialLogger::error(F("UltrasonicSensor is nullptr. Something wrong, stopping timer iteration"));
+				SERIAL_LOGGER_ERROR(F("UltrasonicSensor is nullptr. Something wrong, stopping timer iteration"));
 				return false;
 			} else {
-				SerialLogger::info(F("F: %f, FR: %f, FL: %f, RR: %f, RL: %f"),
+				SERIAL_LOGGER_INFO(F("F: %f, FR: %f, FL: %f, RR: %f, RL: %f"),
 								   ultrasonicSensors->getLatestDistanceFromSensorById(OBSTACLE_FRONT_COMMAND),
 								   ultrasonicSensors->getLatestDistanceFromSensorById(OBSTACLE_FRONT_RIGHT_COMMAND),
 								   ultrasonicSensors->getLatestDistanceFromSensorById(OBSTACLE_FRONT_LEFT_COMMAND),
@@ -111,20 +150,38 @@ public:
 								   ultrasonicSensors->getLatestDistanceFromSensorById(OBSTACLE_BACK_LEFT_COMMAND));
 				return true; // to repeat the action - false to stop
 			}
-		}, this);
+		}, const_cast<UltrasonicSensors *>(this));
 	};
 
+	/**
+	 * Trigger the next sensor (round robin). Its echo is captured by interrupts, i. e. this does not block.
+	 */
 	void updateNextDistanceFromSensors();
 
-	void updateDistanceFromSensors();
+	/**
+	 * Fire the shared tx pin once and capture the echoes of all sensors in parallel. Each sensor times out on its own.
+	 * Sensors still waiting for the echo of the previous trigger are left out.
+	 */
+	void updateAllDistancesFromSensors();
+
+	/**
+	 * Evaluate the echoes captured so far. Call it as often as possible (e. g. every loop).
+	 */
+	void updateDistancesFromEchoes();
 
 	float getLatestDistanceFromSensorByPin(const int sensorPin) const;
 
 	float getLatestDistanceFromSensorById(const int16_t id) const;
 
+	/**
+	 * @return whether there is a sensor with the given id
+	 */
+	bool getLatestSampleFromSensorById(const int16_t id, float &distance, unsigned long &sampleMillis) const;
+
 private:
 	const int k_txPin;
 	const int k_amountSensors;
+	const AcquisitionMode k_mode;
 
 	UltrasonicSensor **_ultrasonicSensors;
 	volatile int _nextSensorIndex = 0;
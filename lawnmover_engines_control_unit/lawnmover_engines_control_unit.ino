@@ -21,7 +21,10 @@ const int MISO_PIN_YELLOW  = 12; // D12 = pin18 = PortB.4
 const int MOSI_PIN_GREEN  = 11; // D11 = pin17 = PortB.3
 const int SS_PIN_BLUE    = 10; // D10 = pin16 = PortB.2
 
-const int EXPECTED_SPI_COMMANDS_BURSTS_PER_SECONDS = 3;
+// frames of ENGINE_COMMANDS data pushes the watchdog expects per validation interval; each data push is counted
+// once (the former linear scan of the callbacks counted 1 + 2 + 3 per frame, i. e. effectively two frames were
+// expected with the previous threshold of 9)
+const int EXPECTED_SPI_COMMANDS_BURSTS_PER_VALIDATION = 2;
 
 
 // Debug
@@ -35,32 +38,13 @@ const int steering_set_interval = 100;
 MoverService *_moverService;
 
 const int k_watchdog_validation_interval = 1200;
-const int k_watchdog_valid_threshold = ENGINE_COMMANDS *  EXPECTED_SPI_COMMANDS_BURSTS_PER_SECONDS;
-Watchdog *_watchdog = Watchdog::getFromScheduled(k_watchdog_validation_interval, k_watchdog_valid_threshold, [](void) -> bool {
+const int k_watchdog_valid_threshold = ENGINE_COMMANDS * EXPECTED_SPI_COMMANDS_BURSTS_PER_VALIDATION;
+Watchdog *_watchdog = Watchdog::getFromScheduled(k_watchdog_validation_interval, k_watchdog_valid_threshold, [](void) -> void {
        _moverService->set_left_wheels_power(LEFT_WHEEL_STEERING_COMMAND, 0);
        _moverService->set_right_wheels_power(RIGHT_WHEEL_STEERING_COMMAND, 0);
        _motorService->set_rotation_speed(MOTOR_SPEED_COMMAND, 0);
     }, _timer);
 
-int k_amount_data_push_commands = 3;
-bool (*_data_push_commands[])(int16_t, int16_t) = {
-    [](int16_t id, int16_t wheelsPower) -> bool {
-        _watchdog->incrementCounter();
-        return _moverService->set_left_wheels_power(id, wheelsPower);
-    },
-    [](int16_t id, int16_t wheelsPower) -> bool {
-        _watchdog->incrementCounter();
-        return _moverService->set_right_wheels_power(id, wheelsPower);
-    },
-    [](int16_t id, int16_t rotation_speed) -> bool {
-        _watchdog->incrementCounter();
-        return _motorService->set_rotation_speed(id, rotation_speed);
-    }};
-
-
-int k_amount_data_request_commands = 0;
-bool (*_data_request_commands[])(int16_t, uint8_t *) = {};
-
 void setup() {
     SerialLogger::init(9600, SerialLogger::LOG_LEVEL::INFO);
     // TODO make static object to ease dynamic memory usage
@@ -70,8 +54,19 @@ void setup() {
     _moverService = new MoverService(LEFT_FWD_PIN, LEFT_BWD_PIN, LEFT_PWM_PIN, RIGHT_PWM_PIN, RIGHT_FWD_PIN,
                                      RIGHT_BWD_PIN);
     _moverService->printInit();
-    SpiSlave::ISRfromArgs(SCK_PIN_ORANGE, MISO_PIN_YELLOW, MOSI_PIN_GREEN, SS_PIN_BLUE, _data_push_commands, 
-                          k_amount_data_push_commands, _data_request_commands, k_amount_data_request_commands, 
+    SpiSlave::putDataPushCallback(LEFT_WHEEL_STEERING_COMMAND, [](int16_t id, int16_t wheelsPower) -> bool {
+        _watchdog->incrementCounter();
+        return _moverService->set_left_wheels_power(id, wheelsPower);
+    });
+    SpiSlave::putDataPushCallback(RIGHT_WHEEL_STEERING_COMMAND, [](int16_t id, int16_t wheelsPower) -> bool {
+        _watchdog->incrementCounter();
+        return _moverService->set_right_wheels_power(id, wheelsPower);
+    });
+    SpiSlave::putDataPushCallback(MOTOR_SPEED_COMMAND, [](int16_t id, int16_t rotation_speed) -> bool {
+        _watchdog->incrementCounter();
+        return _motorService->set_rotation_speed(id, rotation_speed);
+    });
+    SpiSlave::ISRfromArgs(SCK_PIN_ORANGE, MISO_PIN_YELLOW, MOSI_PIN_GREEN, SS_PIN_BLUE,
                           ENGINE_COMMANDS * COMMAND_FRAME_SIZE);
 
     _timer.every(motor_spin_set_interval, [](void*) -> bool {
@@ -106,27 +101,27 @@ void loop() {
     // DEBUG START
     // _moverService->changeLeftPwmRate(255);
     // _moverService->changeRightPwmRate(255);
-    // SerialLogger::debug("change to 255");
+    // SERIAL_LOGGER_DEBUG("change to 255");
     // delay(1500);
     //
     // _moverService->changeLeftPwmRate(128);
     // _moverService->changeRightPwmRate(128);
-    // SerialLogger::debug("change to 128");
+    // SERIAL_LOGGER_DEBUG("change to 128");
     // delay(1500);
     //
     // _moverService->changeLeftPwmRate(56);
     //  _moverService->changeRightPwmRate(56);
-    // SerialLogger::debug("change to 56");
+    // SERIAL_LOGGER_DEBUG("change to 56");
     // delay(1500);
     //
     // _moverService->changeLeftPwmRate(28);
     // _moverService->changeRightPwmRate(28);
-    // SerialLogger::debug("change to 28");
+    // SERIAL_LOGGER_DEBUG("change to 28");
     // delay(2500);
     //
     // _moverService->changeLeftPwmRate(0);
     // _moverService->changeRightPwmRate(0);
-    // SerialLogger::debug("change to 0");
+    // SERIAL_LOGGER_DEBUG("change to 0");
     // delay(1000);
 
     //_moverService->moveForward();
@@ -139,6 +134,14 @@ void loop() {
     //delay(10);
     // DEBUG END
 
+    // apply the commands of the latest spi frame before the timers act on them
+    if (SpiSlave::processDataPushCommands()) {
+        // steer right away instead of up to steering_set_interval later; the main core unit dead reckons its pose
+        // from the wheel powers as of sending them
+        _moverService->interpret_state();
+    }
     // tick timers
     auto ticks = _timer.tick();
+    // hand buffered binary log records to Serial (if any)
+    SerialLogger::flush();
 }
@@ -14,12 +14,12 @@ MotorService::~MotorService() {
 }
 
 void MotorService::printInit() {
-    SerialLogger::info(F("Setup MotorService with Pin: %d"), kMotorPin);
+    SERIAL_LOGGER_INFO(F("Setup MotorService with Pin: %d"), kMotorPin);
 }
 
 bool MotorService::set_rotation_speed(const int16_t id, const int16_t rotation_speed) {
-    // Logging (serial printing is faster) must be kept to an absolute minimum for this SPI command callback depending on the logging baudrate 
-    // SerialLogger::debug("Inspecting motor speed with id %d and value %d", id, rotation_speed);
+    // Called for each frame; keep logging to a minimum depending on the logging baudrate
+    // SERIAL_LOGGER_DEBUG("Inspecting motor speed with id %d and value %d", id, rotation_speed);
     if (id == MOTOR_SPEED_COMMAND) {
         _rotation_speed = rotation_speed;
         return true;
@@ -29,21 +29,21 @@ bool MotorService::set_rotation_speed(const int16_t id, const int16_t rotation_s
 }
 
 void MotorService::startMotor() {
-    SerialLogger::trace(F("Starting motor"));
+    SERIAL_LOGGER_TRACE(F("Starting motor"));
     analogWrite(kMotorPin, 128);
 }
 
 void MotorService::stopMotor() {
-    SerialLogger::trace(F("Stopping motor"));
+    SERIAL_LOGGER_TRACE(F("Stopping motor"));
     analogWrite(kMotorPin, 0);
 }
 
 void MotorService::spinMotor() {
     if (_rotation_speed > 10) {
-        SerialLogger::debug(F("Spinning motor with %d/%d"), _rotation_speed, 255);
+        SERIAL_LOGGER_DEBUG(F("Spinning motor with %d/%d"), _rotation_speed, 255);
         analogWrite(kMotorPin, _rotation_speed);
     } else {
-        SerialLogger::debug(F("Rotation speed was below threshold (%d/10). Stop motor spinning."), _rotation_speed);
+        SERIAL_LOGGER_DEBUG(F("Rotation speed was below threshold (%d/10). Stop motor spinning."), _rotation_speed);
         stopMotor();
     }
 }
@@ -26,7 +26,8 @@ class MotorService {
 
     private:
         const int kMotorPin;
-        volatile int16_t _rotation_speed = 0;
+        // set by spi data push commands from the loop (see SpiSlave::processDataPushCommands)
+        int16_t _rotation_speed = 0;
 };
 
 #endif // MOTOR_H
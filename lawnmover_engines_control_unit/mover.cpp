@@ -17,7 +17,7 @@ MoverService::MoverService(const int leftFwdPin, const int leftBwdPin, const int
 }
 
 void MoverService::printInit() {
-    SerialLogger::info(F("Set up MoverService with leftFwdPin(%d), leftBwdPin(%d), rightFwdPin(%d), rightBwdPin(%d), "
+    SERIAL_LOGGER_INFO(F("Set up MoverService with leftFwdPin(%d), leftBwdPin(%d), rightFwdPin(%d), rightBwdPin(%d), "
                        "leftPwmPin(%d), rightPwmPin(%d) with leftPwmPin(%d) and rightPwnPin(%d)"),
                        kLeftFwdPin, kLeftBwdPin, kRightFwdPin, kRightBwdPin, kLeftPwmPin, kRightPwmPin,
                        kRightFwdPin, kRightBwdPin);
@@ -29,7 +29,7 @@ void MoverService::printState() {
     const bool rightFwdPinState = digitalRead(kRightFwdPin);
     const bool leftBwdPinState = digitalRead(kLeftBwdPin);
     const bool rightBwdPinState = digitalRead(kRightBwdPin);
-    SerialLogger::debug(F("Pin %d: %d, Pin %d: %d, Pin %d: %d, Pin %d: %d"),
+    SERIAL_LOGGER_DEBUG(F("Pin %d: %d, Pin %d: %d, Pin %d: %d, Pin %d: %d"),
                         kLeftFwdPin, leftFwdPinState, kLeftBwdPin, leftBwdPinState, kRightFwdPin, rightFwdPinState,
                         kRightBwdPin, rightBwdPinState);
 }
@@ -40,7 +40,7 @@ MoverService::~MoverService() {
 
 
 void MoverService::stopMovement() {
-    SerialLogger::trace("stopping movement");
+    SERIAL_LOGGER_TRACE("stopping movement");
     digitalWrite(kLeftFwdPin, LOW);
     digitalWrite(kLeftBwdPin, LOW);
     digitalWrite(kRightFwdPin, LOW);
@@ -57,10 +57,10 @@ void MoverService::changeLeftPwmRate(const int rate) {
     // analogRead values go from 0 to 1023, analogWrite values from 0 to 255
     if (rate > 15) {
         // reduce sensitivity around anchor point zero
-        SerialLogger::debug(F("Changing Pwm Pin %i (left) to %d"), kLeftPwmPin, rate);
+        SERIAL_LOGGER_DEBUG(F("Changing Pwm Pin %i (left) to %d"), kLeftPwmPin, rate);
         analogWrite(kLeftPwmPin, rate);
     } else {
-        SerialLogger::debug(F("Not setting left rate. Pwm rate was below threshold (%d/15). Stopping left pwm."), rate);
+        SERIAL_LOGGER_DEBUG(F("Not setting left rate. Pwm rate was below threshold (%d/15). Stopping left pwm."), rate);
         analogWrite(kLeftPwmPin, 0);
     }
 }
@@ -69,10 +69,10 @@ void MoverService::changeRightPwmRate(const int rate) {
     // analogRead values go from 0 to 1023, analogWrite values from 0 to 255
     if (rate > 15) {
         // reduce sensitivity around anchor point zero
-        SerialLogger::debug(F("Changing Pwm Pin %i (right) to %d"), kRightPwmPin, rate);
+        SERIAL_LOGGER_DEBUG(F("Changing Pwm Pin %i (right) to %d"), kRightPwmPin, rate);
         analogWrite(kRightPwmPin, rate);
     } else {
-        SerialLogger::debug(F("Not setting right rate. Pwm rate was below threshold (%d/15). Stopping right pwm."), rate);
+        SERIAL_LOGGER_DEBUG(F("Not setting right rate. Pwm rate was below threshold (%d/15). Stopping right pwm."), rate);
         analogWrite(kRightPwmPin, 0);
     }
 }
@@ -84,11 +84,11 @@ void MoverService::interpret_state() {
     const int right_rate = right_wheels_power < 0 ? right_wheels_power  * -1 : right_wheels_power ;
     if (left_wheels_power != 0) {
        if (left_forward) {
-            SerialLogger::debug(F("Left forwards"));
+            SERIAL_LOGGER_DEBUG(F("Left forwards"));
             digitalWrite(kLeftBwdPin, LOW);
             digitalWrite(kLeftFwdPin, HIGH);
         } else {
-            SerialLogger::debug("Left backwards");
+            SERIAL_LOGGER_DEBUG("Left backwards");
             digitalWrite(kLeftFwdPin, LOW);
             digitalWrite(kLeftBwdPin, HIGH);
         } 
@@ -96,11 +96,11 @@ void MoverService::interpret_state() {
 
     if (right_wheels_power != 0) {
        if (right_forward) {
-            SerialLogger::debug(F("Right forwards"));
+            SERIAL_LOGGER_DEBUG(F("Right forwards"));
             digitalWrite(kRightBwdPin, LOW);
             digitalWrite(kRightFwdPin, HIGH);
         } else {
-            SerialLogger::debug(F("Right backwards"));
+            SERIAL_LOGGER_DEBUG(F("Right backwards"));
             digitalWrite(kRightFwdPin, LOW);
             digitalWrite(kRightBwdPin, HIGH);
         } 
@@ -19,8 +19,8 @@ class MoverService {
         void printState();
 
         bool set_left_wheels_power(const int16_t id, const int16_t wheels_power) {
-            // Logging (serial printing is faster) must be kept to an absolute minimum for this SPI command callback depending on the logging baudrate 
-            // SerialLogger::debug("Inspecting left wheels power with id %d and value %d", id, wheels_power);
+            // Called for each frame; keep logging to a minimum depending on the logging baudrate
+            // SERIAL_LOGGER_DEBUG("Inspecting left wheels power with id %d and value %d", id, wheels_power);
             if (id == LEFT_WHEEL_STEERING_COMMAND) {
                 left_wheels_power = wheels_power;
                 return true;
@@ -30,8 +30,8 @@ class MoverService {
         };
 
         bool set_right_wheels_power(const int16_t id, const int16_t wheels_power) {
-            // Logging (serial printing is faster) must be kept to an absolute minimum for this SPI command callback depending on the logging baudrate 
-            // SerialLogger::debug("Inspecting right wheels power with id %d and value %d", id, wheels_power);
+            // Called for each frame; keep logging to a minimum depending on the logging baudrate
+            // SERIAL_LOGGER_DEBUG("Inspecting right wheels power with id %d and value %d", id, wheels_power);
             if (id == RIGHT_WHEEL_STEERING_COMMAND) {
                 right_wheels_power = wheels_power;
                 return true;
@@ -49,8 +49,9 @@ class MoverService {
         const int kRightFwdPin;
         const int kRightBwdPin;
 
-        volatile int left_wheels_power = 0;
-        volatile int right_wheels_power = 0;
+        // set by spi data push commands from the loop (see SpiSlave::processDataPushCommands)
+        int left_wheels_power = 0;
+        int right_wheels_power = 0;
 
         void stopMovement();
 
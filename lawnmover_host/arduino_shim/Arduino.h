@@ -0,0 +1,212 @@
+#ifndef ARDUINO_SHIM_H
+#define ARDUINO_SHIM_H
+
+/**
+ * Minimal host (Linux) replacement of the Arduino core API. It provides just enough of Arduino.h to compile the
+ * hardware independent modules (e. g. the robo pilot and the serial logger) natively. Hardware related functions
+ * (pins, time) are backed by plain memory and std::chrono. See ArduinoShim below for the host only hooks.
+ *
+ * Define ARDUINO_SHIM_VIRTUAL_CLOCK to start with a clock standing still at zero instead of the host clock (e. g. for
+ * firmware running in the simulator whose static initializers already read millis). Define ARDUINO_ARCH_AVR to get
+ * the AVR registers needed by the Uno firmware, too.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+#include <algorithm>
+
+#if defined(ARDUINO_ARCH_AVR)
+#include <avr/io.h>
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// flash strings are ordinary strings on the host
+class __FlashStringHelper;
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t *>(addr))
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+#define AMOUNT_SHIM_PINS 64
+
+#define bit(b) (1UL << (b))
+
+#if defined(ARDUINO_ARCH_AVR)
+// pin change interrupts of the Uno as in its pins_arduino.h (D0-D7: PCIE2, D8-D13: PCIE0, A0-A5: PCIE1)
+#define digitalPinToPCICR(p) (((p) >= 0 && (p) <= 21) ? (&PCICR) : ((volatile uint8_t *) 0))
+#define digitalPinToPCICRbit(p) (((p) <= 7) ? 2 : (((p) <= 13) ? 0 : 1))
+#define digitalPinToPCMSK(p) (((p) <= 7) ? (&PCMSK2) : (((p) <= 13) ? (&PCMSK0) : \
+		(((p) <= 21) ? (&PCMSK1) : ((volatile uint8_t *) 0))))
+#define digitalPinToPCMSKbit(p) (((p) <= 7) ? (p) : (((p) <= 13) ? ((p) - 8) : ((p) - 14)))
+
+// ports of the Uno as in its pins_arduino.h (D0-D7: PORTD, D8-D13: PORTB, A0-A5: PORTC)
+#define NOT_A_PIN 0
+#define PB 2
+#define PC 3
+#define PD 4
+#define digitalPinToPort(p) (((p) <= 7) ? PD : (((p) <= 13) ? PB : (((p) <= 19) ? PC : NOT_A_PIN)))
+#define digitalPinToBitMask(p) ((uint8_t) bit(digitalPinToPCMSKbit(p)))
+#define portInputRegister(P) (((P) == PB) ? (&PINB) : (((P) == PC) ? (&PINC) : \
+		(((P) == PD) ? (&PIND) : ((volatile uint8_t *) 0))))
+#endif
+
+// as in the esp32 core; the avr core has macros instead
+using std::min;
+using std::max;
+
+unsigned long millis();
+
+unsigned long micros();
+
+void delay(unsigned long ms);
+
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+
+void digitalWrite(uint8_t pin, uint8_t val);
+
+int digitalRead(uint8_t pin);
+
+int analogRead(uint8_t pin);
+
+void analogWrite(uint8_t pin, int val);
+
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000L);
+
+// there are no interrupts on the host; the simulator calls interrupt routines in between loops only
+inline void noInterrupts() {}
+
+inline void interrupts() {}
+
+class HostSerial {
+public:
+	void begin(unsigned long baud);
+
+	void end();
+
+	operator bool() const { return true; };
+
+	// the host never blocks on Serial
+	int availableForWrite() const { return 4096; };
+
+	size_t write(uint8_t value);
+
+	size_t write(const uint8_t *buffer, size_t size);
+
+	size_t print(const __FlashStringHelper *value);
+
+	size_t print(const char *value);
+
+	size_t print(char value);
+
+	size_t print(unsigned char value, int base = DEC);
+
+	size_t print(int value, int base = DEC);
+
+	size_t print(unsigned int value, int base = DEC);
+
+	size_t print(long value, int base = DEC);
+
+	size_t print(unsigned long value, int base = DEC);
+
+	size_t print(double value, int digits = 2);
+
+	size_t println();
+
+	template<typename T>
+	size_t println(const T value) {
+		return print(value) + println();
+	};
+
+	template<typename T>
+	size_t println(const T value, int format) {
+		return print(value, format) + println();
+	};
+
+	size_t printf(const char *format, ...);
+
+private:
+	size_t printNumber(unsigned long value, int base);
+};
+
+extern HostSerial Serial;
+
+/**
+ * Host only hooks of the shim. Not part of the Arduino API and must not be used by firmware code.
+ */
+namespace ArduinoShim {
+	typedef unsigned long long (*MicrosSource)();
+
+	/**
+	 * Replace the time source of millis and micros (e. g. by a virtual clock of a simulator). Put nullptr to use the
+	 * monotonic host clock again.
+	 */
+	void setMicrosSource(MicrosSource microsSource);
+
+	typedef void (*DelayHandler)(unsigned long long microseconds);
+
+	/**
+	 * Replace what delay and delayMicroseconds do. By default, they sleep the calling thread. A virtual clock wants to
+	 * advance its time instead.
+	 */
+	void setDelayHandler(DelayHandler delayHandler);
+
+	typedef unsigned long (*PulseInHandler)(uint8_t pin, uint8_t state, unsigned long timeout);
+
+	/**
+	 * Replace what pulseIn measures (e. g. by echoes of a simulated world). By default, there is never a pulse.
+	 */
+	void setPulseInHandler(PulseInHandler pulseInHandler);
+
+	typedef void (*PinListener)(uint8_t pin, int value);
+
+	/**
+	 * Get notified whenever digitalWrite or analogWrite actually changes the value of a pin
+	 */
+	void setPinListener(PinListener pinListener);
+
+	/**
+	 * Redirect the output of Serial. Put nullptr to mute Serial completely (e. g. for benchmarks).
+	 */
+	void setSerialOutput(FILE *output);
+
+	int getPinMode(uint8_t pin);
+
+	int getPinValue(uint8_t pin);
+
+	/**
+	 * Set the level of an input pin as seen by digitalRead (and the analog value seen by analogRead)
+	 */
+	void setPinValue(uint8_t pin, int value);
+}
+
+#endif // ARDUINO_SHIM_H
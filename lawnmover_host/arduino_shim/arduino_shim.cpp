@@ -0,0 +1,267 @@
+#include "Arduino.h"
+
+#include <chrono>
+#include <thread>
+
+HostSerial Serial;
+
+#if defined(ARDUINO_ARCH_AVR)
+volatile uint8_t SPCR = 0;
+volatile uint8_t SPSR = 0;
+volatile uint8_t SPDR = 0;
+volatile uint8_t SREG = 0;
+volatile uint8_t PCICR = 0;
+volatile uint8_t PCMSK0 = 0;
+volatile uint8_t PCMSK1 = 0;
+volatile uint8_t PCMSK2 = 0;
+volatile uint8_t PINB = 0;
+volatile uint8_t PINC = 0;
+volatile uint8_t PIND = 0;
+#endif
+
+namespace {
+	ArduinoShim::MicrosSource _micros_source = nullptr;
+	ArduinoShim::DelayHandler _delay_handler = nullptr;
+	ArduinoShim::PulseInHandler _pulse_in_handler = nullptr;
+	ArduinoShim::PinListener _pin_listener = nullptr;
+	FILE *_serial_output = stdout;
+
+	int _pin_modes[AMOUNT_SHIM_PINS] = {0};
+	int _pin_values[AMOUNT_SHIM_PINS] = {0};
+
+	unsigned long long steadyMicros() {
+		static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - start).count();
+	}
+
+#if defined(ARDUINO_SHIM_VIRTUAL_CLOCK)
+	unsigned long long _virtual_micros = 0;
+#endif
+
+	unsigned long long nowMicros() {
+		if (_micros_source != nullptr) {
+			return _micros_source();
+		}
+#if defined(ARDUINO_SHIM_VIRTUAL_CLOCK)
+		return _virtual_micros;
+#else
+		return steadyMicros();
+#endif
+	}
+
+	void waitMicros(const unsigned long long microseconds) {
+		if (_delay_handler != nullptr) {
+			_delay_handler(microseconds);
+		} else {
+#if defined(ARDUINO_SHIM_VIRTUAL_CLOCK)
+			_virtual_micros += microseconds;
+#else
+			std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+#endif
+		}
+	}
+
+	// the port input registers read the level of output pins, too
+	void mirrorPortInput(uint8_t pin, int value) {
+#if defined(ARDUINO_ARCH_AVR)
+		volatile uint8_t *input = portInputRegister(digitalPinToPort(pin));
+		if (input != nullptr) {
+			if (value != LOW) {
+				*input |= digitalPinToBitMask(pin);
+			} else {
+				*input &= ~digitalPinToBitMask(pin);
+			}
+		}
+#endif
+	}
+
+	void writePin(uint8_t pin, int value) {
+		if (pin < AMOUNT_SHIM_PINS && _pin_values[pin] != value) {
+			_pin_values[pin] = value;
+			mirrorPortInput(pin, value);
+			if (_pin_listener != nullptr) {
+				_pin_listener(pin, value);
+			}
+		}
+	}
+}
+
+unsigned long millis() {
+	return static_cast<unsigned long>(nowMicros() / 1000ULL);
+}
+
+unsigned long micros() {
+	return static_cast<unsigned long>(nowMicros());
+}
+
+void delay(unsigned long ms) {
+	waitMicros(1000ULL * ms);
+}
+
+void delayMicroseconds(unsigned int us) {
+	waitMicros(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+	if (pin < AMOUNT_SHIM_PINS) {
+		_pin_modes[pin] = mode;
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+	writePin(pin, val == LOW ? LOW : HIGH);
+}
+
+int digitalRead(uint8_t pin) {
+	return pin < AMOUNT_SHIM_PINS && _pin_values[pin] != LOW ? HIGH : LOW;
+}
+
+int analogRead(uint8_t pin) {
+	return pin < AMOUNT_SHIM_PINS ? _pin_values[pin] : 0;
+}
+
+void analogWrite(uint8_t pin, int val) {
+	writePin(pin, val);
+}
+
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout) {
+	if (_pulse_in_handler != nullptr) {
+		return _pulse_in_handler(pin, state, timeout);
+	} else {
+		// there is no echo on the host unless somebody simulates it
+		waitMicros(timeout);
+		return 0;
+	}
+}
+
+void ArduinoShim::setMicrosSource(MicrosSource microsSource) {
+	_micros_source = microsSource;
+}
+
+void ArduinoShim::setDelayHandler(DelayHandler delayHandler) {
+	_delay_handler = delayHandler;
+}
+
+void ArduinoShim::setPulseInHandler(PulseInHandler pulseInHandler) {
+	_pulse_in_handler = pulseInHandler;
+}
+
+void ArduinoShim::setPinListener(PinListener pinListener) {
+	_pin_listener = pinListener;
+}
+
+void ArduinoShim::setSerialOutput(FILE *output) {
+	_serial_output = output;
+}
+
+int ArduinoShim::getPinMode(uint8_t pin) {
+	return pin < AMOUNT_SHIM_PINS ? _pin_modes[pin] : INPUT;
+}
+
+int ArduinoShim::getPinValue(uint8_t pin) {
+	return pin < AMOUNT_SHIM_PINS ? _pin_values[pin] : LOW;
+}
+
+void ArduinoShim::setPinValue(uint8_t pin, int value) {
+	if (pin < AMOUNT_SHIM_PINS) {
+		_pin_values[pin] = value;
+		mirrorPortInput(pin, value);
+	}
+}
+
+void HostSerial::begin(unsigned long baud) {
+	// nothing to do...
+}
+
+void HostSerial::end() {
+	if (_serial_output != nullptr) {
+		fflush(_serial_output);
+	}
+}
+
+size_t HostSerial::write(uint8_t value) {
+	if (_serial_output == nullptr) {
+		return 1;
+	} else {
+		return fputc(value, _serial_output) == EOF ? 0 : 1;
+	}
+}
+
+size_t HostSerial::write(const uint8_t *buffer, size_t size) {
+	if (_serial_output == nullptr) {
+		return size;
+	} else {
+		return fwrite(buffer, 1, size, _serial_output);
+	}
+}
+
+size_t HostSerial::print(const __FlashStringHelper *value) {
+	return print(reinterpret_cast<const char *>(value));
+}
+
+size_t HostSerial::print(const char *value) {
+	return value == nullptr ? 0 : write(reinterpret_cast<const uint8_t *>(value), strlen(value));
+}
+
+size_t HostSerial::print(char value) {
+	return write(static_cast<uint8_t>(value));
+}
+
+size_t HostSerial::print(unsigned char value, int base) {
+	return print(static_cast<unsigned long>(value), base);
+}
+
+size_t HostSerial::print(int value, int base) {
+	return print(static_cast<long>(value), base);
+}
+
+size_t HostSerial::print(unsigned int value, int base) {
+	return print(static_cast<unsigned long>(value), base);
+}
+
+size_t HostSerial::print(long value, int base) {
+	if (base == DEC && value < 0) {
+		return print('-') + printNumber(static_cast<unsigned long>(-value), base);
+	} else {
+		return printNumber(static_cast<unsigned long>(value), base);
+	}
+}
+
+size_t HostSerial::print(unsigned long value, int base) {
+	return printNumber(value, base);
+}
+
+size_t HostSerial::print(double value, int digits) {
+	char buffer[64];
+	snprintf(buffer, sizeof buffer, "%.*f", digits, value);
+	return print(buffer);
+}
+
+size_t HostSerial::println() {
+	return print("\r\n");
+}
+
+size_t HostSerial::printf(const char *format, ...) {
+	char buffer[256];
+	va_list argptr;
+	va_start(argptr, format);
+	vsnprintf(buffer, sizeof buffer, format, argptr);
+	va_end(argptr);
+	return print(buffer);
+}
+
+size_t HostSerial::printNumber(unsigned long value, int base) {
+	char buffer[8 * sizeof(long) + 1];
+	char *c = &buffer[sizeof buffer - 1];
+	*c = '\0';
+	if (base < 2) {
+		base = 10;
+	}
+	do {
+		const char digit = value % base;
+		*--c = digit < 10 ? digit + '0' : digit + 'A' - 10;
+		value /= base;
+	} while (value);
+	return print(c);
+}
@@ -0,0 +1,51 @@
+#ifndef ARDUINO_SHIM_AVR_IO_H
+#define ARDUINO_SHIM_AVR_IO_H
+
+#include <stdint.h>
+
+/**
+ * The SPI, pin change interrupt, port input (and status) registers of the ATmega328P as plain memory. There is no
+ * hardware shifting the bytes or watching the pins; the host (e. g. the simulator) exchanges a byte by swapping SPDR and
+ * calling the SPI_STC_vect interrupt routine itself. Likewise, it calls the PCINTx_vect interrupt routines upon input
+ * changes. The shim keeps PINB, PINC and PIND in sync with the pin values.
+ */
+extern volatile uint8_t SPCR;
+extern volatile uint8_t SPSR;
+extern volatile uint8_t SPDR;
+extern volatile uint8_t SREG;
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCMSK0;
+extern volatile uint8_t PCMSK1;
+extern volatile uint8_t PCMSK2;
+extern volatile uint8_t PINB;
+extern volatile uint8_t PINC;
+extern volatile uint8_t PIND;
+
+// SPCR bits
+#define SPR0 0
+#define SPR1 1
+#define CPHA 2
+#define CPOL 3
+#define MSTR 4
+#define DORD 5
+#define SPE 6
+#define SPIE 7
+
+// SPSR bits
+#define SPI2X 0
+#define WCOL 6
+#define SPIF 7
+
+// PCICR bits
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+
+#define PCINT0_vect __vector_3
+#define PCINT1_vect __vector_4
+#define PCINT2_vect __vector_5
+#define SPI_STC_vect __vector_17
+
+#define ISR(vector, ...) extern "C" void vector(void)
+
+#endif // ARDUINO_SHIM_AVR_IO_H
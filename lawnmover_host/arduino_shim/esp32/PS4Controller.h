@@ -0,0 +1,74 @@
+#ifndef ARDUINO_SHIM_PS4_CONTROLLER_H
+#define ARDUINO_SHIM_PS4_CONTROLLER_H
+
+#include <stdint.h>
+
+/**
+ * A PS4 controller that never connects, i. e. the robo pilot is always in charge on the host
+ */
+class PS4Controller {
+public:
+	bool begin(const char *mac) { return true; };
+
+	bool isConnected() { return false; };
+
+	bool Right() { return false; };
+
+	bool Down() { return false; };
+
+	bool Up() { return false; };
+
+	bool Left() { return false; };
+
+	bool Square() { return false; };
+
+	bool Cross() { return false; };
+
+	bool Circle() { return false; };
+
+	bool Triangle() { return false; };
+
+	bool L1() { return false; };
+
+	bool R1() { return false; };
+
+	bool L2() { return false; };
+
+	bool R2() { return false; };
+
+	bool Share() { return false; };
+
+	bool Options() { return false; };
+
+	bool PSButton() { return false; };
+
+	bool Touchpad() { return false; };
+
+	bool L3() { return false; };
+
+	bool R3() { return false; };
+
+	bool Charging() { return false; };
+
+	bool Audio() { return false; };
+
+	bool Mic() { return false; };
+
+	uint8_t Battery() { return 0; };
+
+	int8_t LStickX() { return 0; };
+
+	int8_t LStickY() { return 0; };
+
+	int8_t RStickX() { return 0; };
+
+	int8_t RStickY() { return 0; };
+
+	uint8_t L2Value() { return 0; };
+
+	uint8_t R2Value() { return 0; };
+};
+
+extern PS4Controller PS4;
+
+#endif // ARDUINO_SHIM_PS4_CONTROLLER_H
@@ -0,0 +1,8 @@
+#ifndef ARDUINO_SHIM_ESP32_SPI_H
+#define ARDUINO_SHIM_ESP32_SPI_H
+
+// The main core unit drives the bus through the esp-idf driver (see driver/spi_master.h), not through SPIClass
+#include <Arduino.h>
+#include "esp32-hal-spi.h"
+
+#endif // ARDUINO_SHIM_ESP32_SPI_H
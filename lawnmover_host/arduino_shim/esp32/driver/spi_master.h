@@ -0,0 +1,129 @@
+#ifndef ARDUINO_SHIM_DRIVER_SPI_MASTER_H
+#define ARDUINO_SHIM_DRIVER_SPI_MASTER_H
+
+/**
+ * The subset of the esp-idf SPI master driver used by the main core unit. The semantics follow the esp-idf
+ * documentation: a host supports up to SPI_SHIM_MAX_DEVICES devices, transactions are either transmitted blocking
+ * (interrupt based or polling) or queued (up to queue_size per device) and fetched afterwards. A transaction takes the
+ * overhead of the driver plus the time needed to clock the bits at the frequency of the device. The bytes themselves
+ * are handed to the handler set by SpiMasterShim::setTransferHandler.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_heap_caps.h"
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_TIMEOUT 0x107
+
+typedef uint32_t TickType_t;
+#define portMAX_DELAY (TickType_t) 0xffffffffUL
+
+typedef enum {
+	SPI1_HOST = 0,
+	SPI2_HOST = 1,
+	SPI3_HOST = 2,
+} spi_host_device_t;
+
+#define HSPI_HOST SPI2_HOST
+#define VSPI_HOST SPI3_HOST
+
+#define SPI_SHIM_MAX_DEVICES 3
+
+#define SPI_MASTER_FREQ_8M (80 * 1000 * 1000 / 10)
+#define SPI_MASTER_FREQ_10M (80 * 1000 * 1000 / 8)
+
+#define SPI_DEVICE_NO_DUMMY (1 << 6)
+
+typedef struct spi_transaction_t spi_transaction_t;
+
+typedef void (*transaction_cb_t)(spi_transaction_t *trans);
+
+typedef struct {
+	int mosi_io_num;
+	int miso_io_num;
+	int sclk_io_num;
+	int quadwp_io_num;
+	int quadhd_io_num;
+	int max_transfer_sz;
+	uint32_t flags;
+	int intr_flags;
+} spi_bus_config_t;
+
+typedef struct {
+	uint8_t command_bits;
+	uint8_t address_bits;
+	uint8_t dummy_bits;
+	uint8_t mode;
+	uint16_t duty_cycle_pos;
+	uint16_t cs_ena_pretrans;
+	uint8_t cs_ena_posttrans;
+	int clock_speed_hz;
+	int input_delay_ns;
+	int spics_io_num;
+	uint32_t flags;
+	int queue_size;
+	transaction_cb_t pre_cb;
+	transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+struct spi_transaction_t {
+	uint32_t flags;
+	uint16_t cmd;
+	uint64_t addr;
+	size_t length; // in bits
+	size_t rxlength; // in bits; 0 means the same as length
+	void *user;
+	union {
+		const void *tx_buffer;
+		uint8_t tx_data[4];
+	};
+	union {
+		void *rx_buffer;
+		uint8_t rx_data[4];
+	};
+};
+
+typedef struct spi_device_t *spi_device_handle_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, int dma_chan);
+
+esp_err_t spi_bus_free(spi_host_device_t host);
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config,
+							 spi_device_handle_t *handle);
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, TickType_t ticks_to_wait);
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc,
+									  TickType_t ticks_to_wait);
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc);
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc);
+
+/**
+ * Host only hooks of the driver shim
+ */
+namespace SpiMasterShim {
+	/**
+	 * Exchanges size bytes with the slave selected by cs_pin. rx may be nullptr. Returns false if nobody is listening.
+	 * The first bit is clocked at start_micros (see micros), the bytes follow each other without any gap.
+	 */
+	typedef bool (*TransferHandler)(int cs_pin, const uint8_t *tx, uint8_t *rx, size_t size, unsigned long start_micros,
+									unsigned long bit_nanoseconds);
+
+	void setTransferHandler(TransferHandler transferHandler);
+}
+
+#endif // ARDUINO_SHIM_DRIVER_SPI_MASTER_H
@@ -0,0 +1,231 @@
+#include <Arduino.h>
+#include <PS4Controller.h>
+
+#include <vector>
+
+#include "driver/spi_master.h"
+
+PS4Controller PS4;
+
+#define SPI_SHIM_AMOUNT_HOSTS 3
+// without dma, the esp32 is limited to its 64 byte hardware buffer
+#define SPI_SHIM_NO_DMA_MAX_TRANSFER_SIZE 64
+#define SPI_SHIM_DEFAULT_MAX_TRANSFER_SIZE 4092
+// rough cpu time of the driver per transaction on the esp32 (see "Transaction Duration" of the esp-idf spi master docs)
+#define SPI_SHIM_INTERRUPT_TRANSACTION_OVERHEAD_MICROSECONDS 28
+#define SPI_SHIM_POLLING_TRANSACTION_OVERHEAD_MICROSECONDS 10
+
+struct spi_queued_transaction_t {
+	spi_transaction_t *transaction;
+	// the time the last bit got clocked out
+	unsigned long done;
+};
+
+struct spi_device_t {
+	spi_host_device_t host;
+	spi_device_interface_config_t config;
+	// one bit in nanoseconds at the clock speed of the device
+	unsigned long bit_nanoseconds;
+	// ring of queue_size transactions not yet fetched by spi_device_get_trans_result
+	std::vector<spi_queued_transaction_t> transactions;
+	int transactions_front;
+	int amount_transactions;
+};
+
+namespace {
+	struct SpiHost {
+		bool initialized = false;
+		int max_transfer_size = 0;
+		int amount_devices = 0;
+		unsigned long busy_until = 0;
+	};
+
+	SpiHost _hosts[SPI_SHIM_AMOUNT_HOSTS];
+	SpiMasterShim::TransferHandler _transfer_handler = nullptr;
+
+	bool validHost(const spi_host_device_t host) {
+		return host >= 0 && host < SPI_SHIM_AMOUNT_HOSTS;
+	}
+
+	unsigned long transferDurationMicros(const spi_device_t *device, const size_t bits) {
+		return (bits * device->bit_nanoseconds + 999UL) / 1000UL;
+	}
+
+	/**
+	 * Exchanges the bytes right away but the transaction is only done after clocking all of them out (and holding
+	 * the chip select for cs_ena_posttrans bit cycles)
+	 */
+	esp_err_t startTransaction(spi_device_t *device, spi_transaction_t *trans_desc, const unsigned long overhead,
+							   unsigned long &done) {
+		if (device == nullptr || trans_desc == nullptr || trans_desc->length % 8 != 0) {
+			return ESP_ERR_INVALID_ARG;
+		}
+		SpiHost &spiHost = _hosts[device->host];
+		const size_t size = trans_desc->length / 8;
+		if (static_cast<int>(size) > spiHost.max_transfer_size) {
+			return ESP_ERR_INVALID_ARG;
+		}
+		if (trans_desc->rxlength == 0) {
+			trans_desc->rxlength = trans_desc->length;
+		}
+
+		const unsigned long now = micros();
+		const unsigned long start = (spiHost.busy_until > now ? spiHost.busy_until : now) + overhead;
+		uint8_t *rx = static_cast<uint8_t *>(trans_desc->rx_buffer);
+		const uint8_t *tx = static_cast<const uint8_t *>(trans_desc->tx_buffer);
+		if (_transfer_handler == nullptr ||
+			!_transfer_handler(device->config.spics_io_num, tx, rx, size, start, device->bit_nanoseconds)) {
+			if (rx != nullptr) {
+				memset(rx, 0, size);
+			}
+		}
+		spiHost.busy_until = start + transferDurationMicros(device, trans_desc->length +
+																	device->config.cs_ena_posttrans);
+		done = spiHost.busy_until;
+		return ESP_OK;
+	}
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+	return malloc(size);
+}
+
+void heap_caps_free(void *ptr) {
+	free(ptr);
+}
+
+void SpiMasterShim::setTransferHandler(TransferHandler transferHandler) {
+	_transfer_handler = transferHandler;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, int dma_chan) {
+	if (!validHost(host) || bus_config == nullptr || dma_chan < 0 || dma_chan > 2) {
+		return ESP_ERR_INVALID_ARG;
+	} else if (_hosts[host].initialized) {
+		return ESP_ERR_INVALID_STATE;
+	} else {
+		SpiHost &spiHost = _hosts[host];
+		spiHost.initialized = true;
+		if (dma_chan == 0) {
+			spiHost.max_transfer_size = SPI_SHIM_NO_DMA_MAX_TRANSFER_SIZE;
+		} else {
+			spiHost.max_transfer_size = bus_config->max_transfer_sz > 0 ? bus_config->max_transfer_sz
+																	   : SPI_SHIM_DEFAULT_MAX_TRANSFER_SIZE;
+		}
+		return ESP_OK;
+	}
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host) {
+	if (!validHost(host) || !_hosts[host].initialized || _hosts[host].amount_devices > 0) {
+		return ESP_ERR_INVALID_STATE;
+	} else {
+		_hosts[host] = SpiHost();
+		return ESP_OK;
+	}
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config,
+							 spi_device_handle_t *handle) {
+	if (!validHost(host) || dev_config == nullptr || handle == nullptr || dev_config->clock_speed_hz <= 0) {
+		return ESP_ERR_INVALID_ARG;
+	} else if (!_hosts[host].initialized) {
+		return ESP_ERR_INVALID_STATE;
+	} else if (_hosts[host].amount_devices >= SPI_SHIM_MAX_DEVICES) {
+		// no free chip select line left
+		return ESP_ERR_NOT_FOUND;
+	} else {
+		spi_device_t *device = new spi_device_t();
+		device->host = host;
+		device->config = *dev_config;
+		if (device->config.queue_size < 1) {
+			device->config.queue_size = 1;
+		}
+		device->bit_nanoseconds = (1000000000UL + dev_config->clock_speed_hz - 1) / dev_config->clock_speed_hz;
+		device->transactions.resize(device->config.queue_size);
+		device->transactions_front = 0;
+		device->amount_transactions = 0;
+		_hosts[host].amount_devices++;
+		*handle = device;
+		return ESP_OK;
+	}
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle) {
+	if (handle == nullptr) {
+		return ESP_ERR_INVALID_ARG;
+	} else if (handle->amount_transactions > 0) {
+		return ESP_ERR_INVALID_STATE;
+	} else {
+		_hosts[handle->host].amount_devices--;
+		delete handle;
+		return ESP_OK;
+	}
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, TickType_t ticks_to_wait) {
+	if (handle != nullptr && handle->amount_transactions >= handle->config.queue_size) {
+		// only fetching results frees the queue, i. e. waiting would not help
+		return ESP_ERR_TIMEOUT;
+	}
+	unsigned long done = 0;
+	const esp_err_t e = startTransaction(handle, trans_desc, SPI_SHIM_INTERRUPT_TRANSACTION_OVERHEAD_MICROSECONDS, done);
+	if (e == ESP_OK) {
+		const int back = (handle->transactions_front + handle->amount_transactions) % handle->config.queue_size;
+		handle->transactions[back] = {trans_desc, done};
+		handle->amount_transactions++;
+	}
+	return e;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc,
+									  TickType_t ticks_to_wait) {
+	if (handle == nullptr || trans_desc == nullptr) {
+		return ESP_ERR_INVALID_ARG;
+	} else if (handle->amount_transactions == 0) {
+		return ESP_ERR_TIMEOUT;
+	}
+
+	const spi_queued_transaction_t &front = handle->transactions[handle->transactions_front];
+	const unsigned long done = front.done;
+	const unsigned long now = micros();
+	if (done > now) {
+		const unsigned long remaining = done - now;
+		// one tick is one millisecond
+		if (ticks_to_wait != portMAX_DELAY && remaining > 1000UL * ticks_to_wait) {
+			delayMicroseconds(1000UL * ticks_to_wait);
+			return ESP_ERR_TIMEOUT;
+		}
+		delayMicroseconds(remaining);
+	}
+	*trans_desc = front.transaction;
+	handle->transactions_front = (handle->transactions_front + 1) % handle->config.queue_size;
+	handle->amount_transactions--;
+	return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc) {
+	esp_err_t e = spi_device_queue_trans(handle, trans_desc, portMAX_DELAY);
+	if (e == ESP_OK) {
+		spi_transaction_t *done = nullptr;
+		e = spi_device_get_trans_result(handle, &done, portMAX_DELAY);
+	}
+	return e;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc) {
+	if (handle != nullptr && handle->amount_transactions > 0) {
+		// polling transactions must not be mixed with queued ones
+		return ESP_ERR_INVALID_STATE;
+	}
+	unsigned long done = 0;
+	const esp_err_t e = startTransaction(handle, trans_desc, SPI_SHIM_POLLING_TRANSACTION_OVERHEAD_MICROSECONDS, done);
+	if (e == ESP_OK) {
+		// the cpu busy waits for the transaction
+		const unsigned long now = micros();
+		if (done > now) {
+			delayMicroseconds(done - now);
+		}
+	}
+	return e;
+}
@@ -0,0 +1,17 @@
+#ifndef ARDUINO_SHIM_ESP_HEAP_CAPS_H
+#define ARDUINO_SHIM_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_EXEC (1 << 0)
+#define MALLOC_CAP_32BIT (1 << 1)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+
+// Every host memory is "DMA capable"
+void *heap_caps_malloc(size_t size, uint32_t caps);
+
+void heap_caps_free(void *ptr);
+
+#endif // ARDUINO_SHIM_ESP_HEAP_CAPS_H
@@ -0,0 +1,30 @@
+#ifndef ARDUINO_SHIM_FREERTOS_FREERTOS_H
+#define ARDUINO_SHIM_FREERTOS_FREERTOS_H
+
+/**
+ * The subset of the FreeRTOS port of esp-idf used by the main core unit. The simulator runs the firmware on a single
+ * thread, thus, the spinlock of a critical section never spins; it counts its nesting only.
+ */
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t owner;
+	uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_FREE_VAL 0xB33FFFFF
+#define portMUX_INITIALIZER_UNLOCKED {portMUX_FREE_VAL, 0}
+
+inline void portENTER_CRITICAL(portMUX_TYPE *mux) {
+	mux->owner = 0;
+	mux->count++;
+}
+
+inline void portEXIT_CRITICAL(portMUX_TYPE *mux) {
+	if (--mux->count == 0) {
+		mux->owner = portMUX_FREE_VAL;
+	}
+}
+
+#endif // ARDUINO_SHIM_FREERTOS_FREERTOS_H
@@ -0,0 +1,7 @@
+#ifndef ARDUINO_SHIM_UNO_SPI_H
+#define ARDUINO_SHIM_UNO_SPI_H
+
+// The Uno firmware uses the SPI registers directly (see avr/io.h) rather than the SPI library
+#include <Arduino.h>
+
+#endif // ARDUINO_SHIM_UNO_SPI_H
@@ -0,0 +1,313 @@
+/**
+ * Coverage efficiency of the robo pilots: each pilot mows each lawn of a library of LawnWorld maps (rectangle,
+ * L-shape, trees, narrow passage and the garden of the simulator) for some simulated minutes. The pilot runs in process
+ * and in virtual time: it gets the distances of simulated ultrasonic sensors and its decisions drive the mower right
+ * away, i. e. without the firmware of the microcontrollers and the spi bus in between (see lawnmover_simulator for
+ * that). Runs are deterministic for a given seed.
+ *
+ * Prints one record per pilot and lawn as JSON (or CSV): the share of the lawn covered, the overlap ratio, the
+ * collisions, the time until 90 % of the lawn was covered and the cpu time of the decisions. With --min-coverage, the
+ * exit code tells whether every run covered at least the given share, e. g. to gate changes of a pilot:
+ *
+ *   robo_pilot_coverage_benchmark --robo-pilot=coverage_planner --min-coverage=75
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <robo_pilot.h>
+
+#include "lawn_world.h"
+
+// the main core unit exchanges with each slave once per interval, i. e. it decides once per interval, too
+#define COVERAGE_BENCHMARK_DECISION_INTERVAL_MICROSECONDS 165000ULL
+// the distance control unit reports no echo within its timeout (6000 us) as the distance of the timeout
+#define COVERAGE_BENCHMARK_MAX_DISTANCE_CM (6000.0f / 29.0f / 2.0f)
+// the engines control unit does not drive a wheel or the blade below these powers
+#define COVERAGE_BENCHMARK_MIN_WHEEL_POWER 16
+#define COVERAGE_BENCHMARK_MIN_BLADE_POWER 11
+#define COVERAGE_BENCHMARK_TARGET_COVERAGE 0.9
+
+namespace {
+	struct RoboPilotFactory {
+		const char *name;
+
+		RoboPilot *(*create)();
+	};
+
+	// Add new robo pilots here
+	const RoboPilotFactory k_robo_pilots[] = {
+			{"rule_based",       []() -> RoboPilot * { return new RuleBasedMotionStateRoboPilot(); }},
+			{"coverage_planner", []() -> RoboPilot * { return new CoveragePlannerRoboPilot(); }}};
+
+	struct Lawn {
+		const char *name;
+
+		LawnWorld (*create)();
+	};
+
+	const Lawn k_lawns[] = {
+			{"rectangle",      LawnWorld::rectangle},
+			{"l_shape",        LawnWorld::lShape},
+			{"trees",          LawnWorld::trees},
+			{"narrow_passage", LawnWorld::narrowPassage},
+			{"garden",         LawnWorld::garden}};
+
+	struct Sensor {
+		Category::Direction direction;
+		UltrasonicMount mount;
+	};
+
+	// as in the simulator (and the default sensor mounts of RoboPilot)
+	const Sensor k_sensors[] = {
+			{Category::FRONT,       {MOWER_RADIUS_METERS, 0.0, 0.0}},
+			{Category::FRONT_LEFT,  {0.8 * MOWER_RADIUS_METERS, 0.5 * MOWER_RADIUS_METERS, M_PI / 6.0}},
+			{Category::FRONT_RIGHT, {0.8 * MOWER_RADIUS_METERS, -0.5 * MOWER_RADIUS_METERS, -M_PI / 6.0}},
+			{Category::BACK_LEFT,   {-0.8 * MOWER_RADIUS_METERS, 0.5 * MOWER_RADIUS_METERS, 5.0 * M_PI / 6.0}},
+			{Category::BACK_RIGHT,  {-0.8 * MOWER_RADIUS_METERS, -0.5 * MOWER_RADIUS_METERS, -5.0 * M_PI / 6.0}}};
+
+	struct Arguments {
+		double minutes = 30.0;
+		unsigned int seed = 42;
+		double echo_noise_cm = 1.0;
+		double echo_dropout = 0.01;
+		// in percent; zero does not gate at all
+		double min_coverage = 0.0;
+		bool csv = false;
+		// all if empty
+		std::vector<std::string> robo_pilots;
+		std::vector<std::string> lawns;
+	};
+
+	struct Result {
+		const char *robo_pilot;
+		const char *lawn;
+		double coverage;
+		// share of the area swept by the blade (its odometer times its cut width) that was mowed before
+		double overlap_ratio;
+		unsigned long collisions;
+		double blocked_seconds;
+		// negative if never
+		double seconds_to_target;
+		unsigned long decisions;
+		double decision_cpu_mean_ns;
+		double decision_cpu_max_ns;
+	};
+
+	// the clock of millis and micros of the robo pilot
+	unsigned long long _now_micros = 0;
+
+	unsigned long long virtualMicros() {
+		return _now_micros;
+	}
+
+	double threadCpuNanoseconds() {
+		timespec now;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+		return now.tv_sec * 1e9 + now.tv_nsec;
+	}
+
+	int toEnginePower(const int power, const int min_power) {
+		const int limited = std::max(-MOWER_MAX_ENGINE_POWER, std::min(MOWER_MAX_ENGINE_POWER, power));
+		return std::abs(limited) < min_power ? 0 : limited;
+	}
+
+	bool matchArgument(const char *argument, const char *name, const char **value) {
+		const size_t length = strlen(name);
+		if (strncmp(argument, name, length) == 0 && argument[length] == '=') {
+			*value = argument + length + 1;
+			return true;
+		}
+		return false;
+	}
+
+	template<typename T, size_t N>
+	bool contains(const T (&entries)[N], const char *name) {
+		for (const T &entry : entries) {
+			if (strcmp(entry.name, name) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool selected(const std::vector<std::string> &names, const char *name) {
+		if (names.empty()) {
+			return true;
+		}
+		for (const std::string &selected : names) {
+			if (selected == name) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool parseArguments(int argc, char **argv, Arguments &arguments) {
+		for (int i = 1; i < argc; i++) {
+			const char *value = nullptr;
+			if (matchArgument(argv[i], "--minutes", &value)) {
+				arguments.minutes = atof(value);
+			} else if (matchArgument(argv[i], "--seed", &value)) {
+				arguments.seed = static_cast<unsigned int>(strtoul(value, nullptr, 10));
+			} else if (matchArgument(argv[i], "--echo-noise-cm", &value)) {
+				arguments.echo_noise_cm = atof(value);
+			} else if (matchArgument(argv[i], "--echo-dropout", &value)) {
+				arguments.echo_dropout = atof(value);
+			} else if (matchArgument(argv[i], "--min-coverage", &value)) {
+				arguments.min_coverage = atof(value);
+			} else if (matchArgument(argv[i], "--format", &value) && (strcmp(value, "json") == 0 ||
+																	  strcmp(value, "csv") == 0)) {
+				arguments.csv = strcmp(value, "csv") == 0;
+			} else if (matchArgument(argv[i], "--robo-pilot", &value) && contains(k_robo_pilots, value)) {
+				arguments.robo_pilots.push_back(value);
+			} else if (matchArgument(argv[i], "--lawn", &value) && contains(k_lawns, value)) {
+				arguments.lawns.push_back(value);
+			} else {
+				fprintf(stderr,
+						"Usage: %s [--minutes=<simulated minutes>] [--seed=<n>] [--format=<json|csv>]\n"
+						"          [--robo-pilot=<rule_based|coverage_planner>]...\n"
+						"          [--lawn=<rectangle|l_shape|trees|narrow_passage|garden>]...\n"
+						"          [--echo-noise-cm=<cm>] [--echo-dropout=<probability>]\n"
+						"          [--min-coverage=<percent>]\n",
+						argv[0]);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	Result run(const RoboPilotFactory &roboPilotFactory, const Lawn &lawn, const Arguments &arguments) {
+		Result result = {roboPilotFactory.name, lawn.name, 0.0, 0.0, 0, 0.0, -1.0, 0, 0.0, 0.0};
+		LawnWorld world = lawn.create();
+		std::mt19937 random(arguments.seed);
+		std::normal_distribution<double> echo_noise(0.0, arguments.echo_noise_cm);
+		std::uniform_real_distribution<double> echo_dropout(0.0, 1.0);
+
+		_now_micros = 0;
+		RoboPilot *roboPilot = roboPilotFactory.create();
+		double decision_cpu_ns = 0.0;
+		const unsigned long long end = static_cast<unsigned long long>(arguments.minutes * 60e6);
+		for (; _now_micros < end; _now_micros += COVERAGE_BENCHMARK_DECISION_INTERVAL_MICROSECONDS) {
+			world.advanceTo(_now_micros);
+			if (result.seconds_to_target < 0.0 && world.getCoverage() >= COVERAGE_BENCHMARK_TARGET_COVERAGE) {
+				result.seconds_to_target = _now_micros / 1e6;
+			}
+
+			for (const Sensor &sensor : k_sensors) {
+				const double distance = world.measureDistance(sensor.mount, COVERAGE_BENCHMARK_MAX_DISTANCE_CM / 100.0);
+				float distance_cm = COVERAGE_BENCHMARK_MAX_DISTANCE_CM;
+				if (distance >= 0.0 && echo_dropout(random) >= arguments.echo_dropout) {
+					const double noisy = 100.0 * distance + (arguments.echo_noise_cm > 0.0 ? echo_noise(random) : 0.0);
+					distance_cm = static_cast<float>(std::max(0.0, std::min(noisy,
+																			 (double) COVERAGE_BENCHMARK_MAX_DISTANCE_CM)));
+				}
+				roboPilot->putSensorDistance(sensor.direction, distance_cm);
+			}
+
+			const double start_ns = threadCpuNanoseconds();
+			const MovementDecision movementDecision = roboPilot->makeMovementDecision();
+			const double cpu_ns = threadCpuNanoseconds() - start_ns;
+			decision_cpu_ns += cpu_ns;
+			result.decision_cpu_max_ns = std::max(result.decision_cpu_max_ns, cpu_ns);
+			result.decisions++;
+
+			roboPilot->putMovementDecision(movementDecision);
+			world.setLeftWheelPower(toEnginePower(movementDecision.get_left_wheel_power(),
+												  COVERAGE_BENCHMARK_MIN_WHEEL_POWER));
+			world.setRightWheelPower(toEnginePower(movementDecision.get_right_wheel_power(),
+												   COVERAGE_BENCHMARK_MIN_WHEEL_POWER));
+			world.setBladePower(toEnginePower(movementDecision.get_blade_motor_power(),
+											  COVERAGE_BENCHMARK_MIN_BLADE_POWER));
+		}
+		world.advanceTo(end);
+		delete roboPilot;
+
+		result.coverage = world.getCoverage();
+		const double swept_area = world.getBladeOdometer() * 2.0 * MOWER_CUT_RADIUS_METERS;
+		result.overlap_ratio = swept_area > world.getCoveredArea() ? 1.0 - world.getCoveredArea() / swept_area : 0.0;
+		result.collisions = world.getCollisions();
+		result.blocked_seconds = world.getBlockedMicros() / 1e6;
+		result.decision_cpu_mean_ns = result.decisions > 0 ? decision_cpu_ns / result.decisions : 0.0;
+		return result;
+	}
+
+	void printJson(const Arguments &arguments, const std::vector<Result> &results) {
+		printf("{\n");
+		printf("  \"context\": {\"minutes\": %g, \"seed\": %u, \"echo_noise_cm\": %g, \"echo_dropout\": %g, "
+			   "\"decision_interval_ms\": %llu},\n", arguments.minutes, arguments.seed, arguments.echo_noise_cm,
+			   arguments.echo_dropout, COVERAGE_BENCHMARK_DECISION_INTERVAL_MICROSECONDS / 1000ULL);
+		printf("  \"runs\": [\n");
+		for (size_t i = 0; i < results.size(); i++) {
+			const Result &result = results[i];
+			char seconds_to_target[32] = "null";
+			if (result.seconds_to_target >= 0.0) {
+				snprintf(seconds_to_target, sizeof(seconds_to_target), "%.1f", result.seconds_to_target);
+			}
+			printf("    {\"robo_pilot\": \"%s\", \"lawn\": \"%s\", \"coverage_percent\": %.2f, "
+				   "\"overlap_ratio\": %.3f, \"collisions\": %lu, \"blocked_seconds\": %.1f, "
+				   "\"seconds_to_90_percent\": %s, \"decisions\": %lu, \"decision_cpu_mean_ns\": %.0f, "
+				   "\"decision_cpu_max_ns\": %.0f}%s\n",
+				   result.robo_pilot, result.lawn, 100.0 * result.coverage, result.overlap_ratio, result.collisions,
+				   result.blocked_seconds, seconds_to_target, result.decisions, result.decision_cpu_mean_ns,
+				   result.decision_cpu_max_ns, i + 1 < results.size() ? "," : "");
+		}
+		printf("  ]\n");
+		printf("}\n");
+	}
+
+	void printCsv(const std::vector<Result> &results) {
+		printf("robo_pilot,lawn,coverage_percent,overlap_ratio,collisions,blocked_seconds,seconds_to_90_percent,"
+			   "decisions,decision_cpu_mean_ns,decision_cpu_max_ns\n");
+		for (const Result &result : results) {
+			// never reaching 90 % leaves the field empty
+			char seconds_to_target[32] = "";
+			if (result.seconds_to_target >= 0.0) {
+				snprintf(seconds_to_target, sizeof(seconds_to_target), "%.1f", result.seconds_to_target);
+			}
+			printf("%s,%s,%.2f,%.3f,%lu,%.1f,%s,%lu,%.0f,%.0f\n", result.robo_pilot, result.lawn,
+				   100.0 * result.coverage, result.overlap_ratio, result.collisions, result.blocked_seconds,
+				   seconds_to_target, result.decisions, result.decision_cpu_mean_ns, result.decision_cpu_max_ns);
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	Arguments arguments;
+	if (!parseArguments(argc, argv, arguments)) {
+		return 1;
+	}
+	// the pilots log through Serial; keep the output machine readable
+	ArduinoShim::setSerialOutput(nullptr);
+	SerialLogger::init(9600, SerialLogger::LOG_LEVEL::INFO);
+	ArduinoShim::setMicrosSource(virtualMicros);
+
+	std::vector<Result> results;
+	for (const RoboPilotFactory &roboPilotFactory : k_robo_pilots) {
+		for (const Lawn &lawn : k_lawns) {
+			if (selected(arguments.robo_pilots, roboPilotFactory.name) && selected(arguments.lawns, lawn.name)) {
+				results.push_back(run(roboPilotFactory, lawn, arguments));
+			}
+		}
+	}
+	if (arguments.csv) {
+		printCsv(results);
+	} else {
+		printJson(arguments, results);
+	}
+
+	int exit_code = 0;
+	for (const Result &result : results) {
+		if (100.0 * result.coverage < arguments.min_coverage) {
+			fprintf(stderr, "%s covered %.2f %% of %s only, less than %.2f %%\n", result.robo_pilot,
+					100.0 * result.coverage, result.lawn, arguments.min_coverage);
+			exit_code = 2;
+		}
+	}
+	return exit_code;
+}
@@ -0,0 +1,253 @@
+/**
+ * Native latency benchmarks of the robo pilot. Run them before flashing a changed robo pilot and compare against the
+ * numbers of the previous firmware (e. g. with --benchmark_out=<file> --benchmark_out_format=json and
+ * compare.py of Google Benchmark).
+ *
+ * Besides the synthetic distance streams, a recorded stream can be replayed with --distance_stream=<file>. The file
+ * holds one sample per line with the five distances in cm in the order of Category::Direction, i. e.
+ * FRONT,FRONT_LEFT,FRONT_RIGHT,BACK_LEFT,BACK_RIGHT. Empty lines and lines starting with '#' are skipped.
+ */
+#include <benchmark/benchmark.h>
+
+#include <robo_pilot.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	typedef std::vector<DirectionArray<float>> DistanceStream;
+
+	const int k_stream_length = 4096;
+	const char *k_distance_stream_argument = "--distance_stream=";
+
+	/**
+	 * The rule based robo pilot hard-codes its buffer size, so, this one allows measuring putSensorDistance for other
+	 * buffer sizes.
+	 */
+	class BenchmarkRoboPilot : public RoboPilot {
+	public:
+		explicit BenchmarkRoboPilot(const int distances_buffer_size) :
+				RoboPilot("BenchmarkRoboPilot", distances_buffer_size) {
+			// nothing to do...
+		};
+
+		MovementDecision makeMovementDecision() override {
+			return StopMovementDecision();
+		};
+	};
+
+	/**
+	 * Nothing in range at all, i. e. the pilot wants to stay at full speed
+	 */
+	DistanceStream openFieldStream() {
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> noise(-5.0f, 5.0f);
+		DistanceStream stream(k_stream_length);
+		for (DirectionArray<float> &sample : stream) {
+			for (int i = 0; i < DirectionArray<float>::size(); i++) {
+				sample[DirectionArray<float>::directionAt(i)] = 2 * MAX_DISTANCE + noise(generator);
+			}
+		}
+		return stream;
+	}
+
+	/**
+	 * Repeatedly driving towards an obstacle until it is too close, i. e. the pilot cycles through all speeds and the
+	 * collision avoidance motions
+	 */
+	DistanceStream approachStream() {
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> noise(-2.0f, 2.0f);
+		const int approach_length = 64;
+		DistanceStream stream(k_stream_length);
+		for (int s = 0; s < k_stream_length; s++) {
+			const float progress = static_cast<float>(s % approach_length) / approach_length;
+			const float front = 1.5f * MAX_DISTANCE * (1.0f - progress) + noise(generator);
+			DirectionArray<float> &sample = stream[s];
+			sample[Category::FRONT] = front;
+			sample[Category::FRONT_LEFT] = 1.2f * front + noise(generator);
+			sample[Category::FRONT_RIGHT] = 1.1f * front + noise(generator);
+			sample[Category::BACK_LEFT] = 2 * MAX_DISTANCE + noise(generator);
+			sample[Category::BACK_RIGHT] = 2 * MAX_DISTANCE + noise(generator);
+		}
+		return stream;
+	}
+
+	/**
+	 * Uniformly distributed distances, i. e. the worst case of flapping states
+	 */
+	DistanceStream noisyStream() {
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> distance(0.0f, 2 * MAX_DISTANCE);
+		DistanceStream stream(k_stream_length);
+		for (DirectionArray<float> &sample : stream) {
+			for (int i = 0; i < DirectionArray<float>::size(); i++) {
+				sample[DirectionArray<float>::directionAt(i)] = distance(generator);
+			}
+		}
+		return stream;
+	}
+
+	bool loadStream(const std::string &path, DistanceStream &stream) {
+		std::ifstream file(path);
+		if (!file) {
+			return false;
+		}
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.empty() || line[0] == '#') {
+				continue;
+			}
+			std::replace(line.begin(), line.end(), ',', ' ');
+			std::istringstream values(line);
+			DirectionArray<float> sample;
+			int i = 0;
+			for (; i < DirectionArray<float>::size() && values >> sample[DirectionArray<float>::directionAt(i)]; i++);
+			if (i == DirectionArray<float>::size()) {
+				stream.push_back(sample);
+			}
+		}
+		return !stream.empty();
+	}
+
+	void putSample(RoboPilot &roboPilot, const DirectionArray<float> &sample) {
+		for (int i = 0; i < DirectionArray<float>::size(); i++) {
+			const Category::Direction direction = DirectionArray<float>::directionAt(i);
+			roboPilot.putSensorDistance(direction, sample[direction]);
+		}
+	}
+
+	void BM_PutSensorDistance(benchmark::State &state) {
+		const DistanceStream stream = noisyStream();
+		BenchmarkRoboPilot roboPilot(static_cast<int>(state.range(0)));
+		// start with full histories as on the mower
+		for (int s = 0; s < state.range(0); s++) {
+			putSample(roboPilot, stream[s % stream.size()]);
+		}
+
+		size_t s = 0;
+		int i = 0;
+		for (auto _ : state) {
+			const Category::Direction direction = DirectionArray<float>::directionAt(i);
+			roboPilot.putSensorDistance(direction, stream[s][direction]);
+			if (++i == DirectionArray<float>::size()) {
+				i = 0;
+				s = s + 1 == stream.size() ? 0 : s + 1;
+			}
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	/**
+	 * Latency of makeMovementDecision only. The distances of the next sample are put between two decisions (as the
+	 * main core unit does), but not measured. Besides the mean, the worst decision is reported as max_ns.
+	 */
+	void BM_MakeMovementDecision(benchmark::State &state, const DistanceStream *stream) {
+		RuleBasedMotionStateRoboPilot roboPilot;
+		size_t s = 0;
+		double max_seconds = 0.0;
+		for (auto _ : state) {
+			putSample(roboPilot, (*stream)[s]);
+			s = s + 1 == stream->size() ? 0 : s + 1;
+
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			const MovementDecision movementDecision = roboPilot.makeMovementDecision();
+			const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			benchmark::DoNotOptimize(movementDecision);
+
+			const double seconds = std::chrono::duration<double>(end - start).count();
+			max_seconds = std::max(max_seconds, seconds);
+			state.SetIterationTime(seconds);
+		}
+		state.counters["max_ns"] = benchmark::Counter(max_seconds * 1e9, benchmark::Counter::kAvgThreads);
+	}
+
+	/**
+	 * A full cycle of the main core unit: put one distance per direction and decide
+	 */
+	void BM_DecisionCycle(benchmark::State &state, const DistanceStream *stream) {
+		RuleBasedMotionStateRoboPilot roboPilot;
+		size_t s = 0;
+		for (auto _ : state) {
+			putSample(roboPilot, (*stream)[s]);
+			s = s + 1 == stream->size() ? 0 : s + 1;
+			benchmark::DoNotOptimize(roboPilot.makeMovementDecision());
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	/**
+	 * The motion state machine only, i. e. without the histories and filters. The samples are taken as the weighted
+	 * moving averages and as the min distances. Besides the time, the predicates evaluated per decision are reported;
+	 * each is evaluated at most once, i. e. never more than AMOUNT_MOTION_PREDICATES.
+	 */
+	void BM_MotionStateMachine(benchmark::State &state, const DistanceStream *stream) {
+		MotionStateMachine motionStateMachine;
+		size_t s = 0;
+		int64_t evaluated_predicates = 0;
+		for (auto _ : state) {
+			const DirectionArray<float> &sample = (*stream)[s];
+			s = s + 1 == stream->size() ? 0 : s + 1;
+			MotionPredicates predicates(sample, sample);
+			benchmark::DoNotOptimize(motionStateMachine.next(predicates));
+			evaluated_predicates += __builtin_popcount(predicates.get_evaluated());
+		}
+		state.counters["predicates"] = benchmark::Counter(static_cast<double>(evaluated_predicates),
+														  benchmark::Counter::kAvgIterations);
+	}
+
+	void registerStream(const std::string &name, const DistanceStream *stream) {
+		benchmark::RegisterBenchmark(("BM_MakeMovementDecision/" + name).c_str(), BM_MakeMovementDecision, stream)
+				->UseManualTime();
+		benchmark::RegisterBenchmark(("BM_DecisionCycle/" + name).c_str(), BM_DecisionCycle, stream);
+		benchmark::RegisterBenchmark(("BM_MotionStateMachine/" + name).c_str(), BM_MotionStateMachine, stream);
+	}
+}
+
+BENCHMARK(BM_PutSensorDistance)->Arg(10)->Arg(100)->Arg(1000);
+
+int main(int argc, char **argv) {
+	// The firmware logs at INFO, too. However, the output itself is not part of the measurement.
+	ArduinoShim::setSerialOutput(nullptr);
+	SerialLogger::init(9600, SerialLogger::LOG_LEVEL::INFO);
+
+	const DistanceStream openField = openFieldStream();
+	const DistanceStream approach = approachStream();
+	const DistanceStream noisy = noisyStream();
+	DistanceStream recorded;
+
+	std::vector<char *> arguments;
+	for (int i = 0; i < argc; i++) {
+		const std::string argument = argv[i];
+		if (argument.compare(0, strlen(k_distance_stream_argument), k_distance_stream_argument) == 0) {
+			const std::string path = argument.substr(strlen(k_distance_stream_argument));
+			if (!loadStream(path, recorded)) {
+				fprintf(stderr, "Cannot read any distance sample from %s\n", path.c_str());
+				return 1;
+			}
+		} else {
+			arguments.push_back(argv[i]);
+		}
+	}
+	int benchmark_argc = static_cast<int>(arguments.size());
+
+	registerStream("open_field", &openField);
+	registerStream("approach", &approach);
+	registerStream("noisy", &noisy);
+	if (!recorded.empty()) {
+		registerStream("recorded", &recorded);
+	}
+
+	benchmark::Initialize(&benchmark_argc, arguments.data());
+	if (benchmark::ReportUnrecognizedArguments(benchmark_argc, arguments.data())) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * Native micro benchmarks of the frames of the main core unit, i. e. of MasterSpiSlave::supply and of
+ * MasterSpiSlave::consume for the answers of a healthy slave. Each frame format is measured with the commands of the
+ * engines control unit (data pushes) and of the distance control unit (data requests). Compare the numbers before and
+ * after changing the parser (e. g. with --benchmark_out=<file> --benchmark_out_format=json and compare.py of Google Benchmark).
+ */
+#include <benchmark/benchmark.h>
+
+#include <master_spi_slave.h>
+
+#include <array>
+#include <cstring>
+
+namespace {
+	typedef std::array<uint8_t, OBSTACLE_COMMANDS * COMMAND_FRAME_SIZE + COMMAND_SPI_RX_OFFSET> Answer;
+	// by sequence number
+	typedef std::array<Answer, 256> Answers;
+
+	const DistanceSample k_sample = DistanceSample::from(123.4f, 17);
+
+	void skipDelays(unsigned long long) {
+		// the constructor of MasterSpiSlave waits for a second
+	}
+
+	/**
+	 * A slave with the consecutive commands starting at first_command_id. Its data requests are answered with k_sample.
+	 */
+	class BenchmarkSlave : public MasterSpiSlave {
+	public:
+		BenchmarkSlave(const int16_t first_command_id, const int amount_commands, const FrameFormat frame_format) :
+				MasterSpiSlave(new SpiSlaveHandler(), 0, "BenchmarkSlave", 0, 0,
+							   SpiCommandTable::get(first_command_id).direction == DATA_PUSH ? amount_commands : 0,
+							   SpiCommandTable::get(first_command_id).direction == DATA_REQUEST ? amount_commands : 0,
+							   first_command_id, frame_format),
+				k_first_command_id(first_command_id), k_amount_commands(amount_commands) {
+			for (int i = 0; i < amount_commands; i++) {
+				_data_request_callbacks[first_command_id + i] = [this](DistanceSample sample) -> void {
+					_distance_sum += sample.getDistance();
+				};
+			}
+		};
+
+		void fill_commands_bytes(uint8_t *tx_buffer) override {
+			for (int i = 0; i < k_amount_commands; i++) {
+				const int16_t id = (int16_t) (k_first_command_id + i);
+				if (SpiCommandTable::get(id).direction == DATA_PUSH) {
+					put_command(i, id, (int16_t) (100 * i - 255), tx_buffer);
+				} else {
+					put_command(i, id, DATA_REQUEST_VALUE_BYTES, tx_buffer);
+				}
+			}
+		};
+
+		bool consume_commands(uint8_t *slave_response_buffer, long slave_response_buffer_size,
+							  uint8_t *tx_buffer) override {
+			return interpret_communication(tx_buffer, slave_response_buffer, slave_response_buffer_size,
+										   _data_request_callbacks);
+		};
+
+		/**
+		 * Synchronize with the slave and put the answers of the slave to the next frames by their sequence number (the
+		 * legacy frames have none)
+		 *
+		 * @return the size of the frames
+		 */
+		long prepare(Answers &answers) {
+			long size;
+			const uint8_t *tx_buffer = supply(size);
+			Answer start_sequence_answer = {0};
+			memcpy(start_sequence_answer.data() + COMMAND_SPI_RX_OFFSET, tx_buffer, size - COMMAND_SPI_RX_OFFSET);
+			consume(start_sequence_answer.data(), size);
+
+			tx_buffer = supply(size);
+			Answer request = {0};
+			memcpy(request.data(), tx_buffer, size);
+			for (int sequence = 0; sequence < (int) answers.size(); sequence++) {
+				request[1] = (uint8_t) sequence;
+				answer(get_frame_format() == LEGACY ? tx_buffer : request.data(), size, answers[sequence].data());
+			}
+			return size;
+		};
+
+		float get_distance_sum() const {
+			return _distance_sum;
+		};
+
+	private:
+		void answer(const uint8_t *tx_buffer, const long size, uint8_t *rx_buffer) const {
+			memset(rx_buffer, 0, size);
+			if (get_frame_format() == LEGACY) {
+				for (int i = 0; i < k_amount_commands; i++) {
+					const int16_t id = (int16_t) (k_first_command_id + i);
+					uint8_t *command = rx_buffer + COMMAND_SPI_RX_OFFSET + i * COMMAND_FRAME_SIZE;
+					memcpy(command, tx_buffer + i * COMMAND_FRAME_SIZE,
+						   COMMAND_FRAME_ID_SIZE + COMMAND_FRAME_VALUE_SIZE);
+					if (SpiCommandTable::get(id).direction == DATA_REQUEST) {
+						memcpy(command + COMMAND_FRAME_ID_SIZE, &k_sample, sizeof k_sample);
+					}
+					memcpy(command + COMMAND_FRAME_ID_SIZE + COMMAND_FRAME_VALUE_SIZE, &id, sizeof id);
+				}
+				return;
+			}
+
+			// the pipelined answer has no rx offset, but is one frame late (the same frame here)
+			const long rx_offset = get_frame_format() == COMPACT ? COMMAND_SPI_RX_OFFSET : 0;
+			const long crc_index = size - COMPACT_FRAME_CRC_SIZE - rx_offset;
+			uint8_t *slave_frame = rx_buffer + rx_offset;
+			memcpy(slave_frame, tx_buffer, crc_index);
+			for (int i = 0; i < k_amount_commands; i++) {
+				const int16_t id = (int16_t) (k_first_command_id + i);
+				if (SpiCommandTable::get(id).direction == DATA_REQUEST) {
+					memcpy(slave_frame + SpiCommands::getCompactValueOffset(k_first_command_id, i), &k_sample,
+						   sizeof k_sample);
+				}
+			}
+			slave_frame[crc_index] = SpiCommands::computeCrc8(slave_frame, crc_index);
+		};
+
+		const int16_t k_first_command_id;
+		const int k_amount_commands;
+
+		DataRequestCallbacks<DistanceSample> _data_request_callbacks;
+		float _distance_sum = 0.0f;
+	};
+
+	/**
+	 * A frame of the main core unit: supplying the frame and consuming the answer of the slave. The pipelined slave
+	 * answers the previous frame.
+	 */
+	void BM_FrameCycle(benchmark::State &state, const int16_t first_command_id, const int amount_commands,
+					   const MasterSpiSlave::FrameFormat frame_format) {
+		ArduinoShim::setDelayHandler(skipDelays);
+		BenchmarkSlave slave(first_command_id, amount_commands, frame_format);
+		Answers *answers = new Answers();
+		long size = slave.prepare(*answers);
+		// the first frame after synchronizing is not answered by a pipelined slave
+		uint8_t sequence = 1;
+		slave.consume((*answers)[sequence].data(), size);
+
+		for (auto _ : state) {
+			slave.supply(size);
+			sequence++;
+			Answer &answer = (*answers)[frame_format == MasterSpiSlave::PIPELINED ? (uint8_t) (sequence - 1)
+																				   : sequence];
+			if (!slave.consume(answer.data(), size)) {
+				state.SkipWithError("The frame was rejected");
+				break;
+			}
+		}
+		delete answers;
+		benchmark::DoNotOptimize(slave.get_distance_sum());
+		state.SetBytesProcessed(state.iterations() * size);
+		state.SetItemsProcessed(state.iterations() * amount_commands);
+	}
+}
+
+BENCHMARK_CAPTURE(BM_FrameCycle, engines_legacy, LEFT_WHEEL_STEERING_COMMAND, ENGINE_COMMANDS,
+				  MasterSpiSlave::LEGACY);
+BENCHMARK_CAPTURE(BM_FrameCycle, engines_compact, LEFT_WHEEL_STEERING_COMMAND, ENGINE_COMMANDS,
+				  MasterSpiSlave::COMPACT);
+BENCHMARK_CAPTURE(BM_FrameCycle, engines_pipelined, LEFT_WHEEL_STEERING_COMMAND, ENGINE_COMMANDS,
+				  MasterSpiSlave::PIPELINED);
+BENCHMARK_CAPTURE(BM_FrameCycle, obstacles_legacy, OBSTACLE_FRONT_COMMAND, OBSTACLE_COMMANDS,
+				  MasterSpiSlave::LEGACY);
+BENCHMARK_CAPTURE(BM_FrameCycle, obstacles_compact, OBSTACLE_FRONT_COMMAND, OBSTACLE_COMMANDS,
+				  MasterSpiSlave::COMPACT);
+BENCHMARK_CAPTURE(BM_FrameCycle, obstacles_pipelined, OBSTACLE_FRONT_COMMAND, OBSTACLE_COMMANDS,
+				  MasterSpiSlave::PIPELINED);
+
+BENCHMARK_MAIN();
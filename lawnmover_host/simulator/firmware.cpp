@@ -0,0 +1,192 @@
+#include "firmware.h"
+
+#include <dlfcn.h>
+#include <stdexcept>
+
+#include "simulator.h"
+
+Firmware::Firmware(Simulator *simulator, const char *name, const std::string &module_path, FILE *serial_output) :
+		k_simulator(simulator), k_name(name), k_module_path(module_path) {
+	_hooks.context = this;
+	_hooks.serial_output = serial_output;
+	_hooks.now = &_now;
+	_hooks.boot_time = &_boot_time;
+	_hooks.delay = hostDelay;
+	_hooks.pin_changed = hostPinChanged;
+	_hooks.pulse_in = hostPulseIn;
+	_hooks.spi_transfer = hostSpiTransfer;
+	_firmware = LawnmoverFirmware();
+	for (int &value : _pin_values) {
+		value = 0;
+	}
+}
+
+Firmware::~Firmware() {
+	powerOff();
+}
+
+void Firmware::powerOn(const unsigned long long now) {
+	if (isPowered()) {
+		return;
+	}
+	// Modules are built without unique symbols, thus, unloading a module really drops all of its state
+	void *stale_handle = dlopen(k_module_path.c_str(), RTLD_NOW | RTLD_LOCAL | RTLD_NOLOAD);
+	if (stale_handle != nullptr) {
+		dlclose(stale_handle);
+		throw std::runtime_error(std::string("Firmware module is still loaded after power off: ") + k_module_path);
+	}
+	_handle = dlopen(k_module_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (_handle == nullptr) {
+		throw std::runtime_error(std::string("Cannot load firmware module: ") + dlerror());
+	}
+	LawnmoverFirmwareAttach attach = reinterpret_cast<LawnmoverFirmwareAttach>(
+			dlsym(_handle, LAWNMOVER_FIRMWARE_ATTACH_SYMBOL));
+	if (attach == nullptr) {
+		throw std::runtime_error(std::string("Firmware module has no attach function: ") + k_module_path);
+	}
+
+	_now = now > _now ? now : _now;
+	_boot_time = _now;
+	_power_cycles++;
+	attach(&_hooks, &_firmware);
+	_firmware.setup();
+	scheduleWakeUp();
+}
+
+void Firmware::powerOff() {
+	if (!isPowered()) {
+		return;
+	}
+	dlclose(_handle);
+	_handle = nullptr;
+	_firmware = LawnmoverFirmware();
+	_spi_isr_done_nanoseconds = 0;
+	_pin_inputs.clear();
+	for (int pin = 0; pin < 64; pin++) {
+		if (_pin_values[pin] != 0) {
+			_pin_values[pin] = 0;
+			k_simulator->onPinChanged(this, pin, 0);
+		}
+	}
+}
+
+void Firmware::runLoop() {
+	advanceTo(_wake_up);
+	_firmware.loop();
+	scheduleWakeUp();
+}
+
+uint8_t Firmware::spiExchange(const uint8_t mosi, const unsigned long long start_nanoseconds,
+							  const unsigned long long end_nanoseconds, const unsigned long isr_nanoseconds) {
+	const bool write_collision = start_nanoseconds < _spi_isr_done_nanoseconds;
+	if (write_collision) {
+		_spi_write_collisions++;
+	}
+	// the interrupt routine runs at the time of the master, even if this one is idle since a while
+	advanceTo(end_nanoseconds / 1000ULL);
+	_spi_isr_done_nanoseconds = end_nanoseconds + isr_nanoseconds;
+	return _firmware.spi_exchange(mosi, write_collision);
+}
+
+void Firmware::spiExchange(const uint8_t *mosi, uint8_t *miso, const size_t size,
+						   const unsigned long long start_nanoseconds, const unsigned long long byte_nanoseconds,
+						   const unsigned long isr_nanoseconds) {
+	const unsigned long long end_nanoseconds = start_nanoseconds + size * byte_nanoseconds;
+	if (size == 0) {
+		return;
+	} else if (!_pin_inputs.empty() && _pin_inputs.begin()->first <= end_nanoseconds / 1000ULL) {
+		// the pin inputs in between interrupt the transfer
+		unsigned long long byte_start_nanoseconds = start_nanoseconds;
+		for (size_t i = 0; i < size; i++) {
+			const uint8_t received = spiExchange(mosi == nullptr ? 0 : mosi[i], byte_start_nanoseconds,
+												 byte_start_nanoseconds + byte_nanoseconds, isr_nanoseconds);
+			byte_start_nanoseconds += byte_nanoseconds;
+			if (miso != nullptr) {
+				miso[i] = received;
+			}
+		}
+		return;
+	}
+	// each further byte starts right when the previous one ended, i. e. before its interrupt routine is done
+	const bool first_write_collision = start_nanoseconds < _spi_isr_done_nanoseconds;
+	const bool write_collisions = isr_nanoseconds > 0;
+	_spi_write_collisions += (first_write_collision ? 1 : 0) + (write_collisions ? size - 1 : 0);
+	advanceTo(end_nanoseconds / 1000ULL);
+	_spi_isr_done_nanoseconds = end_nanoseconds + isr_nanoseconds;
+	_firmware.spi_exchange_bytes(mosi, miso, size, first_write_collision, write_collisions);
+}
+
+void Firmware::schedulePinInput(const uint8_t pin, const int value, const unsigned long long at, const bool wake_up) {
+	_pin_inputs.insert(std::make_pair(at, PinInput{pin, value, wake_up}));
+	if (wake_up) {
+		wakeUpAt(at);
+	}
+}
+
+void Firmware::wakeUpAt(const unsigned long long at) {
+	if (at < _wake_up) {
+		_wake_up = at > _now ? at : _now;
+	}
+}
+
+int Firmware::getPinValue(const uint8_t pin) const {
+	return pin < 64 ? _pin_values[pin] : 0;
+}
+
+void Firmware::scheduleWakeUp() {
+	// the timer of the sketch works on millis; wake up at the millisecond its next task is due
+	const unsigned long long millis_since_boot = (_now - _boot_time) / 1000ULL;
+	const unsigned long long wake_up = _boot_time + 1000ULL * (millis_since_boot + _firmware.next_timer_millis());
+	_wake_up = wake_up > _now ? wake_up : _now;
+	// the pin change interrupt routines leaving work for the loop run at the very time of the pin input; wake up for
+	// them, too
+	for (auto pin_input = _pin_inputs.begin(); pin_input != _pin_inputs.end() && pin_input->first < _wake_up;
+		 ++pin_input) {
+		if (pin_input->second.wake_up) {
+			_wake_up = pin_input->first > _now ? pin_input->first : _now;
+			break;
+		}
+	}
+}
+
+void Firmware::advanceTo(const unsigned long long now) {
+	while (!_pin_inputs.empty() && _pin_inputs.begin()->first <= now) {
+		const auto pin_input = *_pin_inputs.begin();
+		_pin_inputs.erase(_pin_inputs.begin());
+		if (pin_input.first > _now) {
+			_now = pin_input.first;
+		}
+		_firmware.pin_input(pin_input.second.pin, pin_input.second.value);
+	}
+	if (now > _now) {
+		_now = now;
+	}
+}
+
+void Firmware::hostDelay(void *context, unsigned long long microseconds) {
+	Firmware *firmware = static_cast<Firmware *>(context);
+	firmware->advanceTo(firmware->_now + microseconds);
+}
+
+void Firmware::hostPinChanged(void *context, uint8_t pin, int value) {
+	Firmware *firmware = static_cast<Firmware *>(context);
+	if (pin < 64) {
+		firmware->_pin_values[pin] = value;
+	}
+	firmware->k_simulator->onPinChanged(firmware, pin, value);
+}
+
+unsigned long Firmware::hostPulseIn(void *context, uint8_t pin, uint8_t state, unsigned long timeout) {
+	Firmware *firmware = static_cast<Firmware *>(context);
+	const unsigned long duration = firmware->k_simulator->onPulseIn(firmware, pin, state, timeout);
+	// pulseIn returns after the pulse ended or after the timeout
+	firmware->advanceTo(firmware->_now + (duration == 0 ? timeout : duration));
+	return duration;
+}
+
+bool Firmware::hostSpiTransfer(void *context, int cs_pin, const uint8_t *tx, uint8_t *rx, size_t size,
+								unsigned long long start_micros, unsigned long bit_nanoseconds) {
+	Firmware *firmware = static_cast<Firmware *>(context);
+	return firmware->k_simulator->onSpiTransfer(firmware, cs_pin, tx, rx, size, firmware->_boot_time + start_micros,
+												bit_nanoseconds);
+}
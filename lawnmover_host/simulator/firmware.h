@@ -0,0 +1,135 @@
+#ifndef FIRMWARE_H
+#define FIRMWARE_H
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "firmware_api.h"
+
+class Simulator;
+
+/**
+ * Host side of one microcontroller running a firmware module. Each microcontroller has its own clock (now) on the
+ * shared simulated timeline. Busy waiting only moves its own clock forward; other microcontrollers are not blocked by
+ * it just like in reality. Powering off unloads the module, powering on loads it again and runs setup, i. e. all
+ * globals of the sketch start from scratch and millis starts at zero.
+ */
+class Firmware {
+public:
+	Firmware(Simulator *simulator, const char *name, const std::string &module_path, FILE *serial_output);
+
+	~Firmware();
+
+	Firmware(const Firmware &firmware) = delete;
+
+	Firmware &operator=(const Firmware &firmware) = delete;
+
+	void powerOn(const unsigned long long now);
+
+	void powerOff();
+
+	/**
+	 * Run loop once at the time it wants to be woken up and compute the next wake up time
+	 */
+	void runLoop();
+
+	/**
+	 * Clock one byte through the spi slave of this microcontroller. The interrupt routine of the byte takes
+	 * isr_nanoseconds after the byte ended. If it is still running when the next byte starts, its write of the next
+	 * byte to send collides with that byte.
+	 *
+	 * @param start_nanoseconds, end_nanoseconds when the byte is on the wire on the simulated timeline
+	 */
+	uint8_t spiExchange(const uint8_t mosi, const unsigned long long start_nanoseconds,
+						const unsigned long long end_nanoseconds, const unsigned long isr_nanoseconds);
+
+	/**
+	 * Clock size bytes back to back through the spi slave (see spiExchange) in one call to the firmware module. Falls
+	 * back to one call per byte if a pin input is due before the last byte ended. mosi and miso may be nullptr.
+	 */
+	void spiExchange(const uint8_t *mosi, uint8_t *miso, const size_t size, const unsigned long long start_nanoseconds,
+					 const unsigned long long byte_nanoseconds, const unsigned long isr_nanoseconds);
+
+	/**
+	 * Drive an input pin of this microcontroller at the given time (since the simulation started). Pin inputs are
+	 * delivered in order whenever the clock of the microcontroller passes their time, also in the middle of busy waiting.
+	 * Pending pin inputs are dropped upon power off.
+	 *
+	 * @param wake_up whether the interrupt routine of the input leaves work for the loop; otherwise, the input does not
+	 *        wake up the microcontroller but is delivered once its clock passes the input anyhow
+	 */
+	void schedulePinInput(const uint8_t pin, const int value, const unsigned long long at, const bool wake_up = true);
+
+	/**
+	 * Run loop at the given time at the latest, e. g. because an interrupt routine left work for it. A real
+	 * microcontroller spins its loop instead of waiting for its next timer task.
+	 */
+	void wakeUpAt(const unsigned long long at);
+
+	bool isPowered() const { return _handle != nullptr; };
+
+	bool isSpiSlave() const { return _firmware.spi_exchange != nullptr; };
+
+	const char *getName() const { return k_name; };
+
+	unsigned long long getNow() const { return _now; };
+
+	unsigned long long getWakeUp() const { return _wake_up; };
+
+	int getPinValue(const uint8_t pin) const;
+
+	unsigned long getPowerCycles() const { return _power_cycles; };
+
+	unsigned long long getBootTime() const { return _boot_time; };
+
+	unsigned long getSpiWriteCollisions() const { return _spi_write_collisions; };
+
+	Simulator *getSimulator() const { return k_simulator; };
+
+private:
+	static void hostDelay(void *context, unsigned long long microseconds);
+
+	static void hostPinChanged(void *context, uint8_t pin, int value);
+
+	static unsigned long hostPulseIn(void *context, uint8_t pin, uint8_t state, unsigned long timeout);
+
+	static bool hostSpiTransfer(void *context, int cs_pin, const uint8_t *tx, uint8_t *rx, size_t size,
+								unsigned long long start_micros, unsigned long bit_nanoseconds);
+
+	void scheduleWakeUp();
+
+	/**
+	 * Move the clock forward to the given time delivering the pin inputs due until then
+	 */
+	void advanceTo(const unsigned long long now);
+
+	Simulator *const k_simulator;
+	const char *k_name;
+	const std::string k_module_path;
+
+	LawnmoverFirmwareHooks _hooks;
+	LawnmoverFirmware _firmware;
+	void *_handle = nullptr;
+
+	unsigned long long _now = 0;
+	unsigned long long _boot_time = 0;
+	unsigned long long _wake_up = 0;
+	unsigned long _power_cycles = 0;
+
+	// the interrupt routine of the last byte clocked through the spi slave is done at
+	unsigned long long _spi_isr_done_nanoseconds = 0;
+	unsigned long _spi_write_collisions = 0;
+
+	struct PinInput {
+		uint8_t pin;
+		int value;
+		bool wake_up;
+	};
+
+	int _pin_values[64];
+	// by time
+	std::multimap<unsigned long long, PinInput> _pin_inputs;
+};
+
+#endif // FIRMWARE_H
@@ -0,0 +1,69 @@
+#ifndef FIRMWARE_API_H
+#define FIRMWARE_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * C interface between the simulator and a firmware module. A firmware module is one unmodified sketch (including its
+ * libraries and its own copy of the Arduino shim) compiled into a shared object. Every module has its own globals;
+ * unloading and loading it again is a power cycle of the microcontroller.
+ *
+ * The simulator hands in its hooks, the module hands out the entry points of the sketch.
+ */
+extern "C" {
+
+struct LawnmoverFirmwareHooks {
+	// passed back to each hook to identify the microcontroller
+	void *context;
+	// where Serial is written to or nullptr to mute it
+	FILE *serial_output;
+
+	// the clock of the microcontroller and the time it (re)booted, in microseconds on the simulated timeline. Read
+	// directly instead of by a hook; the timers of the sketches read millis for each of their tasks.
+	const unsigned long long *now;
+	const unsigned long long *boot_time;
+
+	// busy waiting of the microcontroller (delay, delayMicroseconds, pulseIn, spi transfers)
+	void (*delay)(void *context, unsigned long long microseconds);
+
+	void (*pin_changed)(void *context, uint8_t pin, int value);
+
+	unsigned long (*pulse_in)(void *context, uint8_t pin, uint8_t state, unsigned long timeout);
+
+	// spi master only: exchange size bytes with the slave selected by cs_pin; rx may be nullptr. The first bit is
+	// clocked at start_micros (since boot), each further bit bit_nanoseconds later.
+	bool (*spi_transfer)(void *context, int cs_pin, const uint8_t *tx, uint8_t *rx, size_t size,
+						 unsigned long long start_micros, unsigned long bit_nanoseconds);
+};
+
+struct LawnmoverFirmware {
+	void (*setup)();
+
+	void (*loop)();
+
+	// milliseconds until the next timer task of the sketch is due
+	unsigned long (*next_timer_millis)();
+
+	// spi slave only (nullptr otherwise): one byte clocked in from the master, returns the byte clocked out. With
+	// write_collision, the interrupt routine of the previous byte wrote the data register too late, i. e. while this
+	// byte was already on the wire.
+	uint8_t (*spi_exchange)(uint8_t mosi, bool write_collision);
+
+	// spi slave only: size bytes clocked back to back, i. e. spi_exchange for each of them in one call; mosi and miso
+	// may be nullptr. The first byte collides with first_write_collision, the others with write_collisions.
+	void (*spi_exchange_bytes)(const uint8_t *mosi, uint8_t *miso, size_t size, bool first_write_collision,
+							   bool write_collisions);
+
+	// drive an input pin from outside (e. g. the echo of a sensor); runs the pin change interrupt routine of the pin if
+	// the sketch enabled it and the level changed
+	void (*pin_input)(uint8_t pin, int value);
+};
+
+typedef void (*LawnmoverFirmwareAttach)(const LawnmoverFirmwareHooks *hooks, LawnmoverFirmware *firmware);
+
+#define LAWNMOVER_FIRMWARE_ATTACH_SYMBOL "lawnmover_firmware_attach"
+}
+
+#endif // FIRMWARE_API_H
@@ -0,0 +1,135 @@
+/**
+ * The module side of the simulator interface (see firmware_api.h). It is compiled once per sketch with
+ * LAWNMOVER_SKETCH set to the path of the .ino file, i. e. the sketch becomes part of this translation unit the same
+ * way the Arduino IDE prepends Arduino.h to it.
+ */
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <driver/spi_master.h>
+#endif
+
+#include LAWNMOVER_SKETCH
+
+#include "firmware_api.h"
+
+#if defined(ARDUINO_ARCH_AVR)
+// defined by the ISR of the spi slave
+extern "C" void SPI_STC_vect(void);
+
+// defined by sketches capturing pin changes only
+extern "C" void PCINT0_vect(void) __attribute__((weak));
+extern "C" void PCINT1_vect(void) __attribute__((weak));
+extern "C" void PCINT2_vect(void) __attribute__((weak));
+#endif
+
+namespace {
+	const LawnmoverFirmwareHooks *_hooks = nullptr;
+
+	unsigned long long hostMicros() {
+		return *_hooks->now - *_hooks->boot_time;
+	}
+
+	void hostDelay(unsigned long long microseconds) {
+		_hooks->delay(_hooks->context, microseconds);
+	}
+
+	void hostPinChanged(uint8_t pin, int value) {
+		_hooks->pin_changed(_hooks->context, pin, value);
+	}
+
+	unsigned long hostPulseIn(uint8_t pin, uint8_t state, unsigned long timeout) {
+		return _hooks->pulse_in(_hooks->context, pin, state, timeout);
+	}
+
+	unsigned long nextTimerMillis() {
+		// a sketch without any timer task would never be woken up
+		return _timer.empty() ? 1000UL : _timer.ticks();
+	}
+
+#if defined(ARDUINO_ARCH_ESP32)
+	bool hostSpiTransfer(int cs_pin, const uint8_t *tx, uint8_t *rx, size_t size, unsigned long start_micros,
+						 unsigned long bit_nanoseconds) {
+		return _hooks->spi_transfer(_hooks->context, cs_pin, tx, rx, size, start_micros, bit_nanoseconds);
+	}
+#endif
+
+#if defined(ARDUINO_ARCH_AVR)
+	// the byte last shifted in
+	uint8_t _received = 0;
+
+	uint8_t spiExchange(uint8_t mosi, bool write_collision) {
+		if ((SPCR & bit(SPE)) == 0) {
+			// spi is disabled; nobody drives miso
+			return 0;
+		}
+		if (write_collision) {
+			// The write to SPDR was ignored (WCOL), i. e. the shift register still holds the byte received last
+			SPDR = _received;
+		}
+		// SPDR holds the byte the slave prepared for this transfer; afterwards it holds the byte received
+		const uint8_t miso = SPDR;
+		SPDR = mosi;
+		_received = mosi;
+		if (SPCR & bit(SPIE)) {
+			SPI_STC_vect();
+		}
+		return miso;
+	}
+
+	void spiExchangeBytes(const uint8_t *mosi, uint8_t *miso, size_t size, bool first_write_collision,
+						  bool write_collisions) {
+		for (size_t i = 0; i < size; i++) {
+			const uint8_t received = spiExchange(mosi == nullptr ? 0 : mosi[i],
+												 i == 0 ? first_write_collision : write_collisions);
+			if (miso != nullptr) {
+				miso[i] = received;
+			}
+		}
+	}
+#endif
+
+	void pinInput(uint8_t pin, int value) {
+		const int previous = ArduinoShim::getPinValue(pin);
+		ArduinoShim::setPinValue(pin, value);
+#if defined(ARDUINO_ARCH_AVR)
+		if (previous == value || digitalPinToPCICR(pin) == nullptr) {
+			return;
+		}
+		const uint8_t pcie = digitalPinToPCICRbit(pin);
+		if ((*digitalPinToPCICR(pin) & bit(pcie)) && (*digitalPinToPCMSK(pin) & bit(digitalPinToPCMSKbit(pin)))) {
+			void (*const vectors[])(void) = {PCINT0_vect, PCINT1_vect, PCINT2_vect};
+			if (vectors[pcie] != nullptr) {
+				vectors[pcie]();
+			}
+		}
+#else
+		(void) previous;
+#endif
+	}
+}
+
+extern "C" __attribute__((visibility("default")))
+void lawnmover_firmware_attach(const LawnmoverFirmwareHooks *hooks, LawnmoverFirmware *firmware) {
+	_hooks = hooks;
+	ArduinoShim::setMicrosSource(hostMicros);
+	ArduinoShim::setDelayHandler(hostDelay);
+	ArduinoShim::setPinListener(hostPinChanged);
+	ArduinoShim::setPulseInHandler(hostPulseIn);
+	ArduinoShim::setSerialOutput(hooks->serial_output);
+
+	firmware->setup = setup;
+	firmware->loop = loop;
+	firmware->next_timer_millis = nextTimerMillis;
+	firmware->pin_input = pinInput;
+#if defined(ARDUINO_ARCH_AVR)
+	firmware->spi_exchange = spiExchange;
+	firmware->spi_exchange_bytes = spiExchangeBytes;
+#else
+	firmware->spi_exchange = nullptr;
+	firmware->spi_exchange_bytes = nullptr;
+#endif
+#if defined(ARDUINO_ARCH_ESP32)
+	SpiMasterShim::setTransferHandler(hostSpiTransfer);
+#endif
+}
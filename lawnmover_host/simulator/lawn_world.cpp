@@ -0,0 +1,348 @@
+#include "lawn_world.h"
+
+#include <algorithm>
+#include <cmath>
+
+// HC-SR04 sound cone; sampled by a few rays
+#define ULTRASONIC_HALF_CONE_RADIANS (15.0 * M_PI / 180.0)
+#define ULTRASONIC_CONE_RAYS 5
+
+namespace {
+	double square(const double value) {
+		return value * value;
+	}
+}
+
+LawnWorld::LawnWorld(const double width, const double height) :
+		k_width(width), k_height(height),
+		k_coverage_columns(static_cast<int>(std::ceil(width / LAWN_WORLD_COVERAGE_RESOLUTION_METERS))),
+		k_coverage_rows(static_cast<int>(std::ceil(height / LAWN_WORLD_COVERAGE_RESOLUTION_METERS))),
+		_covered(static_cast<size_t>(k_coverage_columns) * k_coverage_rows, false) {
+	_pose = {width / 2.0, height / 2.0, 0.0};
+}
+
+LawnWorld LawnWorld::garden() {
+	LawnWorld world(20.0, 12.0);
+	// trees
+	world.addCircle(4.0, 3.0, 0.4);
+	world.addCircle(14.5, 8.5, 0.6);
+	world.addCircle(9.0, 9.5, 0.3);
+	world.addCircle(17.0, 2.5, 0.35);
+	// flower beds
+	world.addRectangle(6.0, 5.0, 8.5, 6.0);
+	world.addRectangle(12.0, 2.0, 13.0, 5.0);
+	// shed
+	world.addRectangle(0.0, 9.0, 3.0, 12.0);
+	world.placeMower({10.0, 7.5, 0.0});
+	return world;
+}
+
+LawnWorld LawnWorld::rectangle() {
+	LawnWorld world(10.0, 6.0);
+	world.placeMower({5.0, 3.0, 0.0});
+	return world;
+}
+
+LawnWorld LawnWorld::lShape() {
+	LawnWorld world(12.0, 10.0);
+	// house
+	world.addRectangle(6.0, 5.0, 12.0, 10.0);
+	world.placeMower({3.0, 2.5, 0.0});
+	return world;
+}
+
+LawnWorld LawnWorld::trees() {
+	LawnWorld world(12.0, 8.0);
+	world.addCircle(2.0, 2.0, 0.3);
+	world.addCircle(4.5, 6.0, 0.5);
+	world.addCircle(6.0, 2.5, 0.2);
+	world.addCircle(8.0, 5.5, 0.4);
+	world.addCircle(9.5, 1.5, 0.3);
+	world.addCircle(10.5, 6.5, 0.25);
+	world.addCircle(3.0, 4.0, 0.2);
+	world.placeMower({6.0, 4.0, 0.0});
+	return world;
+}
+
+LawnWorld LawnWorld::narrowPassage() {
+	LawnWorld world(14.4, 6.0);
+	// hedge with the passage in the middle
+	world.addRectangle(7.0, 0.0, 7.4, 2.6);
+	world.addRectangle(7.0, 3.4, 7.4, 6.0);
+	world.placeMower({3.5, 3.0, 0.0});
+	return world;
+}
+
+void LawnWorld::addCircle(const double x, const double y, const double radius) {
+	_circles.push_back({x, y, radius});
+	_lawn_cells = -1;
+}
+
+void LawnWorld::addRectangle(const double min_x, const double min_y, const double max_x, const double max_y) {
+	_rectangles.push_back({min_x, min_y, max_x, max_y});
+	_lawn_cells = -1;
+}
+
+void LawnWorld::placeMower(const MowerPose &pose) {
+	_pose = pose;
+	_blocked = collides(pose.x, pose.y, MOWER_RADIUS_METERS);
+}
+
+void LawnWorld::advanceTo(const unsigned long long micros) {
+	while (_now < micros) {
+		// Far away from everything, the mower cannot collide anyhow; take one big step then
+		unsigned long long step_micros = LAWN_WORLD_STEP_MICROSECONDS;
+		const double max_speed = MOWER_MAX_WHEEL_SPEED_METERS_PER_SECOND *
+								 std::max(std::abs(_left_wheel_power), std::abs(_right_wheel_power)) /
+								 MOWER_MAX_ENGINE_POWER;
+		if (max_speed > 0.0) {
+			const double clearance = this->clearance(_pose.x, _pose.y) - MOWER_RADIUS_METERS;
+			step_micros = std::max(step_micros, static_cast<unsigned long long>(1e6 * clearance / max_speed));
+		}
+		step_micros = std::min(micros - _now, step_micros);
+		const MowerPose from = _pose;
+		const double odometer = _odometer;
+		step(step_micros / 1e6);
+		if (_blade_power > 0) {
+			cover(from, _pose);
+			_blade_odometer += _odometer - odometer;
+		}
+		if (_left_wheel_power != 0 || _right_wheel_power != 0) {
+			_moving_micros += step_micros;
+			if (_blocked) {
+				_blocked_micros += step_micros;
+			}
+		}
+		if (_blade_power > 0) {
+			_blade_micros += step_micros;
+		}
+		_now += step_micros;
+	}
+}
+
+void LawnWorld::step(const double seconds) {
+	if (_left_wheel_power == 0 && _right_wheel_power == 0) {
+		return;
+	}
+	const double left_speed = MOWER_MAX_WHEEL_SPEED_METERS_PER_SECOND * _left_wheel_power / MOWER_MAX_ENGINE_POWER;
+	const double right_speed = MOWER_MAX_WHEEL_SPEED_METERS_PER_SECOND * _right_wheel_power / MOWER_MAX_ENGINE_POWER;
+	const double speed = (left_speed + right_speed) / 2.0;
+	const double turn_rate = (right_speed - left_speed) / MOWER_WHEEL_BASE_METERS;
+
+	MowerPose next = _pose;
+	if (std::fabs(turn_rate) < 1e-9) {
+		next.x += speed * seconds * std::cos(_pose.heading);
+		next.y += speed * seconds * std::sin(_pose.heading);
+	} else {
+		// exact arc for constant wheel speeds
+		const double radius = speed / turn_rate;
+		next.heading = _pose.heading + turn_rate * seconds;
+		next.x += radius * (std::sin(next.heading) - std::sin(_pose.heading));
+		next.y -= radius * (std::cos(next.heading) - std::cos(_pose.heading));
+	}
+	next.heading = std::remainder(next.heading, 2.0 * M_PI);
+
+	if (collides(next.x, next.y, MOWER_RADIUS_METERS)) {
+		// Turning on the spot is always possible for a disc; anything else is stopped by the obstacle
+		if (!_blocked) {
+			_collisions++;
+			_blocked = true;
+		}
+		_pose.heading = next.heading;
+	} else {
+		_odometer += std::sqrt(square(next.x - _pose.x) + square(next.y - _pose.y));
+		_blocked = false;
+		_pose = next;
+	}
+}
+
+void LawnWorld::cover(const MowerPose &from, const MowerPose &to) {
+	// The steps are short between two pin changes of the engines control unit; most of them start where the previous
+	// one ended, i. e. at cells covered already
+	const bool from_covered = _covered_until_valid && from.x == _covered_until_x && from.y == _covered_until_y;
+	if (from_covered && to.x == from.x && to.y == from.y) {
+		return;
+	}
+	_covered_until_valid = true;
+	_covered_until_x = to.x;
+	_covered_until_y = to.y;
+	const double distance = std::sqrt(square(to.x - from.x) + square(to.y - from.y));
+	const int samples = 1 + static_cast<int>(distance / (LAWN_WORLD_COVERAGE_RESOLUTION_METERS / 2.0));
+	for (int sample = from_covered ? 1 : 0; sample <= samples; sample++) {
+		const double x = from.x + (to.x - from.x) * sample / samples;
+		const double y = from.y + (to.y - from.y) * sample / samples;
+		const int first_column = std::max(0, toCoverageCell(x - MOWER_CUT_RADIUS_METERS));
+		const int last_column = std::min(k_coverage_columns - 1, toCoverageCell(x + MOWER_CUT_RADIUS_METERS));
+		const int first_row = std::max(0, toCoverageCell(y - MOWER_CUT_RADIUS_METERS));
+		const int last_row = std::min(k_coverage_rows - 1, toCoverageCell(y + MOWER_CUT_RADIUS_METERS));
+		for (int row = first_row; row <= last_row; row++) {
+			const double dy = (row + 0.5) * LAWN_WORLD_COVERAGE_RESOLUTION_METERS - y;
+			for (int column = first_column; column <= last_column; column++) {
+				const double dx = (column + 0.5) * LAWN_WORLD_COVERAGE_RESOLUTION_METERS - x;
+				const size_t cell = static_cast<size_t>(row) * k_coverage_columns + column;
+				if (!_covered[cell] && dx * dx + dy * dy <= square(MOWER_CUT_RADIUS_METERS)) {
+					_covered[cell] = true;
+					_covered_cells++;
+				}
+			}
+		}
+	}
+}
+
+unsigned long LawnWorld::getLawnCells() const {
+	// obstacles may be added at any time, thus, the lawn is counted upon request
+	if (_lawn_cells < 0) {
+		_lawn_cells = 0;
+		for (int row = 0; row < k_coverage_rows; row++) {
+			for (int column = 0; column < k_coverage_columns; column++) {
+				if (!collides((column + 0.5) * LAWN_WORLD_COVERAGE_RESOLUTION_METERS,
+							  (row + 0.5) * LAWN_WORLD_COVERAGE_RESOLUTION_METERS, 0.0)) {
+					_lawn_cells++;
+				}
+			}
+		}
+	}
+	return static_cast<unsigned long>(_lawn_cells);
+}
+
+double LawnWorld::getCoverage() const {
+	const unsigned long lawn_cells = getLawnCells();
+	return lawn_cells > 0 ? static_cast<double>(_covered_cells) / lawn_cells : 0.0;
+}
+
+double LawnWorld::getCoveredArea() const {
+	return _covered_cells * LAWN_WORLD_COVERAGE_RESOLUTION_METERS * LAWN_WORLD_COVERAGE_RESOLUTION_METERS;
+}
+
+double LawnWorld::getLawnArea() const {
+	return getLawnCells() * LAWN_WORLD_COVERAGE_RESOLUTION_METERS * LAWN_WORLD_COVERAGE_RESOLUTION_METERS;
+}
+
+double LawnWorld::clearance(const double x, const double y) const {
+	double clearance = std::min(std::min(x, k_width - x), std::min(y, k_height - y));
+	for (const Circle &circle : _circles) {
+		clearance = std::min(clearance, std::sqrt(square(circle.x - x) + square(circle.y - y)) - circle.radius);
+	}
+	for (const Rectangle &rectangle : _rectangles) {
+		const double closest_x = std::max(rectangle.min_x, std::min(x, rectangle.max_x));
+		const double closest_y = std::max(rectangle.min_y, std::min(y, rectangle.max_y));
+		clearance = std::min(clearance, std::sqrt(square(closest_x - x) + square(closest_y - y)));
+	}
+	return clearance;
+}
+
+bool LawnWorld::collides(const double x, const double y, const double radius) const {
+	if (x - radius < 0.0 || y - radius < 0.0 || x + radius > k_width || y + radius > k_height) {
+		return true;
+	}
+	for (const Circle &circle : _circles) {
+		if (square(circle.x - x) + square(circle.y - y) < square(circle.radius + radius)) {
+			return true;
+		}
+	}
+	for (const Rectangle &rectangle : _rectangles) {
+		const double closest_x = std::max(rectangle.min_x, std::min(x, rectangle.max_x));
+		const double closest_y = std::max(rectangle.min_y, std::min(y, rectangle.max_y));
+		if (square(closest_x - x) + square(closest_y - y) < square(radius)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+double LawnWorld::raycast(const double x, const double y, const double angle, const double max_range) const {
+	return raycast(x, y, std::cos(angle), std::sin(angle), max_range);
+}
+
+double LawnWorld::raycast(const double x, const double y, const double dx, const double dy,
+						  const double max_range) const {
+	// leaving the lawn; the ray starts on the lawn
+	double hit = max_range + 1.0;
+	if (dx > 1e-12) {
+		hit = std::min(hit, (k_width - x) / dx);
+	} else if (dx < -1e-12) {
+		hit = std::min(hit, -x / dx);
+	}
+	if (dy > 1e-12) {
+		hit = std::min(hit, (k_height - y) / dy);
+	} else if (dy < -1e-12) {
+		hit = std::min(hit, -y / dy);
+	}
+
+	for (const Circle &circle : _circles) {
+		const double ox = x - circle.x;
+		const double oy = y - circle.y;
+		const double b = ox * dx + oy * dy;
+		const double c = ox * ox + oy * oy - circle.radius * circle.radius;
+		const double discriminant = b * b - c;
+		if (discriminant >= 0.0) {
+			const double t = -b - std::sqrt(discriminant);
+			if (t >= 0.0) {
+				hit = std::min(hit, t);
+			}
+		}
+	}
+
+	for (const Rectangle &rectangle : _rectangles) {
+		// slab method
+		double t_min = 0.0;
+		double t_max = hit;
+		bool miss = false;
+		const double origins[2] = {x, y};
+		const double directions[2] = {dx, dy};
+		const double mins[2] = {rectangle.min_x, rectangle.min_y};
+		const double maxs[2] = {rectangle.max_x, rectangle.max_y};
+		for (int axis = 0; axis < 2 && !miss; axis++) {
+			if (std::fabs(directions[axis]) < 1e-12) {
+				miss = origins[axis] < mins[axis] || origins[axis] > maxs[axis];
+			} else {
+				double t1 = (mins[axis] - origins[axis]) / directions[axis];
+				double t2 = (maxs[axis] - origins[axis]) / directions[axis];
+				if (t1 > t2) {
+					std::swap(t1, t2);
+				}
+				t_min = std::max(t_min, t1);
+				t_max = std::min(t_max, t2);
+				miss = t_min > t_max;
+			}
+		}
+		if (!miss) {
+			hit = std::min(hit, t_min);
+		}
+	}
+
+	return hit <= max_range ? hit : -1.0;
+}
+
+double LawnWorld::measureDistance(const UltrasonicMount &mount, const double max_range) const {
+	const double cos_heading = std::cos(_pose.heading);
+	const double sin_heading = std::sin(_pose.heading);
+	const double x = _pose.x + mount.forward * cos_heading - mount.left * sin_heading;
+	const double y = _pose.y + mount.forward * sin_heading + mount.left * cos_heading;
+
+	// the rays of the cone are rotations of its center ray
+	static double offset_cos[ULTRASONIC_CONE_RAYS];
+	static double offset_sin[ULTRASONIC_CONE_RAYS];
+	static bool offsets_initialized = false;
+	if (!offsets_initialized) {
+		for (int ray = 0; ray < ULTRASONIC_CONE_RAYS; ray++) {
+			const double offset = ULTRASONIC_HALF_CONE_RADIANS * (2.0 * ray / (ULTRASONIC_CONE_RAYS - 1) - 1.0);
+			offset_cos[ray] = std::cos(offset);
+			offset_sin[ray] = std::sin(offset);
+		}
+		offsets_initialized = true;
+	}
+	const double center_cos = std::cos(_pose.heading + mount.angle);
+	const double center_sin = std::sin(_pose.heading + mount.angle);
+
+	double closest = -1.0;
+	for (int ray = 0; ray < ULTRASONIC_CONE_RAYS; ray++) {
+		const double dx = center_cos * offset_cos[ray] - center_sin * offset_sin[ray];
+		const double dy = center_sin * offset_cos[ray] + center_cos * offset_sin[ray];
+		const double distance = raycast(x, y, dx, dy, max_range);
+		if (distance >= 0.0 && (closest < 0.0 || distance < closest)) {
+			closest = distance;
+		}
+	}
+	return closest;
+}
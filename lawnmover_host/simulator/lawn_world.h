@@ -0,0 +1,204 @@
+#ifndef LAWN_WORLD_H
+#define LAWN_WORLD_H
+
+#include <vector>
+
+#define MOWER_RADIUS_METERS 0.25
+// reach of the blade around the center of the mower
+#define MOWER_CUT_RADIUS_METERS 0.22
+#define MOWER_WHEEL_BASE_METERS 0.36
+// wheel speed at full engine power
+#define MOWER_MAX_WHEEL_SPEED_METERS_PER_SECOND 0.4
+#define MOWER_MAX_ENGINE_POWER 255
+// the motion is integrated in steps of this size at most (collision checks included) unless far away from everything
+#define LAWN_WORLD_STEP_MICROSECONDS 20000ULL
+// cells of the lawn mowed or not
+#define LAWN_WORLD_COVERAGE_RESOLUTION_METERS 0.05
+
+// Other than the Pose of the robo pilot, the true pose of the mower in meters
+struct MowerPose {
+	double x;
+	double y;
+	// counterclockwise from the x axis
+	double heading;
+};
+
+/**
+ * Where an ultrasonic sensor sits on the mower, relative to the center of the mower
+ */
+struct UltrasonicMount {
+	double forward;
+	double left;
+	// counterclockwise from the heading
+	double angle;
+};
+
+/**
+ * A rectangular lawn with circular (trees) and rectangular (flower beds, sheds) obstacles and a differential drive
+ * mower on it. The mower is a disc; it cannot move into obstacles or leave the lawn. Time only moves forward; the
+ * wheel powers are constant between two calls of advanceTo.
+ *
+ * The lawn is split into cells of LAWN_WORLD_COVERAGE_RESOLUTION_METERS; a cell is covered once the center of the
+ * mower passed it within MOWER_CUT_RADIUS_METERS while the blade was running.
+ */
+class LawnWorld {
+public:
+	LawnWorld(const double width, const double height);
+
+	/**
+	 * A 20m x 12m garden with some trees, two flower beds and a shed
+	 */
+	static LawnWorld garden();
+
+	/**
+	 * A plain 10m x 6m lawn
+	 */
+	static LawnWorld rectangle();
+
+	/**
+	 * An L-shaped lawn of 12m x 10m with a 6m x 5m corner taken by a house
+	 */
+	static LawnWorld lShape();
+
+	/**
+	 * A 12m x 8m lawn with seven trees of different sizes
+	 */
+	static LawnWorld trees();
+
+	/**
+	 * Two 7m x 6m lawns joined by a passage of 0.8m (i. e. 0.3m wider than the mower) through a hedge
+	 */
+	static LawnWorld narrowPassage();
+
+	void addCircle(const double x, const double y, const double radius);
+
+	void addRectangle(const double min_x, const double min_y, const double max_x, const double max_y);
+
+	void placeMower(const MowerPose &pose);
+
+	/**
+	 * @param power engine power in [-255, 255]; negative is backwards
+	 */
+	void setLeftWheelPower(const int power) { _left_wheel_power = power; };
+
+	void setRightWheelPower(const int power) { _right_wheel_power = power; };
+
+	void setBladePower(const int power) { _blade_power = power; };
+
+	void advanceTo(const unsigned long long micros);
+
+	/**
+	 * Distance to the closest obstacle (or border) within the sound cone of the sensor
+	 *
+	 * @return distance in meters or a negative value if nothing is within max_range
+	 */
+	double measureDistance(const UltrasonicMount &mount, const double max_range) const;
+
+	/**
+	 * @return distance in meters along the ray or a negative value if nothing is within max_range
+	 */
+	double raycast(const double x, const double y, const double angle, const double max_range) const;
+
+	/**
+	 * @param dx, dy unit vector of the ray
+	 */
+	double raycast(const double x, const double y, const double dx, const double dy, const double max_range) const;
+
+	bool collides(const double x, const double y, const double radius) const;
+
+	/**
+	 * @return distance from the given point to the closest obstacle (or border)
+	 */
+	double clearance(const double x, const double y) const;
+
+	const MowerPose &getPose() const { return _pose; };
+
+	unsigned long long getNow() const { return _now; };
+
+	double getWidth() const { return k_width; };
+
+	double getHeight() const { return k_height; };
+
+	double getOdometer() const { return _odometer; };
+
+	// the part of the odometer driven while the blade was running
+	double getBladeOdometer() const { return _blade_odometer; };
+
+	// each time the mower ran into an obstacle while it was free before
+	unsigned long getCollisions() const { return _collisions; };
+
+	unsigned long long getBlockedMicros() const { return _blocked_micros; };
+
+	unsigned long long getMovingMicros() const { return _moving_micros; };
+
+	unsigned long long getBladeMicros() const { return _blade_micros; };
+
+	/**
+	 * @return the share of the lawn not taken by obstacles that was mowed, in [0, 1]
+	 */
+	double getCoverage() const;
+
+	// in square meters
+	double getCoveredArea() const;
+
+	// the area not taken by obstacles in square meters
+	double getLawnArea() const;
+
+private:
+	struct Circle {
+		double x;
+		double y;
+		double radius;
+	};
+
+	struct Rectangle {
+		double min_x;
+		double min_y;
+		double max_x;
+		double max_y;
+	};
+
+	void step(const double seconds);
+
+	// the cells within the cut radius along the straight line between both poses
+	void cover(const MowerPose &from, const MowerPose &to);
+
+	unsigned long getLawnCells() const;
+
+	int toCoverageCell(const double coordinate) const {
+		return static_cast<int>(coordinate / LAWN_WORLD_COVERAGE_RESOLUTION_METERS);
+	};
+
+	const double k_width;
+	const double k_height;
+
+	std::vector<Circle> _circles;
+	std::vector<Rectangle> _rectangles;
+
+	MowerPose _pose;
+	unsigned long long _now = 0;
+	int _left_wheel_power = 0;
+	int _right_wheel_power = 0;
+	int _blade_power = 0;
+
+	bool _blocked = false;
+	double _odometer = 0.0;
+	double _blade_odometer = 0.0;
+	unsigned long _collisions = 0;
+	unsigned long long _blocked_micros = 0;
+	unsigned long long _moving_micros = 0;
+	unsigned long long _blade_micros = 0;
+
+	const int k_coverage_columns;
+	const int k_coverage_rows;
+	std::vector<bool> _covered;
+	unsigned long _covered_cells = 0;
+	// the end of the last step covered
+	bool _covered_until_valid = false;
+	double _covered_until_x = 0.0;
+	double _covered_until_y = 0.0;
+	// counted upon the first request after adding an obstacle
+	mutable long _lawn_cells = -1;
+};
+
+#endif // LAWN_WORLD_H
@@ -0,0 +1,178 @@
+/**
+ * Soak test of the whole lawnmover without hardware: the firmware of the main core unit, the engines control unit and
+ * the distance control unit runs closed loop in the garden of LawnWorld (see simulator.h). Prints the spi and world
+ * metrics every --report-every simulated minutes and at the end, together with the simulation speed and the share of
+ * the lawn mowed after each simulated minute. With --min-speed, the exit code tells whether the simulation kept up the
+ * given simulated minutes per wall clock second, e. g. to catch changes slowing it down. With --max-loops-per-minute, it
+ * tells whether the microcontrollers ran their loop at most as often as given per simulated minute. Unlike the speed,
+ * the loops are deterministic for a given seed, i. e. it catches wake-ups added without need on any host.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "simulator.h"
+
+namespace {
+	struct Arguments {
+		double minutes = 60.0;
+		double report_every_minutes = 0.0;
+		// simulated minutes per wall clock second
+		double min_speed = 0.0;
+		// loops of all microcontrollers per simulated minute, 0 for no bound
+		double max_loops_per_minute = 0.0;
+		std::string serial;
+		SimulatorOptions options;
+	};
+
+	bool matchArgument(const char *argument, const char *name, const char **value) {
+		const size_t length = strlen(name);
+		if (strncmp(argument, name, length) == 0 && argument[length] == '=') {
+			*value = argument + length + 1;
+			return true;
+		}
+		return false;
+	}
+
+	bool parseArguments(int argc, char **argv, Arguments &arguments) {
+		for (int i = 1; i < argc; i++) {
+			const char *value = nullptr;
+			if (matchArgument(argv[i], "--minutes", &value)) {
+				arguments.minutes = atof(value);
+			} else if (matchArgument(argv[i], "--report-every", &value)) {
+				arguments.report_every_minutes = atof(value);
+			} else if (matchArgument(argv[i], "--min-speed", &value)) {
+				arguments.min_speed = atof(value);
+			} else if (matchArgument(argv[i], "--max-loops-per-minute", &value)) {
+				arguments.max_loops_per_minute = atof(value);
+			} else if (matchArgument(argv[i], "--seed", &value)) {
+				arguments.options.seed = static_cast<unsigned int>(strtoul(value, nullptr, 10));
+			} else if (matchArgument(argv[i], "--serial", &value)) {
+				arguments.serial = value;
+			} else if (matchArgument(argv[i], "--echo-noise-cm", &value)) {
+				arguments.options.echo_noise_cm = atof(value);
+			} else if (matchArgument(argv[i], "--echo-dropout", &value)) {
+				arguments.options.echo_dropout = atof(value);
+			} else if (matchArgument(argv[i], "--echo-cross-talk", &value)) {
+				arguments.options.echo_cross_talk = atof(value);
+			} else if (matchArgument(argv[i], "--spi-error-rate", &value)) {
+				arguments.options.spi_bit_error_rate = atof(value);
+			} else if (matchArgument(argv[i], "--avr-spi-isr-us", &value)) {
+				arguments.options.avr_spi_isr_microseconds = atof(value);
+			} else if (matchArgument(argv[i], "--robo-pilot", &value) && strcmp(value, "rule_based") == 0) {
+				arguments.options.main_core_unit_module = LAWNMOVER_MAIN_CORE_UNIT_MODULE;
+			} else if (matchArgument(argv[i], "--robo-pilot", &value) && strcmp(value, "coverage_planner") == 0) {
+				arguments.options.main_core_unit_module = LAWNMOVER_MAIN_CORE_UNIT_COVERAGE_PLANNER_MODULE;
+			} else {
+				fprintf(stderr,
+						"Usage: %s [--minutes=<simulated minutes>] [--report-every=<simulated minutes>] [--seed=<n>]\n"
+						"          [--min-speed=<simulated minutes per second>] [--max-loops-per-minute=<n>]\n"
+						"          [--robo-pilot=<rule_based|coverage_planner>]\n"
+						"          [--serial=<main_core_unit|engines_control_unit|distance_control_unit|all>]\n"
+						"          [--echo-noise-cm=<cm>] [--echo-dropout=<probability>]\n"
+						"          [--echo-cross-talk=<probability>]\n"
+						"          [--spi-error-rate=<probability per byte>] [--avr-spi-isr-us=<microseconds>]\n",
+						argv[0]);
+				return false;
+			}
+		}
+		const bool all = arguments.serial == "all";
+		arguments.options.main_core_unit_serial = all || arguments.serial == "main_core_unit" ? stdout : nullptr;
+		arguments.options.engines_control_unit_serial =
+				all || arguments.serial == "engines_control_unit" ? stdout : nullptr;
+		arguments.options.distance_control_unit_serial =
+				all || arguments.serial == "distance_control_unit" ? stdout : nullptr;
+		return true;
+	}
+
+	void printSlaveMetrics(const char *name, const SpiSlaveMetrics &metrics) {
+		printf("  %-20s transfers %lu, bytes %llu, corrupted bytes %lu, write collisions %lu, unanswered transfers %lu, "
+			   "restarts %lu\n", name, metrics.transfers, metrics.bytes, metrics.corrupted_bytes,
+			   metrics.write_collisions, metrics.unanswered_transfers, metrics.restarts);
+	}
+
+	void printReport(const Simulator &simulator, const double wall_seconds) {
+		const LawnWorld &world = simulator.getWorld();
+		const double simulated_minutes = simulator.getNow() / 60e6;
+		printf("simulated %.1f min in %.3f s wall clock (%.0f simulated min/s), %llu loops, %llu echoes "
+			   "(%llu cross-talk)\n",
+			   simulated_minutes, wall_seconds, wall_seconds > 0.0 ? simulated_minutes / wall_seconds : 0.0,
+			   simulator.getLoops(), simulator.getEchoes(), simulator.getCrossTalkEchoes());
+		printSlaveMetrics("engines", simulator.getEngineMetrics());
+		printSlaveMetrics("obstacle detection", simulator.getObstacleDetectionMetrics());
+		printf("  %-20s odometer %.1f m, collisions %lu, moving %.1f min, blocked %.1f min, blade %.1f min, "
+			   "covered %.1f %%, pose (%.2f, %.2f, %.0f deg)\n",
+			   "world", world.getOdometer(), world.getCollisions(), world.getMovingMicros() / 60e6,
+			   world.getBlockedMicros() / 60e6, world.getBladeMicros() / 60e6, 100.0 * world.getCoverage(),
+			   world.getPose().x, world.getPose().y, world.getPose().heading * 180.0 / M_PI);
+		fflush(stdout);
+	}
+
+	void printCoveragePerMinute(const std::vector<double> &coverages) {
+		printf("  %-20s", "covered per minute");
+		for (size_t minute = 0; minute < coverages.size(); minute++) {
+			printf("%s%.1f", minute == 0 ? " " : ", ", 100.0 * coverages[minute]);
+		}
+		printf(" %%\n");
+		fflush(stdout);
+	}
+}
+
+int main(int argc, char **argv) {
+	Arguments arguments;
+	arguments.options.main_core_unit_module = LAWNMOVER_MAIN_CORE_UNIT_MODULE;
+	arguments.options.engines_control_unit_module = LAWNMOVER_ENGINES_CONTROL_UNIT_MODULE;
+	arguments.options.distance_control_unit_module = LAWNMOVER_DISTANCE_CONTROL_UNIT_MODULE;
+	if (!parseArguments(argc, argv, arguments)) {
+		return 1;
+	}
+
+	try {
+		Simulator simulator(arguments.options, LawnWorld::garden());
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		simulator.powerOn();
+
+		const unsigned long long end = static_cast<unsigned long long>(arguments.minutes * 60e6);
+		const unsigned long long report_every = static_cast<unsigned long long>(
+				arguments.report_every_minutes * 60e6);
+		const unsigned long long minute = 60000000ULL;
+		unsigned long long next_report = report_every == 0 ? end : report_every;
+		std::vector<double> coverages;
+		while (simulator.getNow() < end) {
+			// stop at each full minute, too, to sample the coverage
+			const unsigned long long next_minute = (coverages.size() + 1) * minute;
+			simulator.runUntil(std::min(end, std::min(next_report, next_minute)));
+			if (simulator.getNow() >= next_minute) {
+				coverages.push_back(simulator.getWorld().getCoverage());
+			}
+			if (simulator.getNow() >= next_report && simulator.getNow() < end) {
+				printReport(simulator, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+				next_report += report_every;
+			}
+		}
+		const double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printReport(simulator, wall_seconds);
+		printCoveragePerMinute(coverages);
+		const double speed = wall_seconds > 0.0 ? arguments.minutes / wall_seconds : 0.0;
+		if (speed < arguments.min_speed) {
+			fprintf(stderr, "simulated %.0f min/s only, less than %.0f min/s\n", speed, arguments.min_speed);
+			return 2;
+		}
+		const double loops_per_minute = arguments.minutes > 0.0 ? simulator.getLoops() / arguments.minutes : 0.0;
+		if (arguments.max_loops_per_minute > 0.0 && loops_per_minute > arguments.max_loops_per_minute) {
+			fprintf(stderr, "ran %.0f loops per simulated minute, more than %.0f\n", loops_per_minute,
+					arguments.max_loops_per_minute);
+			return 2;
+		}
+	} catch (const std::exception &exception) {
+		fprintf(stderr, "%s\n", exception.what());
+		return 1;
+	}
+	return 0;
+}
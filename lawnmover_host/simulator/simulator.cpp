@@ -0,0 +1,243 @@
+#include "simulator.h"
+
+#include <cmath>
+
+namespace {
+	const uint8_t k_ultra_rx_pins[SIMULATOR_ULTRASONIC_SENSORS] = {
+			Wiring::ULTRA_RX_FRONT, Wiring::ULTRA_RX_FRONT_RIGHT, Wiring::ULTRA_RX_FRONT_LEFT,
+			Wiring::ULTRA_RX_REAR_RIGHT, Wiring::ULTRA_RX_REAR_LEFT};
+}
+
+Simulator::Simulator(const SimulatorOptions &options, const LawnWorld &world) :
+		k_options(options), _world(world), _random(options.seed),
+		_main_core_unit(this, "main_core_unit", options.main_core_unit_module, options.main_core_unit_serial),
+		_engines_control_unit(this, "engines_control_unit", options.engines_control_unit_module,
+							  options.engines_control_unit_serial),
+		_distance_control_unit(this, "distance_control_unit", options.distance_control_unit_module,
+							   options.distance_control_unit_serial),
+		k_firmwares{&_main_core_unit, &_engines_control_unit, &_distance_control_unit} {
+	// nothing to do...
+}
+
+Simulator::~Simulator() {
+	// power off the master first; it must not talk to unloaded slaves anymore
+	_main_core_unit.powerOff();
+	_engines_control_unit.powerOff();
+	_distance_control_unit.powerOff();
+}
+
+void Simulator::powerOn() {
+	_engines_control_unit.powerOn(0);
+	_distance_control_unit.powerOn(0);
+	_main_core_unit.powerOn(0);
+}
+
+void Simulator::runUntil(const unsigned long long micros) {
+	while (true) {
+		Firmware *next = nullptr;
+		for (Firmware *firmware : k_firmwares) {
+			if (firmware->isPowered() && (next == nullptr || firmware->getWakeUp() < next->getWakeUp())) {
+				next = firmware;
+			}
+		}
+		if (next == nullptr || next->getWakeUp() > micros) {
+			break;
+		}
+		if (next->getWakeUp() > _now) {
+			_now = next->getWakeUp();
+		}
+		next->runLoop();
+		_loops++;
+	}
+	if (micros > _now) {
+		_now = micros;
+	}
+	_world.advanceTo(_now);
+}
+
+void Simulator::onPinChanged(Firmware *firmware, const uint8_t pin, const int value) {
+	if (firmware == &_main_core_unit) {
+		// The restart pins cut the power supply of the slaves while high
+		Firmware *slave = nullptr;
+		SpiSlaveMetrics *metrics = nullptr;
+		if (pin == Wiring::ENGINE_RESTART_PIN) {
+			slave = &_engines_control_unit;
+			metrics = &_engine_metrics;
+		} else if (pin == Wiring::OBSTACLE_DETECTION_RESTART_PIN) {
+			slave = &_distance_control_unit;
+			metrics = &_obstacle_detection_metrics;
+		}
+		if (slave != nullptr) {
+			if (value != 0) {
+				slave->powerOff();
+				metrics->restarts++;
+			} else {
+				slave->powerOn(firmware->getNow());
+			}
+		}
+	} else if (firmware == &_engines_control_unit) {
+		if (pin == Wiring::LEFT_FWD_PIN || pin == Wiring::LEFT_BWD_PIN || pin == Wiring::LEFT_PWM_PIN ||
+			pin == Wiring::RIGHT_FWD_PIN || pin == Wiring::RIGHT_BWD_PIN || pin == Wiring::RIGHT_PWM_PIN ||
+			pin == Wiring::MOTOR_PIN) {
+			// the engines kept the previous powers until now
+			_world.advanceTo(firmware->getNow());
+			updateEngines();
+		}
+	} else if (firmware == &_distance_control_unit) {
+		if (pin == Wiring::ULTRA_TX_PIN && value == 0) {
+			// the falling edge ends the trigger pulse
+			triggerUltrasonicSensors(firmware);
+		}
+	}
+}
+
+void Simulator::updateEngines() {
+	const Firmware &engines = _engines_control_unit;
+	// H-bridge: forward xor backward pin selects the direction, both or none of them brake
+	const int left_direction = engines.getPinValue(Wiring::LEFT_FWD_PIN) - engines.getPinValue(Wiring::LEFT_BWD_PIN);
+	const int right_direction = engines.getPinValue(Wiring::RIGHT_FWD_PIN) -
+								engines.getPinValue(Wiring::RIGHT_BWD_PIN);
+	_world.setLeftWheelPower(left_direction * engines.getPinValue(Wiring::LEFT_PWM_PIN));
+	_world.setRightWheelPower(right_direction * engines.getPinValue(Wiring::RIGHT_PWM_PIN));
+	_world.setBladePower(engines.getPinValue(Wiring::MOTOR_PIN));
+}
+
+bool Simulator::mountByRxPin(const uint8_t pin, UltrasonicMount &mount) const {
+	switch (pin) {
+		case Wiring::ULTRA_RX_FRONT:
+			mount = {MOWER_RADIUS_METERS, 0.0, 0.0};
+			return true;
+		case Wiring::ULTRA_RX_FRONT_LEFT:
+			mount = {0.8 * MOWER_RADIUS_METERS, 0.5 * MOWER_RADIUS_METERS, M_PI / 6.0};
+			return true;
+		case Wiring::ULTRA_RX_FRONT_RIGHT:
+			mount = {0.8 * MOWER_RADIUS_METERS, -0.5 * MOWER_RADIUS_METERS, -M_PI / 6.0};
+			return true;
+		case Wiring::ULTRA_RX_REAR_LEFT:
+			mount = {-0.8 * MOWER_RADIUS_METERS, 0.5 * MOWER_RADIUS_METERS, 5.0 * M_PI / 6.0};
+			return true;
+		case Wiring::ULTRA_RX_REAR_RIGHT:
+			mount = {-0.8 * MOWER_RADIUS_METERS, -0.5 * MOWER_RADIUS_METERS, -5.0 * M_PI / 6.0};
+			return true;
+		default:
+			return false;
+	}
+}
+
+double Simulator::measureEcho(const UltrasonicMount &mount) {
+	_echoes++;
+	const double distance = _world.measureDistance(mount, SIMULATOR_ULTRASONIC_MAX_RANGE_METERS);
+	if (distance < 0.0 || std::uniform_real_distribution<double>(0.0, 1.0)(_random) < k_options.echo_dropout) {
+		return -1.0;
+	}
+	double distance_cm = 100.0 * distance;
+	if (k_options.echo_noise_cm > 0.0) {
+		distance_cm += std::normal_distribution<double>(0.0, k_options.echo_noise_cm)(_random);
+	}
+	return distance_cm < 0.0 ? 0.0 : distance_cm * SIMULATOR_ULTRASONIC_MICROSECONDS_PER_CM;
+}
+
+void Simulator::triggerUltrasonicSensors(Firmware *firmware) {
+	const unsigned long long now = firmware->getNow();
+	_world.advanceTo(now);
+	// round trips of the sensors fired by this trigger (negative if there is no echo or the sensor is busy)
+	double durations[SIMULATOR_ULTRASONIC_SENSORS];
+	bool fired[SIMULATOR_ULTRASONIC_SENSORS];
+	for (int i = 0; i < SIMULATOR_ULTRASONIC_SENSORS; i++) {
+		UltrasonicMount mount;
+		fired[i] = _echo_busy_until[i] <= now && mountByRxPin(k_ultra_rx_pins[i], mount);
+		durations[i] = fired[i] ? measureEcho(mount) : -1.0;
+	}
+	for (int i = 0; i < SIMULATOR_ULTRASONIC_SENSORS; i++) {
+		if (!fired[i]) {
+			continue;
+		}
+		double duration = durations[i];
+		if (k_options.echo_cross_talk > 0.0 &&
+			std::uniform_real_distribution<double>(0.0, 1.0)(_random) < k_options.echo_cross_talk) {
+			// the burst of another sensor reaching this one first ends its echo pulse early
+			for (int j = 0; j < SIMULATOR_ULTRASONIC_SENSORS; j++) {
+				if (j != i && durations[j] >= 0.0 && (duration < 0.0 || durations[j] < duration)) {
+					duration = durations[j];
+				}
+			}
+			if (duration != durations[i]) {
+				_cross_talk_echoes++;
+			}
+		}
+		const unsigned long long rise = now + SIMULATOR_ULTRASONIC_BURST_MICROSECONDS;
+		const unsigned long long fall = rise + (duration < 0.0 ? SIMULATOR_ULTRASONIC_NO_ECHO_MICROSECONDS
+															   : static_cast<unsigned long long>(duration) + 1);
+		// the rising edge only records the start of the pulse (see EchoCapture); the loop waits for the falling one
+		firmware->schedulePinInput(k_ultra_rx_pins[i], 1, rise, false);
+		firmware->schedulePinInput(k_ultra_rx_pins[i], 0, fall);
+		_echo_busy_until[i] = fall;
+	}
+}
+
+unsigned long Simulator::onPulseIn(Firmware *firmware, const uint8_t pin, const uint8_t state,
+								   const unsigned long timeout) {
+	UltrasonicMount mount;
+	if (firmware != &_distance_control_unit || !mountByRxPin(pin, mount)) {
+		return 0;
+	}
+	_world.advanceTo(firmware->getNow());
+	const double duration = measureEcho(mount);
+	return duration < 0.0 || duration > timeout ? 0 : static_cast<unsigned long>(duration) + 1;
+}
+
+uint8_t Simulator::corrupt(const uint8_t value, SpiSlaveMetrics &metrics) {
+	if (k_options.spi_bit_error_rate > 0.0 &&
+		std::uniform_real_distribution<double>(0.0, 1.0)(_random) < k_options.spi_bit_error_rate) {
+		metrics.corrupted_bytes++;
+		return value ^ static_cast<uint8_t>(1 << std::uniform_int_distribution<int>(0, 7)(_random));
+	}
+	return value;
+}
+
+bool Simulator::onSpiTransfer(Firmware *firmware, const int cs_pin, const uint8_t *tx, uint8_t *rx,
+							  const size_t size, const unsigned long long start_micros,
+							  const unsigned long bit_nanoseconds) {
+	Firmware *slave = nullptr;
+	SpiSlaveMetrics *metrics = nullptr;
+	if (cs_pin == Wiring::ENGINE_SS_PIN) {
+		slave = &_engines_control_unit;
+		metrics = &_engine_metrics;
+	} else if (cs_pin == Wiring::OBSTACLE_DETECTION_SS_PIN) {
+		slave = &_distance_control_unit;
+		metrics = &_obstacle_detection_metrics;
+	} else {
+		return false;
+	}
+
+	metrics->transfers++;
+	metrics->bytes += size;
+	if (!slave->isPowered() || !slave->isSpiSlave()) {
+		metrics->unanswered_transfers++;
+		return false;
+	}
+	const unsigned long isr_nanoseconds = static_cast<unsigned long>(1000.0 * k_options.avr_spi_isr_microseconds);
+	const unsigned long long byte_nanoseconds = 8ULL * bit_nanoseconds;
+	unsigned long long start_nanoseconds = 1000ULL * start_micros;
+	const unsigned long write_collisions = slave->getSpiWriteCollisions();
+	if (k_options.spi_bit_error_rate > 0.0) {
+		for (size_t i = 0; i < size; i++) {
+			const uint8_t mosi = corrupt(tx == nullptr ? 0 : tx[i], *metrics);
+			const uint8_t miso = corrupt(slave->spiExchange(mosi, start_nanoseconds,
+															start_nanoseconds + byte_nanoseconds, isr_nanoseconds),
+										 *metrics);
+			start_nanoseconds += byte_nanoseconds;
+			if (rx != nullptr) {
+				rx[i] = miso;
+			}
+		}
+	} else {
+		// nothing to corrupt; the whole transfer goes through the interrupt routine of the slave in one call
+		slave->spiExchange(tx, rx, size, start_nanoseconds, byte_nanoseconds, isr_nanoseconds);
+		start_nanoseconds += size * byte_nanoseconds;
+	}
+	metrics->write_collisions += slave->getSpiWriteCollisions() - write_collisions;
+	// the interrupt routine staged the frame for the loop (see SpiSlave::processDataPushCommands)
+	slave->wakeUpAt((start_nanoseconds + isr_nanoseconds) / 1000ULL);
+	return true;
+}
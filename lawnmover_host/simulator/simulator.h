@@ -0,0 +1,165 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <random>
+#include <string>
+
+#include "firmware.h"
+#include "lawn_world.h"
+
+/**
+ * Wiring of the lawnmover as in the sketches. Keep in sync with lawnmover_main_core_unit.ino,
+ * lawnmover_engines_control_unit.ino and lawnmover_distance_control_unit.ino.
+ */
+namespace Wiring {
+	// main core unit (esp32)
+	const int ENGINE_SS_PIN = 5;
+	const int ENGINE_RESTART_PIN = 13;
+	const int OBSTACLE_DETECTION_SS_PIN = 12;
+	const int OBSTACLE_DETECTION_RESTART_PIN = 14;
+
+	// engines control unit (uno)
+	const int LEFT_FWD_PIN = 8;
+	const int LEFT_BWD_PIN = 9;
+	const int LEFT_PWM_PIN = 5;
+	const int RIGHT_PWM_PIN = 6;
+	const int RIGHT_FWD_PIN = 4;
+	const int RIGHT_BWD_PIN = 7;
+	const int MOTOR_PIN = 3;
+
+	// distance control unit (uno)
+	const int ULTRA_RX_FRONT = 2;
+	const int ULTRA_RX_FRONT_RIGHT = 6;
+	const int ULTRA_RX_FRONT_LEFT = 4;
+	const int ULTRA_RX_REAR_RIGHT = 5;
+	const int ULTRA_RX_REAR_LEFT = 3;
+	const int ULTRA_TX_PIN = 7;
+}
+
+// see ultrasonic_sensors.h of the distance control unit
+#define SIMULATOR_ULTRASONIC_MICROSECONDS_PER_CM (2 * 29)
+#define SIMULATOR_ULTRASONIC_MAX_RANGE_METERS 4.0
+// HC-SR04: the echo pin rises after the burst was sent and stays high for the round trip or this long without echo
+#define SIMULATOR_ULTRASONIC_BURST_MICROSECONDS 250
+#define SIMULATOR_ULTRASONIC_NO_ECHO_MICROSECONDS 38000
+#define SIMULATOR_ULTRASONIC_SENSORS 5
+
+struct SimulatorOptions {
+	std::string main_core_unit_module;
+	std::string engines_control_unit_module;
+	std::string distance_control_unit_module;
+
+	unsigned int seed = 42;
+	// standard deviation of the echo distance
+	double echo_noise_cm = 1.0;
+	// probability of not receiving any echo
+	double echo_dropout = 0.01;
+	// probability of a sensor receiving the earlier echo of another sensor fired by the same trigger
+	double echo_cross_talk = 0.0;
+	// probability of flipping one bit of a byte on the spi bus (each direction)
+	double spi_bit_error_rate = 0.0;
+	// time the SPI_STC_vect interrupt routine of an uno needs until it wrote the next byte to send
+	double avr_spi_isr_microseconds = 6.0;
+
+	// nullptr mutes the serial output of the microcontroller
+	FILE *main_core_unit_serial = nullptr;
+	FILE *engines_control_unit_serial = nullptr;
+	FILE *distance_control_unit_serial = nullptr;
+};
+
+struct SpiSlaveMetrics {
+	unsigned long transfers = 0;
+	unsigned long long bytes = 0;
+	unsigned long corrupted_bytes = 0;
+	// transfers while the slave was powered off (held in reset)
+	unsigned long unanswered_transfers = 0;
+	// bytes clocked out before the interrupt routine of the slave prepared them
+	unsigned long write_collisions = 0;
+	unsigned long restarts = 0;
+};
+
+/**
+ * Closed loop simulation of the lawnmover: the main core unit (esp32) and the engines and distance control units (uno)
+ * run their real firmware (see Firmware) on a virtual spi bus. The engine pins drive the mower of the LawnWorld which
+ * in turn feeds the echoes of the ultrasonic sensors.
+ *
+ * Everything is deterministic for given options: The microcontroller being due first runs its loop next (ties are
+ * broken by their order); there is no wall clock involved at all.
+ */
+class Simulator {
+public:
+	Simulator(const SimulatorOptions &options, const LawnWorld &world);
+
+	~Simulator();
+
+	/**
+	 * Power on all microcontrollers at time zero
+	 */
+	void powerOn();
+
+	/**
+	 * Run the microcontrollers until none of them is due before the given time anymore
+	 */
+	void runUntil(const unsigned long long micros);
+
+	unsigned long long getNow() const { return _now; };
+
+	const LawnWorld &getWorld() const { return _world; };
+
+	const SpiSlaveMetrics &getEngineMetrics() const { return _engine_metrics; };
+
+	const SpiSlaveMetrics &getObstacleDetectionMetrics() const { return _obstacle_detection_metrics; };
+
+	unsigned long long getLoops() const { return _loops; };
+
+	unsigned long long getEchoes() const { return _echoes; };
+
+	unsigned long long getCrossTalkEchoes() const { return _cross_talk_echoes; };
+
+	// called by the firmware hooks
+	void onPinChanged(Firmware *firmware, const uint8_t pin, const int value);
+
+	unsigned long onPulseIn(Firmware *firmware, const uint8_t pin, const uint8_t state, const unsigned long timeout);
+
+	bool onSpiTransfer(Firmware *firmware, const int cs_pin, const uint8_t *tx, uint8_t *rx, const size_t size,
+					   const unsigned long long start_micros, const unsigned long bit_nanoseconds);
+
+private:
+	void updateEngines();
+
+	uint8_t corrupt(const uint8_t value, SpiSlaveMetrics &metrics);
+
+	bool mountByRxPin(const uint8_t pin, UltrasonicMount &mount) const;
+
+	/**
+	 * Measure the echo of one sensor in the world (with noise and dropouts)
+	 *
+	 * @return the round trip in microseconds or a negative value if there is no echo
+	 */
+	double measureEcho(const UltrasonicMount &mount);
+
+	/**
+	 * The tx pin triggers all sensors at once; each of them not busy with a previous echo answers on its rx pin
+	 */
+	void triggerUltrasonicSensors(Firmware *firmware);
+
+	const SimulatorOptions k_options;
+	LawnWorld _world;
+	std::mt19937 _random;
+
+	Firmware _main_core_unit;
+	Firmware _engines_control_unit;
+	Firmware _distance_control_unit;
+	Firmware *const k_firmwares[3];
+
+	unsigned long long _now = 0;
+	unsigned long long _loops = 0;
+	unsigned long long _echoes = 0;
+	unsigned long long _cross_talk_echoes = 0;
+	// the echo pin of each sensor (see k_ultra_rx_pins) is high until then
+	unsigned long long _echo_busy_until[SIMULATOR_ULTRASONIC_SENSORS] = {};
+	SpiSlaveMetrics _engine_metrics;
+	SpiSlaveMetrics _obstacle_detection_metrics;
+};
+
+#endif // SIMULATOR_H
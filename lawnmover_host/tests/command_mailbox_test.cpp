@@ -0,0 +1,157 @@
+/**
+ * Host tests of the mailbox handing the data push commands of a frame from the spi interrupt routine to the loop: what
+ * the consumer gets is always the latest complete frame, and never a mix of two frames while the producer keeps
+ * publishing.
+ */
+#include <gtest/gtest.h>
+
+#include <command_mailbox.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+	const uint8_t k_capacity = 4;
+
+	typedef CommandMailbox<k_capacity> Mailbox;
+
+	/**
+	 * Stage the given amount of commands, all of them with the id and value bytes of the frame
+	 */
+	void stageFrame(Mailbox &mailbox, const int16_t frame, const uint8_t amount) {
+		uint8_t valueBytes[COMMAND_FRAME_VALUE_SIZE];
+		memset(valueBytes, frame & 0xFF, sizeof valueBytes);
+		for (uint8_t i = 0; i < amount; i++) {
+			mailbox.stage(frame, valueBytes);
+		}
+	}
+
+	/**
+	 * @return whether all commands of the snapshot stem from the frame
+	 */
+	bool stemsFrom(const Mailbox::Snapshot &snapshot, const int16_t frame) {
+		for (uint8_t i = 0; i < snapshot.amount; i++) {
+			if (snapshot.commands[i].id != frame) {
+				return false;
+			}
+			for (uint8_t byte : snapshot.commands[i].value_bytes) {
+				if (byte != (frame & 0xFF)) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+TEST(CommandMailboxTest, HasNothingBeforeThePublish) {
+	Mailbox mailbox;
+	Mailbox::Snapshot snapshot = {};
+	EXPECT_FALSE(mailbox.consume(snapshot));
+	stageFrame(mailbox, 1, 2);
+	EXPECT_FALSE(mailbox.consume(snapshot));
+}
+
+TEST(CommandMailboxTest, HandsOverAPublishedFrameOnce) {
+	Mailbox mailbox;
+	Mailbox::Snapshot snapshot = {};
+	stageFrame(mailbox, 7, 3);
+	mailbox.publish();
+	ASSERT_TRUE(mailbox.consume(snapshot));
+	EXPECT_EQ(3, snapshot.amount);
+	EXPECT_TRUE(stemsFrom(snapshot, 7));
+	EXPECT_FALSE(mailbox.consume(snapshot));
+}
+
+TEST(CommandMailboxTest, HandsOverTheLatestFrameOnly) {
+	Mailbox mailbox;
+	Mailbox::Snapshot snapshot = {};
+	stageFrame(mailbox, 1, 4);
+	mailbox.publish();
+	stageFrame(mailbox, 2, 1);
+	mailbox.publish();
+	ASSERT_TRUE(mailbox.consume(snapshot));
+	EXPECT_EQ(1, snapshot.amount);
+	EXPECT_TRUE(stemsFrom(snapshot, 2));
+}
+
+TEST(CommandMailboxTest, HandsOverAnEmptyFrame) {
+	Mailbox mailbox;
+	Mailbox::Snapshot snapshot = {};
+	stageFrame(mailbox, 1, 2);
+	mailbox.publish();
+	mailbox.publish();
+	ASSERT_TRUE(mailbox.consume(snapshot));
+	EXPECT_EQ(0, snapshot.amount);
+}
+
+TEST(CommandMailboxTest, DropsTheCommandsBeyondTheCapacity) {
+	Mailbox mailbox;
+	Mailbox::Snapshot snapshot = {};
+	uint8_t valueBytes[COMMAND_FRAME_VALUE_SIZE] = {};
+	for (uint8_t i = 0; i < k_capacity; i++) {
+		EXPECT_TRUE(mailbox.stage(3, valueBytes));
+	}
+	EXPECT_FALSE(mailbox.stage(4, valueBytes));
+	mailbox.publish();
+	ASSERT_TRUE(mailbox.consume(snapshot));
+	EXPECT_EQ(k_capacity, snapshot.amount);
+	EXPECT_EQ(3, snapshot.commands[k_capacity - 1].id);
+}
+
+TEST(CommandMailboxTest, DiscardsTheStagedCommands) {
+	Mailbox mailbox;
+	Mailbox::Snapshot snapshot = {};
+	stageFrame(mailbox, 1, 3);
+	mailbox.discard();
+	stageFrame(mailbox, 2, 1);
+	mailbox.publish();
+	ASSERT_TRUE(mailbox.consume(snapshot));
+	EXPECT_EQ(1, snapshot.amount);
+	EXPECT_TRUE(stemsFrom(snapshot, 2));
+}
+
+TEST(CommandMailboxTest, KeepsHandingOverFramesWhenTheSequenceWrapsAround) {
+	Mailbox mailbox;
+	Mailbox::Snapshot snapshot = {};
+	// two increments per publish, i. e. the byte wraps around every 128 frames
+	for (int16_t frame = 0; frame < 300; frame++) {
+		stageFrame(mailbox, frame, 1 + frame % k_capacity);
+		mailbox.publish();
+		ASSERT_TRUE(mailbox.consume(snapshot)) << "frame " << frame;
+		ASSERT_TRUE(stemsFrom(snapshot, frame)) << "frame " << frame;
+		ASSERT_FALSE(mailbox.consume(snapshot)) << "frame " << frame;
+	}
+}
+
+TEST(CommandMailboxTest, NeverMixesFramesOfAConcurrentProducer) {
+	// Stands in for the interrupt routine; the compiler barriers suffice on the stores / loads ordering of x86 hosts.
+	// Runs for a while rather than for an amount of frames, such that both threads get preempted amid their copies
+	// even on a single core.
+	const int16_t frames = 30000;
+	Mailbox mailbox;
+	std::atomic<bool> stop(false);
+	std::thread producer([&]() {
+		for (int16_t frame = 0; !stop; frame = (frame + 1) % frames) {
+			stageFrame(mailbox, frame, 1 + frame % k_capacity);
+			mailbox.publish();
+		}
+	});
+
+	Mailbox::Snapshot snapshot = {};
+	int consumed = 0;
+	bool consistent = true;
+	const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+	while (consistent && std::chrono::steady_clock::now() < until) {
+		if (mailbox.consume(snapshot)) {
+			const int16_t frame = snapshot.commands[0].id;
+			consistent = snapshot.amount == 1 + frame % k_capacity && stemsFrom(snapshot, frame);
+			consumed++;
+		}
+	}
+	stop = true;
+	producer.join();
+	EXPECT_TRUE(consistent) << "mixed frames after " << consumed << " snapshots";
+	EXPECT_LT(0, consumed);
+}
@@ -0,0 +1,199 @@
+/**
+ * Host tests of the path planning of the coverage map: the paths are checked cell by cell (neighbours, not blocked,
+ * ending at an uncovered cell seen free) and their length against a breadth first search of the test itself, on
+ * handmade and random maps. Paths cut after max_length cells must be the start of the full path.
+ */
+#include <gtest/gtest.h>
+
+#include <coverage_map.h>
+
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace {
+	const int k_half = COVERAGE_MAP_CELLS / 2;
+
+	bool isTarget(const CoverageMap &map, const int x, const int y) {
+		return map.isSeen(x, y) && !map.isCovered(x, y);
+	}
+
+	/**
+	 * @return the amount of cells to pass from the given cell to the closest target; 0 if there is none
+	 */
+	int distanceToClosestTarget(const CoverageMap &map, const CoverageCell &from, const CoverageCell *avoid) {
+		std::vector<int> distances(COVERAGE_MAP_CELLS * COVERAGE_MAP_CELLS, -1);
+		const auto index = [](const int x, const int y) { return (y + k_half) * COVERAGE_MAP_CELLS + x + k_half; };
+		if (avoid != nullptr) {
+			distances[index(avoid->x, avoid->y)] = 0;
+		}
+		std::deque<CoverageCell> queue = {from};
+		distances[index(from.x, from.y)] = 0;
+		const int steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+		while (!queue.empty()) {
+			const CoverageCell cell = queue.front();
+			queue.pop_front();
+			for (const auto &step : steps) {
+				const int x = cell.x + step[0];
+				const int y = cell.y + step[1];
+				if (map.isBlocked(x, y) || distances[index(x, y)] >= 0) {
+					continue;
+				}
+				distances[index(x, y)] = distances[index(cell.x, cell.y)] + 1;
+				if (isTarget(map, x, y)) {
+					return distances[index(x, y)];
+				}
+				queue.push_back({(int8_t) x, (int8_t) y});
+			}
+		}
+		return 0;
+	}
+
+	/**
+	 * Check the full path from the given cell: neighbour by neighbour through cells not blocked (nor avoided) to the
+	 * closest target
+	 */
+	void expectValidPath(const CoverageMap &map, const CoverageCell &from, const CoverageCell *avoid,
+						 const std::vector<CoverageCell> &path) {
+		ASSERT_EQ(distanceToClosestTarget(map, from, avoid), (int) path.size());
+		CoverageCell previous = from;
+		for (size_t i = 0; i < path.size(); i++) {
+			const CoverageCell &cell = path[i];
+			EXPECT_EQ(1, abs(cell.x - previous.x) + abs(cell.y - previous.y)) << "cell " << i;
+			EXPECT_FALSE(map.isBlocked(cell.x, cell.y)) << "cell " << i;
+			if (avoid != nullptr) {
+				EXPECT_FALSE(cell.x == avoid->x && cell.y == avoid->y) << "cell " << i;
+			}
+			// the path stops at the first target
+			EXPECT_EQ(i + 1 == path.size(), isTarget(map, cell.x, cell.y)) << "cell " << i;
+			previous = cell;
+		}
+	}
+
+	std::vector<CoverageCell> planPath(CoverageMap &map, const CoverageCell &from, const int max_length,
+									   const CoverageCell *avoid = nullptr) {
+		std::vector<CoverageCell> path((size_t) max_length);
+		path.resize((size_t) map.planPath(from, path.data(), max_length, avoid));
+		return path;
+	}
+
+	void expectSameCells(const std::vector<CoverageCell> &expected, const std::vector<CoverageCell> &actual) {
+		ASSERT_EQ(expected.size(), actual.size());
+		for (size_t i = 0; i < expected.size(); i++) {
+			EXPECT_EQ(expected[i].x, actual[i].x) << "cell " << i;
+			EXPECT_EQ(expected[i].y, actual[i].y) << "cell " << i;
+		}
+	}
+}
+
+TEST(CoverageMapTest, PlansTheStraightPath) {
+	CoverageMap map;
+	map.setSeen(4, 0);
+	const std::vector<CoverageCell> path = planPath(map, {0, 0}, 16);
+	expectSameCells({{1, 0}, {2, 0}, {3, 0}, {4, 0}}, path);
+}
+
+TEST(CoverageMapTest, PlansAroundAWall) {
+	// a wall from (2, -3) to (2, 3) between the start and the only target
+	CoverageMap map;
+	for (int y = -3; y <= 3; y++) {
+		map.setBlocked(2, y, true);
+	}
+	map.setSeen(4, 0);
+	const CoverageCell from = {0, 0};
+	const std::vector<CoverageCell> path = planPath(map, from, 32);
+	expectValidPath(map, from, nullptr, path);
+	// up or down to the end of the wall, around it and back
+	EXPECT_EQ(4 + 4 + 4, (int) path.size());
+}
+
+TEST(CoverageMapTest, PlansToTheClosestTarget) {
+	CoverageMap map;
+	map.setSeen(-5, 0);
+	map.setSeen(0, 3);
+	map.setSeen(2, 0);
+	map.setCovered(2, 0);
+	const std::vector<CoverageCell> path = planPath(map, {0, 0}, 16);
+	expectSameCells({{0, 1}, {0, 2}, {0, 3}}, path);
+}
+
+TEST(CoverageMapTest, AvoidsTheGivenCell) {
+	CoverageMap map;
+	map.setSeen(3, 0);
+	const CoverageCell from = {0, 0};
+	const CoverageCell avoid = {1, 0};
+	const std::vector<CoverageCell> path = planPath(map, from, 16, &avoid);
+	expectValidPath(map, from, &avoid, path);
+	EXPECT_EQ(5, (int) path.size());
+}
+
+TEST(CoverageMapTest, PlansNothingWithoutAReachableTarget) {
+	CoverageMap map;
+	CoverageCell path[4];
+	EXPECT_EQ(0, map.planPath({0, 0}, path, 4));
+
+	// the target is enclosed
+	map.setSeen(5, 5);
+	for (int i = 4; i <= 6; i++) {
+		map.setBlocked(i, 4, true);
+		map.setBlocked(i, 6, true);
+		map.setBlocked(4, i, true);
+		map.setBlocked(6, i, true);
+	}
+	EXPECT_EQ(0, map.planPath({0, 0}, path, 4));
+	// or the start is outside of the map
+	map.setSeen(k_half - 1, 0);
+	EXPECT_EQ(0, map.planPath({(int8_t) k_half, 0}, path, 4));
+	EXPECT_EQ(1, map.planPath({(int8_t) (k_half - 2), 0}, path, 4));
+}
+
+TEST(CoverageMapTest, CutsThePathAfterMaxLength) {
+	// a path of 10 cells along the edge of the map, the cells outside of the map being blocked
+	CoverageMap map;
+	map.setSeen(-k_half + 10, -k_half);
+	const CoverageCell from = {(int8_t) -k_half, (int8_t) -k_half};
+	const std::vector<CoverageCell> full = planPath(map, from, 64);
+	ASSERT_EQ(10u, full.size());
+	expectValidPath(map, from, nullptr, full);
+	for (int max_length = 1; max_length <= 12; max_length++) {
+		SCOPED_TRACE(max_length);
+		const std::vector<CoverageCell> cut = planPath(map, from, max_length);
+		expectSameCells(std::vector<CoverageCell>(full.begin(), full.begin() + std::min(10, max_length)), cut);
+	}
+}
+
+TEST(CoverageMapTest, PlansValidPathsOnRandomMaps) {
+	std::mt19937 generator(19);
+	std::uniform_int_distribution<int> cell(-k_half, k_half - 1);
+	std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+	CoverageMap map;
+	for (int trial = 0; trial < 50; trial++) {
+		SCOPED_TRACE(trial);
+		map.clear();
+		for (int y = -k_half; y < k_half; y++) {
+			for (int x = -k_half; x < k_half; x++) {
+				const float roll = chance(generator);
+				if (roll < 0.3f) {
+					map.setBlocked(x, y, true);
+				} else if (roll < 0.6f) {
+					map.setCovered(x, y);
+					map.setSeen(x, y);
+				} else if (roll < 0.602f) {
+					map.setSeen(x, y);
+				}
+			}
+		}
+		const CoverageCell from = {(int8_t) cell(generator), (int8_t) cell(generator)};
+		map.setBlocked(from.x, from.y, false);
+		const CoverageCell avoid = {(int8_t) (from.x + 1), from.y};
+		const CoverageCell *avoided = trial % 2 == 0 ? &avoid : nullptr;
+
+		const std::vector<CoverageCell> full = planPath(map, from, COVERAGE_MAP_CELLS * COVERAGE_MAP_CELLS, avoided);
+		expectValidPath(map, from, avoided, full);
+		for (const int max_length : {1, 3, 8}) {
+			const std::vector<CoverageCell> cut = planPath(map, from, max_length, avoided);
+			const size_t kept = std::min(full.size(), (size_t) max_length);
+			expectSameCells(std::vector<CoverageCell>(full.begin(), full.begin() + kept), cut);
+		}
+	}
+}
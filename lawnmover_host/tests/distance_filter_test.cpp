@@ -0,0 +1,68 @@
+/**
+ * Host tests of the distance filters: distances measured at a steady rate, and the same measurement polled again with
+ * its time shifted by the latency of the poll, which must not count as new information.
+ */
+#include <gtest/gtest.h>
+
+#include <distance_filter.h>
+
+namespace {
+	// the slowest sweep of the sensors (five of them, one after the other)
+	const unsigned long k_sample_interval_millis = 5 * 45;
+
+	/**
+	 * Distances of an obstacle approaching at 40 cm/s from 200 cm
+	 */
+	void putApproach(DistanceFilter &filter, const int amount, const bool repeatEach) {
+		for (int i = 0; i < amount; i++) {
+			const unsigned long sample_millis = i * k_sample_interval_millis;
+			const float distance = 200.0f - 40.0f * sample_millis / 1000.0f;
+			filter.put(distance, sample_millis);
+			if (repeatEach) {
+				// the latency of the next poll makes the distance look 2 ms newer
+				filter.put(distance, sample_millis + 2);
+			}
+		}
+	}
+}
+
+TEST(DistanceFilterTest, IgnoresARepeatedMeasurement) {
+	ExponentialMovingAverageFilter average;
+	ExponentialMovingAverageFilter repeatedAverage;
+	putApproach(average, 8, false);
+	putApproach(repeatedAverage, 8, true);
+	EXPECT_EQ(average.get(), repeatedAverage.get());
+
+	AlphaBetaFilter alphaBeta;
+	AlphaBetaFilter repeatedAlphaBeta;
+	putApproach(alphaBeta, 8, false);
+	putApproach(repeatedAlphaBeta, 8, true);
+	EXPECT_EQ(alphaBeta.get(), repeatedAlphaBeta.get());
+	EXPECT_EQ(alphaBeta.get_velocity(), repeatedAlphaBeta.get_velocity());
+
+	KalmanFilter kalman;
+	KalmanFilter repeatedKalman;
+	putApproach(kalman, 8, false);
+	putApproach(repeatedKalman, 8, true);
+	EXPECT_EQ(kalman.get(), repeatedKalman.get());
+	EXPECT_EQ(kalman.get_variance(), repeatedKalman.get_variance());
+}
+
+TEST(DistanceFilterTest, IgnoresAnOlderMeasurement) {
+	AlphaBetaFilter filter;
+	filter.put(100.0f, 1000);
+	filter.put(50.0f, 900);
+	EXPECT_EQ(100.0f, filter.get());
+	EXPECT_EQ(0.0f, filter.get_velocity());
+}
+
+TEST(DistanceFilterTest, TracksTheApproachAtTheFastestSweep) {
+	// each sensor measures every 45 ms at most
+	AlphaBetaFilter filter;
+	for (int i = 0; i < 100; i++) {
+		const unsigned long sample_millis = i * 45UL;
+		filter.put(200.0f - 40.0f * sample_millis / 1000.0f, sample_millis);
+	}
+	EXPECT_NEAR(-40.0f, filter.get_velocity(), 1.0f);
+	EXPECT_NEAR(200.0f - 40.0f * 99 * 45 / 1000.0f, filter.get(), 1.0f);
+}
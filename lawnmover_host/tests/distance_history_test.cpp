@@ -0,0 +1,119 @@
+/**
+ * Host tests of the sliding window of distances: min, max and mean of the monotonic deques and of the running sum
+ * against a plain window recomputed for every distance put.
+ */
+#include <gtest/gtest.h>
+
+#include <distance_history.h>
+
+#include <algorithm>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+	/**
+	 * Put the distances one by one into a history of the given capacity and compare it to the plain window after each
+	 * of them
+	 */
+	void expectSameAsPlainWindow(const int capacity, const std::vector<float> &distances) {
+		DistanceHistory history;
+		history.resize(capacity);
+		std::deque<float> window;
+		for (size_t i = 0; i < distances.size(); i++) {
+			history.put(distances[i]);
+			window.push_back(distances[i]);
+			if (static_cast<int>(window.size()) > capacity) {
+				window.pop_front();
+			}
+
+			ASSERT_EQ(static_cast<int>(window.size()), history.size()) << "distance " << i;
+			ASSERT_EQ(static_cast<int>(window.size()) == capacity, history.full()) << "distance " << i;
+			ASSERT_EQ(window.back(), history.latest()) << "distance " << i;
+			ASSERT_EQ(window.front(), history.oldest()) << "distance " << i;
+			ASSERT_EQ(*std::min_element(window.begin(), window.end()), history.min()) << "distance " << i;
+			ASSERT_EQ(*std::max_element(window.begin(), window.end()), history.max()) << "distance " << i;
+			const float mean = std::accumulate(window.begin(), window.end(), 0.0f) / window.size();
+			ASSERT_NEAR(mean, history.mean(), 1e-3f) << "distance " << i;
+		}
+	}
+
+	std::vector<float> randomDistances(const int amount, const unsigned int seed) {
+		std::mt19937 generator(seed);
+		std::uniform_real_distribution<float> distance(0.0f, 400.0f);
+		std::vector<float> distances(amount);
+		for (float &value : distances) {
+			value = distance(generator);
+		}
+		return distances;
+	}
+}
+
+TEST(DistanceHistoryTest, StartsEmpty) {
+	DistanceHistory history;
+	history.resize(4);
+	EXPECT_TRUE(history.empty());
+	EXPECT_FALSE(history.full());
+	EXPECT_EQ(0, history.size());
+	EXPECT_EQ(4, history.capacity());
+}
+
+TEST(DistanceHistoryTest, MatchesThePlainWindowOnRandomDistances) {
+	for (const int capacity : {1, 2, 3, 7, 16, 64}) {
+		SCOPED_TRACE(capacity);
+		expectSameAsPlainWindow(capacity, randomDistances(1000, static_cast<unsigned int>(capacity)));
+	}
+}
+
+TEST(DistanceHistoryTest, MatchesThePlainWindowOnMonotonicDistances) {
+	// ascending distances keep every slot in the min deque, descending ones every slot in the max deque
+	std::vector<float> ascending(200);
+	std::vector<float> descending(200);
+	for (int i = 0; i < 200; i++) {
+		ascending[i] = static_cast<float>(i);
+		descending[i] = static_cast<float>(200 - i);
+	}
+	for (const int capacity : {1, 5, 16}) {
+		SCOPED_TRACE(capacity);
+		expectSameAsPlainWindow(capacity, ascending);
+		expectSameAsPlainWindow(capacity, descending);
+	}
+}
+
+TEST(DistanceHistoryTest, MatchesThePlainWindowOnRepeatedDistances) {
+	std::vector<float> distances;
+	for (int i = 0; i < 300; i++) {
+		// runs of equal distances, e. g. a sensor stuck at its max distance
+		distances.push_back(static_cast<float>((i / 7) % 3) * 100.0f);
+	}
+	for (const int capacity : {1, 4, 10}) {
+		SCOPED_TRACE(capacity);
+		expectSameAsPlainWindow(capacity, distances);
+	}
+}
+
+TEST(DistanceHistoryTest, DropsTheDistancesUponResize) {
+	DistanceHistory history;
+	history.resize(3);
+	history.put(10.0f);
+	history.put(5.0f);
+	history.resize(2);
+	EXPECT_TRUE(history.empty());
+	EXPECT_EQ(2, history.capacity());
+	history.put(20.0f);
+	EXPECT_EQ(20.0f, history.min());
+	EXPECT_EQ(20.0f, history.max());
+	EXPECT_EQ(20.0f, history.mean());
+}
+
+TEST(DistanceHistoryTest, KeepsAtLeastOneDistance) {
+	DistanceHistory history;
+	history.resize(0);
+	EXPECT_EQ(1, history.capacity());
+	history.put(10.0f);
+	history.put(30.0f);
+	EXPECT_EQ(1, history.size());
+	EXPECT_EQ(30.0f, history.min());
+	EXPECT_EQ(30.0f, history.max());
+}
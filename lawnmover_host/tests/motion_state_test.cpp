@@ -0,0 +1,170 @@
+/**
+ * Host tests of the table driven motion state machine: the decisions on a fixed distance stream are compared to the
+ * ones recorded from the current table (golden decisions), and each predicate is evaluated at most once per decision.
+ * Update the golden decisions only along with an intended change of the table.
+ */
+#include <gtest/gtest.h>
+
+#include <motion_state.h>
+
+#include <cstdio>
+#include <string>
+
+namespace {
+	const int k_decisions = 96;
+
+	/**
+	 * Three approaches of an obstacle of 32 samples each: free in front first, then closer and closer until the front
+	 * is blocked. The second approach has less room to the left than to the right, the third one has no room in the
+	 * back either. The min distances are the same as the weighted moving averages.
+	 */
+	DirectionArray<float> sampleAt(const int decision) {
+		const int approach = decision / 32;
+		const int step = decision % 32;
+		const float front = step < 29 ? 150.0f - 5.0f * step : 10.0f;
+		DirectionArray<float> sample;
+		sample[Category::FRONT] = front;
+		sample[Category::FRONT_LEFT] = front + (approach == 1 ? 5.0f : 20.0f);
+		sample[Category::FRONT_RIGHT] = front + (approach == 1 ? 20.0f : 10.0f);
+		sample[Category::BACK_LEFT] = approach < 2 ? 150.0f : 20.0f;
+		sample[Category::BACK_RIGHT] = approach < 2 ? 150.0f : 20.0f;
+		return sample;
+	}
+
+	/**
+	 * Serial of the firmware logging at the given level into a temporary file
+	 */
+	class SerialCapture {
+	public:
+		explicit SerialCapture(const SerialLogger::LOG_LEVEL logLevel) : _file(tmpfile()) {
+			ArduinoShim::setSerialOutput(_file);
+			SerialLogger::init(9600, logLevel);
+		};
+
+		~SerialCapture() {
+			SerialLogger::init(9600, SerialLogger::LOG_LEVEL::NONE);
+			ArduinoShim::setSerialOutput(nullptr);
+			fclose(_file);
+		};
+
+		SerialCapture(const SerialCapture &capture) = delete;
+
+		SerialCapture &operator=(const SerialCapture &capture) = delete;
+
+		/**
+		 * @return how often the text was printed so far
+		 */
+		int count(const std::string &text) const {
+			fflush(_file);
+			rewind(_file);
+			std::string output;
+			char chunk[256];
+			size_t read;
+			while ((read = fread(chunk, 1, sizeof chunk, _file)) > 0) {
+				output.append(chunk, read);
+			}
+			int amount = 0;
+			for (size_t at = output.find(text); at != std::string::npos; at = output.find(text, at + text.size())) {
+				amount++;
+			}
+			return amount;
+		};
+
+	private:
+		FILE *_file;
+	};
+}
+
+TEST(MotionStateMachineTest, MatchesTheGoldenDecisions) {
+	const MotionStateId golden[k_decisions] = {
+			IDLE_MOTION, LOW_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION,
+			MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, FULL_SPEED_FORWARD_MOTION,
+			FULL_SPEED_FORWARD_MOTION, FULL_SPEED_FORWARD_MOTION, FULL_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION,
+			MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION,
+			MID_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION,
+			LOW_SPEED_FORWARD_MOTION, IDLE_MOTION, LEFT_TURN_MOTION, LEFT_TURN_MOTION,
+			LEFT_TURN_MOTION, BACKWARD_MOTION, BACKWARD_MOTION, BACKWARD_MOTION,
+			BACKWARD_MOTION, IDLE_MOTION, BACKWARD_MOTION, BACKWARD_MOTION,
+			// less room to the left
+			BACKWARD_MOTION, BACKWARD_MOTION, IDLE_MOTION, LOW_SPEED_FORWARD_MOTION,
+			LOW_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION,
+			MID_SPEED_FORWARD_MOTION, FULL_SPEED_FORWARD_MOTION, FULL_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION,
+			MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION,
+			MID_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION,
+			LOW_SPEED_FORWARD_MOTION, IDLE_MOTION, RIGHT_TURN_MOTION, RIGHT_TURN_MOTION,
+			RIGHT_TURN_MOTION, BACKWARD_MOTION, BACKWARD_MOTION, BACKWARD_MOTION,
+			BACKWARD_MOTION, IDLE_MOTION, BACKWARD_MOTION, BACKWARD_MOTION,
+			// no room in the back
+			ERROR_MOTION, IDLE_MOTION, LOW_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION,
+			LOW_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION,
+			FULL_SPEED_FORWARD_MOTION, FULL_SPEED_FORWARD_MOTION, FULL_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION,
+			MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION, MID_SPEED_FORWARD_MOTION,
+			MID_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION,
+			LOW_SPEED_FORWARD_MOTION, IDLE_MOTION, ERROR_MOTION, IDLE_MOTION,
+			ERROR_MOTION, IDLE_MOTION, ERROR_MOTION, IDLE_MOTION,
+			ERROR_MOTION, IDLE_MOTION, ERROR_MOTION, IDLE_MOTION
+	};
+	SerialCapture capture(SerialLogger::LOG_LEVEL::NONE);
+	MotionStateMachine motionStateMachine;
+	bool entered[AMOUNT_MOTION_STATES] = {};
+	for (int decision = 0; decision < k_decisions; decision++) {
+		const DirectionArray<float> sample = sampleAt(decision);
+		MotionPredicates predicates(sample, sample);
+		ASSERT_EQ(golden[decision], motionStateMachine.next(predicates)) << "decision " << decision;
+		ASSERT_EQ(golden[decision], motionStateMachine.get_state()) << "decision " << decision;
+		entered[golden[decision]] = true;
+	}
+	// the stream is worth its while only if it walks through every motion
+	for (int state = 0; state < PRIORITY_STRATEGY; state++) {
+		EXPECT_TRUE(entered[state]) << MotionStateTable::get(static_cast<MotionStateId>(state)).name;
+	}
+}
+
+TEST(MotionPredicatesTest, EvaluatesEachPredicateOnce) {
+	// The front is inconsistent, i. e. both turns (and their mapped eligibility) ask for FRONT_CONSISTENT in the same
+	// decision before falling back to the backward motion. Each evaluation warns about the discrepancy.
+	SerialCapture capture(SerialLogger::LOG_LEVEL::WARNING);
+	const std::string warning = "Discrepancy between front min and wAvg distances";
+	DirectionArray<float> minDistances;
+	DirectionArray<float> weightedMovingAvgDistances;
+	for (int i = 0; i < DirectionArray<float>::size(); i++) {
+		minDistances[DirectionArray<float>::directionAt(i)] = 150.0f;
+		weightedMovingAvgDistances[DirectionArray<float>::directionAt(i)] = 150.0f;
+	}
+	minDistances[Category::FRONT] = 10.0f;
+
+	MotionStateMachine motionStateMachine(PRIORITY_STRATEGY);
+	MotionPredicates predicates(minDistances, weightedMovingAvgDistances);
+	EXPECT_EQ(BACKWARD_MOTION, motionStateMachine.next(predicates));
+	EXPECT_EQ(1, capture.count(warning));
+
+	const MotionPredicateMask evaluated = predicates.get_evaluated();
+	EXPECT_NE(0u, evaluated & motionPredicateBit(FRONT_CONSISTENT));
+	EXPECT_NE(0u, evaluated & motionPredicateBit(BACK_CONSISTENT));
+	// asking again takes the remembered values
+	EXPECT_FALSE(predicates.hold(motionPredicateBit(FRONT_CONSISTENT)));
+	EXPECT_FALSE(predicates.hold(evaluated));
+	EXPECT_EQ(evaluated, predicates.get_evaluated());
+	EXPECT_EQ(1, capture.count(warning));
+
+	// the next decision has a context of its own
+	motionStateMachine.reset(PRIORITY_STRATEGY);
+	MotionPredicates nextPredicates(minDistances, weightedMovingAvgDistances);
+	EXPECT_EQ(BACKWARD_MOTION, motionStateMachine.next(nextPredicates));
+	EXPECT_EQ(2, capture.count(warning));
+}
+
+TEST(MotionPredicatesTest, KeepsTheEvaluatedPredicatesOfADecision) {
+	SerialCapture capture(SerialLogger::LOG_LEVEL::NONE);
+	MotionStateMachine motionStateMachine;
+	for (int decision = 0; decision < k_decisions; decision++) {
+		const DirectionArray<float> sample = sampleAt(decision);
+		MotionPredicates predicates(sample, sample);
+		motionStateMachine.next(predicates);
+		// e. g. nothing at all for the first self iteration of the idle motion
+		const MotionPredicateMask evaluated = predicates.get_evaluated();
+		EXPECT_EQ(0u, evaluated >> AMOUNT_MOTION_PREDICATES) << "decision " << decision;
+		predicates.hold(evaluated);
+		EXPECT_EQ(evaluated, predicates.get_evaluated()) << "decision " << decision;
+	}
+}
@@ -0,0 +1,212 @@
+/**
+ * Host tests of the crc-8 and of the compact and pipelined frames: the master puts a frame, a slave answers it as the
+ * spi slave module does, and the master reads the answer through the CompactFrameView.
+ */
+#include <gtest/gtest.h>
+
+#include <spi_commands.h>
+
+#include <vector>
+
+namespace {
+	/**
+	 * Crc-8 with the polynomial 0x07 shifting bit by bit
+	 */
+	uint8_t crc8BitByBit(uint8_t crc, const uint8_t *bytes, const long length) {
+		for (long i = 0; i < length; i++) {
+			crc ^= bytes[i];
+			for (int bit = 0; bit < 8; bit++) {
+				crc = (crc & 0x80) != 0 ? (uint8_t) ((crc << 1) ^ 0x07) : (uint8_t) (crc << 1);
+			}
+		}
+		return crc;
+	}
+
+	const uint8_t k_check_bytes[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+	const DistanceSample k_samples[OBSTACLE_COMMANDS] = {{1234, 5}, {80, 0}, {65535, 65535}, {0, 17}, {4000, 300}};
+
+	/**
+	 * The frame of the master: the engine commands (data pushes) or the obstacle commands (data requests)
+	 */
+	std::vector<uint8_t> putFrame(const uint8_t marker, const uint8_t sequence, const int16_t firstId,
+								  const uint8_t amount) {
+		const long size = marker == COMPACT_FRAME_MARKER ? SpiCommands::getCompactFrameSize(firstId, amount)
+														 : SpiCommands::getPipelinedFrameSize(firstId, amount);
+		std::vector<uint8_t> frame((size_t) size, 0);
+		uint8_t crc = SpiCommands::putCompactFrameHeader(marker, sequence, firstId, amount, frame.data());
+		long offset = COMPACT_FRAME_HEADER_SIZE;
+		for (uint8_t i = 0; i < amount; i++) {
+			const int16_t id = (int16_t) (firstId + i);
+			if (SpiCommandTable::get(id).direction == DATA_PUSH) {
+				// more bytes than the value size of the id
+				offset = SpiCommands::putCompactValueToBuffer(id, offset, 1000 * id - 2500, frame.data(), crc);
+			} else {
+				offset = SpiCommands::putCompactValueToBuffer(id, offset, DATA_REQUEST_VALUE_BYTES, frame.data(), crc);
+			}
+		}
+		if (marker == COMPACT_FRAME_MARKER) {
+			SpiCommands::putCompactFrameTrailer(frame.data(), size, crc);
+		} else {
+			SpiCommands::putPipelinedFrameTrailer(frame.data(), size, crc);
+		}
+		return frame;
+	}
+
+	/**
+	 * The frame of the slave answering: the echo of the header and of the pushed values, the requested values and the
+	 * crc-8 of its bytes at crcIndex
+	 */
+	std::vector<uint8_t> answerFrame(const std::vector<uint8_t> &request, const long crcIndex) {
+		std::vector<uint8_t> answer(request.begin(), request.begin() + crcIndex);
+		const CompactFrameView frame(request.data(), answer.data(), crcIndex);
+		for (int i = 0; i < frame.getAmount(); i++) {
+			const int16_t id = (int16_t) (frame.getFirstId() + i);
+			if (SpiCommandTable::get(id).direction == DATA_REQUEST) {
+				memcpy(answer.data() + SpiCommands::getCompactValueOffset(frame.getFirstId(), i),
+					   &k_samples[id - OBSTACLE_FRONT_COMMAND], sizeof(DistanceSample));
+			}
+		}
+		answer.push_back(SpiCommands::computeCrc8(answer.data(), crcIndex));
+		return answer;
+	}
+
+	/**
+	 * Read the answer as the master does
+	 *
+	 * @return whether the header and the pushed values are echoed and the crc-8 holds
+	 */
+	bool readAnswer(const std::vector<uint8_t> &request, const std::vector<uint8_t> &answer, const long crcIndex,
+					std::vector<DistanceSample> &samples) {
+		const CompactFrameView frame(request.data(), answer.data(), crcIndex);
+		uint8_t crc;
+		bool echoes = frame.echoesHeader(crc);
+		long offset = COMPACT_FRAME_HEADER_SIZE;
+		samples.clear();
+		for (int i = 0; i < frame.getAmount(); i++) {
+			const SpiCommandSpec &command = SpiCommandTable::get((int16_t) (frame.getFirstId() + i));
+			if (command.direction == DATA_REQUEST) {
+				DistanceSample sample;
+				memcpy(&sample, frame.getAnswerValueBytes(offset, command.value_size, crc), sizeof sample);
+				samples.push_back(sample);
+			} else {
+				echoes &= frame.echoesValue(offset, command.value_size, crc);
+			}
+			offset += command.value_size;
+		}
+		return echoes && frame.hasValidCrc(crc);
+	}
+}
+
+TEST(SpiCommandsTest, MatchesTheCrc8CheckValues) {
+	// CRC-8/SMBUS starts at 0, the frames at COMPACT_FRAME_CRC_INIT
+	EXPECT_EQ(0xF4, SpiCommands::updateCrc8(0, k_check_bytes, sizeof k_check_bytes));
+	EXPECT_EQ(0xFB, SpiCommands::computeCrc8(k_check_bytes, sizeof k_check_bytes));
+	EXPECT_EQ(COMPACT_FRAME_CRC_INIT, SpiCommands::computeCrc8(k_check_bytes, 0));
+}
+
+TEST(SpiCommandsTest, MatchesTheCrc8BitByBit) {
+	for (int crc = 0; crc < 256; crc++) {
+		for (int data = 0; data < 256; data++) {
+			const uint8_t byte = (uint8_t) data;
+			ASSERT_EQ(crc8BitByBit((uint8_t) crc, &byte, 1), SpiCommands::updateCrc8((uint8_t) crc, byte))
+										<< "crc " << crc << ", data " << data;
+		}
+	}
+}
+
+TEST(SpiCommandsTest, DetectsEverySingleAndCloseDoubleBitError) {
+	// 0x07 has the order 127, i. e. two flipped bits 127 bits apart (or a multiple of it) cancel out. The bits count from
+	// the most significant one of the first byte as the crc-8 shifts them.
+	const long period = 127;
+	const std::vector<uint8_t> frame = putFrame(COMPACT_FRAME_MARKER, 9, OBSTACLE_FRONT_COMMAND, OBSTACLE_COMMANDS);
+	const long length = (long) frame.size() - COMPACT_FRAME_CRC_SIZE - COMMAND_SPI_RX_OFFSET;
+	const uint8_t crc = SpiCommands::computeCrc8(frame.data(), length);
+	std::vector<uint8_t> corrupted(frame.begin(), frame.begin() + length);
+	for (long first = 0; first < length * 8; first++) {
+		corrupted[first / 8] ^= (uint8_t) (0x80 >> (first % 8));
+		ASSERT_NE(crc, SpiCommands::computeCrc8(corrupted.data(), length)) << "bit " << first;
+		for (long second = first + 1; second < length * 8 && second - first < period; second++) {
+			corrupted[second / 8] ^= (uint8_t) (0x80 >> (second % 8));
+			ASSERT_NE(crc, SpiCommands::computeCrc8(corrupted.data(), length)) << "bits " << first << ", " << second;
+			corrupted[second / 8] ^= (uint8_t) (0x80 >> (second % 8));
+		}
+		corrupted[first / 8] ^= (uint8_t) (0x80 >> (first % 8));
+	}
+}
+
+TEST(SpiCommandsTest, SizesTheFramesByTheValueSizes) {
+	// int16_t per engine command, DistanceSample per obstacle command
+	EXPECT_EQ(COMPACT_FRAME_HEADER_SIZE + 3 * 2 + COMPACT_FRAME_CRC_SIZE + COMMAND_SPI_RX_OFFSET,
+			  SpiCommands::getCompactFrameSize(LEFT_WHEEL_STEERING_COMMAND, ENGINE_COMMANDS));
+	EXPECT_EQ(COMPACT_FRAME_HEADER_SIZE + 5 * 4 + COMPACT_FRAME_CRC_SIZE,
+			  SpiCommands::getPipelinedFrameSize(OBSTACLE_FRONT_COMMAND, OBSTACLE_COMMANDS));
+	EXPECT_EQ(COMPACT_FRAME_HEADER_SIZE + 2 + 2, SpiCommands::getCompactValueOffset(LEFT_WHEEL_STEERING_COMMAND, 2));
+	EXPECT_EQ(-1, SpiCommands::getCompactFrameSize(OBSTACLE_BACK_LEFT_COMMAND, 3));
+	EXPECT_EQ(-1, SpiCommands::getPipelinedFrameSize(NO_COMMAND, 1));
+}
+
+TEST(SpiCommandsTest, PutsTheCompactFrame) {
+	const std::vector<uint8_t> frame = putFrame(COMPACT_FRAME_MARKER, 42, LEFT_WHEEL_STEERING_COMMAND,
+												ENGINE_COMMANDS);
+	const uint8_t expected[] = {
+			COMPACT_FRAME_MARKER, 42, LEFT_WHEEL_STEERING_COMMAND, ENGINE_COMMANDS,
+			// -1500, -500 and 500 as little endian int16_t, i. e. the leading bytes of the int
+			0x24, 0xFA, 0x0C, 0xFE, 0xF4, 0x01
+	};
+	ASSERT_EQ(sizeof expected + COMPACT_FRAME_CRC_SIZE + COMMAND_SPI_RX_OFFSET, frame.size());
+	EXPECT_EQ(0, memcmp(expected, frame.data(), sizeof expected));
+	EXPECT_EQ(crc8BitByBit(COMPACT_FRAME_CRC_INIT, expected, sizeof expected), frame[sizeof expected]);
+	EXPECT_EQ(0xFF, frame.back());
+}
+
+TEST(SpiCommandsTest, ReadsTheAnswerToACompactFrame) {
+	const std::vector<uint8_t> request = putFrame(COMPACT_FRAME_MARKER, 7, LEFT_WHEEL_STEERING_COMMAND,
+												  ENGINE_COMMANDS);
+	// the slave answers one byte later, i. e. its crc-8 takes the place of the trailing byte
+	const long crcIndex = (long) request.size() - COMPACT_FRAME_CRC_SIZE - COMMAND_SPI_RX_OFFSET;
+	std::vector<uint8_t> answer = answerFrame(request, crcIndex);
+	const CompactFrameView frame(request.data(), answer.data(), crcIndex);
+	EXPECT_EQ(7, frame.getSequence());
+	EXPECT_EQ(LEFT_WHEEL_STEERING_COMMAND, frame.getFirstId());
+	EXPECT_EQ(ENGINE_COMMANDS, frame.getAmount());
+
+	std::vector<DistanceSample> samples;
+	EXPECT_TRUE(readAnswer(request, answer, crcIndex, samples));
+	EXPECT_TRUE(samples.empty());
+
+	// a value the slave did not echo, with or without a crc-8 matching it
+	answer[SpiCommands::getCompactValueOffset(LEFT_WHEEL_STEERING_COMMAND, 1)] ^= 0x10;
+	EXPECT_FALSE(readAnswer(request, answer, crcIndex, samples));
+	answer[crcIndex] = SpiCommands::computeCrc8(answer.data(), crcIndex);
+	EXPECT_FALSE(readAnswer(request, answer, crcIndex, samples));
+}
+
+TEST(SpiCommandsTest, ReadsTheAnswerToAPipelinedFrame) {
+	const std::vector<uint8_t> request = putFrame(PIPELINED_FRAME_MARKER, 255, OBSTACLE_FRONT_COMMAND,
+												  OBSTACLE_COMMANDS);
+	// without a trailing byte the crc-8 of the slave is at the place of the one of the master
+	const long crcIndex = (long) request.size() - COMPACT_FRAME_CRC_SIZE;
+	EXPECT_EQ(SpiCommands::computeCrc8(request.data(), crcIndex), request[crcIndex]);
+	std::vector<uint8_t> recomputed = request;
+	recomputed[crcIndex] = 0;
+	SpiCommands::putPipelinedFrameTrailer(recomputed.data(), (long) recomputed.size());
+	EXPECT_EQ(request, recomputed);
+
+	std::vector<uint8_t> answer = answerFrame(request, crcIndex);
+	std::vector<DistanceSample> samples;
+	ASSERT_TRUE(readAnswer(request, answer, crcIndex, samples));
+	ASSERT_EQ((size_t) OBSTACLE_COMMANDS, samples.size());
+	for (int i = 0; i < OBSTACLE_COMMANDS; i++) {
+		EXPECT_EQ(k_samples[i].distance_millimeters, samples[i].distance_millimeters) << "sample " << i;
+		EXPECT_EQ(k_samples[i].age_millis, samples[i].age_millis) << "sample " << i;
+	}
+
+	// a requested value off by one bit
+	answer[SpiCommands::getCompactValueOffset(OBSTACLE_FRONT_COMMAND, 3)] ^= 0x01;
+	EXPECT_FALSE(readAnswer(request, answer, crcIndex, samples));
+	answer[SpiCommands::getCompactValueOffset(OBSTACLE_FRONT_COMMAND, 3)] ^= 0x01;
+	// a header of another frame
+	answer[1]++;
+	EXPECT_FALSE(readAnswer(request, answer, crcIndex, samples));
+}
@@ -0,0 +1,247 @@
+/**
+ * Decoder of the binary SerialLogger records (see SerialLogger::LOG_FORMAT::BINARY). The records only hold the
+ * address of their F() format string, thus, the decoder looks the format strings up in the elf file of the very
+ * firmware which wrote the records (e. g. from the build directory of the Arduino IDE). The log is read from a file
+ * or stdin (e. g. a serial port) and printed as the text log would have been, prefixed with the micros of the record:
+ *
+ *   lawnmover_log_decoder lawnmover_main_core_unit.ino.elf < /dev/ttyUSB0
+ *
+ * Bytes in between records (e. g. text printed by other means than SerialLogger) are skipped.
+ */
+#include <elf.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <serial_logger.h>
+
+namespace {
+	const char *k_level_prefixes[] = {"TRACE: ", "DEBUG: ", "INFO: ", "WARN: ", "ERROR: "};
+
+	class ElfStrings {
+	public:
+		bool load(const char *path) {
+			std::ifstream file(path, std::ios::binary);
+			_image.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			if (_image.size() < EI_NIDENT || memcmp(_image.data(), ELFMAG, SELFMAG) != 0) {
+				return false;
+			} else if (_image[EI_CLASS] == ELFCLASS32) {
+				return loadSections<Elf32_Ehdr, Elf32_Shdr>();
+			} else if (_image[EI_CLASS] == ELFCLASS64) {
+				return loadSections<Elf64_Ehdr, Elf64_Shdr>();
+			}
+			return false;
+		}
+
+		/**
+		 * @return the zero terminated string at the given address of the firmware or nullptr if no section holds it
+		 */
+		const char *at(const uint32_t address) const {
+			for (const Section &section : _sections) {
+				if (address >= section.address && address - section.address < section.size) {
+					const uint64_t offset = section.offset + (address - section.address);
+					const void *end = memchr(&_image[offset], '\0', _image.size() - offset);
+					return end == nullptr ? nullptr : &_image[offset];
+				}
+			}
+			return nullptr;
+		}
+
+	private:
+		struct Section {
+			uint64_t address;
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		template<typename Ehdr, typename Shdr>
+		bool loadSections() {
+			Ehdr header;
+			if (_image.size() < sizeof header) {
+				return false;
+			}
+			memcpy(&header, _image.data(), sizeof header);
+			for (int i = 0; i < header.e_shnum; i++) {
+				Shdr section;
+				const uint64_t offset = header.e_shoff + static_cast<uint64_t>(i) * header.e_shentsize;
+				if (offset + sizeof section > _image.size()) {
+					return false;
+				}
+				memcpy(&section, &_image[offset], sizeof section);
+				// only sections loaded into the mcu and present in the file (i. e. no .bss)
+				if ((section.sh_flags & SHF_ALLOC) && section.sh_type != SHT_NOBITS &&
+					section.sh_offset + section.sh_size <= _image.size()) {
+					_sections.push_back({section.sh_addr, section.sh_offset, section.sh_size});
+				}
+			}
+			return !_sections.empty();
+		}
+
+		std::vector<char> _image;
+		std::vector<Section> _sections;
+	};
+
+	uint32_t getUint32(const uint8_t *bytes) {
+		return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+	}
+
+	void printBase(uint32_t value, const int base) {
+		char digits[33];
+		char *c = &digits[sizeof digits - 1];
+		*c = '\0';
+		do {
+			const int digit = value % base;
+			*--c = digit < 10 ? digit + '0' : digit + 'A' - 10;
+			value /= base;
+		} while (value);
+		fputs(c, stdout);
+	}
+
+	/**
+	 * Print the message of a record the very same way SerialLogger::log formats it. Arguments cut off by the logger
+	 * are printed as '?'.
+	 */
+	void printMessage(const char *format, const uint8_t *arguments, const uint8_t *end) {
+		bool formatSpecifier = false;
+		for (const char *c = format; *c != '\0'; c++) {
+			if (*c == '%') {
+				formatSpecifier = true;
+			} else {
+				if (formatSpecifier) {
+					if (*c == 's') {
+						const void *terminator = memchr(arguments, '\0', end - arguments);
+						if (terminator == nullptr) {
+							fputc('?', stdout);
+							arguments = end;
+						} else {
+							fputs(reinterpret_cast<const char *>(arguments), stdout);
+							arguments = static_cast<const uint8_t *>(terminator) + 1;
+						}
+					} else if (*c == 'd' || *c == 'i' || *c == 'x' || *c == 'b' || *c == 'l' || *c == 'c' ||
+							   *c == 'f') {
+						if (end - arguments < 4) {
+							fputc('?', stdout);
+							arguments = end;
+						} else {
+							const uint32_t value = getUint32(arguments);
+							arguments += 4;
+							if (*c == 'x') {
+								printBase(value, 16);
+							} else if (*c == 'b') {
+								printBase(value, 2);
+							} else if (*c == 'f') {
+								float f;
+								memcpy(&f, &value, sizeof f);
+								printf("%.6f", f);
+							} else {
+								printf("%d", static_cast<int32_t>(value));
+							}
+						}
+					}
+				} else {
+					fputc(*c, stdout);
+				}
+				formatSpecifier = false;
+			}
+		}
+		fputc('\n', stdout);
+	}
+
+	/**
+	 * @return whether the bytes are a plausible record (otherwise, its sync byte was a coincidence)
+	 */
+	bool decode(const ElfStrings &strings, const uint8_t *record, const uint8_t *end) {
+		const uint8_t level = record[2] & ~SerialLogger::RECORD_INLINE_FORMAT;
+		const bool inline_format = record[2] & SerialLogger::RECORD_INLINE_FORMAT;
+		const uint32_t micros = getUint32(&record[3]);
+		const uint8_t *arguments = &record[7];
+		if (level == SerialLogger::LOG_LEVEL::NONE && !inline_format) {
+			if (end - arguments != 4) {
+				return false;
+			}
+			printf("%12.6f WARN: %u log records dropped\n", micros / 1e6, getUint32(arguments));
+			return true;
+		} else if (level >= SerialLogger::LOG_LEVEL::NONE) {
+			return false;
+		}
+
+		const char *format;
+		if (inline_format) {
+			const void *terminator = memchr(arguments, '\0', end - arguments);
+			if (terminator == nullptr) {
+				return false;
+			}
+			format = reinterpret_cast<const char *>(arguments);
+			arguments = static_cast<const uint8_t *>(terminator) + 1;
+		} else if (end - arguments < 4) {
+			return false;
+		} else {
+			const uint32_t address = getUint32(arguments);
+			arguments += 4;
+			format = strings.at(address);
+			if (format == nullptr) {
+				printf("%12.6f %s<unknown format string at 0x%x>\n", micros / 1e6, k_level_prefixes[level], address);
+				return true;
+			}
+		}
+		printf("%12.6f %s", micros / 1e6, k_level_prefixes[level]);
+		printMessage(format, arguments, end);
+		return true;
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s <firmware elf file> [binary log file, default: stdin]\n", argv[0]);
+		return 1;
+	}
+	ElfStrings strings;
+	if (!strings.load(argv[1])) {
+		fprintf(stderr, "Cannot read the sections of the elf file %s\n", argv[1]);
+		return 1;
+	}
+	FILE *input = argc == 3 ? fopen(argv[2], "rb") : stdin;
+	if (input == nullptr) {
+		fprintf(stderr, "Cannot open %s\n", argv[2]);
+		return 1;
+	}
+
+	// sync byte, length and level at least
+	const size_t header_size = 3 + 4;
+	std::vector<uint8_t> pending;
+	uint8_t chunk[4096];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof chunk, input)) > 0) {
+		pending.insert(pending.end(), chunk, chunk + read);
+		size_t position = 0;
+		while (position < pending.size()) {
+			if (pending[position] != SerialLogger::RECORD_SYNC) {
+				position++;
+				continue;
+			}
+			if (pending.size() - position < 2) {
+				break;
+			}
+			const size_t size = 2 + pending[position + 1];
+			if (size < header_size || size > SerialLogger::RECORD_MAX_SIZE) {
+				position++;
+			} else if (pending.size() - position < size) {
+				break;
+			} else if (decode(strings, &pending[position], &pending[position] + size)) {
+				position += size;
+			} else {
+				position++;
+			}
+		}
+		pending.erase(pending.begin(), pending.begin() + position);
+		fflush(stdout);
+	}
+	if (input != stdin) {
+		fclose(input);
+	}
+	return 0;
+}
@@ -4,14 +4,15 @@
 #include <robo_pilot.h>
 
 #include "master_spi_slave.h"
-#include "ESP32_PS4_Controller.h"
+#include "esp32_ps4_controller.h"
 
 class EngineSlave : public MasterSpiSlave {
 public:
 	EngineSlave(SpiSlaveHandler *spi_slave_handler, const int slave_id, const int slave_pin,
 				const int slave_restart_pin, ESP32_PS4_Controller *esp32Ps4Ctrl, RoboPilot *roboPilot,
-				const char *name = "EngineControl") :
-			MasterSpiSlave(spi_slave_handler, slave_id, name, slave_pin, slave_restart_pin, 3, 0),
+				const FrameFormat frame_format, const char *name = "EngineControl") :
+			MasterSpiSlave(spi_slave_handler, slave_id, name, slave_pin, slave_restart_pin, 3, 0,
+						   LEFT_WHEEL_STEERING_COMMAND, frame_format),
 			_roboPilot(roboPilot) {
 		_esp32Ps4Ctrl = esp32Ps4Ctrl;
 	};
@@ -25,26 +26,25 @@ public:
         if (!_esp32Ps4Ctrl->isConnected()) {
             _roboPilot->printWeightedMovingAverageDistances();
         }
+		_roboPilot->putMovementDecision(movementDecision);
 
-		SpiCommands::putCommandToBuffer(LEFT_WHEEL_STEERING_COMMAND, movementDecision.get_left_wheel_power(),
-										tx_buffer);
-		SpiCommands::putCommandToBuffer(RIGHT_WHEEL_STEERING_COMMAND, movementDecision.get_right_wheel_power(),
-										tx_buffer + COMMAND_FRAME_SIZE);
-		SpiCommands::putCommandToBuffer(MOTOR_SPEED_COMMAND, movementDecision.get_blade_motor_power(),
-										tx_buffer + 2 * COMMAND_FRAME_SIZE);
+		put_command(0, LEFT_WHEEL_STEERING_COMMAND, movementDecision.get_left_wheel_power(), tx_buffer);
+		put_command(1, RIGHT_WHEEL_STEERING_COMMAND, movementDecision.get_right_wheel_power(), tx_buffer);
+		put_command(2, MOTOR_SPEED_COMMAND, movementDecision.get_blade_motor_power(), tx_buffer);
 	};
 
 	bool
 	consume_commands(uint8_t *slave_response_buffer, long slave_response_buffer_size, uint8_t *tx_buffer) override {
 		return interpret_communication(tx_buffer, slave_response_buffer, slave_response_buffer_size,
-									   k_amount_data_request_callbacks, _data_request_callbacks);
+									   _data_request_callbacks);
 	};
 
 private:
 	ESP32_PS4_Controller *_esp32Ps4Ctrl;
 	RoboPilot *_roboPilot;
 
-	std::vector <std::function<bool(int16_t, int16_t)>> _data_request_callbacks;
+	// none; the engine commands are data pushes
+	DataRequestCallbacks<int16_t> _data_request_callbacks;
 };
 
 #endif // ENGINE_SLAVE_H
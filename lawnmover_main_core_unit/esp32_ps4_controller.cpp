@@ -1,4 +1,4 @@
-#include "ESP32_PS4_Controller.h"
+#include "esp32_ps4_controller.h"
 #include <PS4Controller.h>
 #include <serial_logger.h>
 
@@ -12,7 +12,7 @@ void toggle(const int pin) {
 
 ESP32_PS4_Controller::ESP32_PS4_Controller(const char *masterMac, Timer<> &timer, const unsigned long timerDelay,
 										   const int readyPin, const int connectedPin, const int commandReceivedPin) :
-		k_masterMac(masterMac), k_timerDelay(timerDelay), k_readyPin(), k_connectedPin(connectedPin),
+		k_masterMac(masterMac), k_timerDelay(timerDelay), k_readyPin(readyPin), k_connectedPin(connectedPin),
 		k_commandReceivedPin(commandReceivedPin) {
 
 	// LEDs (all on initially)
@@ -23,21 +23,21 @@ ESP32_PS4_Controller::ESP32_PS4_Controller(const char *masterMac, Timer<> &timer
 	digitalWrite(k_connectedPin, LOW);
 	digitalWrite(k_commandReceivedPin, LOW);
 
-	SerialLogger::info(F("Beginning listening for master PS4 controller connection to: %s"), k_masterMac);
+	SERIAL_LOGGER_INFO(F("Beginning listening for master PS4 controller connection to: %s"), k_masterMac);
 	PS4.begin(masterMac);
 
 	timer.every(k_timerDelay, [this](void *) -> bool {
 		if (readState()) {
 			if (!_connected) {
 				digitalWrite(k_connectedPin, HIGH);
-				SerialLogger::info(F("Connected to: %s"), k_masterMac);
+				SERIAL_LOGGER_INFO(F("Connected to: %s"), k_masterMac);
 				_connected = true;
 			}
 		} else {
 			if (_connected) {
 				digitalWrite(k_connectedPin, LOW);
 				digitalWrite(k_commandReceivedPin, LOW);
-				SerialLogger::info(F("Disconnected from: %s"), k_masterMac);
+				SERIAL_LOGGER_INFO(F("Disconnected from: %s"), k_masterMac);
 				reset_state();
 			}
 			_connected = false;
@@ -66,7 +66,7 @@ bool ESP32_PS4_Controller::readState() {
 		}
 		return true;
 	} else {
-		//SerialLogger::debug("PS4 still not connected to: %s", k_masterMac);
+		//SERIAL_LOGGER_DEBUG("PS4 still not connected to: %s", k_masterMac);
 		return false;
 	}
 }
@@ -137,118 +137,118 @@ bool ESP32_PS4_Controller::checkCommandStates() {
 
 	if (rightButtonPressed != m_rightButtonPressed) {
 		m_rightButtonPressed = rightButtonPressed;
-		SerialLogger::debug(F("Right Button"));
+		SERIAL_LOGGER_DEBUG(F("Right Button"));
 		stateChanged = true;
 	}
 	if (leftButtonPressed != m_leftButtonPressed) {
 		m_leftButtonPressed = leftButtonPressed;
-		SerialLogger::debug(F("Left Button"));
+		SERIAL_LOGGER_DEBUG(F("Left Button"));
 		stateChanged = true;
 	}
 	if (downButtonPressed != m_downButtonPressed) {
 		m_downButtonPressed = downButtonPressed;
-		SerialLogger::debug(F("Down Button"));
+		SERIAL_LOGGER_DEBUG(F("Down Button"));
 		stateChanged = true;
 	}
 	if (upButtonPressed != m_upButtonPressed) {
 		m_upButtonPressed = upButtonPressed;
-		SerialLogger::debug(F("Up Button"));
+		SERIAL_LOGGER_DEBUG(F("Up Button"));
 		stateChanged = true;
 	}
 
 	// The axis sticks are highly sensitive. Make less sensitive changes by checking range over exact value
 	if (!(m_lStickX - 2 < lStickX && lStickX < m_lStickX + 2)) {
 		m_lStickX = lStickX;
-		SerialLogger::debug(F("Left Stick x at %d"), m_lStickX);
+		SERIAL_LOGGER_DEBUG(F("Left Stick x at %d"), m_lStickX);
 		stateChanged = true;
 	}
 	if (!(m_lStickY - 2 < lStickY && lStickY < m_lStickY + 2)) {
 		m_lStickY = lStickY;
-		SerialLogger::debug(F("Left Stick y at %d"), m_lStickY);
+		SERIAL_LOGGER_DEBUG(F("Left Stick y at %d"), m_lStickY);
 		stateChanged = true;
 	}
 	if (!(m_rStickX - 2 < rStickX && rStickX < m_rStickX + 2)) {
 		m_rStickX = rStickX;
-		SerialLogger::debug(F("Right Stick x at %d"), m_rStickX);
+		SERIAL_LOGGER_DEBUG(F("Right Stick x at %d"), m_rStickX);
 		stateChanged = true;
 	}
 	if (!(m_rStickY - 2 < rStickY && rStickY < m_rStickY + 2)) {
 		m_rStickY = rStickY;
-		SerialLogger::debug(F("Right Stick y at %d"), m_rStickY);
+		SERIAL_LOGGER_DEBUG(F("Right Stick y at %d"), m_rStickY);
 		stateChanged = true;
 	}
 
 	if (squareButtonPressed != m_squareButtonPressed) {
 		m_squareButtonPressed = squareButtonPressed;
-		SerialLogger::debug(F("Square Button"));
+		SERIAL_LOGGER_DEBUG(F("Square Button"));
 		stateChanged = true;
 	}
 	if (crossButtonPressed != m_crossButtonPressed) {
 		m_crossButtonPressed = crossButtonPressed;
-		SerialLogger::debug(F("Cross Button"));
+		SERIAL_LOGGER_DEBUG(F("Cross Button"));
 		stateChanged = true;
 	}
 	if (circleButtonPressed != m_circleButtonPressed) {
 		m_circleButtonPressed = circleButtonPressed;
-		SerialLogger::debug(F("Circle Button"));
+		SERIAL_LOGGER_DEBUG(F("Circle Button"));
 		stateChanged = true;
 	}
 
 	if (triangleButtonPressed != m_triangleButtonPressed) {
 		m_triangleButtonPressed = triangleButtonPressed;
-		SerialLogger::debug(F("Triangle Button"));
+		SERIAL_LOGGER_DEBUG(F("Triangle Button"));
 		stateChanged = true;
 	}
 	if (lbButtonPressed != m_lbButtonPressed) {
 		m_lbButtonPressed = lbButtonPressed;
-		SerialLogger::debug(F("LB Button"));
+		SERIAL_LOGGER_DEBUG(F("LB Button"));
 		stateChanged = true;
 	}
 	if (rbButtonPressed != m_rbButtonPressed) {
 		m_rbButtonPressed = rbButtonPressed;
-		SerialLogger::debug(F("RB Button"));
+		SERIAL_LOGGER_DEBUG(F("RB Button"));
 		stateChanged = true;
 	}
 	if (ltButtonPressed != m_ltButtonPressed || m_ltValue != ltValue) {
 		m_ltButtonPressed = ltButtonPressed;
 		m_ltValue = ltValue;
-		SerialLogger::debug(F("LT button at %d"), m_ltValue);
+		SERIAL_LOGGER_DEBUG(F("LT button at %d"), m_ltValue);
 		stateChanged = true;
 	}
 	if (rtButtonPressed != m_rtButtonPressed || m_rtValue != rtValue) {
 		m_rtButtonPressed = rtButtonPressed;
 		m_rtValue = rtValue;
-		SerialLogger::debug(F("RT button at %d"), m_rtValue);
+		SERIAL_LOGGER_DEBUG(F("RT button at %d"), m_rtValue);
 		stateChanged = true;
 	}
 	if (l3ButtonPressed != m_l3ButtonPressed) {
 		m_l3ButtonPressed = l3ButtonPressed;
-		SerialLogger::debug(F("L3 Button"));
+		SERIAL_LOGGER_DEBUG(F("L3 Button"));
 		stateChanged = true;
 	}
 	if (r3ButtonPressed != m_r3ButtonPressed) {
 		m_r3ButtonPressed = r3ButtonPressed;
-		SerialLogger::debug(F("R3 Button"));
+		SERIAL_LOGGER_DEBUG(F("R3 Button"));
 		stateChanged = true;
 	}
 	if (shareButtonPressed != m_shareButtonPressed) {
 		m_shareButtonPressed = shareButtonPressed;
-		SerialLogger::debug(F("Share Button"));
+		SERIAL_LOGGER_DEBUG(F("Share Button"));
 		stateChanged = true;
 	}
 	if (optionsButtonPressed != m_optionsButtonPressed) {
 		m_optionsButtonPressed = optionsButtonPressed;
-		SerialLogger::debug(F("Options Button"));
+		SERIAL_LOGGER_DEBUG(F("Options Button"));
 		stateChanged = true;
 	}
 	if (psButtonPressed != m_psButtonPressed) {
 		m_psButtonPressed = psButtonPressed;
-		SerialLogger::debug(F("PS Button"));
+		SERIAL_LOGGER_DEBUG(F("PS Button"));
 		stateChanged = true;
 	}
 	if (touchpadButtonPressed != m_touchpadButtonPressed) {
 		m_touchpadButtonPressed = touchpadButtonPressed;
-		SerialLogger::debug(F("Touch Pad Button"));
+		SERIAL_LOGGER_DEBUG(F("Touch Pad Button"));
 		stateChanged = true;
 	}
 	return stateChanged;
@@ -263,34 +263,34 @@ bool ESP32_PS4_Controller::checkAuxiliaryStates() {
 
 	if (m_charging != charging) {
 		if (charging) {
-			SerialLogger::info(F("The controller is charging"));
+			SERIAL_LOGGER_INFO(F("The controller is charging"));
 		} else {
-			SerialLogger::info(F("The controller is not charging (anymore)"));
+			SERIAL_LOGGER_INFO(F("The controller is not charging (anymore)"));
 		}
 		m_charging = charging;
 		stateChanged = true;
 	}
 	if (m_audioConnected != audioConnected) {
 		if (audioConnected) {
-			SerialLogger::info(F("The controller has headphones attached"));
+			SERIAL_LOGGER_INFO(F("The controller has headphones attached"));
 		} else {
-			SerialLogger::info(F("The controller has no headphones attached (anymore)"));
+			SERIAL_LOGGER_INFO(F("The controller has no headphones attached (anymore)"));
 		}
 		m_audioConnected = audioConnected;
 		stateChanged = true;
 	}
 	if (m_micConnected != micConnected) {
 		if (micConnected) {
-			SerialLogger::info(F("The controller has a mic attached"));
+			SERIAL_LOGGER_INFO(F("The controller has a mic attached"));
 		} else {
-			SerialLogger::info(F("The controller has no mic attached (anymore)"));
+			SERIAL_LOGGER_INFO(F("The controller has no mic attached (anymore)"));
 		}
 		m_micConnected = micConnected;
 		stateChanged = true;
 	}
 
 	if (m_batteryLevel != batteryLevel) {
-		SerialLogger::info(F("Battery Level : %d"), batteryLevel);
+		SERIAL_LOGGER_INFO(F("Battery Level : %d"), batteryLevel);
 		m_batteryLevel = batteryLevel;
 		stateChanged = true;
 	}
@@ -28,19 +28,33 @@ Esp32SpiMaster::Esp32SpiMaster(const int clock_pin, const int miso_pin, const in
 							   const int dma_channel, const uint8_t spi_mode, const int tx_rx_buffer_size,
 							   const int chunk_size, const int inter_transaction_delay_microseconds) :
 		k_clock_pin(clock_pin), k_miso_pin(miso_pin), k_mosi_pin(mosi_pin), k_frequency(frequency),
-		k_dma_channel(dma_channel), k_spi_mode(spi_mode), k_chunk_size(chunk_size),
-		k_inter_transaction_delay_microseconds(inter_transaction_delay_microseconds) {
+		k_dma_channel(dma_channel), k_spi_mode(spi_mode), k_tx_rx_buffer_size(tx_rx_buffer_size),
+		k_chunk_size(chunk_size), k_inter_transaction_delay_microseconds(inter_transaction_delay_microseconds) {
 	for (int i = 0; i < MAX_SLAVES; i++) {
 		free_ids[i] = i;
 	}
+	// the peripheral holds the chip select for up to 16 spi clock cycles; busy wait the remainder only
+	const long cs_hold_cycles = min(16L, (long) k_inter_transaction_delay_microseconds * frequency / 1000000L);
+	SpiSlaveHandler::setCsHoldCycles(cs_hold_cycles);
+	_inter_transaction_software_delay_microseconds = max(0L, k_inter_transaction_delay_microseconds -
+															  cs_hold_cycles * 1000000L / frequency);
 }
 
 Esp32SpiMaster::~Esp32SpiMaster() {
-	SerialLogger::info(F("Shutting down all slaves"));
+	if (_timer != nullptr) {
+		// the queued mode may stop outside the interval task, thus, the latter may still be scheduled
+		_timer->cancel(_schedule_task);
+		_timer->cancel(_poll_task);
+	}
+	SERIAL_LOGGER_INFO(F("Shutting down all slaves"));
 	for (int i = 0; i < _registered_slaves; i++) {
 		put_free_id(_slaves[i]->get_slave_id());
 		delete _slaves[i];
+		_slaves[i] = nullptr;
 	}
+	// the slaves are static; a new master must not schedule the deleted ones
+	_registered_slaves = 0;
+	_slave_cursor = 0;
 }
 
 /**
@@ -54,102 +68,239 @@ Esp32SpiMaster::~Esp32SpiMaster() {
 */
 void Esp32SpiMaster::put_slave(MasterSpiSlave *spi_slave) {
 	if (spi_slave == nullptr) {
-		SerialLogger::error(F("Cannot add new slave to internal array. The spi Slave is a nullptr"));
+		SERIAL_LOGGER_ERROR(F("Cannot add new slave to internal array. The spi Slave is a nullptr"));
+	} else if (_registered_slaves >= MAX_SLAVES) {
+		SERIAL_LOGGER_ERROR(F("Cannot add slave %s. All %d slots are taken"), spi_slave->get_name(), MAX_SLAVES);
 	} else {
-		_slaves[_registered_slaves] = spi_slave;
-		SerialLogger::info(F("Adding slave %d/%d"), spi_slave->get_slave_id() + 1, MAX_SLAVES);
+		// Keep slaves requesting data in front of slaves only pushing commands (see SchedulingMode::BATCHED)
+		int slot = _registered_slaves;
+		if (spi_slave->get_amount_data_request_commands() > 0) {
+			while (slot > 0 && _slaves[slot - 1]->get_amount_data_request_commands() == 0) {
+				_slaves[slot] = _slaves[slot - 1];
+				slot--;
+			}
+		}
+		_slaves[slot] = spi_slave;
+		SERIAL_LOGGER_INFO(F("Adding slave %d/%d"), spi_slave->get_slave_id() + 1, MAX_SLAVES);
 		_registered_slaves++;
 	}
 }
 
 
-void Esp32SpiMaster::schedule(const int interval, Timer<> &timer) {
+void Esp32SpiMaster::schedule(const int interval, Timer<> &timer, const SchedulingMode scheduling_mode,
+							  const TransferMode transfer_mode) {
 	_stopped = false;
-   SerialLogger::info(F("Scheduled spi communication (round-robin) every %d milliseconds"), interval);
-	timer.every(interval, [&](void *) -> bool {
-        bool valid = false;
+	_scheduling_mode = scheduling_mode;
+	_transfer_mode = transfer_mode;
+	_timer = &timer;
+	_batch_slot = -1;
+	SERIAL_LOGGER_INFO(F("Scheduled spi communication (%s, %s) every %d milliseconds"),
+					   _scheduling_mode == BATCHED ? "batched" : "round-robin",
+					   _transfer_mode == QUEUED ? "queued" : "blocking", interval);
+	_schedule_task = timer.every(interval, [&](void *) -> bool {
 		if (_registered_slaves < 1) {
-			SerialLogger::error(F("No slaves registered. No need to start a timer for spi communication for no "
+			SERIAL_LOGGER_ERROR(F("No slaves registered. No need to start a timer for spi communication for no "
 								  "spi slaves"));
 			_stopped = true;
-		} else {
-			MasterSpiSlave *spi_slave = _slaves[_slave_cursor];
-			_slave_cursor = (_slave_cursor + 1) % _registered_slaves;
-			SerialLogger::debug(F("Initiating spi communication with slave %d (%s) and moved cursor to %d."),
-								spi_slave->get_slave_id(), spi_slave->get_name(), _slave_cursor);
-
-			long tx_rx_buffer_size = -1;
-			uint8_t *tx_buffer = spi_slave->supply(tx_rx_buffer_size);
-			uint8_t *rx_buffer = spi_slave->get_rx_buffer(tx_rx_buffer_size);
-			if (tx_rx_buffer_size < 0) {
-				SerialLogger::error(F("Cannot create spi slave communication. Supplier returned bad buffer_size %d"),
-									tx_rx_buffer_size);
-				_stopped = true;
-			} else if (tx_buffer == nullptr) {
-				SerialLogger::error(F("Cannot create spi slave communication. Tx buffer were supplied as nullptr from "
-									  "slave representation"));
-				_stopped = true;
-			} else if (rx_buffer == nullptr) {
-				SerialLogger::error(F("Cannot create spi slave communication. Rx buffer were supplied as nullptr from "
-									  "slave representation"));
-				_stopped = true;
+		} else if (_transfer_mode == QUEUED) {
+			if (_batch_slot >= 0) {
+				SERIAL_LOGGER_WARN(F("Spi frames of the previous interval are still on the wire. Skipping this "
+									 "interval"));
 			} else {
-				for (long counter = 0; counter < tx_rx_buffer_size; counter += k_chunk_size) {
-					try {
-						size_t sendBytes = spi_slave->get_spi_slave_handler()->transfer(tx_buffer + counter,
-																						rx_buffer + counter,
-																						k_chunk_size);
-
-						// TODO can we omit small delays?
-						delayMicroseconds(k_inter_transaction_delay_microseconds);
-					} catch (const std::runtime_error &e) {
-						SerialLogger::error(F("Failed to transfer bytes for slave on slave select %d: %s"),
-											spi_slave->get_slave_pin(), e.what());
-						spi_slave->restart();
-						_stopped = true;
-						break;
-					}
+				if (_scheduling_mode == BATCHED) {
+					_batch_slot = -1;
+					_batch_end = _registered_slaves;
+				} else {
+					_batch_slot = _slave_cursor - 1;
+					_batch_end = _slave_cursor + 1;
+					_slave_cursor = (_slave_cursor + 1) % _registered_slaves;
+					SERIAL_LOGGER_DEBUG(F("Moved cursor to %d."), _slave_cursor);
 				}
-				if (!_stopped) {
-                    valid = spi_slave->consume(rx_buffer, tx_rx_buffer_size);
-					if (valid) {
-						SerialLogger::debug(F("Slave on slave select pin %d (%s) did return correct results and remains synchronized!"),
-											spi_slave->get_slave_pin(), spi_slave->get_name());
-					} else {
-						SerialLogger::error(F("Slave on slave select pin %d (%s) did NOT return correct results!"),
-											spi_slave->get_slave_pin(), spi_slave->get_name());
-						spi_slave->restart();
+				if (queue_next_frame()) {
+					_poll_task = _timer->every(1, [this](void *) -> bool {
+						return poll_frame();
+					});
+					if (!_poll_task) {
+						SERIAL_LOGGER_WARN(F("Cannot schedule the polling of the spi frames. All timer tasks are "
+											 "taken. Waiting for the frames of this interval"));
+						collect_batch();
 					}
 				}
 			}
-
-			if (_stopped) {
-				SerialLogger::error(F("Spi communication appears broken. Stopping scheduler, thus, whole spi "
-									  "communication."));
+		} else if (_scheduling_mode == BATCHED) {
+			for (int i = 0; i < _registered_slaves && !_stopped; i++) {
+				communicate(_slaves[i]);
 			}
+		} else {
+			MasterSpiSlave *spi_slave = _slaves[_slave_cursor];
+			_slave_cursor = (_slave_cursor + 1) % _registered_slaves;
+			SERIAL_LOGGER_DEBUG(F("Moved cursor to %d."), _slave_cursor);
+			communicate(spi_slave);
+		}
+		return !_stopped; // to repeat the action - false to stop
+	});
+}
 
-			if (SerialLogger::isBelow(SerialLogger::TRACE) || !valid) {
-				Serial.printf("RxBufferInput (Slave %d: %s): ", spi_slave->get_slave_id() + 1,
-							  spi_slave->get_name());
-				for (long i = 0; i < tx_rx_buffer_size; i += 1) {
-					if (i % COMMAND_FRAME_SIZE == 0) {
-						Serial.print(F(" "));
-					}
-					Serial.print(rx_buffer[i], HEX);
+bool Esp32SpiMaster::communicate(MasterSpiSlave *spi_slave) {
+	if (supply_frame(spi_slave)) {
+		const long chunk_size = k_chunk_size > 0 ? k_chunk_size : _frame_size;
+		for (long counter = 0; counter < _frame_size; counter += chunk_size) {
+			try {
+				size_t sendBytes = spi_slave->get_spi_slave_handler()->transfer(
+						_frame_tx_buffer + counter, _frame_rx_buffer + counter,
+						min(chunk_size, _frame_size - counter));
+
+				if (_inter_transaction_software_delay_microseconds > 0) {
+					delayMicroseconds(_inter_transaction_software_delay_microseconds);
 				}
-				Serial.println();
-				Serial.printf("TxBufferInput (Slave %d: %s):", spi_slave->get_slave_id() + 1, spi_slave->get_name());
-				for (long i = 0; i < tx_rx_buffer_size; i += 1) {
-					if (i % COMMAND_FRAME_SIZE == 0) {
-						Serial.print(F(" "));
-					}
-					Serial.print(tx_buffer[i], HEX);
+			} catch (const std::runtime_error &e) {
+				SERIAL_LOGGER_ERROR(F("Failed to transfer bytes for slave on slave select %d: %s"),
+									spi_slave->get_slave_pin(), e.what());
+				spi_slave->restart();
+				_stopped = true;
+				break;
+			}
+		}
+	}
+	return finish_frame();
+}
+
+bool Esp32SpiMaster::supply_frame(MasterSpiSlave *spi_slave) {
+	SERIAL_LOGGER_DEBUG(F("Initiating spi communication with slave %d (%s)."), spi_slave->get_slave_id(),
+						spi_slave->get_name());
+
+	_frame_slave = spi_slave;
+	_frame_size = -1;
+	_frame_tx_buffer = spi_slave->supply(_frame_size);
+	_frame_rx_buffer = spi_slave->get_rx_buffer(_frame_size);
+	if (_frame_size < 0) {
+		SERIAL_LOGGER_ERROR(F("Cannot create spi slave communication. Supplier returned bad buffer_size %d"),
+							_frame_size);
+		_stopped = true;
+	} else if (_frame_tx_buffer == nullptr) {
+		SERIAL_LOGGER_ERROR(F("Cannot create spi slave communication. Tx buffer were supplied as nullptr from "
+							  "slave representation"));
+		_stopped = true;
+	} else if (_frame_rx_buffer == nullptr) {
+		SERIAL_LOGGER_ERROR(F("Cannot create spi slave communication. Rx buffer were supplied as nullptr from "
+							  "slave representation"));
+		_stopped = true;
+	}
+	return !_stopped;
+}
+
+bool Esp32SpiMaster::finish_frame() {
+	bool valid = false;
+	MasterSpiSlave *spi_slave = _frame_slave;
+	if (!_stopped) {
+		valid = spi_slave->consume(_frame_rx_buffer, _frame_size);
+		if (valid) {
+			SERIAL_LOGGER_DEBUG(F("Slave on slave select pin %d (%s) did return correct results and remains synchronized!"),
+								spi_slave->get_slave_pin(), spi_slave->get_name());
+		} else {
+			SERIAL_LOGGER_ERROR(F("Slave on slave select pin %d (%s) did NOT return correct results!"),
+								spi_slave->get_slave_pin(), spi_slave->get_name());
+			spi_slave->recover();
+		}
+	}
+
+	if (_stopped) {
+		SERIAL_LOGGER_ERROR(F("Spi communication appears broken. Stopping scheduler, thus, whole spi "
+							  "communication."));
+	}
+
+	if (_frame_tx_buffer != nullptr && _frame_rx_buffer != nullptr &&
+		(SerialLogger::isBelow(SerialLogger::TRACE) || !valid)) {
+		Serial.printf("RxBufferInput (Slave %d: %s): ", spi_slave->get_slave_id() + 1,
+					  spi_slave->get_name());
+		for (long i = 0; i < _frame_size; i += 1) {
+			if (i % COMMAND_FRAME_SIZE == 0) {
+				Serial.print(F(" "));
+			}
+			Serial.print(_frame_rx_buffer[i], HEX);
+		}
+		Serial.println();
+		Serial.printf("TxBufferInput (Slave %d: %s):", spi_slave->get_slave_id() + 1, spi_slave->get_name());
+		for (long i = 0; i < _frame_size; i += 1) {
+			if (i % COMMAND_FRAME_SIZE == 0) {
+				Serial.print(F(" "));
+			}
+			Serial.print(_frame_tx_buffer[i], HEX);
+		}
+		Serial.println();
+	}
+	_frame_slave = nullptr;
+	return valid;
+}
+
+bool Esp32SpiMaster::queue_next_frame() {
+	while (!_stopped && ++_batch_slot < _batch_end) {
+		MasterSpiSlave *spi_slave = _slaves[_batch_slot];
+		if (supply_frame(spi_slave)) {
+			SpiSlaveHandler *spi_slave_handler = spi_slave->get_spi_slave_handler();
+			const long chunk_size = k_chunk_size > 0 ? k_chunk_size : _frame_size;
+			for (long counter = 0; counter < _frame_size && !_stopped; counter += chunk_size) {
+				if (!spi_slave_handler->queue(_frame_tx_buffer + counter, _frame_rx_buffer + counter,
+											  min(chunk_size, _frame_size - counter))) {
+					SERIAL_LOGGER_ERROR(F("Failed to queue bytes for slave on slave select %d"),
+										spi_slave->get_slave_pin());
+					spi_slave->restart();
+					_stopped = true;
 				}
-				Serial.println();
 			}
 		}
-		return !_stopped; // to repeat the action - false to stop
-	});
+		if (_stopped) {
+			// transactions queued so far are collected once the slave handler is deleted
+			finish_frame();
+		} else {
+			return true;
+		}
+	}
+	_batch_slot = -1;
+	return false;
+}
+
+bool Esp32SpiMaster::poll_frame() {
+	if (_frame_slave != nullptr) {
+		SpiSlaveHandler *spi_slave_handler = _frame_slave->get_spi_slave_handler();
+		while (spi_slave_handler->pending() > 0 && spi_slave_handler->collect());
+		if (spi_slave_handler->pending() > 0) {
+			return true; // still on the wire
+		}
+		finish_frame();
+	}
+
+	const bool polling = queue_next_frame();
+	if (!polling) {
+		_poll_task = 0;
+	}
+	return polling;
+}
+
+void Esp32SpiMaster::collect_batch() {
+	do {
+		SpiSlaveHandler *spi_slave_handler = _frame_slave->get_spi_slave_handler();
+		while (spi_slave_handler->pending() > 0 && spi_slave_handler->collect(portMAX_DELAY));
+		finish_frame();
+	} while (queue_next_frame());
+}
+
+void Esp32SpiMaster::print_recovery_metrics() {
+	for (int i = 0; i < _registered_slaves; i++) {
+		for (int tier = 0; tier < MasterSpiSlave::AMOUNT_RECOVERY_TIERS; tier++) {
+			const MasterSpiSlave::RecoveryTier recovery_tier = static_cast<MasterSpiSlave::RecoveryTier>(tier);
+			const MasterSpiSlave::RecoveryMetrics &metrics = _slaves[i]->get_recovery_metrics(recovery_tier);
+			if (metrics.recoveries == _reported_recoveries[i][tier]) {
+				continue;
+			}
+			_reported_recoveries[i][tier] = metrics.recoveries;
+			SERIAL_LOGGER_INFO(F("Recoveries of slave %d (%s) by %s: %l (%l ms mean, %l ms max)"),
+							   _slaves[i]->get_slave_id() + 1, _slaves[i]->get_name(),
+							   MasterSpiSlave::get_recovery_tier_name(recovery_tier), metrics.recoveries,
+							   metrics.recoveries > 0 ? metrics.total_millis / metrics.recoveries : 0UL,
+							   metrics.max_millis);
+		}
+	}
 }
 
 int Esp32SpiMaster::take_free_id() {
@@ -170,10 +321,11 @@ bool Esp32SpiMaster::put_free_id(const int id) {
 		if (free_ids[i] == -1) {
 			free_ids[i] = id;
 			added = true;
+			break;
 		}
 	}
 	if (!added) {
-		SerialLogger::warn(F("Could not add free Id %d back to repository."), id);
+		SERIAL_LOGGER_WARN(F("Could not add free Id %d back to repository."), id);
 	}
 	return added;
 }
@@ -182,7 +334,9 @@ SpiSlaveHandler *Esp32SpiMaster::get_handler(const int slave_pin) {
 	SpiSlaveHandler *slave_handler = new SpiSlaveHandler();
 	slave_handler->setDataMode(k_spi_mode);
 	slave_handler->setFrequency(k_frequency);
-	slave_handler->setMaxTransferSize(k_chunk_size);
+	slave_handler->setMaxTransferSize(k_chunk_size > 0 ? k_chunk_size : k_tx_rx_buffer_size);
+	// room to queue a whole frame (see TransferMode::QUEUED)
+	slave_handler->setQueueSize(k_chunk_size > 0 ? (k_tx_rx_buffer_size + k_chunk_size - 1) / k_chunk_size : 1);
 	// Disabling DMA limits to 64 bytes per transaction only
 	slave_handler->setDMAChannel(k_dma_channel);  // 1 or 2 only
 	// VSPI = CS: 5, CLK: 18, MOSI: 23, MISO: 19
@@ -11,10 +11,39 @@
 
 class Esp32SpiMaster {
 public:
+	/**
+	 * ROUND_ROBIN: Communicate with one slave per interval, i. e. each slave is refreshed once every n intervals for n
+	 * slaves.
+	 * BATCHED: Communicate with every slave once per interval. Slaves requesting data (e. g. the obstacle detection)
+	 * come first, thus, slaves pushing commands (e. g. the engines) always act on data of the very same interval.
+	 */
+	enum SchedulingMode {
+		ROUND_ROBIN, BATCHED
+	};
+
+	/**
+	 * BLOCKING: Transfer the frames of an interval within the timer task, i. e. the loop stalls until all bytes moved.
+	 * QUEUED: Hand all transactions of a frame to the spi driver and return right away. A short polling timer task
+	 * collects the finished transactions, consumes the frame and queues the frame of the next slave. Thus, the loop
+	 * (e. g. the PS4 controller) keeps running while the bytes are on the wire. The gap between two transactions is
+	 * paced by the peripheral only (see inter_transaction_delay_microseconds).
+	 */
+	enum TransferMode {
+		BLOCKING, QUEUED
+	};
+
 	static int take_free_id();
 
 	static bool put_free_id(const int id);
 
+	/**
+	 * @param chunk_size Bytes per spi transaction or 0 to transfer the whole buffer of a slave in one transaction.
+	 * The Uno slaves need 1: their interrupt routine must have written the next byte to send before the next byte
+	 * starts, but bytes of one transaction follow each other without any gap.
+	 * @param inter_transaction_delay_microseconds Gap between two transactions. As far as possible (up to 16 spi clock
+	 * cycles), the peripheral keeps the slave selected for this time after each transaction; only the remainder is
+	 * busy waited.
+	 */
 	Esp32SpiMaster(const int clock_pin, const int miso_pin, const int mosi_pin, const long frequency = 2000000,
 				   const int dma_channel = 1, const uint8_t spi_mode = SPI_MODE0, const int tx_rx_buffer_size = 60,
 				   const int chunk_size = 1, const int inter_transaction_delay_microseconds = 10);
@@ -25,11 +54,58 @@ public:
 
 	SpiSlaveHandler *get_handler(const int slave_pin);
 
-	void schedule(const int interval, Timer<> &timer);
+	void schedule(const int interval, Timer<> &timer, const SchedulingMode scheduling_mode = ROUND_ROBIN,
+				  const TransferMode transfer_mode = BLOCKING);
 
 	bool stopped() const { return _stopped; };
 
+	/**
+	 * Log the recoveries of each slave per tier (see MasterSpiSlave::RecoveryMetrics). Only the tiers a slave recovered
+	 * by since the last call are logged: printing at 9600 baud blocks the timer tasks for about 1 ms per character.
+	 */
+	void print_recovery_metrics();
+
 private:
+	/**
+	 * One complete frame (supply, transfer, consume) with the given slave. Recovers the slave if its response is not
+	 * valid (see MasterSpiSlave::recover) and stops the whole communication if the frame cannot be transferred at all.
+	 *
+	 * @return whether the slave returned valid results
+	 */
+	bool communicate(MasterSpiSlave *spi_slave);
+
+	/**
+	 * Supply the next frame of the given slave. Stops the whole communication if the slave supplies bad buffers.
+	 */
+	bool supply_frame(MasterSpiSlave *spi_slave);
+
+	/**
+	 * Consume the response to the current frame (unless stopped) and recover the slave if it is not valid
+	 *
+	 * @return whether the slave returned valid results
+	 */
+	bool finish_frame();
+
+	/**
+	 * Queue all transactions of the next frame of the current batch (see TransferMode::QUEUED)
+	 *
+	 * @return whether a frame is on the wire now; false if the batch is done or the communication stopped
+	 */
+	bool queue_next_frame();
+
+	/**
+	 * Polling timer task of TransferMode::QUEUED: collects finished transactions without waiting
+	 *
+	 * @return whether to poll again
+	 */
+	bool poll_frame();
+
+	/**
+	 * Fallback of TransferMode::QUEUED if the polling timer task cannot be scheduled: waits for the frame on the wire
+	 * and transfers the remaining frames of the batch like TransferMode::BLOCKING does. Otherwise, the batch would
+	 * never finish and no further frame would be queued.
+	 */
+	void collect_batch();
 
 	static MasterSpiSlave *_slaves[];
 	static int _registered_slaves;
@@ -42,11 +118,30 @@ private:
 	const int k_frequency;
 	const int k_dma_channel;
 	const uint8_t k_spi_mode;
+	const int k_tx_rx_buffer_size;
+	const int k_chunk_size;
 	const int k_inter_transaction_delay_microseconds;
+	int _inter_transaction_software_delay_microseconds;
 
 	volatile bool _stopped;
-
-	const int k_chunk_size;
+	SchedulingMode _scheduling_mode = ROUND_ROBIN;
+	TransferMode _transfer_mode = BLOCKING;
+
+	// the frame currently supplied, transferred or consumed
+	MasterSpiSlave *_frame_slave = nullptr;
+	uint8_t *_frame_tx_buffer = nullptr;
+	uint8_t *_frame_rx_buffer = nullptr;
+	long _frame_size = -1;
+
+	// slots [_batch_slot, _batch_end) of the slaves to communicate with in this interval (TransferMode::QUEUED only)
+	int _batch_slot = -1;
+	int _batch_end = 0;
+	Timer<> *_timer = nullptr;
+	Timer<>::Task _schedule_task = 0;
+	Timer<>::Task _poll_task = 0;
+
+	// the recoveries of each slave per tier print_recovery_metrics logged last time
+	unsigned long _reported_recoveries[MAX_SLAVES][MasterSpiSlave::AMOUNT_RECOVERY_TIERS] = {};
 };
 
 #endif // ESP32_SPI_MASTER_H
@@ -1,10 +1,10 @@
 #include <serial_logger.h>
 #include <robo_pilot.h>
 
-#include "ESP32_PS4_Controller.h"
+#include "esp32_ps4_controller.h"
 #include "esp32_spi_master.h"
 #include "engine_slave.h"
-#include "obstacle_detection_Slave.h"
+#include "obstacle_detection_slave.h"
 
 // General SPI settings
 const int MOSI_PIN_GREEN = 23;
@@ -12,7 +12,12 @@ const int MISO_PIN_YELLOW = 19;
 const int SCK_PIN_ORANGE = 18;
 const long frequency = 2000000;
 const long clock_divide = SPI_CLOCK_DIV8;
-const int INTER_TRANSACTION_DELAY_MICROSECONDS = 10;
+const int DMA_CHANNEL = 1;
+const int TX_RX_BUFFER_SIZE = 60;
+// The uno slaves need a gap after each byte to prepare the next one in their interrupt routine. 8 us are 16 spi clock
+// cycles at 2 MHz which the spi peripheral paces on its own by holding the chip select.
+const int CHUNK_SIZE = 1;
+const int INTER_TRANSACTION_DELAY_MICROSECONDS = 8;
 
 // Engine SPI slave settings
 const int ENGINE_CONTROL_SS_PIN_BLUE = 5;
@@ -23,6 +28,17 @@ const int OBSTACLE_DETECTION_CONTROL_SS_PIN_BROWN = 12;
 const int OBSTACLE_DETECTION_RESTART_PIN_PIN = 14;
 
 const int spi_schedule_next_slave_commands_intervall = 165;
+// every slave once per interval, obstacle detection before the engines
+const Esp32SpiMaster::SchedulingMode spi_scheduling_mode = Esp32SpiMaster::BATCHED;
+// keep the loop (e. g. the PS4 controller) running while the frames are on the wire
+const Esp32SpiMaster::TransferMode spi_transfer_mode = Esp32SpiMaster::QUEUED;
+// one crc protected frame of packed values per slave instead of a 9 byte frame per command; PIPELINED saves another
+// byte, but its requested values arrive one frame later and the robo pilots do not compensate this lag yet
+const MasterSpiSlave::FrameFormat spi_frame_format = MasterSpiSlave::COMPACT;
+// consecutive rejected frames of a slave the master retries, then resynchronizes in-band before restarting the slave;
+// a single corrupted pipelined frame is rejected twice (its answer is stale, too)
+const int spi_recovery_retries = 2;
+const int spi_recovery_resyncs = 3;
 
 // General processing + PS4 (Bluetooth) settings
 auto _timer = timer_create_default();
@@ -30,25 +46,34 @@ const char *masterMac = "ac:89:95:b8:7f:be";
 ESP32_PS4_Controller *esp32Ps4Ctrl = nullptr;
 Esp32SpiMaster *esp32_spi_master = nullptr;
 const int restart_check_intervall = 1000;
+// log the recoveries of the slaves since the last report (if any) every n restart checks
+const int recovery_metrics_report_restart_checks = 10;
+int recovery_metrics_report_checks = 0;
 
+// RuleBasedMotionStateRoboPilot bounces around at random, CoveragePlannerRoboPilot mows stripes (see robo_pilot.h)
+#ifndef LAWNMOVER_ROBO_PILOT
+#define LAWNMOVER_ROBO_PILOT RuleBasedMotionStateRoboPilot
+#endif
 RoboPilot *_roboPilot = nullptr;
 
 void re_setup_spi_communication() {
 	// delete the master will tear down all slaves (inclusive their power supply) put into master
-	SerialLogger::info(F("Shutting down all previous slaves"));
+	SERIAL_LOGGER_INFO(F("Shutting down all previous slaves"));
 	delete esp32_spi_master;
-	SerialLogger::info(F("(Re)Setting up all slaves"));
+	SERIAL_LOGGER_INFO(F("(Re)Setting up all slaves"));
 	esp32_spi_master = new Esp32SpiMaster(SCK_PIN_ORANGE, MISO_PIN_YELLOW, MOSI_PIN_GREEN,
-										  frequency, INTER_TRANSACTION_DELAY_MICROSECONDS);
+										  frequency, DMA_CHANNEL, SPI_MODE0, TX_RX_BUFFER_SIZE, CHUNK_SIZE,
+										  INTER_TRANSACTION_DELAY_MICROSECONDS);
 
 	const int engine_slave_id = Esp32SpiMaster::take_free_id();
 	if (engine_slave_id >= 0) {
 		SpiSlaveHandler *spi_slave_handler = esp32_spi_master->get_handler(ENGINE_CONTROL_SS_PIN_BLUE);
 		EngineSlave *spi_slave = new EngineSlave(spi_slave_handler, engine_slave_id, ENGINE_CONTROL_SS_PIN_BLUE,
-												 ENGINE_RESTART_PIN_PIN, esp32Ps4Ctrl, _roboPilot);
+												 ENGINE_RESTART_PIN_PIN, esp32Ps4Ctrl, _roboPilot, spi_frame_format);
+		spi_slave->set_recovery_limits(spi_recovery_retries, spi_recovery_resyncs);
 		esp32_spi_master->put_slave(spi_slave);
 	} else {
-		SerialLogger::error(F("Cannot add a new engine slave to. Got no free id from Esp32SpiMaster"));
+		SERIAL_LOGGER_ERROR(F("Cannot add a new engine slave to. Got no free id from Esp32SpiMaster"));
 	}
 
 	const int obstacle_slave_id = Esp32SpiMaster::take_free_id();
@@ -56,23 +81,29 @@ void re_setup_spi_communication() {
 		SpiSlaveHandler *spi_slave_handler = esp32_spi_master->get_handler(OBSTACLE_DETECTION_CONTROL_SS_PIN_BROWN);
 		ObstacleDetectionSlave *spi_slave = new ObstacleDetectionSlave(spi_slave_handler, obstacle_slave_id,
 																	   OBSTACLE_DETECTION_CONTROL_SS_PIN_BROWN,
-																	   OBSTACLE_DETECTION_RESTART_PIN_PIN, _roboPilot);
+																	   OBSTACLE_DETECTION_RESTART_PIN_PIN, _roboPilot,
+																	   spi_frame_format);
+		spi_slave->set_recovery_limits(spi_recovery_retries, spi_recovery_resyncs);
 		esp32_spi_master->put_slave(spi_slave);
 	} else {
-		SerialLogger::error(F("Cannot add a new obstacle detection slave to. Got no free id from Esp32SpiMaster"));
+		SERIAL_LOGGER_ERROR(F("Cannot add a new obstacle detection slave to. Got no free id from Esp32SpiMaster"));
 	}
-	esp32_spi_master->schedule(spi_schedule_next_slave_commands_intervall, _timer);
+	esp32_spi_master->schedule(spi_schedule_next_slave_commands_intervall, _timer, spi_scheduling_mode,
+							   spi_transfer_mode);
 }
 
 void setup() {
 	SerialLogger::init(9600, SerialLogger::LOG_LEVEL::INFO);
 	esp32Ps4Ctrl = new ESP32_PS4_Controller(masterMac, _timer);
 
-	_roboPilot = new RuleBasedMotionStateRoboPilot();
+	_roboPilot = new LAWNMOVER_ROBO_PILOT();
 
 	_timer.every(restart_check_intervall, [](void *) -> bool {
 		if (esp32_spi_master == nullptr || esp32_spi_master->stopped()) {
 			re_setup_spi_communication();
+		} else if (++recovery_metrics_report_checks >= recovery_metrics_report_restart_checks) {
+			recovery_metrics_report_checks = 0;
+			esp32_spi_master->print_recovery_metrics();
 		}
 		return true;
 	});
@@ -82,4 +113,6 @@ void setup() {
 void loop() {
 	// tick timers
 	auto ticks = _timer.tick();
+	// hand buffered binary log records to Serial (if any)
+	SerialLogger::flush();
 }
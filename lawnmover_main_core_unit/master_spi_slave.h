@@ -4,8 +4,8 @@
 #include <Arduino.h>
 #include <stdint.h>
 
-#include <vector>
 #include <functional>
+#include <utility>
 
 #include <spi_commands.h>
 #include <serial_logger.h>
@@ -13,43 +13,117 @@
 
 #include "spi_slave_handler.h"
 
+/**
+ * Callbacks of the values a slave answers to data requests, by command id (see SpiCommandTable)
+ */
+template<typename T>
+using DataRequestCallbacks = std::function<void(T)>[AMOUNT_SPI_COMMANDS];
+
 class MasterSpiSlave {
 public:
+	/**
+	 * LEGACY sends a frame of 9 bytes per command, COMPACT one frame with the values of all commands packed and a
+	 * crc-8 (see SpiCommands::getCompactFrameSize). PIPELINED drops the trailing byte of the compact frame: the slave
+	 * answers each frame with the one its loop staged for the previous frame (see SpiCommands::getPipelinedFrameSize),
+	 * i. e. requested values arrive one frame later. The slaves understand all of them.
+	 */
+	enum FrameFormat {
+		LEGACY, COMPACT, PIPELINED
+	};
+
+	/**
+	 * How the master reacts to a rejected frame, escalating with the consecutive rejected frames of the slave (see
+	 * set_recovery_limits): RETRY goes on with the next frame, RESYNC sends the start sequence in-band instead (see
+	 * SpiCommands::COMMUNICATION_START_SEQUENCE) and RESET pulses the restart pin, i. e. the slave reboots.
+	 */
+	enum RecoveryTier {
+		RETRY, RESYNC, RESET, AMOUNT_RECOVERY_TIERS
+	};
+
+	/**
+	 * The recoveries whose highest tier was a given one and the time from their first rejected frame until the next
+	 * accepted one, i. e. the time the main core unit was blind to the slave
+	 */
+	struct RecoveryMetrics {
+		unsigned long recoveries;
+		unsigned long total_millis;
+		unsigned long max_millis;
+	};
+
+	/**
+	 * The commands of a slave have the consecutive ids starting at first_command_id
+	 */
 	MasterSpiSlave(SpiSlaveHandler *spi_slave_handler, const int slave_id, const char *name, const int slave_pin,
 				   const int slave_restart_pin, const int amount_data_push_commands,
-				   const int amount_data_request_commands) :
+				   const int amount_data_request_commands, const int16_t first_command_id,
+				   const FrameFormat frame_format) :
 			k_slave_id(slave_id), k_name(name), k_slave_pin(slave_pin), k_slave_restart_pin(slave_restart_pin),
 			k_amount_data_push_commands(amount_data_push_commands),
 			k_amount_data_request_callbacks(amount_data_request_commands),
-			k_buffer_size((amount_data_push_commands + amount_data_request_commands) * COMMAND_FRAME_SIZE) {
+			k_first_command_id(first_command_id), k_frame_format(frame_format),
+			k_buffer_size(get_frame_size(frame_format, first_command_id,
+										 amount_data_push_commands + amount_data_request_commands)) {
 		_spi_slave_handler = spi_slave_handler;
 
-		// to use DMA buffer, use these methods to allocate buffer
-		_tx_buffer = (uint8_t *) malloc(k_buffer_size * sizeof _tx_buffer);
-		memset(_tx_buffer, 0, k_buffer_size);
+		// DMA capable buffers spare the driver copying them into temporary ones for each transaction. DMA writes whole
+		// words, thus, round up to a multiple of 4 bytes. The start sequence is sent from the tx buffer, too.
+		const long dma_buffer_size = (max(k_buffer_size, (long) COMMUNICATION_START_SEQUENCE_LENGTH) + 3) / 4 * 4;
+		_tx_buffer = _spi_slave_handler->allocDMABuffer(dma_buffer_size * sizeof *_tx_buffer);
+		memset(_tx_buffer, 0, dma_buffer_size);
 
-		// to use DMA buffer, use these methods to allocate buffer
-		_rx_buffer = (uint8_t *) malloc(k_buffer_size * sizeof _rx_buffer);
-		memset(_rx_buffer, 0, k_buffer_size);
+		_rx_buffer = _spi_slave_handler->allocDMABuffer(dma_buffer_size * sizeof *_rx_buffer);
+		memset(_rx_buffer, 0, dma_buffer_size);
+
+		if (k_frame_format == PIPELINED) {
+			// the slave answers a frame with the next one; swapped with the tx buffer after each frame
+			_previous_tx_buffer = _spi_slave_handler->allocDMABuffer(dma_buffer_size * sizeof *_previous_tx_buffer);
+			memset(_previous_tx_buffer, 0, dma_buffer_size);
+		}
 
 		delay(1000);
 	};
 
+	virtual ~MasterSpiSlave() {
+		// memory of heap_caps_malloc may be freed by free, too
+		free(_tx_buffer);
+		free(_rx_buffer);
+		free(_previous_tx_buffer);
+		// releases the chip select line of the slave, too
+		delete _spi_slave_handler;
+	};
+
 	uint8_t *supply(long &buffer_size) {
 		if (_slave_synchronized) {
-			fill_commands_bytes(_tx_buffer);
+			if (k_frame_format == COMPACT || k_frame_format == PIPELINED) {
+				_compact_crc = SpiCommands::putCompactFrameHeader(k_frame_format == COMPACT ? COMPACT_FRAME_MARKER
+																							: PIPELINED_FRAME_MARKER,
+																  ++_sequence, k_first_command_id,
+																  k_amount_data_push_commands +
+																  k_amount_data_request_callbacks, _tx_buffer);
+				_compact_value_offset = COMPACT_FRAME_HEADER_SIZE;
+				fill_commands_bytes(_tx_buffer);
+				if (k_frame_format == COMPACT) {
+					SpiCommands::putCompactFrameTrailer(_tx_buffer, k_buffer_size, _compact_crc);
+				} else {
+					SpiCommands::putPipelinedFrameTrailer(_tx_buffer, k_buffer_size, _compact_crc);
+				}
+			} else {
+				fill_commands_bytes(_tx_buffer);
+			}
 
 			buffer_size = k_buffer_size;
 			return _tx_buffer;
 		} else {
+			_previous_frame_pending = false;
 			buffer_size = COMMUNICATION_START_SEQUENCE_LENGTH;
-			return SpiCommands::COMMUNICATION_START_SEQUENCE;
+			memcpy(_tx_buffer, SpiCommands::COMMUNICATION_START_SEQUENCE, COMMUNICATION_START_SEQUENCE_LENGTH);
+			return _tx_buffer;
 		}
 	};
 
 	uint8_t *get_rx_buffer(long tx_rx_buffer_size) {
 		if (tx_rx_buffer_size > k_buffer_size) {
-			SerialLogger::warn(F("Attempt to get rx buffer with %d bytes while buffer has size %d"), tx_rx_buffer_size,
+			SERIAL_LOGGER_WARN(F("Attempt to get rx buffer with %d bytes while buffer has size %d"), tx_rx_buffer_size,
 							   k_buffer_size);
 			return nullptr;
 		} else {
@@ -63,7 +137,7 @@ public:
 		bool valid = true;
 		if (_slave_synchronized) {
 			if (buffer_size != k_buffer_size) {
-				SerialLogger::error(F("Cannot consume slave output from %s. Buffer size does not match written "
+				SERIAL_LOGGER_ERROR(F("Cannot consume slave output from %s. Buffer size does not match written "
 									  "bytes to slave"), k_name);
 				valid = false;
 			} else {
@@ -71,7 +145,7 @@ public:
 			}
 		} else {
 			if (buffer_size != COMMUNICATION_START_SEQUENCE_LENGTH) {
-				SerialLogger::error(F("Cannot consume slave output from %s. Buffer size does not match written bytes "
+				SERIAL_LOGGER_ERROR(F("Cannot consume slave output from %s. Buffer size does not match written bytes "
 									  "to slave"), k_name);
 				valid = false;
 			} else {
@@ -79,10 +153,10 @@ public:
 				for (long i = 0; i < COMMUNICATION_START_SEQUENCE_LENGTH - 1; i += 1) {
 					const char &rx_byte = slave_response_buffer[i + COMMAND_SPI_RX_OFFSET];
 					if (rx_byte == SpiCommands::COMMUNICATION_START_SEQUENCE[i]) {
-						SerialLogger::trace(F("Slave from %s rx byte on index %d is %x and does match expected byte "
+						SERIAL_LOGGER_TRACE(F("Slave from %s rx byte on index %d is %x and does match expected byte "
 											  "%x "), k_name, i, rx_byte, SpiCommands::COMMUNICATION_START_SEQUENCE[i]);
 					} else {
-						SerialLogger::warn(F("Slave from %s rx byte on index %d is %x and does not match expected byte "
+						SERIAL_LOGGER_WARN(F("Slave from %s rx byte on index %d is %x and does not match expected byte "
 											 "%x "), k_name, i, rx_byte, SpiCommands::COMMUNICATION_START_SEQUENCE[i]);
 						valid = false;
 						break;
@@ -93,24 +167,97 @@ public:
 
 		if (valid) {
 			if (!_slave_synchronized) {
-				SerialLogger::info(F("%s slave synchronized with this master"), k_name);
+				SERIAL_LOGGER_INFO(F("%s slave synchronized with this master"), k_name);
 			}
 			_slave_synchronized = true;
 		} else {
 			if (_slave_synchronized) {
-				SerialLogger::warn(F("%s slave no longer synchronized with this master"), k_name);
+				SERIAL_LOGGER_WARN(F("%s slave no longer synchronized with this master"), k_name);
 			} else {
-				SerialLogger::warn(F("%s slave not synchronized with this master"), k_name);
+				SERIAL_LOGGER_WARN(F("%s slave not synchronized with this master"), k_name);
 			}
+			_rejected_frame_synchronized = _slave_synchronized;
 			_slave_synchronized = false;
+			_previous_frame_pending = false;
 		}
 
+		if (valid && _recovering) {
+			finish_recovery();
+		}
 		return valid;
 	};
 
+	/**
+	 * Call upon a frame consume rejected: retry, resynchronize or restart the slave depending on the consecutive
+	 * rejected frames
+	 *
+	 * @return the tier taken
+	 */
+	RecoveryTier recover() {
+		if (!_recovering) {
+			_recovering = true;
+			_recovery_start_millis = millis();
+			_recovery_tier = RETRY;
+			_rejected_frames = 0;
+		}
+		_rejected_frames++;
+		_tier_rejected_frames++;
+		const RecoveryTier tier = _tier_rejected_frames <= _max_retries ? RETRY :
+								  (_tier_rejected_frames <= _max_retries + _max_resyncs ? RESYNC : RESET);
+		if (tier > _recovery_tier) {
+			_recovery_tier = tier;
+		}
+
+		switch (tier) {
+			case RETRY:
+				// the slave may have missed or garbled a single frame only; a rejected start sequence is sent again
+				_slave_synchronized = _rejected_frame_synchronized;
+				// a pipelined slave discards a frame with a bad crc, i. e. its next answer is stale and rejected, too
+				_previous_frame_pending = _rejected_frame_synchronized && k_frame_format == PIPELINED;
+				break;
+			case RESYNC:
+				// consume dropped the synchronization already, i. e. the next frame is the start sequence
+				SERIAL_LOGGER_INFO(F("Resynchronizing slave %s after %d rejected frames"), k_name,
+								   _tier_rejected_frames);
+				break;
+			default:
+				restart();
+				// give the rebooted slave the retries and resyncs again
+				_tier_rejected_frames = 0;
+				break;
+		}
+		return tier;
+	};
+
+	/**
+	 * Consecutive rejected frames recover allows at each tier before escalating to the next one. 0 and 0 restart the
+	 * slave upon any rejected frame.
+	 */
+	void set_recovery_limits(const int max_retries, const int max_resyncs) {
+		_max_retries = max_retries;
+		_max_resyncs = max_resyncs;
+	};
+
+	const RecoveryMetrics &get_recovery_metrics(const RecoveryTier tier) const {
+		return _recovery_metrics[tier];
+	};
+
+	static const char *get_recovery_tier_name(const RecoveryTier tier) {
+		switch (tier) {
+			case RETRY:
+				return "retry";
+			case RESYNC:
+				return "resync";
+			case RESET:
+				return "reset";
+			default:
+				return "<unknown>";
+		}
+	};
+
 
 	void restart() {
-		SerialLogger::info(F("(Re)Starting slave %d (%s) connected to slave-select pin %d with power supply on pin %d"),
+		SERIAL_LOGGER_INFO(F("(Re)Starting slave %d (%s) connected to slave-select pin %d with power supply on pin %d"),
 						   k_slave_id + 1, k_name, k_slave_pin, k_slave_restart_pin);
 		// if we put some voltage on the reset pin, the board will restart
 		pinMode(k_slave_restart_pin, OUTPUT);
@@ -147,6 +294,10 @@ public:
 		return k_buffer_size;
 	};
 
+	FrameFormat get_frame_format() const {
+		return k_frame_format;
+	};
+
 	bool is_slave_synchronized() const {
 		return _slave_synchronized;
 	};
@@ -156,6 +307,20 @@ public:
 	};
 
 protected:
+	/**
+	 * Put the command at index (of the commands of this slave) to the frame in the tx buffer. The values of compact
+	 * frames are packed one after another and update the crc-8 of the frame, thus, put the commands in order of index.
+	 */
+	template<typename T>
+	void put_command(const int index, const int16_t command_id, const T command_value, uint8_t *tx_buffer) {
+		if (k_frame_format != LEGACY) {
+			_compact_value_offset = SpiCommands::putCompactValueToBuffer(command_id, _compact_value_offset,
+																		 command_value, tx_buffer, _compact_crc);
+		} else {
+			SpiCommands::putCommandToBuffer(command_id, command_value, tx_buffer + index * COMMAND_FRAME_SIZE);
+		}
+	};
+
 	/**
 	 * Please note: Passing the data request callbacks with template type allows interpreations of different commands
 	 * with different value type if called with different callbacks and an offset to tx, rx buffer leading to maximum
@@ -163,91 +328,83 @@ protected:
 	 */
 	template<typename T>
 	bool interpret_communication(const uint8_t *tx_buffer, const uint8_t *rx_buffer, const long buffer_size,
-								 const int amount_data_request_callbacks,
-								 std::vector <std::function<bool(int16_t, T)>> data_request_callbacks) {
-		SerialLogger::trace(F("Validating master-slave communication for %s"), k_name);
-		uint8_t rxId1[COMMAND_FRAME_ID_SIZE];
-		uint8_t rxId2[COMMAND_FRAME_ID_SIZE];
-		uint8_t txId1_bytes[COMMAND_FRAME_ID_SIZE];
-		uint8_t txId2_bytes[COMMAND_FRAME_ID_SIZE];
-		uint8_t rx_value_bytes[COMMAND_FRAME_VALUE_SIZE];
-		uint8_t tx_value_bytes[COMMAND_FRAME_VALUE_SIZE];
-
+								 const DataRequestCallbacks<T> &data_request_callbacks) {
+		if (k_frame_format == COMPACT) {
+			return interpret_compact_communication(tx_buffer, rx_buffer, buffer_size, data_request_callbacks);
+		} else if (k_frame_format == PIPELINED) {
+			return interpret_pipelined_communication(tx_buffer, rx_buffer, buffer_size, data_request_callbacks);
+		}
+		SERIAL_LOGGER_TRACE(F("Validating master-slave communication for %s"), k_name);
 		for (long i = 0; i + COMMAND_FRAME_SIZE <= buffer_size; i += COMMAND_FRAME_SIZE) {
-			// Get the ReqId
-			for (int id_counter = 0; id_counter < COMMAND_FRAME_ID_SIZE; id_counter++) {
-				//Serial.printf("%d, %d, %d -> %d: %x\n", COMMAND_SPI_RX_OFFSET , i, id_counter, COMMAND_SPI_RX_OFFSET + i + id_counter, rx_buffer[COMMAND_SPI_RX_OFFSET + i + id_counter]);
-				rxId1[id_counter] = rx_buffer[COMMAND_SPI_RX_OFFSET + i + id_counter];
-				txId1_bytes[id_counter] = tx_buffer[i + id_counter];
+			const LegacyCommandView command(tx_buffer + i, rx_buffer + COMMAND_SPI_RX_OFFSET + i);
+			const int16_t id = command.getRequestId();
+			if (command.getRequestAckId() != -1) {
+				SERIAL_LOGGER_WARN(F("Master did send wrong 2nd (ack) id which must be -1 but was %d. This is rather "
+									 "strange..."), command.getRequestAckId());
 			}
 
-			// Get the command value
-			for (int value_counter = 0; value_counter < COMMAND_FRAME_VALUE_SIZE; value_counter++) {
-				//Serial.printf("%d: %x\n", COMMAND_SPI_RX_OFFSET + i + COMMAND_FRAME_ID_SIZE + value_counter, rx_buffer[COMMAND_SPI_RX_OFFSET + i + COMMAND_FRAME_ID_SIZE + value_counter]);
-				rx_value_bytes[value_counter] = rx_buffer[COMMAND_SPI_RX_OFFSET + i + COMMAND_FRAME_ID_SIZE +
-														  value_counter];
-				tx_value_bytes[value_counter] = tx_buffer[i + COMMAND_FRAME_ID_SIZE + value_counter];
-			}
-
-			// Get the AckId == ReqId
-			for (int id_counter = 0; id_counter < COMMAND_FRAME_ID_SIZE; id_counter++) {
-				//Serial.printf("%d: %x\n", COMMAND_SPI_RX_OFFSET + i + COMMAND_FRAME_ID_SIZE + COMMAND_FRAME_VALUE_SIZE + id_counter, rx_buffer[COMMAND_SPI_RX_OFFSET + i + COMMAND_FRAME_ID_SIZE + COMMAND_FRAME_VALUE_SIZE + id_counter]);
-				rxId2[id_counter] = rx_buffer[COMMAND_SPI_RX_OFFSET + i + COMMAND_FRAME_ID_SIZE +
-											  COMMAND_FRAME_VALUE_SIZE + id_counter];
-				txId2_bytes[id_counter] = tx_buffer[i + COMMAND_FRAME_ID_SIZE + COMMAND_FRAME_VALUE_SIZE + id_counter];
-			}
-
-			int16_t txId1 = 0;
-			int16_t txId2 = 0;
-			memcpy(&txId1, txId1_bytes, sizeof(txId1));
-			memcpy(&txId2, txId2_bytes, sizeof(txId2));
-			if (txId2 != -1) {
-				SerialLogger::warn(F("Master did send wrong 2nd (ack) id which must be -1 but was %d. This is rather "
-									 "strange..."), txId2);
-			}
-
-			const int16_t id1 = SpiCommands::verifyIds(rxId1, txId1_bytes);
-			// txId2 is the request to ack the very first id of a command, thus we use txId1 again to compare against rxId2
-			const int16_t id2 = SpiCommands::verifyIds(rxId2, txId1_bytes);
-			SerialLogger::trace(F("Comparing %d (txId1) with %d (rxId1) with %d (rxId2/ackId) and value %x%x%x%x"),
-								txId1, id1, id2, rx_value_bytes[0], rx_value_bytes[1], rx_value_bytes[2],
-								rx_value_bytes[3]);
-			if (id1 <= 0 || id2 <= 0) {
-				SerialLogger::error(F("Unknown ids received %d, %d"), id1, id2);
+			if (command.getAnswerId() != id || command.getAnswerAckId() != id) {
+				SERIAL_LOGGER_ERROR(F("Req and Ack Id do not align: tx %d, rx %d, ack %d"), id, command.getAnswerId(),
+									command.getAnswerAckId());
 				return false;
-			} else if (id1 != id2) {
-				SerialLogger::error(F("Req and Ack Id do not align %d != %d"), id1, id2);
+			} else if (!SpiCommandTable::isKnown(id)) {
+				SERIAL_LOGGER_WARN(F("Received unknown id %d"), id);
 				return false;
-			} else if (id1 > MAX_ID) {
-				SerialLogger::warn(F("Received bad id %d > %d (max)"), id1, MAX_ID);
+			} else if (!dispatch_data_request(data_request_callbacks, id, command.getAnswerValueBytes(),
+											  COMMAND_FRAME_VALUE_SIZE) && !command.echoesValue()) {
+				SERIAL_LOGGER_WARN(F("Slave did not return correct value bytes"));
 				return false;
-			} else {
-				T rx_data = 0;
-				memcpy(&rx_data, rx_value_bytes, COMMAND_FRAME_VALUE_SIZE);
-				bool processed = false;
-				for (int i = 0; i < amount_data_request_callbacks && !processed; i++) {
-					processed = data_request_callbacks[i](id1, rx_data);
-				}
-
-				if (processed) {
-					SerialLogger::trace(F("Data response from slave %s with id %d was processed as data request"),
-										k_name, id1);
-				} else {
-					SerialLogger::trace(F("Data response from slave %s with id %d was processed as data push"),
-										k_name, id1);
-					for (int value_counter; value_counter < COMMAND_FRAME_VALUE_SIZE; value_counter++) {
-						if (rx_value_bytes[value_counter] != tx_value_bytes[value_counter]) {
-							SerialLogger::warn(F("Slave did not return correct value bytes"));
-							return false;
-						}
-					}
-				}
 			}
 		}
-		SerialLogger::trace(F("Validating master-slave communication for %s done"), k_name);
 		return true;
 	}
 
+	/**
+	 * The slave answers with its own frame one byte later: the echo of the header, the values and the crc-8 of both.
+	 * Unlike the echo of the ids of the legacy frame, the crc reveals corrupted values of data requests, too.
+	 */
+	template<typename T>
+	bool interpret_compact_communication(const uint8_t *tx_buffer, const uint8_t *rx_buffer, const long buffer_size,
+										 const DataRequestCallbacks<T> &data_request_callbacks) {
+		SERIAL_LOGGER_TRACE(F("Validating compact master-slave communication for %s"), k_name);
+		return interpret_compact_frame(tx_buffer, rx_buffer + COMMAND_SPI_RX_OFFSET,
+									   buffer_size - COMPACT_FRAME_CRC_SIZE - COMMAND_SPI_RX_OFFSET,
+									   data_request_callbacks);
+	}
+
+	/**
+	 * The slave answers with the frame its loop staged for the previous frame, thus, reconcile it with the previous
+	 * tx buffer. There is nothing to reconcile for the first frame after synchronizing.
+	 */
+	template<typename T>
+	bool interpret_pipelined_communication(const uint8_t *tx_buffer, const uint8_t *rx_buffer, const long buffer_size,
+										   const DataRequestCallbacks<T> &data_request_callbacks) {
+		SERIAL_LOGGER_TRACE(F("Validating pipelined master-slave communication for %s"), k_name);
+		const unsigned long now = millis();
+		bool valid = true;
+		if (_previous_frame_pending) {
+			_response_delay_millis = now - _previous_frame_millis;
+			valid = interpret_compact_frame(_previous_tx_buffer, rx_buffer, buffer_size - COMPACT_FRAME_CRC_SIZE,
+											data_request_callbacks);
+		}
+		if (tx_buffer == _tx_buffer) {
+			// supply fills the whole tx buffer anew, thus, keep the sent one instead of copying it
+			std::swap(_tx_buffer, _previous_tx_buffer);
+		} else {
+			memcpy(_previous_tx_buffer, tx_buffer, buffer_size);
+		}
+		_previous_frame_millis = now;
+		_previous_frame_pending = valid;
+		return valid;
+	}
+
+	/**
+	 * Milliseconds the answers of the slave lag behind (the time since the previous frame if pipelined)
+	 */
+	unsigned long get_response_delay_millis() const {
+		return k_frame_format == PIPELINED ? _response_delay_millis : 0;
+	};
+
 	virtual void fill_commands_bytes(uint8_t *tx_buffer) = 0;
 
 	virtual bool
@@ -256,17 +413,157 @@ protected:
 	const int k_amount_data_request_callbacks;
 
 private:
+	void finish_recovery() {
+		const unsigned long recovery_millis = millis() - _recovery_start_millis;
+		RecoveryMetrics &metrics = _recovery_metrics[_recovery_tier];
+		metrics.recoveries++;
+		metrics.total_millis += recovery_millis;
+		if (recovery_millis > metrics.max_millis) {
+			metrics.max_millis = recovery_millis;
+		}
+		SERIAL_LOGGER_INFO(F("%s slave recovered by %s after %l ms and %d rejected frames (%l recoveries by this "
+							 "tier, %l ms mean, %l ms max)"), k_name, get_recovery_tier_name(_recovery_tier),
+						   recovery_millis, _rejected_frames, metrics.recoveries,
+						   metrics.total_millis / metrics.recoveries, metrics.max_millis);
+		_recovering = false;
+		_tier_rejected_frames = 0;
+	};
+
+	static long get_frame_size(const FrameFormat frame_format, const int16_t first_command_id, const int amount) {
+		switch (frame_format) {
+			case COMPACT:
+				return SpiCommands::getCompactFrameSize(first_command_id, amount);
+			case PIPELINED:
+				return SpiCommands::getPipelinedFrameSize(first_command_id, amount);
+			default:
+				return amount * COMMAND_FRAME_SIZE;
+		}
+	};
+
+	/**
+	 * Decode the value of a data request from the bytes of the slave (values smaller than T fill its leading bytes)
+	 * and hand it to the callback of the id
+	 *
+	 * @return whether the command is a data request (and its callback got the value)
+	 */
+	template<typename T>
+	bool dispatch_data_request(const DataRequestCallbacks<T> &data_request_callbacks, const int16_t id,
+							   const uint8_t *value_bytes, const uint8_t value_size) {
+		const SpiCommandSpec &command = SpiCommandTable::get(id);
+		if (command.direction != DATA_REQUEST) {
+			return false;
+		}
+		return dispatch_data_request(data_request_callbacks, command, decode_value<T>(value_bytes, value_size));
+	}
+
+	template<typename T>
+	bool dispatch_data_request(const DataRequestCallbacks<T> &data_request_callbacks, const SpiCommandSpec &command,
+							   const T value) {
+		if (!data_request_callbacks[command.id]) {
+			SERIAL_LOGGER_WARN(F("Slave %s has no callback for data request %s"), k_name, command.name);
+			return false;
+		}
+		data_request_callbacks[command.id](value);
+		return true;
+	}
+
+	// values smaller than T fill its leading bytes
+	template<typename T>
+	static T decode_value(const uint8_t *value_bytes, const uint8_t value_size) {
+		T value = T();
+		memcpy(&value, value_bytes, sizeof value < value_size ? sizeof value : value_size);
+		return value;
+	}
+
+	/**
+	 * Check the header echo, the echoes of the pushed values and the crc-8 of the frame of the slave in a single walk
+	 * over its bytes. The callbacks get the requested values only once the crc proved them.
+	 *
+	 * @param request_frame the frame the slave answers
+	 * @param slave_frame the frame of the slave with its crc at crc_index
+	 */
+	template<typename T>
+	bool interpret_compact_frame(const uint8_t *request_frame, const uint8_t *slave_frame, const long crc_index,
+								 const DataRequestCallbacks<T> &data_request_callbacks) {
+		const CompactFrameView frame(request_frame, slave_frame, crc_index);
+		uint8_t crc;
+		if (!frame.echoesHeader(crc)) {
+			SERIAL_LOGGER_ERROR(F("Slave %s did not echo the header of frame %d: %x%x%x%x"), k_name,
+								frame.getSequence(), slave_frame[0], slave_frame[1], slave_frame[2], slave_frame[3]);
+			return false;
+		}
+
+		const int16_t first_id = frame.getFirstId();
+		T values[AMOUNT_SPI_COMMANDS];
+		int16_t not_echoed_id = NO_COMMAND;
+		long offset = COMPACT_FRAME_HEADER_SIZE;
+		for (int index = 0; index < frame.getAmount(); index++) {
+			const SpiCommandSpec &command = SpiCommandTable::get((int16_t) (first_id + index));
+			if (command.direction == DATA_REQUEST) {
+				values[command.id] = decode_value<T>(frame.getAnswerValueBytes(offset, command.value_size, crc),
+													 command.value_size);
+			} else if (!frame.echoesValue(offset, command.value_size, crc) && not_echoed_id == NO_COMMAND) {
+				not_echoed_id = command.id;
+			}
+			offset += command.value_size;
+		}
+
+		if (!frame.hasValidCrc(crc)) {
+			SERIAL_LOGGER_ERROR(F("Crc of frame %d from slave %s is %x but should be %x"), frame.getSequence(), k_name,
+								frame.getAnswerCrc(), crc);
+			return false;
+		} else if (not_echoed_id != NO_COMMAND) {
+			SERIAL_LOGGER_WARN(F("Slave did not return correct value bytes of id %d"), not_echoed_id);
+			return false;
+		}
+
+		for (int index = 0; index < frame.getAmount(); index++) {
+			const SpiCommandSpec &command = SpiCommandTable::get((int16_t) (first_id + index));
+			if (command.direction == DATA_REQUEST &&
+				!dispatch_data_request(data_request_callbacks, command, values[command.id])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
 	const int k_slave_id;
 	const char *k_name;
 	const int k_slave_pin;
 	const int k_slave_restart_pin;
 	const int k_amount_data_push_commands;
+	const int16_t k_first_command_id;
+	const FrameFormat k_frame_format;
 	const long k_buffer_size;
 
 	uint8_t *_tx_buffer;
 	uint8_t *_rx_buffer;
 
-	bool _slave_synchronized;
+	bool _slave_synchronized = false;
+	// of the compact frames; the slave echoes it
+	uint8_t _sequence = 0;
+
+	// of the compact frame supply fills: where put_command puts the next value and the crc-8 of the bytes so far
+	long _compact_value_offset = COMPACT_FRAME_HEADER_SIZE;
+	uint8_t _compact_crc = COMPACT_FRAME_CRC_INIT;
+
+	// the frame the slave answers next if pipelined
+	uint8_t *_previous_tx_buffer = nullptr;
+	bool _previous_frame_pending = false;
+	unsigned long _previous_frame_millis = 0;
+	unsigned long _response_delay_millis = 0;
+
+	// see recover
+	int _max_retries = 2;
+	int _max_resyncs = 3;
+	bool _rejected_frame_synchronized = false;
+	bool _recovering = false;
+	unsigned long _recovery_start_millis = 0;
+	RecoveryTier _recovery_tier = RETRY;
+	int _rejected_frames = 0;
+	// since the recovery started or the slave was restarted
+	int _tier_rejected_frames = 0;
+	RecoveryMetrics _recovery_metrics[AMOUNT_RECOVERY_TIERS] = {};
 	SpiSlaveHandler *_spi_slave_handler;
 };
 
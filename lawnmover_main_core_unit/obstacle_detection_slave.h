@@ -8,73 +8,45 @@
 class ObstacleDetectionSlave : public MasterSpiSlave {
 public:
 	ObstacleDetectionSlave(SpiSlaveHandler *spi_slave_handler, const int slave_id, const int slave_pin,
-						   const int slave_restart_pin, RoboPilot *roboPilot,
+						   const int slave_restart_pin, RoboPilot *roboPilot, const FrameFormat frame_format,
 						   const char *name = "ObstacleDetectionSlave") :
-			MasterSpiSlave(spi_slave_handler, slave_id, name, slave_pin, slave_restart_pin, 0, OBSTACLE_COMMANDS),
+			MasterSpiSlave(spi_slave_handler, slave_id, name, slave_pin, slave_restart_pin, 0, OBSTACLE_COMMANDS,
+						   OBSTACLE_FRONT_COMMAND, frame_format),
 			_roboPilot(roboPilot) {
-		_data_request_callbacks.push_back([&](int16_t id, float distance) -> bool {
-			if (id == OBSTACLE_FRONT_COMMAND) {
-				_roboPilot->putSensorDistance(Category::Direction::FRONT, distance);
-				return true;
-			} else {
-				return false;
-			}
-		});
-		_data_request_callbacks.push_back([&](int16_t id, float distance) -> bool {
-			if (id == OBSTACLE_FRONT_LEFT_COMMAND) {
-				_roboPilot->putSensorDistance(Category::Direction::FRONT_LEFT, distance);
-				return true;
-			} else {
-				return false;
-			}
-		});
-		_data_request_callbacks.push_back([&](int16_t id, float distance) -> bool {
-			if (id == OBSTACLE_FRONT_RIGHT_COMMAND) {
-				_roboPilot->putSensorDistance(Category::Direction::FRONT_RIGHT, distance);
-				return true;
-			} else {
-				return false;
-			}
-		});
-		_data_request_callbacks.push_back([&](int16_t id, float distance) -> bool {
-			if (id == OBSTACLE_BACK_LEFT_COMMAND) {
-				_roboPilot->putSensorDistance(Category::Direction::BACK_LEFT, distance);
-				return true;
-			} else {
-				return false;
-			}
-		});
-		_data_request_callbacks.push_back([&](int16_t id, float distance) -> bool {
-			if (id == OBSTACLE_BACK_RIGHT_COMMAND) {
-				_roboPilot->putSensorDistance(Category::Direction::BACK_RIGHT, distance);
-				return true;
-			} else {
-				return false;
-			}
-		});
+		const int16_t ids[OBSTACLE_COMMANDS] = {OBSTACLE_FRONT_COMMAND, OBSTACLE_FRONT_LEFT_COMMAND,
+												OBSTACLE_FRONT_RIGHT_COMMAND, OBSTACLE_BACK_LEFT_COMMAND,
+												OBSTACLE_BACK_RIGHT_COMMAND};
+		const Category::Direction directions[OBSTACLE_COMMANDS] = {Category::Direction::FRONT,
+																   Category::Direction::FRONT_LEFT,
+																   Category::Direction::FRONT_RIGHT,
+																   Category::Direction::BACK_LEFT,
+																   Category::Direction::BACK_RIGHT};
+		for (int i = 0; i < OBSTACLE_COMMANDS; i++) {
+			const Category::Direction direction = directions[i];
+			_data_request_callbacks[ids[i]] = [this, direction](DistanceSample sample) -> void {
+				_roboPilot->putSensorDistance(direction, sample.getDistance(),
+											  sample.age_millis + get_response_delay_millis());
+			};
+		}
 	};
 
 	void fill_commands_bytes(uint8_t *tx_buffer) override {
-		SpiCommands::putCommandToBuffer(OBSTACLE_FRONT_COMMAND, DATA_REQUEST_VALUE_BYTES, tx_buffer);
-		SpiCommands::putCommandToBuffer(OBSTACLE_FRONT_LEFT_COMMAND, DATA_REQUEST_VALUE_BYTES,
-										tx_buffer + COMMAND_FRAME_SIZE);
-		SpiCommands::putCommandToBuffer(OBSTACLE_FRONT_RIGHT_COMMAND, DATA_REQUEST_VALUE_BYTES,
-										tx_buffer + 2 * COMMAND_FRAME_SIZE);
-		SpiCommands::putCommandToBuffer(OBSTACLE_BACK_LEFT_COMMAND, DATA_REQUEST_VALUE_BYTES,
-										tx_buffer + 3 * COMMAND_FRAME_SIZE);
-		SpiCommands::putCommandToBuffer(OBSTACLE_BACK_RIGHT_COMMAND, DATA_REQUEST_VALUE_BYTES,
-										tx_buffer + 4 * COMMAND_FRAME_SIZE);
+		put_command(0, OBSTACLE_FRONT_COMMAND, DATA_REQUEST_VALUE_BYTES, tx_buffer);
+		put_command(1, OBSTACLE_FRONT_LEFT_COMMAND, DATA_REQUEST_VALUE_BYTES, tx_buffer);
+		put_command(2, OBSTACLE_FRONT_RIGHT_COMMAND, DATA_REQUEST_VALUE_BYTES, tx_buffer);
+		put_command(3, OBSTACLE_BACK_LEFT_COMMAND, DATA_REQUEST_VALUE_BYTES, tx_buffer);
+		put_command(4, OBSTACLE_BACK_RIGHT_COMMAND, DATA_REQUEST_VALUE_BYTES, tx_buffer);
 	};
 
 	bool
 	consume_commands(uint8_t *slave_response_buffer, long slave_response_buffer_size, uint8_t *tx_buffer) override {
 		return interpret_communication(tx_buffer, slave_response_buffer, slave_response_buffer_size,
-									   k_amount_data_request_callbacks, _data_request_callbacks);
+									   _data_request_callbacks);
 	};
 
 private:
 	RoboPilot *_roboPilot;
-	std::vector <std::function<bool(int16_t, float)>> _data_request_callbacks;
+	DataRequestCallbacks<DistanceSample> _data_request_callbacks;
 };
 
 #endif // OBSTACLE_DETECTION_SLAVE_H
@@ -35,11 +35,23 @@ uint32_t SpiSlaveHandler::_frequency = SPI_MASTER_FREQ_8M;
 int SpiSlaveHandler::_queue_size = 1;
 int SpiSlaveHandler::_dma_chan = 0;     // must be 1 or 2 or 0 if deactivated (limits transaction size to 64 bytes)
 int SpiSlaveHandler::_max_size = 4094;  // default size
-std::deque<spi_transaction_t> SpiSlaveHandler::_transactions; // Default init with constructor
+int SpiSlaveHandler::_cs_hold_cycles = 0;
+
+SpiSlaveHandler::~SpiSlaveHandler() {
+    // the esp32 supports three devices per bus only; free the device or it is lost for a re-setup of the slave
+    if (_handle != nullptr) {
+        // the driver still owns the queued transactions
+        while (!_transactions.empty() && collect(portMAX_DELAY));
+        esp_err_t e = spi_bus_remove_device(_handle);
+        if (e != ESP_OK) {
+            printf("[ERROR] SPI bus remove device failed : %d\n", e);
+        }
+    }
+}
 
 bool SpiSlaveHandler::init_bus(const int8_t sck, const int8_t miso, const int8_t mosi, const uint8_t spi_bus) {
     if (_initialized_once) {
-        SerialLogger::info(F("Not initializing SPI bus again. Already initialized."));
+        SERIAL_LOGGER_INFO(F("Not initializing SPI bus again. Already initialized."));
     } else {
         _bus_cfg.sclk_io_num = sck;
         _bus_cfg.miso_io_num = miso;
@@ -58,7 +70,7 @@ bool SpiSlaveHandler::init_bus(const int8_t sck, const int8_t miso, const int8_t
         esp_err_t e = spi_bus_initialize(_host, &_bus_cfg, _dma_chan);
         if (e == ESP_OK) {
             _initialized_once = true;
-            SerialLogger::info("SPI bus initialize succeeded.");
+            SERIAL_LOGGER_INFO("SPI bus initialize succeeded.");
         } else {
             printf("[ERROR] SPI bus initialize failed : %d\n", e);
         }
@@ -73,6 +85,7 @@ bool SpiSlaveHandler::begin(const int8_t sck, const int8_t miso, const int8_t mo
     _if_cfg.clock_speed_hz = _frequency;
     _if_cfg.queue_size = _queue_size;
     _if_cfg.flags = SPI_DEVICE_NO_DUMMY;
+    _if_cfg.cs_ena_posttrans = _cs_hold_cycles;
     // TODO: callback??
     _if_cfg.pre_cb = NULL;
     _if_cfg.post_cb = NULL;
@@ -115,8 +128,9 @@ size_t SpiSlaveHandler::transfer(const uint8_t* tx_buf, uint8_t* rx_buf, const s
 
     addTransaction(tx_buf, rx_buf, size);
 
-    // send a spi transaction, wait for it to complete, and return the result
-    esp_err_t e = spi_device_transmit(_handle, &_transactions.back());
+    // send a spi transaction, wait for it to complete, and return the result. Polling saves the interrupt and task
+    // switch of spi_device_transmit which costs way more than clocking a few bytes.
+    esp_err_t e = spi_device_polling_transmit(_handle, &_transactions.back());
     if (e == ESP_OK) {
         size_t len = _transactions.back().rxlength / 8;
         _transactions.pop_back();
@@ -128,9 +142,43 @@ size_t SpiSlaveHandler::transfer(const uint8_t* tx_buf, uint8_t* rx_buf, const s
     }
 }
 
+bool SpiSlaveHandler::queue(const uint8_t* tx_buf, uint8_t* rx_buf, const size_t size) {
+    if (static_cast<int>(_transactions.size()) >= _if_cfg.queue_size) {
+        SERIAL_LOGGER_ERROR(F("Cannot queue another transaction. All %d slots are pending"), _if_cfg.queue_size);
+        return false;
+    }
+
+    addTransaction(tx_buf, rx_buf, size);
+    esp_err_t e = spi_device_queue_trans(_handle, &_transactions.back(), 0);
+    if (e == ESP_OK) {
+        return true;
+    } else {
+        printf("[ERROR] SPI device queue transaction failed : %d\n", e);
+        _transactions.pop_back();
+        return false;
+    }
+}
+
+bool SpiSlaveHandler::collect(const TickType_t ticks_to_wait) {
+    if (_transactions.empty()) {
+        return false;
+    }
+
+    spi_transaction_t* done = nullptr;
+    esp_err_t e = spi_device_get_trans_result(_handle, &done, ticks_to_wait);
+    if (e == ESP_OK) {
+        // the driver finishes transactions in the order they were queued
+        _transactions.pop_front();
+        return true;
+    } else if (e != ESP_ERR_TIMEOUT) {
+        printf("[ERROR] SPI device get transaction result failed : %d\n", e);
+    }
+    return false;
+}
+
 void SpiSlaveHandler::setDataMode(const uint8_t mode) {
     if (_initialized_once) {
-        SerialLogger::info(F("Not setting data mode again. Already initialized."));
+        SERIAL_LOGGER_INFO(F("Not setting data mode again. Already initialized."));
     } else {
         _mode = mode;
     }
@@ -138,7 +186,7 @@ void SpiSlaveHandler::setDataMode(const uint8_t mode) {
 
 void SpiSlaveHandler::setFrequency(const uint32_t frequency) {
     if (_initialized_once) {
-        SerialLogger::info(F("Not setting frequency again. Already initialized."));
+        SERIAL_LOGGER_INFO(F("Not setting frequency again. Already initialized."));
     } else {
         _frequency = frequency;
     }
@@ -146,7 +194,7 @@ void SpiSlaveHandler::setFrequency(const uint32_t frequency) {
 
 void SpiSlaveHandler::setMaxTransferSize(const int max_size) {
     if (_initialized_once) {
-        SerialLogger::info(F("Not setting max_size again. Already initialized."));
+        SERIAL_LOGGER_INFO(F("Not setting max_size again. Already initialized."));
     } else {
         _max_size = max_size;
     }
@@ -154,12 +202,22 @@ void SpiSlaveHandler::setMaxTransferSize(const int max_size) {
 
 void SpiSlaveHandler::setDMAChannel(const int channel) {
     if (_initialized_once) {
-        SerialLogger::info(F("Not setting DMA channel again. Already initialized."));
+        SERIAL_LOGGER_INFO(F("Not setting DMA channel again. Already initialized."));
     } else {
         _dma_chan = channel;  // 1 or 2 only or 0 to disable
     }
 }
 
+void SpiSlaveHandler::setQueueSize(const int queue_size) {
+    // the same for all slaves, thus, can be set any time before adding a slave
+    _queue_size = queue_size < 1 ? 1 : queue_size;
+}
+
+void SpiSlaveHandler::setCsHoldCycles(const int cycles) {
+    // the same for all slaves, thus, can be set any time before adding a slave
+    _cs_hold_cycles = cycles < 0 ? 0 : (cycles > 16 ? 16 : cycles);
+}
+
 void SpiSlaveHandler::addTransaction(const uint8_t* tx_buf, uint8_t* rx_buf, const size_t size) {
     _transactions.emplace_back(spi_transaction_t());
     _transactions.back().flags = 0;
@@ -34,20 +34,32 @@
 
 class SpiSlaveHandler {
     public:
+        ~SpiSlaveHandler();
+
         bool begin(const int8_t sck, const int8_t miso, const int8_t mosi, const int8_t ss, const uint8_t spi_bus = HSPI);
         bool end();
 
         uint8_t* allocDMABuffer(const size_t s);
 
-        // execute transaction and wait for transmission one by one
+        // execute transaction and busy wait (polling) for its transmission one by one
         size_t transfer(const uint8_t* tx_buf, const size_t size);
         size_t transfer(const uint8_t* tx_buf, uint8_t* rx_buf, const size_t size);
 
+        // queue a transaction and return right away; the buffers must not be touched until it was collected
+        bool queue(const uint8_t* tx_buf, uint8_t* rx_buf, const size_t size);
+        // fetch the oldest queued transaction if it is done within ticks_to_wait (0 does not wait at all)
+        bool collect(const TickType_t ticks_to_wait = 0);
+        size_t pending() const { return _transactions.size(); };
+
         // set these optional parameters before begin() if you want
         static void setDataMode(const uint8_t mode);
         static void setFrequency(const uint32_t frequency);
         static void setMaxTransferSize(const int max_size);
         static void setDMAChannel(const int channel);
+        // keep the slave selected for some spi clock cycles (0-16) after each transaction
+        static void setCsHoldCycles(const int cycles);
+        // maximum amount of queued transactions per slave
+        static void setQueueSize(const int queue_size);
 
     private:
         static bool init_bus(const int8_t sck, const int8_t miso, const int8_t mosi, const uint8_t spi_bus);
@@ -63,10 +75,13 @@ class SpiSlaveHandler {
 
         static int _dma_chan;
         static int _max_size;
-        static std::deque<spi_transaction_t> _transactions;
+        static int _cs_hold_cycles;
+
+        // queued (or transmitting) transactions of this slave; a deque keeps their addresses while the driver owns them
+        std::deque<spi_transaction_t> _transactions;
 
         spi_device_interface_config_t _if_cfg;
-        spi_device_handle_t _handle;
+        spi_device_handle_t _handle = nullptr;
 };
 
 #endif  // SPI_SLAVE_HANDLER_H
@@ -11,6 +11,8 @@
 #define CLOSE_RANGE_LIMIT (float) MAX_DISTANCE * CLOSE_RANGE_MULTIPLIER
 #define CRITICAL_RANGE_LIMIT (float) MAX_DISTANCE * CRITICAL_RANGE_MULTIPLIER
 
+#define AMOUNT_DIRECTIONS 5
+
 
 class Category {
 public:
@@ -36,7 +38,7 @@ public:
 		}
 	};
 
-	static char *getNameFromDistance(const Distance &distance) {
+	static const char *getNameFromDistance(const Distance &distance) {
 		switch (distance) {
 			case TOO_CLOSE:
 				return "TooClose";
@@ -66,7 +68,7 @@ public:
 		BACK_RIGHT
 	};
 
-	static char *getNameFromDirection(const Direction &direction) {
+	static const char *getNameFromDirection(const Direction &direction) {
 		switch (direction) {
 			case FRONT:
 				return "FRONT";
@@ -0,0 +1,119 @@
+#include "coverage_map.h"
+
+#define COVERAGE_MAP_NOT_REACHED 0
+#define COVERAGE_MAP_START 5
+
+namespace {
+	// the directions a cell is reached from, indexed by _reached_from - 1
+	const int8_t k_step_x[] = {1, -1, 0, 0};
+	const int8_t k_step_y[] = {0, 0, 1, -1};
+
+	void reverse(CoverageCell *cells, int first, int last) {
+		for (last--; first < last; first++, last--) {
+			const CoverageCell cell = cells[first];
+			cells[first] = cells[last];
+			cells[last] = cell;
+		}
+	}
+}
+
+CoverageMap::CoverageMap(const float resolution_cm) : k_resolution_cm(resolution_cm) {
+	clear();
+}
+
+void CoverageMap::clear() {
+	memset(_covered, 0, sizeof(_covered));
+	memset(_blocked, 0, sizeof(_blocked));
+	memset(_seen, 0, sizeof(_seen));
+}
+
+void CoverageMap::cover(const float x, const float y, const float radius) {
+	for (int cell_y = toIndex(y - radius); cell_y <= toIndex(y + radius); cell_y++) {
+		const float dy = cell_y * k_resolution_cm - y;
+		for (int cell_x = toIndex(x - radius); cell_x <= toIndex(x + radius); cell_x++) {
+			const float dx = cell_x * k_resolution_cm - x;
+			if (dx * dx + dy * dy <= radius * radius) {
+				setCovered(cell_x, cell_y);
+				// the mower stands there, i. e. it is not blocked whatever was thought before
+				setBlocked(cell_x, cell_y, false);
+			}
+		}
+	}
+}
+
+int CoverageMap::getCoveredCells() const {
+	int cells = 0;
+	for (uint8_t bits : _covered) {
+		for (; bits != 0; bits &= bits - 1) {
+			cells++;
+		}
+	}
+	return cells;
+}
+
+int CoverageMap::planPath(const CoverageCell &from, CoverageCell *path, const int max_length,
+						  const CoverageCell *avoid) {
+	if (!contains(from.x, from.y)) {
+		return 0;
+	}
+	memset(_reached_from, COVERAGE_MAP_NOT_REACHED, sizeof(_reached_from));
+	if (avoid != nullptr && contains(avoid->x, avoid->y)) {
+		// as if reached already
+		_reached_from[toBit(avoid->x, avoid->y)] = COVERAGE_MAP_START;
+	}
+	int head = 0;
+	int tail = 0;
+	_queue[tail++] = (uint16_t) toBit(from.x, from.y);
+	_reached_from[toBit(from.x, from.y)] = COVERAGE_MAP_START;
+
+	// 4-connected, i. e. no cutting corners of blocked cells
+	int target = -1;
+	while (head < tail && target < 0) {
+		const int bit = _queue[head++];
+		const int cell_x = bit % COVERAGE_MAP_CELLS - COVERAGE_MAP_CELLS / 2;
+		const int cell_y = bit / COVERAGE_MAP_CELLS - COVERAGE_MAP_CELLS / 2;
+		for (int direction = 0; direction < 4; direction++) {
+			const int next_x = cell_x + k_step_x[direction];
+			const int next_y = cell_y + k_step_y[direction];
+			if (isBlocked(next_x, next_y)) {
+				continue;
+			}
+			const int next = toBit(next_x, next_y);
+			if (_reached_from[next] != COVERAGE_MAP_NOT_REACHED) {
+				continue;
+			}
+			_reached_from[next] = (uint8_t) (direction + 1);
+			if (isSeen(next_x, next_y) && !get(_covered, next_x, next_y)) {
+				target = next;
+				break;
+			}
+			_queue[tail++] = (uint16_t) next;
+		}
+	}
+	if (target < 0) {
+		return 0;
+	}
+
+	// walk back to the start; the cells closest to the start are the ones kept
+	int length = 0;
+	int cell_x = target % COVERAGE_MAP_CELLS - COVERAGE_MAP_CELLS / 2;
+	int cell_y = target / COVERAGE_MAP_CELLS - COVERAGE_MAP_CELLS / 2;
+	while (_reached_from[toBit(cell_x, cell_y)] != COVERAGE_MAP_START) {
+		const int direction = _reached_from[toBit(cell_x, cell_y)] - 1;
+		path[length % max_length] = {(int8_t) cell_x, (int8_t) cell_y};
+		length++;
+		cell_x -= k_step_x[direction];
+		cell_y -= k_step_y[direction];
+	}
+
+	// the ring holds the path backwards starting at slot length % max_length; turn it into the order to pass the cells
+	const int kept = min(length, max_length);
+	if (length > max_length) {
+		const int oldest = length % max_length;
+		reverse(path, 0, oldest);
+		reverse(path, oldest, max_length);
+		reverse(path, 0, max_length);
+	}
+	reverse(path, 0, kept);
+	return kept;
+}
@@ -0,0 +1,131 @@
+#ifndef COVERAGE_MAP_H
+#define COVERAGE_MAP_H
+
+#include <Arduino.h>
+
+// cells per side of the map; three bits per cell plus the scratch of planPath
+#define COVERAGE_MAP_CELLS 64
+// one stripe per row of cells, i. e. the cut width of the mower minus some overlap
+#define DEFAULT_COVERAGE_MAP_RESOLUTION_CM 40.0f
+
+/**
+ * A cell of the CoverageMap; (0, 0) is centered around the origin of the pose
+ */
+struct CoverageCell {
+	int8_t x;
+	int8_t y;
+};
+
+/**
+ * Coarse bitmap of the lawn around the start of the mower (COVERAGE_MAP_CELLS^2 cells of a configurable resolution,
+ * i. e. 25.6 m x 25.6 m by default). Other than the OccupancyGrid, the map does not move along with the mower: it
+ * remembers for the whole run which cells were mowed already. Per cell, it keeps whether
+ * * it is covered, i. e. the blade passed its center (or it was given up)
+ * * it is blocked, i. e. the mower cannot stand on its center due to a mapped obstacle
+ * * it was seen free, i. e. a sound cone passed its center without an echo
+ *
+ * Cells outside of the map are taken as covered and blocked.
+ */
+class CoverageMap {
+public:
+	explicit CoverageMap(const float resolution_cm = DEFAULT_COVERAGE_MAP_RESOLUTION_CM);
+
+	CoverageCell toCell(const float x, const float y) const {
+		return {(int8_t) toIndex(x), (int8_t) toIndex(y)};
+	};
+
+	float toCoordinate(const int8_t index) const {
+		return index * k_resolution_cm;
+	};
+
+	bool contains(const int cell_x, const int cell_y) const {
+		return cell_x >= -COVERAGE_MAP_CELLS / 2 && cell_x < COVERAGE_MAP_CELLS / 2 &&
+			   cell_y >= -COVERAGE_MAP_CELLS / 2 && cell_y < COVERAGE_MAP_CELLS / 2;
+	};
+
+	/**
+	 * Mark the cells whose center is within the radius around the given position as covered (and not blocked)
+	 */
+	void cover(const float x, const float y, const float radius);
+
+	void setCovered(const int cell_x, const int cell_y) {
+		set(_covered, cell_x, cell_y, true);
+	};
+
+	void setBlocked(const int cell_x, const int cell_y, const bool blocked) {
+		set(_blocked, cell_x, cell_y, blocked);
+	};
+
+	void setSeen(const int cell_x, const int cell_y) {
+		set(_seen, cell_x, cell_y, true);
+	};
+
+	bool isCovered(const int cell_x, const int cell_y) const {
+		return !contains(cell_x, cell_y) || get(_covered, cell_x, cell_y);
+	};
+
+	bool isBlocked(const int cell_x, const int cell_y) const {
+		return !contains(cell_x, cell_y) || get(_blocked, cell_x, cell_y);
+	};
+
+	bool isSeen(const int cell_x, const int cell_y) const {
+		return contains(cell_x, cell_y) && get(_seen, cell_x, cell_y);
+	};
+
+	/**
+	 * Breadth first search from the given cell through the cells not blocked to the closest cell that is seen free
+	 * but not covered yet
+	 *
+	 * @param path filled with the cells to pass, starting with the neighbour of the given cell and ending with the
+	 *        uncovered one. Longer paths are cut after max_length cells.
+	 * @param avoid a cell to take as blocked for this path only (if any)
+	 * @return the amount of cells put into path; zero if there is no uncovered cell reachable
+	 */
+	int planPath(const CoverageCell &from, CoverageCell *path, const int max_length,
+				 const CoverageCell *avoid = nullptr);
+
+	int getCoveredCells() const;
+
+	// Drop everything known
+	void clear();
+
+	float get_resolution() const { return k_resolution_cm; };
+
+private:
+	int toIndex(const float coordinate) const {
+		// the centers of the cells are the multiples of the resolution
+		return (int) floorf(coordinate / k_resolution_cm + 0.5f);
+	};
+
+	static int toBit(const int cell_x, const int cell_y) {
+		return (cell_y + COVERAGE_MAP_CELLS / 2) * COVERAGE_MAP_CELLS + cell_x + COVERAGE_MAP_CELLS / 2;
+	};
+
+	static bool get(const uint8_t *bits, const int cell_x, const int cell_y) {
+		const int bit = toBit(cell_x, cell_y);
+		return (bits[bit >> 3] >> (bit & 7)) & 1;
+	};
+
+	void set(uint8_t *bits, const int cell_x, const int cell_y, const bool value) {
+		if (contains(cell_x, cell_y)) {
+			const int bit = toBit(cell_x, cell_y);
+			if (value) {
+				bits[bit >> 3] |= (uint8_t) (1 << (bit & 7));
+			} else {
+				bits[bit >> 3] &= (uint8_t) ~(1 << (bit & 7));
+			}
+		}
+	};
+
+	const float k_resolution_cm;
+
+	uint8_t _covered[COVERAGE_MAP_CELLS * COVERAGE_MAP_CELLS / 8];
+	uint8_t _blocked[COVERAGE_MAP_CELLS * COVERAGE_MAP_CELLS / 8];
+	uint8_t _seen[COVERAGE_MAP_CELLS * COVERAGE_MAP_CELLS / 8];
+
+	// scratch of planPath: the direction each visited cell was reached from and the queue of cells to visit
+	uint8_t _reached_from[COVERAGE_MAP_CELLS * COVERAGE_MAP_CELLS];
+	uint16_t _queue[COVERAGE_MAP_CELLS * COVERAGE_MAP_CELLS];
+};
+
+#endif // COVERAGE_MAP_H
@@ -7,10 +7,10 @@
 
 class MovementDecision {
 public:
-	static MovementDecision fromState(const MotionState &motionState) {
-		return MovementDecision(static_cast<int16_t>(motionState.get_speed_left() * ENGINE_MAX_POWER_VALUE),
-								static_cast<int16_t>(motionState.get_speed_right() * ENGINE_MAX_POWER_VALUE),
-								static_cast<int16_t>(motionState.get_blade_speed() * ENGINE_MAX_POWER_VALUE));
+	static MovementDecision fromState(const MotionStateSpec &motionState) {
+		return MovementDecision(static_cast<int16_t>(motionState.left_speed * ENGINE_MAX_POWER_VALUE),
+								static_cast<int16_t>(motionState.right_speed * ENGINE_MAX_POWER_VALUE),
+								static_cast<int16_t>(motionState.blade_speed * ENGINE_MAX_POWER_VALUE));
 	};
 
 	/**
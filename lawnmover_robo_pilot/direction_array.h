@@ -0,0 +1,56 @@
+#ifndef DIRECTION_ARRAY_H
+#define DIRECTION_ARRAY_H
+
+#include "category.h"
+
+/**
+ * Fixed-size value type holding exactly one value per Category::Direction. It is indexed by the direction itself and
+ * lives wherever its owner lives (e. g. on the stack of makeMovementDecision), thus, there is no heap allocation and
+ * no tree lookup involved compared to a std::map<Category::Direction, T>.
+ */
+template<typename T>
+class DirectionArray {
+public:
+	DirectionArray() : _values{} {
+		// nothing to do...
+	};
+
+	explicit DirectionArray(const T &value) {
+		fill(value);
+	};
+
+	T &operator[](const Category::Direction direction) {
+		return _values[direction];
+	};
+
+	const T &operator[](const Category::Direction direction) const {
+		return _values[direction];
+	};
+
+	void fill(const T &value) {
+		for (int i = 0; i < AMOUNT_DIRECTIONS; i++) {
+			_values[i] = value;
+		}
+	};
+
+	static Category::Direction directionAt(const int index) {
+		return static_cast<Category::Direction>(index);
+	};
+
+	static int size() {
+		return AMOUNT_DIRECTIONS;
+	};
+
+	T *begin() { return _values; };
+
+	T *end() { return _values + AMOUNT_DIRECTIONS; };
+
+	const T *begin() const { return _values; };
+
+	const T *end() const { return _values + AMOUNT_DIRECTIONS; };
+
+private:
+	T _values[AMOUNT_DIRECTIONS];
+};
+
+#endif // DIRECTION_ARRAY_H
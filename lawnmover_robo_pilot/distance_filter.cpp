@@ -0,0 +1,44 @@
+#include "distance_filter.h"
+
+void DistanceFilter::put(const float distance, const unsigned long sample_millis) {
+	if (!_initialized) {
+		init(distance);
+		_initialized = true;
+	} else if ((long) (sample_millis - _last_sample_millis) >= (long) DISTANCE_FILTER_MIN_SAMPLE_INTERVAL_MILLIS) {
+		update(distance, (sample_millis - _last_sample_millis) / 1000.0f);
+	} else {
+		return;
+	}
+	_last_sample_millis = sample_millis;
+}
+
+void ExponentialMovingAverageFilter::update(const float distance, const float dt_seconds) {
+	const float alpha = 1.0f - expf(-dt_seconds / k_time_constant_seconds);
+	_distance += alpha * (distance - _distance);
+}
+
+void AlphaBetaFilter::init(const float distance) {
+	_distance = distance;
+	_velocity = 0.0f;
+}
+
+void AlphaBetaFilter::update(const float distance, const float dt_seconds) {
+	const float predicted = _distance + _velocity * dt_seconds;
+	const float residual = distance - predicted;
+	_distance = predicted + k_alpha * residual;
+	_velocity += k_beta * residual / dt_seconds;
+}
+
+void KalmanFilter::init(const float distance) {
+	_distance = distance;
+	_variance = k_measurement_noise;
+}
+
+void KalmanFilter::update(const float distance, const float dt_seconds) {
+	// predict: the distance stays, its uncertainty grows
+	_variance += k_process_noise * dt_seconds;
+	// correct
+	const float gain = _variance / (_variance + k_measurement_noise);
+	_distance += gain * (distance - _distance);
+	_variance *= 1.0f - gain;
+}
@@ -0,0 +1,135 @@
+#ifndef DISTANCE_FILTER_H
+#define DISTANCE_FILTER_H
+
+#include <Arduino.h>
+
+// time constant of the exponential moving average; as fast as an alpha of 0.7 per spi schedule of 165 ms was
+#define DEFAULT_DISTANCE_FILTER_TIME_CONSTANT_MILLIS 140UL
+// A distance measured less than this after the previous one is taken as the same measurement polled again: the main
+// core unit reconstructs the time of a distance from its age, which shifts by a few ms of spi latency per poll. Each
+// sensor measures every 45 ms at most (see SENSORING_FREQUENCY_DELAY of the distance control unit).
+#define DISTANCE_FILTER_MIN_SAMPLE_INTERVAL_MILLIS 20UL
+#define DEFAULT_ALPHA_BETA_FILTER_ALPHA 0.5f
+#define DEFAULT_ALPHA_BETA_FILTER_BETA 0.1f
+// variance growth of the distance per second (cm^2/s), i. e. how fast obstacles may approach unseen
+#define DEFAULT_KALMAN_FILTER_PROCESS_NOISE 400.0f
+// variance of a single measurement (cm^2)
+#define DEFAULT_KALMAN_FILTER_MEASUREMENT_NOISE 4.0f
+
+/**
+ * Smoothing of the distances of one direction. Filters work on the time a distance was measured at, not on the amount
+ * of distances put, i. e. their response does not change with the spi schedule, the amount of slaves or the sweep rate
+ * of the sensors. A distance less than DISTANCE_FILTER_MIN_SAMPLE_INTERVAL_MILLIS newer than the previous one (e. g. the
+ * very same measurement polled twice) is ignored; otherwise the tiny interval would inflate rates of change.
+ */
+class DistanceFilter {
+public:
+	virtual ~DistanceFilter() = default;
+
+	/**
+	 * @param distance The measured distance in cm
+	 * @param sample_millis The millis (of this mcu) the distance was measured at
+	 */
+	void put(const float distance, const unsigned long sample_millis);
+
+	bool empty() const { return !_initialized; };
+
+	// Note: Zero if empty
+	float get() const { return _distance < 0.0f ? 0.0f : _distance; };
+
+	virtual const char *get_name() const = 0;
+
+protected:
+	// the first distance
+	virtual void init(const float distance) {
+		_distance = distance;
+	};
+
+	// any further distance dt_seconds after the previous one
+	virtual void update(const float distance, const float dt_seconds) = 0;
+
+	float _distance = 0.0f;
+
+private:
+	bool _initialized = false;
+	unsigned long _last_sample_millis = 0;
+};
+
+/**
+ * Exponential moving average in continuous time (https://en.wikipedia.org/wiki/Exponential_smoothing#Time_constant):
+ * the weight of a distance is 1 - exp(-dt / time constant).
+ */
+class ExponentialMovingAverageFilter : public DistanceFilter {
+public:
+	explicit ExponentialMovingAverageFilter(
+			const unsigned long time_constant_millis = DEFAULT_DISTANCE_FILTER_TIME_CONSTANT_MILLIS) :
+			k_time_constant_seconds(time_constant_millis / 1000.0f) {
+		// nothing to do...
+	};
+
+	const char *get_name() const override { return "ExponentialMovingAverageFilter"; };
+
+protected:
+	void update(const float distance, const float dt_seconds) override;
+
+private:
+	const float k_time_constant_seconds;
+};
+
+/**
+ * Alpha-beta filter (https://en.wikipedia.org/wiki/Alpha_beta_filter) tracking the distance and its rate of change,
+ * i. e. an approaching obstacle is not lagging behind as with a moving average.
+ */
+class AlphaBetaFilter : public DistanceFilter {
+public:
+	AlphaBetaFilter(const float alpha = DEFAULT_ALPHA_BETA_FILTER_ALPHA,
+					const float beta = DEFAULT_ALPHA_BETA_FILTER_BETA) :
+			k_alpha(alpha), k_beta(beta) {
+		// nothing to do...
+	};
+
+	const char *get_name() const override { return "AlphaBetaFilter"; };
+
+	// in cm/s; negative if approaching
+	float get_velocity() const { return _velocity; };
+
+protected:
+	void init(const float distance) override;
+
+	void update(const float distance, const float dt_seconds) override;
+
+private:
+	const float k_alpha;
+	const float k_beta;
+	float _velocity = 0.0f;
+};
+
+/**
+ * One dimensional Kalman filter (https://en.wikipedia.org/wiki/Kalman_filter) with a constant distance model. The
+ * uncertainty of the estimate grows with the time since the previous distance, thus, a distance after a long gap
+ * weighs more.
+ */
+class KalmanFilter : public DistanceFilter {
+public:
+	KalmanFilter(const float process_noise = DEFAULT_KALMAN_FILTER_PROCESS_NOISE,
+				 const float measurement_noise = DEFAULT_KALMAN_FILTER_MEASUREMENT_NOISE) :
+			k_process_noise(process_noise), k_measurement_noise(measurement_noise) {
+		// nothing to do...
+	};
+
+	const char *get_name() const override { return "KalmanFilter"; };
+
+	float get_variance() const { return _variance; };
+
+protected:
+	void init(const float distance) override;
+
+	void update(const float distance, const float dt_seconds) override;
+
+private:
+	const float k_process_noise;
+	const float k_measurement_noise;
+	float _variance = 0.0f;
+};
+
+#endif // DISTANCE_FILTER_H
@@ -0,0 +1,77 @@
+#include "distance_history.h"
+
+DistanceHistory::~DistanceHistory() {
+	delete[] _values;
+	delete[] _min_slots;
+	delete[] _max_slots;
+}
+
+void DistanceHistory::resize(const int capacity) {
+	delete[] _values;
+	delete[] _min_slots;
+	delete[] _max_slots;
+
+	_capacity = capacity > 0 ? capacity : 1;
+	_values = new float[_capacity];
+	_min_slots = new int[_capacity];
+	_max_slots = new int[_capacity];
+
+	_size = 0;
+	_head = 0;
+	_sum = 0.0f;
+	_min_front = 0;
+	_min_size = 0;
+	_max_front = 0;
+	_max_size = 0;
+}
+
+float DistanceHistory::latest() const {
+	return _values[_head == 0 ? _capacity - 1 : _head - 1];
+}
+
+float DistanceHistory::oldest() const {
+	return _values[full() ? _head : 0];
+}
+
+void DistanceHistory::put(const float distance) {
+	if (full()) {
+		// The oldest distance gets overwritten. Being the oldest, it can only be at the very front of each deque.
+		_sum -= _values[_head];
+		if (_min_size > 0 && _min_slots[_min_front] == _head) {
+			_min_front = wrap(_min_front + 1);
+			_min_size--;
+		}
+		if (_max_size > 0 && _max_slots[_max_front] == _head) {
+			_max_front = wrap(_max_front + 1);
+			_max_size--;
+		}
+	} else {
+		_size++;
+	}
+
+	_values[_head] = distance;
+	_sum += distance;
+
+	// Drop every slot from the back which can never become the min (max) again since the new distance is both younger
+	// and lower (higher) or equal
+	while (_min_size > 0 && _values[_min_slots[wrap(_min_front + _min_size - 1)]] >= distance) {
+		_min_size--;
+	}
+	_min_slots[wrap(_min_front + _min_size)] = _head;
+	_min_size++;
+
+	while (_max_size > 0 && _values[_max_slots[wrap(_max_front + _max_size - 1)]] <= distance) {
+		_max_size--;
+	}
+	_max_slots[wrap(_max_front + _max_size)] = _head;
+	_max_size++;
+
+	_head = wrap(_head + 1);
+	if (_head == 0) {
+		// Once per wrap-around, recompute the running sum to keep float rounding errors from accumulating
+		_sum = 0.0f;
+		for (int i = 0; i < _size; i++) {
+			_sum += _values[i];
+		}
+	}
+}
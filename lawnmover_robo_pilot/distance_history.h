@@ -0,0 +1,71 @@
+#ifndef DISTANCE_HISTORY_H
+#define DISTANCE_HISTORY_H
+
+/**
+ * Fixed capacity sliding window of distances of one direction. Insertion and all statistics are O(1) (amortized):
+ * * The samples are kept in a circular buffer, thus, no shifting of older samples upon insertion
+ * * Min and max are kept in monotonic deques (https://en.wikipedia.org/wiki/Sliding_window_minimum) holding the slots
+ *   of the circular buffer which can still become the min (max) of the window
+ * * The mean is derived from a running sum that gets recomputed once per wrap-around to prevent float drift
+ *
+ * Memory is allocated once by resize and never again while putting distances.
+ */
+class DistanceHistory {
+public:
+	DistanceHistory() = default;
+
+	// owns raw buffers; copying would lead to double deletion
+	DistanceHistory(const DistanceHistory &distanceHistory) = delete;
+
+	DistanceHistory &operator=(const DistanceHistory &distanceHistory) = delete;
+
+	~DistanceHistory();
+
+	/**
+	 * (Re)allocate the buffers for the given capacity. Any previously stored distances are dropped.
+	 *
+	 * @param capacity The maximum amount of distances kept in the sliding window
+	 */
+	void resize(const int capacity);
+
+	void put(const float distance);
+
+	int size() const { return _size; };
+
+	int capacity() const { return _capacity; };
+
+	bool empty() const { return _size == 0; };
+
+	bool full() const { return _size == _capacity; };
+
+	// Note: The following getters must not be called if empty
+	float latest() const;
+
+	float oldest() const;
+
+	float min() const { return _values[_min_slots[_min_front]]; };
+
+	float max() const { return _values[_max_slots[_max_front]]; };
+
+	float mean() const { return _sum / _size; };
+
+private:
+	int wrap(const int slot) const { return slot >= _capacity ? slot - _capacity : slot; };
+
+	int _capacity = 0;
+	int _size = 0;
+	// the slot the next distance is written to, i. e. the slot of the oldest distance if full
+	int _head = 0;
+	float _sum = 0.0f;
+	float *_values = nullptr;
+
+	// monotonic deques of slots; min values ascending and max values descending from front to back
+	int *_min_slots = nullptr;
+	int _min_front = 0;
+	int _min_size = 0;
+	int *_max_slots = nullptr;
+	int _max_front = 0;
+	int _max_size = 0;
+};
+
+#endif // DISTANCE_HISTORY_H
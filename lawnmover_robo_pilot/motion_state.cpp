@@ -1,5 +1,11 @@
 #include "motion_state.h"
 
+// ISO C++11 needs a definition of odr-used static constexpr members
+constexpr MotionPredicateMask MotionStateTable::k_front_consistent;
+constexpr MotionPredicateMask MotionStateTable::k_back_consistent;
+constexpr MotionRangePredicate MotionStateTable::k_range_predicates[];
+constexpr MotionStateSpec MotionStateTable::k_states[];
+
 /**
  * If there is a large discrepancy between the min distance of a Direction and the weighted moving average, we need to
  * take safety measures because
@@ -23,244 +29,187 @@ bool has_large_min_wAvg_differences(const float minDistance, const float weighte
 	}
 }
 
-bool has_large_min_wAvg_differences_front(const std::map<Category::Direction, float> &minDistances,
-										  const std::map<Category::Direction, float> &weightedMovingAvgDistances) {
+bool has_large_min_wAvg_differences_front(const DirectionArray<float> &minDistances,
+										  const DirectionArray<float> &weightedMovingAvgDistances) {
 
-	if (has_large_min_wAvg_differences(minDistances.at(Category::FRONT_LEFT),
-									   weightedMovingAvgDistances.at(Category::FRONT_LEFT))) {
-		SerialLogger::warn(F("FRONT_LEFT min_wAvg difference too high with min=%f and wAvg=%f"),
-						   minDistances.at(Category::FRONT_LEFT), weightedMovingAvgDistances.at(Category::FRONT_LEFT));
+	if (has_large_min_wAvg_differences(minDistances[Category::FRONT_LEFT],
+									   weightedMovingAvgDistances[Category::FRONT_LEFT])) {
+		SERIAL_LOGGER_WARN(F("FRONT_LEFT min_wAvg difference too high with min=%f and wAvg=%f"),
+						   minDistances[Category::FRONT_LEFT], weightedMovingAvgDistances[Category::FRONT_LEFT]);
 		return true;
-	} else if (has_large_min_wAvg_differences(minDistances.at(Category::FRONT),
-											  weightedMovingAvgDistances.at(Category::FRONT))) {
-		SerialLogger::warn(F("FRONT min_wAvg difference too high with min=%f and wAvg=%f"),
-						   minDistances.at(Category::FRONT), weightedMovingAvgDistances.at(Category::FRONT));
+	} else if (has_large_min_wAvg_differences(minDistances[Category::FRONT],
+											  weightedMovingAvgDistances[Category::FRONT])) {
+		SERIAL_LOGGER_WARN(F("FRONT min_wAvg difference too high with min=%f and wAvg=%f"),
+						   minDistances[Category::FRONT], weightedMovingAvgDistances[Category::FRONT]);
 		return true;
-	} else if (has_large_min_wAvg_differences(minDistances.at(Category::FRONT_RIGHT),
-											  weightedMovingAvgDistances.at(Category::FRONT_RIGHT))) {
-		SerialLogger::warn(F("FRONT_RIGHT min_wAvg difference too high with min=%f and wAvg=%f"),
-						   minDistances.at(Category::FRONT_RIGHT),
-						   weightedMovingAvgDistances.at(Category::FRONT_RIGHT));
+	} else if (has_large_min_wAvg_differences(minDistances[Category::FRONT_RIGHT],
+											  weightedMovingAvgDistances[Category::FRONT_RIGHT])) {
+		SERIAL_LOGGER_WARN(F("FRONT_RIGHT min_wAvg difference too high with min=%f and wAvg=%f"),
+						   minDistances[Category::FRONT_RIGHT],
+						   weightedMovingAvgDistances[Category::FRONT_RIGHT]);
 		return true;
 	} else {
 		return false;
 	}
 }
 
-bool has_large_min_wAvg_differences_back(const std::map<Category::Direction, float> &minDistances,
-										 const std::map<Category::Direction, float> &weightedMovingAvgDistances) {
-	if (has_large_min_wAvg_differences(minDistances.at(Category::BACK_LEFT),
-									   weightedMovingAvgDistances.at(Category::BACK_LEFT))) {
-		SerialLogger::warn(F("BACK_LEFT min_wAvg difference too high with min=%f and wAvg=%f"),
-						   minDistances.at(Category::BACK_LEFT), weightedMovingAvgDistances.at(Category::BACK_LEFT));
+bool has_large_min_wAvg_differences_back(const DirectionArray<float> &minDistances,
+										 const DirectionArray<float> &weightedMovingAvgDistances) {
+	if (has_large_min_wAvg_differences(minDistances[Category::BACK_LEFT],
+									   weightedMovingAvgDistances[Category::BACK_LEFT])) {
+		SERIAL_LOGGER_WARN(F("BACK_LEFT min_wAvg difference too high with min=%f and wAvg=%f"),
+						   minDistances[Category::BACK_LEFT], weightedMovingAvgDistances[Category::BACK_LEFT]);
 		return true;
-	} else if (has_large_min_wAvg_differences(minDistances.at(Category::BACK_RIGHT),
-											  weightedMovingAvgDistances.at(Category::BACK_RIGHT))) {
-		SerialLogger::warn(F("BACK_RIGHT min_wAvg difference too high with min=%f and wAvg=%f"),
-						   minDistances.at(Category::BACK_RIGHT), weightedMovingAvgDistances.at(Category::BACK_RIGHT));
+	} else if (has_large_min_wAvg_differences(minDistances[Category::BACK_RIGHT],
+											  weightedMovingAvgDistances[Category::BACK_RIGHT])) {
+		SERIAL_LOGGER_WARN(F("BACK_RIGHT min_wAvg difference too high with min=%f and wAvg=%f"),
+						   minDistances[Category::BACK_RIGHT], weightedMovingAvgDistances[Category::BACK_RIGHT]);
 		return true;
 	} else {
 		return false;
 	}
 }
 
-bool ErrorMotion::isEligible(const std::map<Category::Direction, float> &minDistances,
-							 const std::map<Category::Direction, float> &maxDistances,
-							 const std::map<Category::Direction, float> &weightedMovingAvgDistances) const {
-	return true;
-}
-
-bool IdleMotion::isEligible(const std::map<Category::Direction, float> &minDistances,
-							const std::map<Category::Direction, float> &maxDistances,
-							const std::map<Category::Direction, float> &weightedMovingAvgDistances) const {
+bool MotionPredicates::hold(const MotionPredicateMask mask) {
+	for (int i = 0; i < AMOUNT_MOTION_PREDICATES; i++) {
+		const MotionPredicate predicate = static_cast<MotionPredicate>(i);
+		const MotionPredicateMask bit = motionPredicateBit(predicate);
+		if ((mask & bit) == 0) {
+			continue;
+		} else if ((_evaluated & bit) == 0) {
+			_evaluated |= bit;
+			if (evaluate(predicate)) {
+				_values |= bit;
+			}
+		}
+		if ((_values & bit) == 0) {
+			return false;
+		}
+	}
 	return true;
 }
 
-bool LowSpeedForwardMotion::isEligible(const std::map<Category::Direction, float> &minDistances,
-									   const std::map<Category::Direction, float> &maxDistances,
-									   const std::map<Category::Direction, float> &weightedMovingAvgDistances) const {
-	if (has_large_min_wAvg_differences_front(minDistances, weightedMovingAvgDistances)) {
-		SerialLogger::warn(F("Discrepancy between front min and wAvg distances to high. Need cleaner history for save "
-							 "eligibility."));
-		return false;
-	} else {
-		const Category::Distance &frontDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::FRONT));
-		const Category::Distance &frontLeftDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::FRONT_LEFT));
-		const Category::Distance &frontRightDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::FRONT_RIGHT));
-
-		const bool eligible = frontDistance >= Category::CLOSE_RANGE && frontLeftDistance >= Category::CLOSE_RANGE &&
-							  frontRightDistance >= Category::CLOSE_RANGE;
-		if (eligible) {
-			SerialLogger::debug(F("%s is eligible to be the next state. All ranges are above threshold"), get_name());
-		} else {
-			SerialLogger::debug(F("%s is NOT eligible to be the next state. Some ranges are below threshold"),
-								get_name());
-		}
-		return eligible;
+Category::Distance MotionPredicates::getCategory(const Category::Direction direction) {
+	const uint8_t bit = static_cast<uint8_t>(1 << direction);
+	if ((_classified & bit) == 0) {
+		_classified |= bit;
+		_categories[direction] = Category::fromDistance(k_weightedMovingAvgDistances[direction]);
+		SERIAL_LOGGER_TRACE(F("%s is in %s"), Category::getNameFromDirection(direction),
+							Category::getNameFromDistance(_categories[direction]));
 	}
+	return _categories[direction];
 }
 
-bool MidSpeedForwardMotion::isEligible(const std::map<Category::Direction, float> &minDistances,
-									   const std::map<Category::Direction, float> &maxDistances,
-									   const std::map<Category::Direction, float> &weightedMovingAvgDistances) const {
-	if (has_large_min_wAvg_differences_front(minDistances, weightedMovingAvgDistances)) {
-		SerialLogger::warn(F("Discrepancy between front min and wAvg distances to high. Need cleaner history for save "
-							 "eligibility."));
-		return false;
+float MotionPredicates::getMappedDistance(const float angle, const float max_distance) const {
+	if (k_occupancyGrid == nullptr || k_pose == nullptr) {
+		return max_distance;
 	} else {
-		const Category::Distance &frontDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::FRONT));
-		const Category::Distance &frontLeftDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::FRONT_LEFT));
-		const Category::Distance &frontRightDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::FRONT_RIGHT));
-
-		const bool eligible = frontDistance >= Category::MID_RANGE && frontLeftDistance >= Category::CLOSE_RANGE &&
-							  frontRightDistance >= Category::CLOSE_RANGE;
-		if (eligible) {
-			SerialLogger::debug(F("%s is eligible to be the next state. All ranges are above threshold"), get_name());
-		} else {
-			SerialLogger::debug(F("%s is NOT eligible to be the next state. Some ranges are below threshold"),
-								get_name());
-		}
-		return eligible;
+		return k_occupancyGrid->castRay(k_pose->x, k_pose->y, k_pose->heading + angle, max_distance);
 	}
 }
 
-bool FullSpeedForwardMotion::isEligible(const std::map<Category::Direction, float> &minDistances,
-										const std::map<Category::Direction, float> &maxDistances,
-										const std::map<Category::Direction, float> &weightedMovingAvgDistances) const {
-	if (has_large_min_wAvg_differences_front(minDistances, weightedMovingAvgDistances)) {
-		SerialLogger::warn(F("Discrepancy between front min and wAvg distances to high. Need cleaner history for save "
-							 "eligibility."));
-		return false;
-	} else {
-		const Category::Distance &frontDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::FRONT));
-		const Category::Distance &frontLeftDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::FRONT_LEFT));
-		const Category::Distance &frontRightDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::FRONT_RIGHT));
-
-		const bool eligible = frontDistance >= Category::OUT_OF_RANGE && frontLeftDistance >= Category::MID_RANGE &&
-							  frontRightDistance >= Category::MID_RANGE;
-		if (eligible) {
-			SerialLogger::debug(F("%s is eligible to be the next state. All ranges are above threshold"), get_name());
-		} else {
-			SerialLogger::debug(F("%s is NOT eligible to be the next state. Some ranges are below threshold"),
-								get_name());
+bool MotionPredicates::evaluate(const MotionPredicate predicate) {
+	switch (predicate) {
+		case FRONT_CONSISTENT:
+			if (has_large_min_wAvg_differences_front(k_minDistances, k_weightedMovingAvgDistances)) {
+				SERIAL_LOGGER_WARN(F("Discrepancy between front min and wAvg distances to high. Need cleaner history for "
+									 "save eligibility."));
+				return false;
+			} else {
+				return true;
+			}
+		case BACK_CONSISTENT:
+			if (has_large_min_wAvg_differences_back(k_minDistances, k_weightedMovingAvgDistances)) {
+				SERIAL_LOGGER_WARN(F("Discrepancy between backwards min and wAvg distances to high. Need cleaner history "
+									 "for save eligibility."));
+				return false;
+			} else {
+				return true;
+			}
+		case TURN_MAPPED_CLEAR:
+			return k_occupancyGrid != nullptr && k_pose != nullptr &&
+				   k_occupancyGrid->isClear(k_pose->x, k_pose->y, DEFAULT_TURN_CLEARANCE_CM);
+		case LEFT_MAPPED_PREFERRED:
+			return getMappedDistance((float) M_PI / 2.0f, DEFAULT_MAPPED_SIDE_RANGE_CM) >=
+				   getMappedDistance(-(float) M_PI / 2.0f, DEFAULT_MAPPED_SIDE_RANGE_CM);
+		default: {
+			const MotionRangePredicate &rangePredicate = MotionStateTable::k_range_predicates[predicate];
+			return getCategory(rangePredicate.direction) >= rangePredicate.distance;
 		}
-		return eligible;
 	}
 }
 
-bool BackwardMotion::isEligible(const std::map<Category::Direction, float> &minDistances,
-								const std::map<Category::Direction, float> &maxDistances,
-								const std::map<Category::Direction, float> &weightedMovingAvgDistances) const {
-	if (has_large_min_wAvg_differences_back(minDistances, weightedMovingAvgDistances)) {
-		SerialLogger::warn(F("Discrepancy between backwards min and wAvg distances to high. Need cleaner history for "
-							 "save eligibility."));
-		return false;
+bool MotionStateMachine::delayedFollowUp(const MotionStateSpec &spec, const int self_iterations, const Pose *pose,
+										 const float entry_heading) {
+	if (spec.turn_angle_degrees != 0 && pose != nullptr) {
+		const float turned_degrees = fabsf(pose->heading - entry_heading) * 180.0f / (float) M_PI;
+		return turned_degrees < spec.turn_angle_degrees && self_iterations <= MOTION_STATE_MAX_TURN_ITERATIONS;
 	} else {
-		const Category::Distance &backLeftDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::BACK_LEFT));
-		const Category::Distance &backRightDistance = Category::fromDistance(
-				weightedMovingAvgDistances.at(Category::BACK_RIGHT));
-
-		const bool eligible = backLeftDistance >= Category::CLOSE_RANGE && backRightDistance >= Category::CLOSE_RANGE;
-		if (eligible) {
-			SerialLogger::debug(F("%s is eligible to be the next state. All ranges are above threshold"), get_name());
-		} else {
-			SerialLogger::debug(F("%s is NOT eligible to be the next state. Some ranges are below threshold"),
-								get_name());
-		}
-		return eligible;
+		return self_iterations <= spec.delayed_follow_up_iterations;
 	}
 }
 
-bool LeftTurnMotion::isEligible(const std::map<Category::Direction, float> &minDistances,
-								const std::map<Category::Direction, float> &maxDistances,
-								const std::map<Category::Direction, float> &weightedMovingAvgDistances) const {
-	// If we want to turn, we need clean history in front and backwards sensors
-	if (has_large_min_wAvg_differences_front(minDistances, weightedMovingAvgDistances)) {
-		SerialLogger::warn(F("Discrepancy between front min and wAvg distances to high. Need cleaner history for save "
-							 "eligibility."));
-		return false;
-	} else {
-		if (has_large_min_wAvg_differences_back(minDistances, weightedMovingAvgDistances)) {
-			SerialLogger::warn(F("Discrepancy between backwards min and wAvg distances to high. Need cleaner history "
-								 "for save eligibility."));
-			return false;
+MotionStateId MotionStateMachine::next(MotionPredicates &predicates) {
+	const Pose *pose = predicates.get_pose();
+	MotionStateId state = _currentState;
+	int self_iterations = _self_iterations;
+	float entry_heading = self_iterations == 0 && pose != nullptr ? pose->heading : _entry_heading;
+	// the table is safe (see MotionStateTable::isSafe), thus, the limit is just a guard
+	for (int hop = 0; hop < 2 * AMOUNT_MOTION_STATES; hop++) {
+		const MotionStateSpec &spec = MotionStateTable::get(state);
+		MotionStateId nextState = state;
+		if (state == PRIORITY_STRATEGY) {
+			// not a motion on its own but the follow up state if eligible and the fallback state otherwise. If both are
+			// eligible, the follow up state needs to be preferred, too.
+			nextState = isEligible(spec.followUpState, predicates) &&
+						(predicates.hold(spec.eligibility) || !isEligible(spec.fallbackState, predicates)) ?
+						spec.followUpState : spec.fallbackState;
 		} else {
-			const Category::Distance &frontDistance = Category::fromDistance(
-					weightedMovingAvgDistances.at(Category::FRONT));
-			const Category::Distance &frontLeftDistance = Category::fromDistance(
-					weightedMovingAvgDistances.at(Category::FRONT_LEFT));
-			const Category::Distance &frontRightDistance = Category::fromDistance(
-					weightedMovingAvgDistances.at(Category::FRONT_RIGHT));
-			const Category::Distance &backLeftDistance = Category::fromDistance(
-					weightedMovingAvgDistances.at(Category::BACK_LEFT));
-			const Category::Distance &backRightDistance = Category::fromDistance(
-					weightedMovingAvgDistances.at(Category::BACK_RIGHT));
-
-			const bool eligible = frontDistance >= Category::CRITICAL_RANGE &&
-								  frontLeftDistance >= Category::CLOSE_RANGE &&
-								  frontRightDistance >= Category::CRITICAL_RANGE &&
-								  backLeftDistance >= Category::CLOSE_RANGE &&
-								  backRightDistance >= Category::CRITICAL_RANGE;
-			if (eligible) {
-				SerialLogger::debug(F("%s is eligible to be the next state. All ranges are above threshold"),
-									get_name());
-			} else {
-				SerialLogger::debug(F("%s is NOT eligible to be the next state. Some ranges are below threshold"),
-									get_name());
+			self_iterations++;
+			const bool withinMaxSelfIterations = spec.max_self_iterations < 0 ||
+												 self_iterations <= spec.max_self_iterations;
+			if (spec.followUpState == NO_MOTION_STATE) {
+				if (!withinMaxSelfIterations || !isEligible(state, predicates)) {
+					SERIAL_LOGGER_TRACE(F("%s no longer eligible, trying fallback due to no follow up state and "
+										  "non-eligibility"), spec.name);
+					nextState = spec.fallbackState;
+				}
+			} else if (delayedFollowUp(spec, self_iterations, pose, entry_heading)) {
+				// Note: We do not check the max self iterations for good reasons. Assume we stop a left turn at a random
+				// step t=3 while having reached an angle of 30/90°. If we now move to the fallback, we start with a wrong
+				// angle.
+				if (!isEligible(state, predicates)) {
+					SERIAL_LOGGER_TRACE(F("%s no longer eligible, trying fallback due to delayed follow up but "
+										  "non-eligibility"), spec.name);
+					nextState = spec.fallbackState;
+				}
+			} else if (isEligible(spec.followUpState, predicates)) {
+				SERIAL_LOGGER_DEBUG(F("Follow up state of %s is eligible"), spec.name);
+				nextState = spec.followUpState;
+			} else if (!withinMaxSelfIterations || !isEligible(state, predicates)) {
+				SERIAL_LOGGER_TRACE(F("Trying fallback of %s due to non-delayed follow up and states "
+									  "non-eligibility"), spec.name);
+				nextState = spec.fallbackState;
 			}
-			return eligible;
 		}
-	}
-}
 
-bool RightTurnMotion::isEligible(const std::map<Category::Direction, float> &minDistances,
-								 const std::map<Category::Direction, float> &maxDistances,
-								 const std::map<Category::Direction, float> &weightedMovingAvgDistances) const {
-	// If we want to turn, we need clean history in front and backwards sensors
-	if (has_large_min_wAvg_differences_front(minDistances, weightedMovingAvgDistances)) {
-		SerialLogger::warn(F("Discrepancy between front min and wAvg distances to high. Need cleaner history for save "
-							 "eligibility."));
-		return false;
-	} else {
-		if (has_large_min_wAvg_differences_back(minDistances, weightedMovingAvgDistances)) {
-			SerialLogger::warn(F("Discrepancy between backwards min and wAvg distances to high. Need cleaner history "
-								 "for save eligibility."));
-			return false;
+		if (nextState == state) {
+			_currentState = state;
+			_self_iterations = self_iterations;
+			_entry_heading = entry_heading;
+			return state;
+		} else if (nextState == NO_MOTION_STATE) {
+			return NO_MOTION_STATE;
 		} else {
-			const Category::Distance &frontDistance = Category::fromDistance(
-					weightedMovingAvgDistances.at(Category::FRONT));
-			const Category::Distance &frontLeftDistance = Category::fromDistance(
-					weightedMovingAvgDistances.at(Category::FRONT_LEFT));
-			const Category::Distance &frontRightDistance = Category::fromDistance(
-					weightedMovingAvgDistances.at(Category::FRONT_RIGHT));
-			const Category::Distance &backLeftDistance = Category::fromDistance(
-					weightedMovingAvgDistances.at(Category::BACK_LEFT));
-			const Category::Distance &backRightDistance = Category::fromDistance(
-					weightedMovingAvgDistances.at(Category::BACK_RIGHT));
-
-			const bool eligible = frontDistance >= Category::CRITICAL_RANGE &&
-								  frontLeftDistance >= Category::CRITICAL_RANGE &&
-								  frontRightDistance >= Category::CLOSE_RANGE &&
-								  backLeftDistance >= Category::CRITICAL_RANGE &&
-								  backRightDistance >= Category::CLOSE_RANGE;
-			if (eligible) {
-				SerialLogger::debug(F("%s is eligible to be the next state. All ranges are above threshold"),
-									get_name());
-			} else {
-				SerialLogger::debug(F("%s is NOT eligible to be the next state. Some ranges are below threshold"),
-									get_name());
+			SERIAL_LOGGER_DEBUG(F("Trying next state %s"), MotionStateTable::get(nextState).name);
+			state = nextState;
+			self_iterations = 0;
+			if (pose != nullptr) {
+				entry_heading = pose->heading;
 			}
-			return eligible;
 		}
 	}
-}
\ No newline at end of file
+	SERIAL_LOGGER_ERROR(F("No next state after %d hops starting from %s"), 2 * AMOUNT_MOTION_STATES,
+						get_name());
+	return NO_MOTION_STATE;
+}
@@ -1,348 +1,348 @@
 #ifndef MOTION_STATE_H
 #define MOTION_STATE_H
 
-#define DEFAULT_WEIGHTED_MOVING_AVERAGE_ALPHA (float) 0.70f
 #define DEFAULT_WEIGHTED_MOVING_AVERAGE_MIN_MAX_DISCREPANCY (float) 0.30f
+// no mapped obstacle within this distance from the center of the mower to turn on the spot
+#define DEFAULT_TURN_CLEARANCE_CM (float) 40.0f
+// how far to look for mapped obstacles to the left and to the right
+#define DEFAULT_MAPPED_SIDE_RANGE_CM (float) 1.5f * MAX_DISTANCE
+// how far the collision avoidance turns turn before trying their follow up state
+#define DEFAULT_TURN_ANGLE_DEGREES 30
+// a turn by angle is no longer delayed after these self iterations, e. g. if the odometry is not calibrated
+#define MOTION_STATE_MAX_TURN_ITERATIONS 16
+
+#include <stdint.h>
 
-#include <vector>
-#include <map>
 #include <serial_logger.h>
 
 #include "category.h"
+#include "direction_array.h"
+#include "occupancy_grid.h"
+#include "pose.h"
+
+/**
+ * The distance predicates the eligibility of the motion states is built from. Each predicate is evaluated at most once
+ * per decision (see MotionPredicates). The order is the order of evaluation, i. e. the sanity of the history goes first.
+ */
+enum MotionPredicate {
+	// there is no large discrepancy between the min and the weighted moving average distance of any front direction
+	FRONT_CONSISTENT,
+	// same for the back directions
+	BACK_CONSISTENT,
+	// the weighted moving average distance of a direction is at least the given Category::Distance
+	FRONT_AT_LEAST_CRITICAL_RANGE,
+	FRONT_AT_LEAST_CLOSE_RANGE,
+	FRONT_AT_LEAST_MID_RANGE,
+	FRONT_OUT_OF_RANGE,
+	FRONT_LEFT_AT_LEAST_CRITICAL_RANGE,
+	FRONT_LEFT_AT_LEAST_CLOSE_RANGE,
+	FRONT_LEFT_AT_LEAST_MID_RANGE,
+	FRONT_RIGHT_AT_LEAST_CRITICAL_RANGE,
+	FRONT_RIGHT_AT_LEAST_CLOSE_RANGE,
+	FRONT_RIGHT_AT_LEAST_MID_RANGE,
+	BACK_LEFT_AT_LEAST_CRITICAL_RANGE,
+	BACK_LEFT_AT_LEAST_CLOSE_RANGE,
+	BACK_RIGHT_AT_LEAST_CRITICAL_RANGE,
+	BACK_RIGHT_AT_LEAST_CLOSE_RANGE,
+	// there is no mapped obstacle within the turn clearance; never holds without an occupancy grid
+	TURN_MAPPED_CLEAR,
+	// there is at least as much mapped free space to the left as to the right; always holds without an occupancy grid
+	LEFT_MAPPED_PREFERRED,
+	AMOUNT_MOTION_PREDICATES
+};
+
+// one bit per MotionPredicate
+typedef uint32_t MotionPredicateMask;
+
+constexpr MotionPredicateMask motionPredicateBit(const MotionPredicate predicate) {
+	return static_cast<MotionPredicateMask>(1) << predicate;
+}
+
+static_assert(AMOUNT_MOTION_PREDICATES <= 8 * sizeof(MotionPredicateMask), "Too many predicates for the mask");
 
-class MotionState {
+/**
+ * A direction predicate: the weighted moving average distance of the direction is at least the distance category
+ */
+struct MotionRangePredicate {
+	Category::Direction direction;
+	Category::Distance distance;
+};
+
+/**
+ * Evaluation context of a single decision on a snapshot of the distances. Whatever predicate a motion state asks for is
+ * evaluated upon its first use and remembered for the rest of the decision, i. e. the cost of a decision is bound by
+ * the amount of predicates, not by the amount of states tried. Likewise, each direction is classified into its
+ * Category::Distance once and shared by all range predicates of the direction.
+ */
+class MotionPredicates {
 public:
 	/**
-	 * Init a MotionState chained in other MotionStates and chaining MitoionStates as well
-	 *
-	 * @param name The name of this motion state
-	 * @param min_self_iterations The minimum amount of self iterations this states needs to perform (i. e. how may
- 	 * 		  requests on getNextState returning this) before the follow up states is considered an option.
-	 * @param max_self_iterations The maximum allowed self iterations of this state (i. e. how may requests on
-	 *        getNextState are allowed to this state). Put to -1 to make an infinitive amount.
- 	 * @param followUpState The next (better) following state to enter if eligible or nullptr if None exists. Caller
-	 *        does not put ownership of this pointer in this state but needs to guarantee it lives as long as this state.
-	 *        We chain states, thus, its likely that we produce a cycle. A cycle would case segsev upon deletion.
-	 * @param fallbackState The (previous) state to enter if neither the followUp nor this state are eligible (anymore)
-	 *        or nullptr if None exists. Caller does not put ownership of this pointer in this state but needs to
-	 *        guarantee it lives as long as this state. We chain states, thus, its likely that we produce a cycle.
-	 *        A cycle would case segsev upon deletion.
-	 * @param left_speed The speed to apply to the left wheel in percentage of power. Negative for backwards.
-	 * @param right_speed The speed to apply to the right wheel in percentage of power. Negative for backwards.
-	 * @param blade_speed The speed to apply to the blade motor in percentage of power
+	 * @param occupancyGrid The map of the surroundings or nullptr if there is none. Caller needs to guarantee it lives
+	 *        as long as this context.
+	 * @param pose The (dead reckoned) pose of the mower, e. g. within the occupancy grid, or nullptr if unknown. Caller
+	 *        needs to guarantee it lives as long as this context.
 	 */
-	MotionState(const char *name, const int min_self_iterations, const int max_self_iterations,
-				MotionState *followUpState, MotionState *fallbackState,
-				const float &left_speed, const float &right_speed, const float blade_speed)
-			: k_name(name), k_min_self_iterations(min_self_iterations), k_max_self_iterations(max_self_iterations),
-			  k_left_speed(left_speed), k_right_speed(right_speed), k_blade_speed(blade_speed) {
-		_followUpState = followUpState;
-		_fallbackState = fallbackState;
-		if (fallbackState == nullptr) {
-			SerialLogger::error(F("nullptr fallback states are not allowed. Expect serious issues"));
-		}
-		_self_iterations = 0;
+	MotionPredicates(const DirectionArray<float> &minDistances,
+					 const DirectionArray<float> &weightedMovingAvgDistances,
+					 const OccupancyGrid *occupancyGrid = nullptr, const Pose *pose = nullptr) :
+			k_minDistances(minDistances), k_weightedMovingAvgDistances(weightedMovingAvgDistances),
+			k_occupancyGrid(occupancyGrid), k_pose(pose) {
+		// nothing to do...
 	};
 
-	~MotionState() = default;
-
 	/**
-	 * Specialised class must determine whether the next state is the followUpState, this very state again (if
-	 * eligible by check and by max_iterations) or if both of them are not possible the fallbackState
-	 * @return
+	 * @return whether all predicates of the mask hold. Stops at the first one that does not hold.
 	 */
-	virtual MotionState *getNextState(const std::map<Category::Direction, float> &minDistances,
-									  const std::map<Category::Direction, float> &maxDistances,
-									  const std::map<Category::Direction, float> &weightedMovingAvgDistances) {
-		_self_iterations++;
-		if (_followUpState == nullptr) {
-			if ((k_max_self_iterations < 0 || _self_iterations <= k_max_self_iterations) &&
-				this->isEligible(minDistances, maxDistances, weightedMovingAvgDistances)) {
-				SerialLogger::trace(F("No follow up state and %s is still eligible, thus, returning it"),
-									this->get_name());
-				return this;
-			} else {
-				SerialLogger::trace(F("%s no longer eligible, trying fallback due to nullptr followUpState and "
-									  "non-eligibility"), this->get_name());
-				return changeState(_fallbackState, minDistances, maxDistances, weightedMovingAvgDistances);
-			}
-		} else if (delayedFollowUp(minDistances, maxDistances, weightedMovingAvgDistances)) {
-			// Note: We do not check the self iterations for good reasons. Assume we stop a left turn at a random step
-			// t=3 while having reached an angle of 30/90°. If we now move to the fallback, we start with a wrong angle.
-			// If we already use another function to determine eligibility, we need and can safely drop the check.
-			if (this->isEligible(minDistances, maxDistances, weightedMovingAvgDistances)) {
-				SerialLogger::trace(F("Returning %s due to delayed follow up and eligibility"), this->get_name());
-				return this;
-			} else {
-				SerialLogger::trace(F("%s no longer eligible, trying fallback due to delayed follow up but "
-									  "non-eligibility"), this->get_name());
-				return changeState(_fallbackState, minDistances, maxDistances, weightedMovingAvgDistances);
-			}
-		} else if (_followUpState->isEligible(minDistances, maxDistances, weightedMovingAvgDistances)) {
-			SerialLogger::debug(F("Returning follow up state due to non-delayed follow up and follow-up states "
-								  "eligibility"));
-			return changeState(_followUpState, minDistances, maxDistances, weightedMovingAvgDistances);
-		} else {
-			if ((k_max_self_iterations < 0 || _self_iterations <= k_max_self_iterations) &&
-				this->isEligible(minDistances, maxDistances, weightedMovingAvgDistances)) {
-				SerialLogger::trace(F("Follow up state is not eligible but this %s is still eligible, thus, returning "
-									  "it"), this->get_name());
-				return this;
-			} else {
-				SerialLogger::trace(F("Trying fallback due to non-delayed follow up and states non-eligibility"));
-				return changeState(_fallbackState, minDistances, maxDistances, weightedMovingAvgDistances);
-			}
-		}
-	};
-
-	float get_speed_left() const { return k_left_speed; };
+	bool hold(const MotionPredicateMask mask);
 
-	float get_speed_right() const { return k_right_speed; };
+	// the predicates evaluated so far
+	MotionPredicateMask get_evaluated() const { return _evaluated; };
 
-	float get_blade_speed() const { return k_blade_speed; };
-
-	const char *get_name() const { return k_name; };
-
-	MotionState *getFollowUpState() const {
-		return _followUpState;
-	};
-
-	void setFollowUpState(MotionState *motionState) {
-		if (_followUpState == nullptr) {
-			_followUpState = motionState;
-		} else {
-			SerialLogger::warn(F("Cannot reset followUpState. State already occupied by %s"),
-							   _followUpState->get_name());
-		}
-	};
+	// Note: nullptr if unknown
+	const Pose *get_pose() const { return k_pose; };
 
 	/**
-	 * Special treatment for some MotionStates which do not want to try to immediately move the the next follow up state
-	 * (e. g. if IdleState is always possible and we are in a CollisionAvoidanceState)
-	 *
-	 * @param minDistances The min distances of the history (configurable) for each direction.
-	 * @param maxDistances The max distances of the history (configurable) for each direction.
-	 * @param weightedMovingAvgDistances The weighted moving averages of distances (configurable) for each direction.
-	 * @return Whether this state must be executed again or not by extra options.
+	 * @return the category of the weighted moving average distance of the direction
 	 */
-	virtual bool delayedFollowUp(const std::map<Category::Direction, float> &minDistances,
-								 const std::map<Category::Direction, float> &maxDistances,
-								 const std::map<Category::Direction, float> &weightedMovingAvgDistances) const {
-		return _self_iterations <= k_min_self_iterations;
-	};
-
-	virtual bool isEligible(const std::map<Category::Direction, float> &minDistances,
-							const std::map<Category::Direction, float> &maxDistances,
-							const std::map<Category::Direction, float> &weightedMovingAvgDistances) const = 0;
+	Category::Distance getCategory(const Category::Direction direction);
 
-protected:
-	const int k_min_self_iterations;
-	const int k_max_self_iterations;
-	MotionState *_fallbackState;
-	MotionState *_followUpState;
-	int _self_iterations;
+	/**
+	 * @param angle The direction to look at in radians counterclockwise from the heading of the mower
+	 * @return the distance from the center of the mower to the closest mapped obstacle in the given direction (up to
+	 *         max_distance) or max_distance if there is no occupancy grid or no pose
+	 */
+	float getMappedDistance(const float angle, const float max_distance) const;
 
 private:
-	MotionState *changeState(MotionState *nextState, const std::map<Category::Direction, float> &minDistances,
-							 const std::map<Category::Direction, float> &maxDistances,
-							 const std::map<Category::Direction, float> &weightedMovingAvgDistances) {
-		_self_iterations = 0;
-		if (nextState == nullptr) {
-			return nextState;
-		} else {
-			SerialLogger::debug(F("Trying next state %s"), nextState->get_name());
-			return nextState->getNextState(minDistances, maxDistances, weightedMovingAvgDistances);
-		}
-	};
-
-	const char *k_name;
-
-	const float k_left_speed;
-	const float k_right_speed;
-	const float k_blade_speed;
+	bool evaluate(const MotionPredicate predicate);
+
+	const DirectionArray<float> &k_minDistances;
+	const DirectionArray<float> &k_weightedMovingAvgDistances;
+	const OccupancyGrid *k_occupancyGrid;
+	const Pose *k_pose;
+	MotionPredicateMask _evaluated = 0;
+	MotionPredicateMask _values = 0;
+	// one bit per Category::Direction
+	uint8_t _classified = 0;
+	DirectionArray<Category::Distance> _categories;
 };
 
-class ErrorMotion : public MotionState {
-public:
+enum MotionStateId {
 	// An error state for states from which we cannot escape to indicate limits of current motion model
-	ErrorMotion(MotionState *followUpState = nullptr) :
-			MotionState("ErrorMotion", 1, -1, followUpState, nullptr, 0.0f, 0.0f, 0.0f) {
-		// nothing to do...
-	};
-
-	bool isEligible(const std::map<Category::Direction, float> &minDistances,
-					const std::map<Category::Direction, float> &maxDistances,
-					const std::map<Category::Direction, float> &weightedMovingAvgDistances) const override;
+	ERROR_MOTION,
+	IDLE_MOTION,
+	LOW_SPEED_FORWARD_MOTION,
+	MID_SPEED_FORWARD_MOTION,
+	FULL_SPEED_FORWARD_MOTION,
+	BACKWARD_MOTION,
+	LEFT_TURN_MOTION,
+	RIGHT_TURN_MOTION,
+	// not a motion but picks the follow up state if eligible or the fallback state otherwise
+	PRIORITY_STRATEGY,
+	AMOUNT_MOTION_STATES,
+	NO_MOTION_STATE = AMOUNT_MOTION_STATES
 };
 
-class IdleMotion : public MotionState {
-public:
-	IdleMotion(MotionState *followUpState, MotionState *fallbackState) :
-			MotionState("IdleMotion", 1, 1, followUpState, fallbackState, 0.0f, 0.0f, 0.0f) {
-		// nothing to do...
-	};
-
-	bool isEligible(const std::map<Category::Direction, float> &minDistances,
-					const std::map<Category::Direction, float> &maxDistances,
-					const std::map<Category::Direction, float> &weightedMovingAvgDistances) const override;
+/**
+ * A row of the transition table of the motion states.
+ *
+ * The next state is the follow up (better) state once this state performed more than delayed_follow_up_iterations
+ * self iterations and the follow up state is eligible. Otherwise, it is this very state again if it is eligible (and
+ * within max_self_iterations unless the follow up is delayed). If neither are possible, the fallback state is tried.
+ */
+struct MotionStateSpec {
+	const char *name;
+	// Put to -1 to make an infinitive amount
+	int8_t max_self_iterations;
+	// the follow up state is not considered before; forward motions use their min self iterations, collision avoidance
+	// motions their max self iterations to not stop a turn at a random angle
+	int8_t delayed_follow_up_iterations;
+	// if not zero and the pose is known, the follow up state is not considered before the state turned by this angle
+	// (but at most MOTION_STATE_MAX_TURN_ITERATIONS) instead of the delayed follow up iterations
+	int16_t turn_angle_degrees;
+	MotionStateId followUpState;
+	MotionStateId fallbackState;
+	// predicates that must hold to be eligible; zero for always eligible. For the priority strategy, the predicates that
+	// must hold to prefer the follow up state if both the follow up and the fallback state are eligible.
+	MotionPredicateMask eligibility;
+	// alternative predicates (e. g. by the occupancy grid) that make the state eligible as well; zero for none
+	MotionPredicateMask mapped_eligibility;
+	// in percentage of power; negative for backwards
+	float left_speed;
+	float right_speed;
+	float blade_speed;
 };
 
-class ForwardMotion : public MotionState {
+class MotionStateTable {
 public:
-	ForwardMotion(const char *name, MotionState *followUpState, MotionState *fallbackState,
-				  const float &left_speed, const float &right_speed, const float blade_speed) :
-			MotionState(name, 3, -1, followUpState, fallbackState, left_speed, right_speed, blade_speed) {
-		// nothing to do...
+	static constexpr MotionPredicateMask k_front_consistent = motionPredicateBit(FRONT_CONSISTENT);
+	static constexpr MotionPredicateMask k_back_consistent = motionPredicateBit(BACK_CONSISTENT);
+
+	static constexpr MotionRangePredicate k_range_predicates[AMOUNT_MOTION_PREDICATES] = {
+			// consistency and mapped predicates are not bound to a single range
+			{Category::FRONT, Category::TOO_CLOSE},
+			{Category::FRONT, Category::TOO_CLOSE},
+			{Category::FRONT, Category::CRITICAL_RANGE},
+			{Category::FRONT, Category::CLOSE_RANGE},
+			{Category::FRONT, Category::MID_RANGE},
+			{Category::FRONT, Category::OUT_OF_RANGE},
+			{Category::FRONT_LEFT, Category::CRITICAL_RANGE},
+			{Category::FRONT_LEFT, Category::CLOSE_RANGE},
+			{Category::FRONT_LEFT, Category::MID_RANGE},
+			{Category::FRONT_RIGHT, Category::CRITICAL_RANGE},
+			{Category::FRONT_RIGHT, Category::CLOSE_RANGE},
+			{Category::FRONT_RIGHT, Category::MID_RANGE},
+			{Category::BACK_LEFT, Category::CRITICAL_RANGE},
+			{Category::BACK_LEFT, Category::CLOSE_RANGE},
+			{Category::BACK_RIGHT, Category::CRITICAL_RANGE},
+			{Category::BACK_RIGHT, Category::CLOSE_RANGE},
+			{Category::FRONT, Category::TOO_CLOSE},
+			{Category::FRONT, Category::TOO_CLOSE}
 	};
 
-	// TODO once added angle/azitmuth we need to take this value into account for the left, right speed to keep on the
-	//  line. Therefore, we need to be able to modify the return value (maybe overwrite the getter) as well as being
-	//  able to set and reset an initial angle/azimuth once this state is used as currently active state. In addition,
-	//  we need to configure a tolerance within which we do nothing. We need pass this value once we return this state
-	//  as the next state to have the original angles - we need getter and setter.
-};
-
-class LowSpeedForwardMotion : public ForwardMotion {
-public:
-	LowSpeedForwardMotion(MotionState *followUpState, MotionState *fallbackState) :
-			ForwardMotion("LowSpeedForwardMotion", followUpState, fallbackState,
-						  CLOSE_RANGE_MULTIPLIER, CLOSE_RANGE_MULTIPLIER, 0.5f) {
-		// nothing to do...
+	// turning on the spot only needs room for the mower itself
+	static constexpr MotionPredicateMask k_turn_mapped_clear = k_front_consistent | k_back_consistent |
+															   motionPredicateBit(TURN_MAPPED_CLEAR);
+
+	// by MotionStateId
+	static constexpr MotionStateSpec k_states[AMOUNT_MOTION_STATES] = {
+			{"ErrorMotion", -1, 1, 0, IDLE_MOTION, NO_MOTION_STATE, 0, 0, 0.0f, 0.0f, 0.0f},
+			{"IdleMotion", 1, 1, 0, LOW_SPEED_FORWARD_MOTION, PRIORITY_STRATEGY, 0, 0, 0.0f, 0.0f, 0.0f},
+			{"LowSpeedForwardMotion", -1, 3, 0, MID_SPEED_FORWARD_MOTION, IDLE_MOTION,
+					k_front_consistent | motionPredicateBit(FRONT_AT_LEAST_CLOSE_RANGE) |
+					motionPredicateBit(FRONT_LEFT_AT_LEAST_CLOSE_RANGE) |
+					motionPredicateBit(FRONT_RIGHT_AT_LEAST_CLOSE_RANGE), 0,
+					CLOSE_RANGE_MULTIPLIER, CLOSE_RANGE_MULTIPLIER, 0.5f},
+			{"MidSpeedForwardMotion", -1, 3, 0, FULL_SPEED_FORWARD_MOTION, LOW_SPEED_FORWARD_MOTION,
+					k_front_consistent | motionPredicateBit(FRONT_AT_LEAST_MID_RANGE) |
+					motionPredicateBit(FRONT_LEFT_AT_LEAST_CLOSE_RANGE) |
+					motionPredicateBit(FRONT_RIGHT_AT_LEAST_CLOSE_RANGE), 0,
+					MID_RANGE_MULTIPLIER, MID_RANGE_MULTIPLIER, 1.0f},
+			{"FullSpeedForwardMotion", -1, 3, 0, NO_MOTION_STATE, MID_SPEED_FORWARD_MOTION,
+					k_front_consistent | motionPredicateBit(FRONT_OUT_OF_RANGE) |
+					motionPredicateBit(FRONT_LEFT_AT_LEAST_MID_RANGE) |
+					motionPredicateBit(FRONT_RIGHT_AT_LEAST_MID_RANGE), 0,
+					OUT_OF_RANGE_MULTIPLIER, OUT_OF_RANGE_MULTIPLIER, 1.0f},
+			// Please note: 4 iterations left/right is at the origin position. Turns go by angle if the pose is known.
+			{"BackwardMotion", 4, 4, 0, IDLE_MOTION, ERROR_MOTION,
+					k_back_consistent | motionPredicateBit(BACK_LEFT_AT_LEAST_CLOSE_RANGE) |
+					motionPredicateBit(BACK_RIGHT_AT_LEAST_CLOSE_RANGE), 0,
+					-CLOSE_RANGE_MULTIPLIER, -CLOSE_RANGE_MULTIPLIER, 0.0f},
+			// If we want to turn, we need clean history in front and backwards sensors
+			{"LeftTurnMotion", 4, 4, DEFAULT_TURN_ANGLE_DEGREES, IDLE_MOTION, BACKWARD_MOTION,
+					k_front_consistent | k_back_consistent | motionPredicateBit(FRONT_AT_LEAST_CRITICAL_RANGE) |
+					motionPredicateBit(FRONT_LEFT_AT_LEAST_CLOSE_RANGE) |
+					motionPredicateBit(FRONT_RIGHT_AT_LEAST_CRITICAL_RANGE) |
+					motionPredicateBit(BACK_LEFT_AT_LEAST_CLOSE_RANGE) |
+					motionPredicateBit(BACK_RIGHT_AT_LEAST_CRITICAL_RANGE), k_turn_mapped_clear,
+					-CLOSE_RANGE_MULTIPLIER, CLOSE_RANGE_MULTIPLIER, 0.0f},
+			{"RightTurnMotion", 4, 4, DEFAULT_TURN_ANGLE_DEGREES, IDLE_MOTION, BACKWARD_MOTION,
+					k_front_consistent | k_back_consistent | motionPredicateBit(FRONT_AT_LEAST_CRITICAL_RANGE) |
+					motionPredicateBit(FRONT_LEFT_AT_LEAST_CRITICAL_RANGE) |
+					motionPredicateBit(FRONT_RIGHT_AT_LEAST_CLOSE_RANGE) |
+					motionPredicateBit(BACK_LEFT_AT_LEAST_CRITICAL_RANGE) |
+					motionPredicateBit(BACK_RIGHT_AT_LEAST_CLOSE_RANGE), k_turn_mapped_clear,
+					CLOSE_RANGE_MULTIPLIER, -CLOSE_RANGE_MULTIPLIER, 0.0f},
+			// turns to the side with more mapped free space if both turns are eligible
+			{"PriorityStrategy", 4, 4, 0, LEFT_TURN_MOTION, RIGHT_TURN_MOTION, motionPredicateBit(LEFT_MAPPED_PREFERRED), 0,
+					0.0f, 0.0f, 0.0f}
 	};
 
-	bool isEligible(const std::map<Category::Direction, float> &minDistances,
-					const std::map<Category::Direction, float> &maxDistances,
-					const std::map<Category::Direction, float> &weightedMovingAvgDistances) const override;
-};
-
-class MidSpeedForwardMotion : public ForwardMotion {
-public:
-	MidSpeedForwardMotion(MotionState *followUpState, MotionState *fallbackState) :
-			ForwardMotion("MidSpeedForwardMotion", followUpState, fallbackState,
-						  MID_RANGE_MULTIPLIER, MID_RANGE_MULTIPLIER, 1.0f) {
-		// nothing to do...
+	static constexpr const MotionStateSpec &get(const MotionStateId id) {
+		return k_states[id];
 	};
 
-	bool isEligible(const std::map<Category::Direction, float> &minDistances,
-					const std::map<Category::Direction, float> &maxDistances,
-					const std::map<Category::Direction, float> &weightedMovingAvgDistances) const override;
-};
-
-class FullSpeedForwardMotion : public ForwardMotion {
-public:
-	FullSpeedForwardMotion(MotionState *followUpState, MotionState *fallbackState) :
-			ForwardMotion("FullSpeedForwardMotion", followUpState, fallbackState,
-						  OUT_OF_RANGE_MULTIPLIER, OUT_OF_RANGE_MULTIPLIER, 1.0f) {
-		// nothing to do...
+	// whether the state, entered with its first self iteration, is the next state no matter the predicates
+	static constexpr bool staysWhenEntered(const MotionStateId id) {
+		return id != PRIORITY_STRATEGY && get(id).eligibility == 0 && (get(id).followUpState == NO_MOTION_STATE ?
+				get(id).max_self_iterations != 0 : get(id).delayed_follow_up_iterations >= 1);
 	};
 
-	bool isEligible(const std::map<Category::Direction, float> &minDistances,
-					const std::map<Category::Direction, float> &maxDistances,
-					const std::map<Category::Direction, float> &weightedMovingAvgDistances) const override;
-};
-
-class CollisionAvoidanceMotion : public MotionState {
-public:
 	/**
-	 * Please note: 4 iterations left/right is at the origin position. Child classes need to implement the countering
-	 * correctly or otherwise guarantee that motion is done within one iteration.
+	 * @return whether entering the state and trying its fallbacks (and, for the priority strategy, its follow up) always
+	 *         ends in a state staying (or no state) within the given amount of hops, i. e. any decision terminates
 	 */
-	CollisionAvoidanceMotion(const char *name, MotionState *followUpState, MotionState *fallbackState,
-							 const float &left_speed, const float &right_speed) :
-			MotionState(name, 0, 4, followUpState, fallbackState, left_speed, right_speed, 0.0f) {
-		// nothing to do...
+	static constexpr bool fallsBackSafely(const MotionStateId id, const int hops) {
+		return id == NO_MOTION_STATE || (hops > 0 && (id == PRIORITY_STRATEGY ?
+				fallsBackSafely(get(id).followUpState, hops - 1) && fallsBackSafely(get(id).fallbackState, hops - 1) :
+				staysWhenEntered(id) || fallsBackSafely(get(id).fallbackState, hops - 1)));
 	};
 
-	virtual bool delayedFollowUp(const std::map<Category::Direction, float> &minDistances,
-								 const std::map<Category::Direction, float> &maxDistances,
-								 const std::map<Category::Direction, float> &weightedMovingAvgDistances) const override {
-		// TODO iterations are bad. We need to take the angle/azimuth difference from a starting angle/azimuth to the
-		//  current angle/azimuth into account (e. g. whether we performed a 90° turn already or are still on the line)
-		return _self_iterations <= k_max_self_iterations;
+	/**
+	 * @return whether an entered follow up state stays for the rest of the decision, i. e. it is delayed at least once
+	 *         and is no priority strategy whose eligibility is undefined
+	 */
+	static constexpr bool entersFollowUpSafely(const MotionStateId id) {
+		return get(id).followUpState == NO_MOTION_STATE || id == PRIORITY_STRATEGY ||
+			   (get(id).followUpState != PRIORITY_STRATEGY &&
+				get(get(id).followUpState).delayed_follow_up_iterations >= 1);
 	};
-};
 
-class LeftTurnMotion : public CollisionAvoidanceMotion {
-public:
-	LeftTurnMotion(MotionState *followUpState, MotionState *fallbackState) :
-			CollisionAvoidanceMotion("LeftTurnMotion", followUpState, fallbackState,
-									 -CLOSE_RANGE_MULTIPLIER, CLOSE_RANGE_MULTIPLIER) {
-		// nothing to do...
+	static constexpr bool isSafe(const int id = 0) {
+		return id == AMOUNT_MOTION_STATES ||
+			   (fallsBackSafely(static_cast<MotionStateId>(id), AMOUNT_MOTION_STATES) &&
+				entersFollowUpSafely(static_cast<MotionStateId>(id)) && isSafe(id + 1));
 	};
 
-	bool isEligible(const std::map<Category::Direction, float> &minDistances,
-					const std::map<Category::Direction, float> &maxDistances,
-					const std::map<Category::Direction, float> &weightedMovingAvgDistances) const override;
+	MotionStateTable() = delete;
 };
 
-class RightTurnMotion : public CollisionAvoidanceMotion {
+static_assert(MotionStateTable::isSafe(), "Motion state table may not terminate within a decision");
+
+/**
+ * Table driven state machine of the motion states (see MotionStateTable). It does neither allocate nor recurse: a
+ * decision walks the table for at most 2 * AMOUNT_MOTION_STATES hops and asks MotionPredicates for the eligibility.
+ */
+class MotionStateMachine {
 public:
-	RightTurnMotion(MotionState *followUpState, MotionState *fallbackState) :
-			CollisionAvoidanceMotion("RightTurnMotion", followUpState, fallbackState,
-									 CLOSE_RANGE_MULTIPLIER, -CLOSE_RANGE_MULTIPLIER) {
+	explicit MotionStateMachine(const MotionStateId initialState = IDLE_MOTION) :
+			_currentState(initialState), _self_iterations(0), _entry_heading(0.0f) {
 		// nothing to do...
 	};
 
-	bool isEligible(const std::map<Category::Direction, float> &minDistances,
-					const std::map<Category::Direction, float> &maxDistances,
-					const std::map<Category::Direction, float> &weightedMovingAvgDistances) const override;
-};
+	/**
+	 * Move on to the next state
+	 *
+	 * @return the next state or NO_MOTION_STATE if the chaining of the table broke. The current state is unchanged in
+	 *         this case.
+	 */
+	MotionStateId next(MotionPredicates &predicates);
 
-class BackwardMotion : public CollisionAvoidanceMotion {
-public:
-	BackwardMotion(MotionState *followUpState, MotionState *fallbackState) :
-			CollisionAvoidanceMotion("BackwardMotion", followUpState, fallbackState,
-									 -CLOSE_RANGE_MULTIPLIER, -CLOSE_RANGE_MULTIPLIER) {
-		// nothing to do...
+	void reset(const MotionStateId state) {
+		_currentState = state;
+		_self_iterations = 0;
 	};
 
-	bool isEligible(const std::map<Category::Direction, float> &minDistances,
-					const std::map<Category::Direction, float> &maxDistances,
-					const std::map<Category::Direction, float> &weightedMovingAvgDistances) const override;
-};
+	MotionStateId get_state() const { return _currentState; };
 
+	const MotionStateSpec &get_spec() const { return MotionStateTable::get(_currentState); };
 
-class PriorityStrategy : public CollisionAvoidanceMotion {
-public:
-	PriorityStrategy(MotionState *followUpState, MotionState *fallbackState) :
-			CollisionAvoidanceMotion("PriorityStrategy", followUpState, fallbackState, 0.0f, 0.0f) {
-		// nothing to do...
-	};
+	const char *get_name() const { return get_spec().name; };
 
 	/**
-	 * Different strategy to get the next state based sorely on the followUpStates decision. This state is just for
-	 * convenience.
-	 *
-	 * @return The next state based on this priority strategy
+	 * @return the angle (in radians, counterclockwise) turned since entering the current state or zero if the pose is
+	 *         unknown
 	 */
-	MotionState *getNextState(const std::map<Category::Direction, float> &minDistances,
-							  const std::map<Category::Direction, float> &maxDistances,
-							  const std::map<Category::Direction, float> &weightedMovingAvgDistances) override {
-		if (_followUpState == nullptr && _fallbackState == nullptr) {
-			return nullptr;
-		} else if (_followUpState == nullptr) {
-			return _fallbackState->getNextState(minDistances, maxDistances, weightedMovingAvgDistances);
-		} else {
-			if (_followUpState->isEligible(minDistances, maxDistances, weightedMovingAvgDistances)) {
-				return _followUpState->getNextState(minDistances, maxDistances, weightedMovingAvgDistances);
-			} else {
-				return _fallbackState->getNextState(minDistances, maxDistances, weightedMovingAvgDistances);
-			}
-		}
+	float getTurnedAngle(const MotionPredicates &predicates) const {
+		return predicates.get_pose() == nullptr || _self_iterations == 0 ? 0.0f :
+			   predicates.get_pose()->heading - _entry_heading;
 	};
 
-	bool isEligible(const std::map<Category::Direction, float> &minDistances,
-					const std::map<Category::Direction, float> &maxDistances,
-					const std::map<Category::Direction, float> &weightedMovingAvgDistances) const override {
-		if (_followUpState == nullptr && _fallbackState == nullptr) {
-			return false;
-		} else if (_followUpState == nullptr) {
-			return _fallbackState->isEligible(minDistances, maxDistances, weightedMovingAvgDistances);
-		} else {
-			return _followUpState->isEligible(minDistances, maxDistances, weightedMovingAvgDistances) ||
-				   _fallbackState->isEligible(minDistances, maxDistances, weightedMovingAvgDistances);
-		}
+private:
+	static bool isEligible(const MotionStateId state, MotionPredicates &predicates) {
+		const MotionStateSpec &spec = MotionStateTable::get(state);
+		return predicates.hold(spec.eligibility) ||
+			   (spec.mapped_eligibility != 0 && predicates.hold(spec.mapped_eligibility));
 	};
+
+	static bool delayedFollowUp(const MotionStateSpec &spec, const int self_iterations, const Pose *pose,
+								const float entry_heading);
+
+	MotionStateId _currentState;
+	// self iterations of the current state; zero for any other state
+	int _self_iterations;
+	// heading upon entering the current state (if the pose is known)
+	float _entry_heading;
 };
 
 #endif // MOTION_STATE_H
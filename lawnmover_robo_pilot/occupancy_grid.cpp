@@ -0,0 +1,186 @@
+#include "occupancy_grid.h"
+
+#define OCCUPANCY_GRID_INFINITY 1e30f
+
+OccupancyGrid::OccupancyGrid(const float resolution_cm, const float cone_half_angle_degrees) :
+		k_resolution_cm(resolution_cm), k_cone_half_angle(cone_half_angle_degrees * (float) M_PI / 180.0f),
+		k_cos_cone_half_angle(cosf(cone_half_angle_degrees * (float) M_PI / 180.0f)),
+		_origin_x(-OCCUPANCY_GRID_CELLS / 2), _origin_y(-OCCUPANCY_GRID_CELLS / 2) {
+	clear();
+}
+
+void OccupancyGrid::clear() {
+	memset(_cells, 0, sizeof(_cells));
+}
+
+void OccupancyGrid::recenter(const float x, const float y) {
+	const int origin_x = toCell(x) - OCCUPANCY_GRID_CELLS / 2;
+	if (abs(origin_x - _origin_x) > OCCUPANCY_GRID_CELLS / 4) {
+		// the columns entering the window share their memory with the ones leaving it
+		const int first = origin_x > _origin_x ? max(_origin_x + OCCUPANCY_GRID_CELLS, origin_x) : origin_x;
+		const int last = origin_x > _origin_x ? origin_x + OCCUPANCY_GRID_CELLS :
+						 min(_origin_x, origin_x + OCCUPANCY_GRID_CELLS);
+		for (int column = first; column < last; column++) {
+			for (int row = 0; row < OCCUPANCY_GRID_CELLS; row++) {
+				_cells[row * OCCUPANCY_GRID_CELLS + wrap(column)] = 0;
+			}
+		}
+		_origin_x = origin_x;
+	}
+
+	const int origin_y = toCell(y) - OCCUPANCY_GRID_CELLS / 2;
+	if (abs(origin_y - _origin_y) > OCCUPANCY_GRID_CELLS / 4) {
+		const int first = origin_y > _origin_y ? max(_origin_y + OCCUPANCY_GRID_CELLS, origin_y) : origin_y;
+		const int last = origin_y > _origin_y ? origin_y + OCCUPANCY_GRID_CELLS :
+						 min(_origin_y, origin_y + OCCUPANCY_GRID_CELLS);
+		for (int row = first; row < last; row++) {
+			memset(_cells + wrap(row) * OCCUPANCY_GRID_CELLS, 0, OCCUPANCY_GRID_CELLS);
+		}
+		_origin_y = origin_y;
+	}
+}
+
+void OccupancyGrid::update(const int cell_x, const int cell_y, const int log_odds) {
+	int8_t &cell = at(cell_x, cell_y);
+	cell = (int8_t) max(-OCCUPANCY_GRID_LOG_ODDS_LIMIT, min(cell + log_odds, OCCUPANCY_GRID_LOG_ODDS_LIMIT));
+}
+
+void OccupancyGrid::putDistance(const Pose &pose, const SensorMount &mount, const float distance,
+								const float max_distance) {
+	recenter(pose.x, pose.y);
+
+	const float sensor_x = pose.x + mount.forward * cosf(pose.heading) - mount.left * sinf(pose.heading);
+	const float sensor_y = pose.y + mount.forward * sinf(pose.heading) + mount.left * cosf(pose.heading);
+	const float direction = pose.heading + mount.angle;
+	const float direction_x = cosf(direction);
+	const float direction_y = sinf(direction);
+
+	const bool hit = distance < max_distance;
+	const float range = hit ? max(distance, 0.0f) : max_distance;
+	// an echo is from within half a cell around the distance
+	const float tolerance = k_resolution_cm / 2.0f;
+	const float reach = hit ? range + tolerance : range;
+
+	// bounding box of the cone: its apex, both edges, its axis and any extreme point of the arc
+	float min_x = sensor_x;
+	float max_x = sensor_x;
+	float min_y = sensor_y;
+	float max_y = sensor_y;
+	const float angles[] = {direction - k_cone_half_angle, direction, direction + k_cone_half_angle,
+							0.0f, (float) M_PI / 2.0f, (float) M_PI, -(float) M_PI / 2.0f};
+	for (int i = 0; i < 7; i++) {
+		if (i < 3 || cosf(angles[i] - direction) >= k_cos_cone_half_angle) {
+			const float x = sensor_x + reach * cosf(angles[i]);
+			const float y = sensor_y + reach * sinf(angles[i]);
+			min_x = min(min_x, x);
+			max_x = max(max_x, x);
+			min_y = min(min_y, y);
+			max_y = max(max_y, y);
+		}
+	}
+
+	// The cells are compared by their squared distances. Each row only walks the span between both edges of the cone
+	// (widened by a cell against rounding); the bounding box of a long cone holds thousands of cells.
+	const float reach_squared = reach * reach;
+	const float cos_squared = k_cos_cone_half_angle * k_cos_cone_half_angle;
+	const float inner = range - tolerance;
+	const float inner_squared = inner > 0.0f ? inner * inner : 0.0f;
+	const float right_x = cosf(direction - k_cone_half_angle);
+	const float right_y = sinf(direction - k_cone_half_angle);
+	const float left_x = cosf(direction + k_cone_half_angle);
+	const float left_y = sinf(direction + k_cone_half_angle);
+	const int first_x = max(toCell(min_x), _origin_x);
+	const int last_x = min(toCell(max_x), _origin_x + OCCUPANCY_GRID_CELLS - 1);
+	const int first_y = max(toCell(min_y), _origin_y);
+	const int last_y = min(toCell(max_y), _origin_y + OCCUPANCY_GRID_CELLS - 1);
+	for (int cell_y = first_y; cell_y <= last_y; cell_y++) {
+		const float dy = (cell_y + 0.5f) * k_resolution_cm - sensor_y;
+		if (dy * dy > reach_squared) {
+			continue;
+		}
+		const float half_chord = sqrtf(reach_squared - dy * dy);
+		float span_min = -half_chord;
+		float span_max = half_chord;
+		// left of the right edge: right_x * dy - right_y * dx >= 0; right of the left edge: left_y * dx - left_x * dy >= 0
+		if (right_y > 0.0f) {
+			span_max = min(span_max, right_x * dy / right_y);
+		} else if (right_y < 0.0f) {
+			span_min = max(span_min, right_x * dy / right_y);
+		}
+		if (left_y > 0.0f) {
+			span_min = max(span_min, left_x * dy / left_y);
+		} else if (left_y < 0.0f) {
+			span_max = min(span_max, left_x * dy / left_y);
+		}
+		const int span_first_x = max(first_x, toCell(sensor_x + span_min) - 1);
+		const int span_last_x = min(last_x, toCell(sensor_x + span_max) + 1);
+		for (int cell_x = span_first_x; cell_x <= span_last_x; cell_x++) {
+			const float dx = (cell_x + 0.5f) * k_resolution_cm - sensor_x;
+			const float r_squared = dx * dx + dy * dy;
+			const float along = dx * direction_x + dy * direction_y;
+			// within the cone: along >= r * cos, i. e. in front of the sensor and along^2 >= r^2 * cos^2
+			if (r_squared > reach_squared || along < 0.0f || along * along < r_squared * cos_squared) {
+				continue;
+			}
+			update(cell_x, cell_y, hit && r_squared >= inner_squared ? OCCUPANCY_GRID_LOG_ODDS_HIT :
+								   OCCUPANCY_GRID_LOG_ODDS_MISS);
+		}
+	}
+}
+
+float OccupancyGrid::castRay(const float x, const float y, const float angle, const float max_distance) const {
+	int cell_x = toCell(x);
+	int cell_y = toCell(y);
+	const float direction_x = cosf(angle);
+	const float direction_y = sinf(angle);
+	const int step_x = direction_x > 0.0f ? 1 : -1;
+	const int step_y = direction_y > 0.0f ? 1 : -1;
+	// distance along the ray to the next cell border in x (y) and between two borders
+	float next_x = direction_x != 0.0f ?
+				   ((cell_x + (step_x > 0 ? 1 : 0)) * k_resolution_cm - x) / direction_x : OCCUPANCY_GRID_INFINITY;
+	float next_y = direction_y != 0.0f ?
+				   ((cell_y + (step_y > 0 ? 1 : 0)) * k_resolution_cm - y) / direction_y : OCCUPANCY_GRID_INFINITY;
+	const float delta_x = direction_x != 0.0f ? k_resolution_cm / fabsf(direction_x) : OCCUPANCY_GRID_INFINITY;
+	const float delta_y = direction_y != 0.0f ? k_resolution_cm / fabsf(direction_y) : OCCUPANCY_GRID_INFINITY;
+
+	float travelled = 0.0f;
+	while (travelled <= max_distance && contains(cell_x, cell_y)) {
+		if (at(cell_x, cell_y) >= OCCUPANCY_GRID_LOG_ODDS_OCCUPIED) {
+			return travelled;
+		}
+		if (next_x < next_y) {
+			travelled = next_x;
+			next_x += delta_x;
+			cell_x += step_x;
+		} else {
+			travelled = next_y;
+			next_y += delta_y;
+			cell_y += step_y;
+		}
+	}
+	return max_distance;
+}
+
+bool OccupancyGrid::isClear(const float x, const float y, const float radius) const {
+	const float reach = radius + k_resolution_cm / 2.0f;
+	const int first_x = max(toCell(x - reach), _origin_x);
+	const int last_x = min(toCell(x + reach), _origin_x + OCCUPANCY_GRID_CELLS - 1);
+	const int first_y = max(toCell(y - reach), _origin_y);
+	const int last_y = min(toCell(y + reach), _origin_y + OCCUPANCY_GRID_CELLS - 1);
+	for (int cell_y = first_y; cell_y <= last_y; cell_y++) {
+		const float dy = (cell_y + 0.5f) * k_resolution_cm - y;
+		for (int cell_x = first_x; cell_x <= last_x; cell_x++) {
+			const float dx = (cell_x + 0.5f) * k_resolution_cm - x;
+			if (dx * dx + dy * dy <= reach * reach && at(cell_x, cell_y) >= OCCUPANCY_GRID_LOG_ODDS_OCCUPIED) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int8_t OccupancyGrid::getLogOdds(const float x, const float y) const {
+	const int cell_x = toCell(x);
+	const int cell_y = toCell(y);
+	return contains(cell_x, cell_y) ? at(cell_x, cell_y) : 0;
+}
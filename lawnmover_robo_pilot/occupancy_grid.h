@@ -0,0 +1,122 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <Arduino.h>
+
+#include "pose.h"
+
+// cells per side of the grid; one byte per cell
+#define OCCUPANCY_GRID_CELLS 64
+#define DEFAULT_OCCUPANCY_GRID_RESOLUTION_CM 5.0f
+// half of the opening angle of the sound cone of an HC-SR04
+#define DEFAULT_ULTRASONIC_CONE_HALF_ANGLE_DEGREES 15.0f
+// log odds of the cells in tenths, i. e. a hit adds 0.9 (p = 0.71) and a miss removes 0.4 (p = 0.4)
+#define OCCUPANCY_GRID_LOG_ODDS_HIT 9
+#define OCCUPANCY_GRID_LOG_ODDS_MISS -4
+#define OCCUPANCY_GRID_LOG_ODDS_LIMIT 100
+// p = 0.88
+#define OCCUPANCY_GRID_LOG_ODDS_OCCUPIED 20
+
+/**
+ * Where an ultrasonic sensor sits on the mower, relative to the center of the mower
+ */
+struct SensorMount {
+	// in cm
+	float forward;
+	float left;
+	// in radians counterclockwise from the heading
+	float angle;
+};
+
+/**
+ * Local occupancy grid (https://en.wikipedia.org/wiki/Occupancy_grid_mapping) of the surroundings of the mower, i. e.
+ * obstacles are remembered after the mower turned away from them. Each cell holds the log odds of being occupied; zero
+ * is unknown.
+ *
+ * The grid has a fixed size of OCCUPANCY_GRID_CELLS^2 bytes and moves with the mower: It is a window into the world
+ * whose cells wrap around (the index of a cell is its world coordinate modulo the size), so, recentering clears the
+ * cells that leave the window instead of copying the others.
+ */
+class OccupancyGrid {
+public:
+	explicit OccupancyGrid(const float resolution_cm = DEFAULT_OCCUPANCY_GRID_RESOLUTION_CM,
+						   const float cone_half_angle_degrees = DEFAULT_ULTRASONIC_CONE_HALF_ANGLE_DEGREES);
+
+	/**
+	 * Project the sound cone of a sensor into the grid: cells closer than the distance are free, cells at the distance
+	 * are occupied. A distance of at least max_distance is no echo, i. e. the cone is free up to max_distance.
+	 * Moves the window if the mower left its center.
+	 */
+	void putDistance(const Pose &pose, const SensorMount &mount, const float distance, const float max_distance);
+
+	/**
+	 * Walk the cells from the given position in the given direction (amanatides woo traversal)
+	 *
+	 * @return the distance to the first occupied cell or max_distance if there is none within max_distance (or the
+	 *         ray leaves the window, i. e. unknown is taken as free)
+	 */
+	float castRay(const float x, const float y, const float angle, const float max_distance) const;
+
+	/**
+	 * @return whether there is no occupied cell within the radius around the given position
+	 */
+	bool isClear(const float x, const float y, const float radius) const;
+
+	/**
+	 * @return whether the radius around the given position lies within the window, i. e. isClear knows all its cells
+	 */
+	bool isWithin(const float x, const float y, const float radius) const {
+		return contains(toCell(x - radius), toCell(y - radius)) && contains(toCell(x + radius), toCell(y + radius));
+	};
+
+	// Note: Zero if outside the window
+	int8_t getLogOdds(const float x, const float y) const;
+
+	bool isOccupied(const float x, const float y) const {
+		return getLogOdds(x, y) >= OCCUPANCY_GRID_LOG_ODDS_OCCUPIED;
+	};
+
+	// Drop everything known
+	void clear();
+
+	float get_resolution() const { return k_resolution_cm; };
+
+private:
+	// keep the window centered around the given position (with some hysteresis)
+	void recenter(const float x, const float y);
+
+	int toCell(const float coordinate) const {
+		return (int) floorf(coordinate / k_resolution_cm);
+	};
+
+	bool contains(const int cell_x, const int cell_y) const {
+		return cell_x >= _origin_x && cell_x < _origin_x + OCCUPANCY_GRID_CELLS &&
+			   cell_y >= _origin_y && cell_y < _origin_y + OCCUPANCY_GRID_CELLS;
+	};
+
+	static int wrap(const int cell) {
+		const int wrapped = cell % OCCUPANCY_GRID_CELLS;
+		return wrapped < 0 ? wrapped + OCCUPANCY_GRID_CELLS : wrapped;
+	};
+
+	int8_t &at(const int cell_x, const int cell_y) {
+		return _cells[wrap(cell_y) * OCCUPANCY_GRID_CELLS + wrap(cell_x)];
+	};
+
+	int8_t at(const int cell_x, const int cell_y) const {
+		return _cells[wrap(cell_y) * OCCUPANCY_GRID_CELLS + wrap(cell_x)];
+	};
+
+	void update(const int cell_x, const int cell_y, const int log_odds);
+
+	const float k_resolution_cm;
+	const float k_cone_half_angle;
+	const float k_cos_cone_half_angle;
+
+	// world cell of the lower left cell of the window
+	int _origin_x;
+	int _origin_y;
+	int8_t _cells[OCCUPANCY_GRID_CELLS * OCCUPANCY_GRID_CELLS];
+};
+
+#endif // OCCUPANCY_GRID_H
@@ -0,0 +1,72 @@
+#include "odometry_estimator.h"
+
+float WheelModel::toSpeed(const int16_t power) const {
+	const int magnitude = abs(power);
+	if (magnitude <= dead_band_power) {
+		return 0.0f;
+	}
+	const float speed = (float) (magnitude - dead_band_power) / (ODOMETRY_MAX_ENGINE_POWER - dead_band_power) *
+						max_speed_cm_per_second;
+	return power < 0 ? -speed : speed;
+}
+
+WheelModel WheelModel::fromMeasurements(const int16_t power, const float speed_cm_per_second,
+										const int16_t other_power, const float other_speed_cm_per_second) {
+	// the line through both measurements crosses zero speed at the dead band
+	const float slope = (other_speed_cm_per_second - speed_cm_per_second) / (float) (other_power - power);
+	const float dead_band_power = power - speed_cm_per_second / slope;
+	WheelModel wheelModel;
+	wheelModel.dead_band_power = (int16_t) max(0.0f, dead_band_power);
+	wheelModel.max_speed_cm_per_second = slope * (ODOMETRY_MAX_ENGINE_POWER - wheelModel.dead_band_power);
+	return wheelModel;
+}
+
+OdometryEstimator::OdometryEstimator(const float wheel_base_cm, const WheelModel &leftWheel,
+									 const WheelModel &rightWheel) :
+		_wheel_base_cm(wheel_base_cm), _left_wheel(leftWheel), _right_wheel(rightWheel) {
+	// standing still at the origin since ever
+	_commands[0] = {0, {0.0f, 0.0f, 0.0f}, 0, 0};
+}
+
+void OdometryEstimator::putWheelPowers(const int16_t left_wheel_power, const int16_t right_wheel_power,
+									   const unsigned long now_millis) {
+	const Pose pose = integrate(_commands[_latest], now_millis);
+	_latest = (_latest + 1) % ODOMETRY_HISTORY_SIZE;
+	_size = min(_size + 1, ODOMETRY_HISTORY_SIZE);
+	_commands[_latest] = {now_millis, pose, left_wheel_power, right_wheel_power};
+}
+
+Pose OdometryEstimator::getPose(const unsigned long at_millis) const {
+	// the latest command given at or before the millis
+	int index = _latest;
+	for (int i = 1; i < _size && (long) (at_millis - _commands[index].millis) < 0; i++) {
+		index = (index + ODOMETRY_HISTORY_SIZE - 1) % ODOMETRY_HISTORY_SIZE;
+	}
+	return integrate(_commands[index], at_millis);
+}
+
+Pose OdometryEstimator::integrate(const Command &command, const unsigned long to_millis) const {
+	const long elapsed_millis = (long) (to_millis - command.millis);
+	if (elapsed_millis <= 0 || (command.left_wheel_power == 0 && command.right_wheel_power == 0)) {
+		return command.pose;
+	}
+	const float dt = min((unsigned long) elapsed_millis, ODOMETRY_MAX_STEP_MILLIS) / 1000.0f;
+	const float left_speed = _left_wheel.toSpeed(command.left_wheel_power);
+	const float right_speed = _right_wheel.toSpeed(command.right_wheel_power);
+	const float speed = (left_speed + right_speed) / 2.0f;
+	const float turn_rate = (right_speed - left_speed) / _wheel_base_cm;
+
+	Pose pose = command.pose;
+	if (fabsf(turn_rate) < 1e-4f) {
+		pose.x += speed * dt * cosf(pose.heading);
+		pose.y += speed * dt * sinf(pose.heading);
+	} else {
+		// the wheel powers are constant, thus, the mower drives on a circular arc
+		const float heading = pose.heading + turn_rate * dt;
+		const float radius = speed / turn_rate;
+		pose.x += radius * (sinf(heading) - sinf(pose.heading));
+		pose.y -= radius * (cosf(heading) - cosf(pose.heading));
+		pose.heading = heading;
+	}
+	return pose;
+}
@@ -0,0 +1,101 @@
+#ifndef ODOMETRY_ESTIMATOR_H
+#define ODOMETRY_ESTIMATOR_H
+
+#include <Arduino.h>
+
+#include "pose.h"
+
+#define DEFAULT_WHEEL_BASE_CM 36.0f
+// wheel speed at full engine power
+#define DEFAULT_MAX_WHEEL_SPEED_CM_PER_SECOND 40.0f
+#define ODOMETRY_MAX_ENGINE_POWER 255
+// wheel powers are not integrated any longer than this, i. e. the engines control unit stops if it gets no commands
+#define ODOMETRY_MAX_STEP_MILLIS 1000UL
+// commanded wheel powers kept to get the pose of some millis ago (e. g. when a distance was measured)
+#define ODOMETRY_HISTORY_SIZE 8
+
+/**
+ * Power to velocity model of a wheel: it does not turn up to the dead band power (friction, motor driver) and speeds
+ * up linearly from there to its max speed at full power
+ */
+struct WheelModel {
+	int16_t dead_band_power;
+	float max_speed_cm_per_second;
+
+	/**
+	 * @param power in [-255, 255]; negative is backwards
+	 * @return the speed of the wheel in cm/s; negative is backwards
+	 */
+	float toSpeed(const int16_t power) const;
+
+	/**
+	 * Calibrate the model by the speeds measured at two different powers (e. g. by timing the mower on a lawn of known
+	 * length or by counting the turns of a wheel)
+	 */
+	static WheelModel fromMeasurements(const int16_t power, const float speed_cm_per_second,
+									   const int16_t other_power, const float other_speed_cm_per_second);
+};
+
+/**
+ * Differential drive odometry (https://en.wikipedia.org/wiki/Dead_reckoning) integrating the commanded wheel powers
+ * over time. There are no wheel encoders, thus, the wheels are taken to move as their WheelModel tells, i. e. there is
+ * no slip and no blocked wheel. The pose drifts and is good for the near surroundings only.
+ *
+ * The latest commands are kept, so, the pose of some millis ago is integrated from the command active back then
+ * rather than extrapolated from the latest one.
+ */
+class OdometryEstimator {
+public:
+	OdometryEstimator(const float wheel_base_cm = DEFAULT_WHEEL_BASE_CM,
+					  const WheelModel &leftWheel = {0, DEFAULT_MAX_WHEEL_SPEED_CM_PER_SECOND},
+					  const WheelModel &rightWheel = {0, DEFAULT_MAX_WHEEL_SPEED_CM_PER_SECOND});
+
+	/**
+	 * Replace the calibration. Already integrated poses are kept.
+	 */
+	void setWheelModels(const float wheel_base_cm, const WheelModel &leftWheel, const WheelModel &rightWheel) {
+		_wheel_base_cm = wheel_base_cm;
+		_left_wheel = leftWheel;
+		_right_wheel = rightWheel;
+	};
+
+	/**
+	 * Integrate the previously commanded wheel powers up to now and command the given ones from now on
+	 *
+	 * @param left_wheel_power in [-255, 255]; negative is backwards
+	 * @param right_wheel_power in [-255, 255]; negative is backwards
+	 */
+	void putWheelPowers(const int16_t left_wheel_power, const int16_t right_wheel_power, const unsigned long now_millis);
+
+	/**
+	 * @return the pose at the given millis, i. e. the wheel powers commanded back then are integrated up to then.
+	 *         Millis before the kept commands get the pose of the oldest one.
+	 */
+	Pose getPose(const unsigned long at_millis) const;
+
+	float getHeading(const unsigned long at_millis) const {
+		return getPose(at_millis).heading;
+	};
+
+private:
+	struct Command {
+		unsigned long millis;
+		// at millis
+		Pose pose;
+		int16_t left_wheel_power;
+		int16_t right_wheel_power;
+	};
+
+	Pose integrate(const Command &command, const unsigned long to_millis) const;
+
+	float _wheel_base_cm;
+	WheelModel _left_wheel;
+	WheelModel _right_wheel;
+
+	// ring buffer of the latest commands
+	Command _commands[ODOMETRY_HISTORY_SIZE];
+	int _latest = 0;
+	int _size = 1;
+};
+
+#endif // ODOMETRY_ESTIMATOR_H
@@ -0,0 +1,16 @@
+#ifndef POSE_H
+#define POSE_H
+
+/**
+ * Position and heading of the mower relative to where the robo pilot started, i. e. as dead reckoned
+ */
+struct Pose {
+	// in cm
+	float x;
+	float y;
+	// in radians counterclockwise from the x axis; not wrapped into [-pi, pi], i. e. the difference of two headings is
+	// the angle turned in between
+	float heading;
+};
+
+#endif // POSE_H
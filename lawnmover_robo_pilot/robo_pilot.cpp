@@ -1,62 +1,335 @@
 #include "robo_pilot.h"
 
 RuleBasedMotionStateRoboPilot::RuleBasedMotionStateRoboPilot() :
-		RoboPilot("RuleBasedMotionStateRoboPilot", 10) {
-	_errorMotion = new ErrorMotion();
+		RoboPilot("RuleBasedMotionStateRoboPilot", 10), _motionStateMachine(IDLE_MOTION) {
+	// nothing to do...
+}
+
+MovementDecision RuleBasedMotionStateRoboPilot::makeMovementDecision() {
+	if (hasStaleSensorDistances()) {
+		// a clear path measured long ago is no clear path; start over once all distances are fresh again
+		if (!_stale) {
+			SERIAL_LOGGER_WARN(F("Distances are stale. Stopping in %s"), _motionStateMachine.get_name());
+			_stale = true;
+		}
+		_motionStateMachine.reset(IDLE_MOTION);
+		return StopMovementDecision();
+	} else if (_stale) {
+		SERIAL_LOGGER_INFO(F("Distances are fresh again"));
+		_stale = false;
+	}
+
+	const char *last_name = _motionStateMachine.get_name();
+	const DirectionArray<float> minDistances = getMinSensorDistances();
+	// each predicate of the table is evaluated at most once for this decision
+	const Pose pose = getPose();
+	MotionPredicates predicates(minDistances, getWeightedMovingAverageSensorDistances(), &getOccupancyGrid(), &pose);
+
+	if (_motionStateMachine.next(predicates) == NO_MOTION_STATE) {
+		_motionStateMachine.reset(IDLE_MOTION);
+		SERIAL_LOGGER_ERROR(F("MotionState chaining did not work and caused no next state. Last motion state was %s. "
+							  "Resetting to initial motion %s"), last_name, _motionStateMachine.get_name());
+		return StopMovementDecision();
+	} else {
+		SERIAL_LOGGER_DEBUG(F("Switched MotionState from %s to %s"), last_name, _motionStateMachine.get_name());
+		const MovementDecision &movementDecision = MovementDecision::fromState(_motionStateMachine.get_spec());
+		return movementDecision;
+	}
+}
+
+CoveragePlannerRoboPilot::CoveragePlannerRoboPilot(const float resolution_cm, const float mower_radius_cm,
+												   const float cut_radius_cm) :
+		RoboPilot("CoveragePlannerRoboPilot", 3), k_mower_radius_cm(mower_radius_cm), k_cut_radius_cm(cut_radius_cm),
+		_coverage_map(resolution_cm) {
+	// nothing to do...
+}
+
+const char *CoveragePlannerRoboPilot::getNameFromPhase(const Phase phase) {
+	switch (phase) {
+		case STRIPE:
+			return "Stripe";
+		case TURN:
+			return "Turn";
+		case SHIFT:
+			return "Shift";
+		case TRANSIT:
+			return "Transit";
+		case DONE:
+			return "Done";
+		default:
+			return "Unknown";
+	}
+}
 
-	// Collision avoidance chaining
-	_backwardMotion = new BackwardMotion(nullptr, _errorMotion);
-	_leftTurnMotion = new LeftTurnMotion(nullptr, _backwardMotion);
-	_rightTurnMotion = new RightTurnMotion(nullptr, _backwardMotion);
+MovementDecision CoveragePlannerRoboPilot::makeMovementDecision() {
+	if (hasStaleSensorDistances()) {
+		if (!_stale) {
+			SERIAL_LOGGER_WARN(F("Distances are stale. Stopping in %s"), getNameFromPhase(_phase));
+			_stale = true;
+		}
+		return StopMovementDecision();
+	} else if (_stale) {
+		SERIAL_LOGGER_INFO(F("Distances are fresh again"));
+		_stale = false;
+	}
 
-	_priorityStrategy = new PriorityStrategy(_leftTurnMotion, _rightTurnMotion);
-	_idleMotion = new IdleMotion(nullptr, _priorityStrategy);
+	const Pose pose = getPose();
+	updateCoverageMap(pose);
+	// a phase being over hands over to the next one within the same decision
+	for (int hops = 0; hops < COVERAGE_PLANNER_MAX_HOPS; hops++) {
+		const Phase phase = _phase;
+		const MovementDecision movementDecision = decide(pose);
+		if (_phase == phase) {
+			return movementDecision;
+		}
+	}
+	SERIAL_LOGGER_DEBUG(F("No decision within %d phases. Stopping in %s"), COVERAGE_PLANNER_MAX_HOPS,
+						getNameFromPhase(_phase));
+	return StopMovementDecision();
+}
 
-	// Cutting chaining
-	_lowSpeedForwardMotion = new LowSpeedForwardMotion(nullptr, _idleMotion);
-	_midSpeedForwardMotion = new MidSpeedForwardMotion(nullptr, _lowSpeedForwardMotion);
-	_fullSpeedForwardMotion = new FullSpeedForwardMotion(nullptr, _midSpeedForwardMotion);
+MovementDecision CoveragePlannerRoboPilot::decide(const Pose &pose) {
+	switch (_phase) {
+		case STRIPE:
+			return stripe(pose);
+		case TURN:
+			return turn(pose);
+		case SHIFT:
+			return shift(pose);
+		case TRANSIT:
+			return transit(pose);
+		case DONE:
+		default:
+			return StopMovementDecision();
+	}
+}
 
-	_midSpeedForwardMotion->setFollowUpState(_fullSpeedForwardMotion);
-	_lowSpeedForwardMotion->setFollowUpState(_midSpeedForwardMotion);
+void CoveragePlannerRoboPilot::updateCoverageMap(const Pose &pose) {
+	_coverage_map.cover(pose.x, pose.y, k_cut_radius_cm);
 
-	// idle state and final loop chaining
-	_idleMotion->setFollowUpState(_lowSpeedForwardMotion);
-	_backwardMotion->setFollowUpState(_idleMotion);
-	_leftTurnMotion->setFollowUpState(_idleMotion);
-	_rightTurnMotion->setFollowUpState(_idleMotion);
-	_errorMotion->setFollowUpState(_idleMotion);
+	const OccupancyGrid &occupancyGrid = getOccupancyGrid();
+	const CoverageCell cell = _coverage_map.toCell(pose.x, pose.y);
+	for (int cell_y = cell.y - COVERAGE_PLANNER_MAP_UPDATE_CELLS;
+		 cell_y <= cell.y + COVERAGE_PLANNER_MAP_UPDATE_CELLS; cell_y++) {
+		for (int cell_x = cell.x - COVERAGE_PLANNER_MAP_UPDATE_CELLS;
+			 cell_x <= cell.x + COVERAGE_PLANNER_MAP_UPDATE_CELLS; cell_x++) {
+			const float x = _coverage_map.toCoordinate(cell_x);
+			const float y = _coverage_map.toCoordinate(cell_y);
+			// cells partially outside of the grid are not known yet
+			if (_coverage_map.contains(cell_x, cell_y) && occupancyGrid.isWithin(x, y, k_mower_radius_cm)) {
+				// the mower stood on the covered cells already, i. e. obstacles mapped there are noise of nearby ones
+				if (!_coverage_map.isCovered(cell_x, cell_y) && !occupancyGrid.isClear(x, y, k_mower_radius_cm)) {
+					_coverage_map.setBlocked(cell_x, cell_y, true);
+				}
+				if (occupancyGrid.getLogOdds(x, y) < 0) {
+					_coverage_map.setSeen(cell_x, cell_y);
+				}
+			}
+		}
+	}
+}
 
-	_currentMotion = _idleMotion;
+bool CoveragePlannerRoboPilot::isBlockedAhead(const Pose &pose) const {
+	if (getMinSensorDistances()[Category::FRONT] < COVERAGE_PLANNER_STOP_DISTANCE_CM) {
+		return true;
+	}
+	// the corridor the mower sweeps through, i. e. nothing beside or behind it
+	const OccupancyGrid &occupancyGrid = getOccupancyGrid();
+	const float reach = k_mower_radius_cm + COVERAGE_PLANNER_LOOKAHEAD_CM;
+	for (int ray = -COVERAGE_PLANNER_CORRIDOR_RAYS / 2; ray <= COVERAGE_PLANNER_CORRIDOR_RAYS / 2; ray++) {
+		const float left = (k_mower_radius_cm - occupancyGrid.get_resolution()) * ray /
+						   (COVERAGE_PLANNER_CORRIDOR_RAYS / 2);
+		const float x = pose.x - left * sinf(pose.heading);
+		const float y = pose.y + left * cosf(pose.heading);
+		if (occupancyGrid.castRay(x, y, pose.heading, reach) < reach) {
+			return true;
+		}
+	}
+	return false;
 }
 
-RuleBasedMotionStateRoboPilot::~RuleBasedMotionStateRoboPilot() {
-	delete _errorMotion;
-	delete _backwardMotion;
-	delete _leftTurnMotion;
-	delete _rightTurnMotion;
-	delete _priorityStrategy;
-	delete _idleMotion;
-	delete _lowSpeedForwardMotion;
-	delete _midSpeedForwardMotion;
-	delete _fullSpeedForwardMotion;
+MovementDecision CoveragePlannerRoboPilot::rotate(const float heading_error) const {
+	const int16_t power = (int16_t) min((float) COVERAGE_PLANNER_MAX_TURN_POWER,
+										max((float) COVERAGE_PLANNER_MIN_TURN_POWER,
+											fabsf(heading_error) * COVERAGE_PLANNER_MAX_TURN_POWER));
+	// counterclockwise for a positive error
+	return heading_error > 0.0f ? MovementDecision(-power, power, ENGINE_MAX_POWER_VALUE) :
+		   MovementDecision(power, -power, ENGINE_MAX_POWER_VALUE);
 }
 
-MovementDecision RuleBasedMotionStateRoboPilot::makeMovementDecision() {
-	const char *last_name = _currentMotion->get_name();
-	const std::map<Category::Direction, float> &minDistances = getMinSensorDistances();
-	const std::map<Category::Direction, float> &maxDistances = getMaxSensorDistances();
-	const std::map<Category::Direction, float> &weightedMovingAvgDistances = getWeightedMovingAverageSensorDistances();
-
-	_currentMotion = _currentMotion->getNextState(minDistances, maxDistances, weightedMovingAvgDistances);
-	if (_currentMotion == nullptr) {
-		_currentMotion = _idleMotion;
-		SerialLogger::error(F("MotionState chaining did not work and caused a next state that was nullptr. Last motion "
-							  "state was %s. Resetting to initial motion %s"), last_name, _currentMotion->get_name());
+MovementDecision CoveragePlannerRoboPilot::steer(const float heading, const Pose &pose) const {
+	const float heading_error = remainderf(heading - pose.heading, 2.0f * (float) M_PI);
+	if (fabsf(heading_error) > COVERAGE_PLANNER_MAX_STEERING_DEGREES * (float) M_PI / 180.0f) {
+		return rotate(heading_error);
+	}
+	// turns at twice the heading error per second, i. e. a third of it until the next decision
+	const int16_t steering = (int16_t) (heading_error * DEFAULT_WHEEL_BASE_CM * ODOMETRY_MAX_ENGINE_POWER /
+										DEFAULT_MAX_WHEEL_SPEED_CM_PER_SECOND);
+	return MovementDecision(COVERAGE_PLANNER_DRIVE_POWER - steering, COVERAGE_PLANNER_DRIVE_POWER + steering,
+							ENGINE_MAX_POWER_VALUE);
+}
+
+void CoveragePlannerRoboPilot::enter(const Phase phase) {
+	SERIAL_LOGGER_DEBUG(F("Switched coverage phase from %s to %s"), getNameFromPhase(_phase),
+						getNameFromPhase(phase));
+	_phase = phase;
+}
+
+void CoveragePlannerRoboPilot::turnThen(const float heading, const Phase phase) {
+	_turn_heading = heading;
+	_next_phase = phase;
+	enter(TURN);
+}
+
+MovementDecision CoveragePlannerRoboPilot::turn(const Pose &pose) {
+	const float heading_error = remainderf(_turn_heading - pose.heading, 2.0f * (float) M_PI);
+	if (fabsf(heading_error) <= COVERAGE_PLANNER_HEADING_TOLERANCE_DEGREES * (float) M_PI / 180.0f) {
+		enter(_next_phase);
 		return StopMovementDecision();
-	} else {
-		SerialLogger::debug(F("Switched MotionState from %s to %s"), last_name, _currentMotion->get_name());
-		const MovementDecision &movementDecision = MovementDecision::fromState(*_currentMotion);
-		return movementDecision;
 	}
-}
\ No newline at end of file
+	return rotate(heading_error);
+}
+
+MovementDecision CoveragePlannerRoboPilot::stripe(const Pose &pose) {
+	const CoverageCell cell = _coverage_map.toCell(pose.x, pose.y);
+	if (isBlockedAhead(pose) || (_coverage_map.isCovered(cell.x + _stripe_direction, cell.y) &&
+								 _coverage_map.isCovered(cell.x + 2 * _stripe_direction, cell.y))) {
+		endStripe(pose);
+		return StopMovementDecision();
+	}
+	// back onto the line within about twice the resolution
+	const float offset = (_line - pose.y) * _stripe_direction;
+	return steer(get_stripe_heading() + atanf(offset / (2.0f * _coverage_map.get_resolution())), pose);
+}
+
+void CoveragePlannerRoboPilot::endStripe(const Pose &pose) {
+	const CoverageCell cell = _coverage_map.toCell(pose.x, _line);
+	if (_coverage_map.isCovered(cell.x, cell.y + _sweep_direction)) {
+		startTransit(pose);
+		return;
+	}
+	_line = _coverage_map.toCoordinate(cell.y + _sweep_direction);
+	_shift_start = pose.y;
+	turnThen(_sweep_direction * (float) M_PI / 2.0f, SHIFT);
+}
+
+MovementDecision CoveragePlannerRoboPilot::shift(const Pose &pose) {
+	const bool shifting = (_line - pose.y) * _sweep_direction > 0.0f;
+	if (shifting && isBlockedAhead(pose)) {
+		if ((pose.y - _shift_start) * _sweep_direction < k_cut_radius_cm / 2.0f) {
+			startTransit(pose);
+			return StopMovementDecision();
+		}
+		// the border is closer than a stripe; mow along it
+		_line = pose.y;
+	} else if (shifting) {
+		return steer(_sweep_direction * (float) M_PI / 2.0f, pose);
+	}
+	_stripe_direction = -_stripe_direction;
+	turnThen(get_stripe_heading(), STRIPE);
+	return StopMovementDecision();
+}
+
+void CoveragePlannerRoboPilot::startSweep(const Pose &pose) {
+	const CoverageCell cell = _coverage_map.toCell(pose.x, pose.y);
+	_line = _coverage_map.toCoordinate(cell.y);
+	// keep on mowing into the same directions unless they are covered already
+	if (_coverage_map.isCovered(cell.x + _stripe_direction, cell.y) &&
+		!_coverage_map.isCovered(cell.x - _stripe_direction, cell.y)) {
+		_stripe_direction = -_stripe_direction;
+	}
+	if (_coverage_map.isCovered(cell.x, cell.y + _sweep_direction) &&
+		!_coverage_map.isCovered(cell.x, cell.y - _sweep_direction)) {
+		_sweep_direction = -_sweep_direction;
+	}
+	SERIAL_LOGGER_INFO(F("Starting a sweep at (%f, %f), %d of %d cells covered"), pose.x, pose.y,
+					   _coverage_map.getCoveredCells(), COVERAGE_MAP_CELLS * COVERAGE_MAP_CELLS);
+	turnThen(get_stripe_heading(), STRIPE);
+}
+
+void CoveragePlannerRoboPilot::startTransit(const Pose &pose, const CoverageCell *avoid) {
+	_path_length = _coverage_map.planPath(_coverage_map.toCell(pose.x, pose.y), _path, COVERAGE_PLANNER_PATH_LENGTH,
+										  avoid);
+	_path_index = 0;
+	_detouring = false;
+	_squeezing = false;
+	if (_path_length == 0) {
+		SERIAL_LOGGER_INFO(F("No uncovered cell left, %d of %d cells covered"), _coverage_map.getCoveredCells(),
+						   COVERAGE_MAP_CELLS * COVERAGE_MAP_CELLS);
+		enter(DONE);
+		return;
+	}
+	if (avoid == nullptr) {
+		// twice the time driving straight to it, and some for turning; detours do not get more (or they might go on
+		// forever)
+		_transit_deadline_millis = millis() + 2000UL + (unsigned long) (
+				2000.0f * _path_length * _coverage_map.get_resolution() /
+				(COVERAGE_PLANNER_DRIVE_POWER * DEFAULT_MAX_WHEEL_SPEED_CM_PER_SECOND / ODOMETRY_MAX_ENGINE_POWER));
+	}
+	if (_phase != TRANSIT) {
+		enter(TRANSIT);
+	}
+}
+
+void CoveragePlannerRoboPilot::giveUpTarget(const Pose &pose) {
+	const CoverageCell target = _path[_path_length - 1];
+	SERIAL_LOGGER_DEBUG(F("Giving up cell (%d, %d)"), target.x, target.y);
+	_coverage_map.setBlocked(target.x, target.y, true);
+	startTransit(pose);
+}
+
+MovementDecision CoveragePlannerRoboPilot::transit(const Pose &pose) {
+	// skip the cells reached already
+	while (_path_index < _path_length) {
+		const float dx = _coverage_map.toCoordinate(_path[_path_index].x) - pose.x;
+		const float dy = _coverage_map.toCoordinate(_path[_path_index].y) - pose.y;
+		if (dx * dx + dy * dy > k_cut_radius_cm * k_cut_radius_cm) {
+			break;
+		}
+		_path_index++;
+		_detouring = false;
+		_squeezing = false;
+	}
+	if (_path_index == _path_length) {
+		if (_path_length < COVERAGE_PLANNER_PATH_LENGTH) {
+			startSweep(pose);
+		} else {
+			// the path was cut
+			startTransit(pose);
+		}
+		return StopMovementDecision();
+	}
+
+	const CoverageCell &waypoint = _path[_path_index];
+	const float heading = atan2f(_coverage_map.toCoordinate(waypoint.y) - pose.y,
+								 _coverage_map.toCoordinate(waypoint.x) - pose.x);
+	const bool heading_ahead = fabsf(remainderf(heading - pose.heading, 2.0f * (float) M_PI)) <=
+							   COVERAGE_PLANNER_MAX_STEERING_DEGREES * (float) M_PI / 180.0f;
+	if (heading_ahead && _squeezing) {
+		if (getMinSensorDistances()[Category::FRONT] < COVERAGE_PLANNER_STOP_DISTANCE_CM) {
+			giveUpTarget(pose);
+			return StopMovementDecision();
+		}
+	} else if (heading_ahead && isBlockedAhead(pose)) {
+		// there is an obstacle on the way the map did not know of; find another way around it first. If the detour is
+		// blocked as well, block the cell; unless the mower stood on it already, then the noise of the obstacles
+		// around may have sealed it in: squeeze through by what the sonars see right ahead only.
+		SERIAL_LOGGER_DEBUG(F("Way to cell (%d, %d) is blocked"), waypoint.x, waypoint.y);
+		const CoverageCell avoid = waypoint;
+		if (!_detouring) {
+			startTransit(pose, &avoid);
+			_detouring = true;
+			return StopMovementDecision();
+		} else if (!_coverage_map.isCovered(avoid.x, avoid.y)) {
+			_coverage_map.setBlocked(avoid.x, avoid.y, true);
+			startTransit(pose);
+			return StopMovementDecision();
+		}
+		_squeezing = true;
+	}
+	if ((long) (millis() - _transit_deadline_millis) > 0) {
+		giveUpTarget(pose);
+		return StopMovementDecision();
+	}
+	return steer(heading, pose);
+}
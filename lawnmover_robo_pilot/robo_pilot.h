@@ -2,64 +2,156 @@
 #define ROBO_PILOT_H
 
 #include <Arduino.h>
-#include <numeric>
 
+#include "coverage_map.h"
 #include "decision.h"
+#include "distance_filter.h"
+#include "distance_history.h"
 #include "motion_state.h"
+#include "occupancy_grid.h"
+#include "odometry_estimator.h"
+
+// distances older than this are dropped; if the latest distance of a direction is older, the pilot stops
+#define DEFAULT_MAX_SAMPLE_AGE_MILLIS 500UL
+
+#define DEFAULT_MOWER_RADIUS_CM 25.0f
+// reach of the blade around the center of the mower
+#define DEFAULT_CUT_RADIUS_CM 20.0f
+#define COVERAGE_PLANNER_DRIVE_POWER 220
+#define COVERAGE_PLANNER_MIN_TURN_POWER 60
+#define COVERAGE_PLANNER_MAX_TURN_POWER 160
+// turning on the spot until the heading is this close; larger heading errors than the max steering angle turn on the
+// spot, too
+#define COVERAGE_PLANNER_HEADING_TOLERANCE_DEGREES 6.0f
+#define COVERAGE_PLANNER_MAX_STEERING_DEGREES 30.0f
+// the mower stops driving forward if a mapped obstacle is this close ahead of its rim (on any of the rays spread
+// over its width) or the front sensor measures less than the stop distance
+#define COVERAGE_PLANNER_LOOKAHEAD_CM 10.0f
+#define COVERAGE_PLANNER_CORRIDOR_RAYS 5
+#define COVERAGE_PLANNER_STOP_DISTANCE_CM 12.0f
+// the cells around the mower taking over blocked and seen from the occupancy grid
+#define COVERAGE_PLANNER_MAP_UPDATE_CELLS 4
+#define COVERAGE_PLANNER_PATH_LENGTH 32
+// phases handed over within a single decision at most
+#define COVERAGE_PLANNER_MAX_HOPS 4
 
 // TODO better algorithms https://en.wikibooks.org/wiki/Robotics/Navigation/Collision_Avoidance or see README
 
 class RoboPilot {
 public:
+	/**
+	 * @param time_constant_millis The time constant of the (default) exponential moving average of each direction
+	 */
 	RoboPilot(const char *name, const int distances_buffer_size,
-			  const float weighted_moving_average_alpha = DEFAULT_WEIGHTED_MOVING_AVERAGE_ALPHA) :
+			  const unsigned long time_constant_millis = DEFAULT_DISTANCE_FILTER_TIME_CONSTANT_MILLIS,
+			  const unsigned long max_sample_age_millis = DEFAULT_MAX_SAMPLE_AGE_MILLIS) :
 			k_name(name), k_distances_buffer_size(distances_buffer_size),
-			k_weighted_moving_average_alpha(weighted_moving_average_alpha) {
-		_directionsDistances.insert(std::make_pair(Category::Direction::FRONT, std::vector<float>()));
-		_directionsDistances.insert(std::make_pair(Category::Direction::FRONT_LEFT, std::vector<float>()));
-		_directionsDistances.insert(std::make_pair(Category::Direction::FRONT_RIGHT, std::vector<float>()));
-		_directionsDistances.insert(std::make_pair(Category::Direction::BACK_LEFT, std::vector<float>()));
-		_directionsDistances.insert(std::make_pair(Category::Direction::BACK_RIGHT, std::vector<float>()));
-
-		// reserve space for the vectors
-		_directionsDistances[Category::Direction::FRONT].reserve(distances_buffer_size);
-		_directionsDistances[Category::Direction::FRONT_LEFT].reserve(distances_buffer_size);
-		_directionsDistances[Category::Direction::FRONT_RIGHT].reserve(distances_buffer_size);
-		_directionsDistances[Category::Direction::BACK_LEFT].reserve(distances_buffer_size);
-		_directionsDistances[Category::Direction::BACK_RIGHT].reserve(distances_buffer_size);
-
-		// fill initial values of weighted moving averages
-		_weighted_moving_averages.insert(std::make_pair(Category::Direction::FRONT, 0));
-		_weighted_moving_averages.insert(std::make_pair(Category::Direction::FRONT_LEFT, 0));
-		_weighted_moving_averages.insert(std::make_pair(Category::Direction::FRONT_RIGHT, 0));
-		_weighted_moving_averages.insert(std::make_pair(Category::Direction::BACK_LEFT, 0));
-		_weighted_moving_averages.insert(std::make_pair(Category::Direction::BACK_RIGHT, 0));
-	};
-
-	~RoboPilot() = default;
-
-	void putSensorDistance(Category::Direction direction, const float distance) {
-		std::vector<float> &directionDistances = _directionsDistances[direction];
-		if (directionDistances.size() >= k_distances_buffer_size) {
-			SerialLogger::trace(F("Removing oldest distance from %s with value %f"),
-								Category::getNameFromDirection(direction), directionDistances.back());
-			directionDistances.pop_back();
+			k_max_sample_age_millis(max_sample_age_millis) {
+		// allocate the histories once; putting distances does not allocate anymore
+		for (DistanceHistory &directionDistances : _directionsDistances) {
+			directionDistances.resize(distances_buffer_size);
+		}
+		for (DistanceFilter *&distanceFilter : _distance_filters) {
+			distanceFilter = new ExponentialMovingAverageFilter(time_constant_millis);
 		}
-		SerialLogger::trace(F("Inserting new distance for %s with value %f"),
+		// weighted moving averages are value initialized with 0 by DirectionArray
+
+		// sensors at the rim of the mower (radius 25 cm); the side ones look 30° off the front and back
+		_sensor_mounts[Category::FRONT] = {25.0f, 0.0f, 0.0f};
+		_sensor_mounts[Category::FRONT_LEFT] = {20.0f, 12.5f, (float) M_PI / 6.0f};
+		_sensor_mounts[Category::FRONT_RIGHT] = {20.0f, -12.5f, -(float) M_PI / 6.0f};
+		_sensor_mounts[Category::BACK_LEFT] = {-20.0f, 12.5f, 5.0f * (float) M_PI / 6.0f};
+		_sensor_mounts[Category::BACK_RIGHT] = {-20.0f, -12.5f, -5.0f * (float) M_PI / 6.0f};
+	};
+
+	virtual ~RoboPilot() {
+		for (DistanceFilter *distanceFilter : _distance_filters) {
+			delete distanceFilter;
+		}
+	};
+
+	// the pilot owns its filters
+	RoboPilot(const RoboPilot &roboPilot) = delete;
+
+	RoboPilot &operator=(const RoboPilot &roboPilot) = delete;
+
+	/**
+	 * Replace the filter of the given direction (e. g. by an AlphaBetaFilter or a KalmanFilter). The pilot takes
+	 * ownership of the filter. Put filters before putting distances; the new filter starts from scratch.
+	 */
+	void setDistanceFilter(Category::Direction direction, DistanceFilter *distanceFilter) {
+		if (distanceFilter == nullptr) {
+			SERIAL_LOGGER_ERROR(F("Cannot set no distance filter for %s. Keeping %s"),
+								Category::getNameFromDirection(direction), _distance_filters[direction]->get_name());
+			return;
+		} else if (distanceFilter == _distance_filters[direction]) {
+			// owned already
+			return;
+		}
+		delete _distance_filters[direction];
+		_distance_filters[direction] = distanceFilter;
+		_weighted_moving_averages[direction] = distanceFilter->get();
+	};
+
+	/**
+	 * Replace where the sensor of the given direction sits on the mower (see the defaults in the constructor)
+	 */
+	void setSensorMount(Category::Direction direction, const SensorMount &sensorMount) {
+		_sensor_mounts[direction] = sensorMount;
+	};
+
+	/**
+	 * Calibrate the power to velocity model of the odometry (see WheelModel::fromMeasurements)
+	 */
+	void setWheelModels(const float wheel_base_cm, const WheelModel &leftWheel, const WheelModel &rightWheel) {
+		_odometry.setWheelModels(wheel_base_cm, leftWheel, rightWheel);
+	};
+
+	/**
+	 * The movement the engines were actually commanded (by this pilot or by anybody else, e. g. a PS4 controller). Put
+	 * it whenever commanding the engines; the pilot dead reckons its pose from it.
+	 */
+	void putMovementDecision(const MovementDecision &movementDecision) {
+		_odometry.putWheelPowers(movementDecision.get_left_wheel_power(),
+									   movementDecision.get_right_wheel_power(), millis());
+	};
+
+	/**
+	 * @param age_millis How long ago the distance was measured. Distances older than the max sample age are dropped.
+	 *        The filters work on the time the distance was measured at.
+	 */
+	void putSensorDistance(Category::Direction direction, const float distance, const unsigned long age_millis = 0) {
+		if (age_millis > k_max_sample_age_millis) {
+			SERIAL_LOGGER_TRACE(F("Dropping distance from %s with value %f measured %l ms ago"),
+								Category::getNameFromDirection(direction), distance, age_millis);
+			return;
+		}
+		_sample_millis[direction] = millis() - age_millis;
+		_sampled[direction] = true;
+
+		DistanceHistory &directionDistances = _directionsDistances[direction];
+		if (directionDistances.full()) {
+			SERIAL_LOGGER_TRACE(F("Removing oldest distance from %s with value %f"),
+								Category::getNameFromDirection(direction), directionDistances.oldest());
+		}
+		SERIAL_LOGGER_TRACE(F("Inserting new distance for %s with value %f"),
 							Category::getNameFromDirection(direction), distance);
-		directionDistances.insert(directionDistances.begin(), distance);
+		directionDistances.put(distance);
 
 		updateSensorWeightedMovingAverage(direction, distance);
+		_occupancy_grid.putDistance(_odometry.getPose(_sample_millis[direction]), _sensor_mounts[direction],
+									distance, MAX_DISTANCE);
 	};
 
 	virtual MovementDecision makeMovementDecision() = 0;
 
 	void printWeightedMovingAverageDistances() const {
 		if (SerialLogger::isBelow(SerialLogger::DEBUG)) {
-			for (auto it = _weighted_moving_averages.begin(); it != _weighted_moving_averages.end(); ++it) {
-				Serial.print(Category::getNameFromDirection(it->first));
+			for (int i = 0; i < DirectionArray<float>::size(); i++) {
+				const Category::Direction direction = DirectionArray<float>::directionAt(i);
+				Serial.print(Category::getNameFromDirection(direction));
 				Serial.print(F(": "));
-				Serial.print(it->second);
+				Serial.print(_weighted_moving_averages[direction]);
 				Serial.print(F(", "));
 			}
 			Serial.println();
@@ -68,89 +160,202 @@ public:
 
 protected:
 
-	std::map<Category::Direction, float> getMeanSensorDistances() const {
-		std::map<Category::Direction, float> copy_assigned_tmp_map = _weighted_moving_averages;
-		for (auto it = copy_assigned_tmp_map.begin(); it != copy_assigned_tmp_map.end(); ++it) {
-			const std::vector<float> &directionDistances = _directionsDistances.at(it->first);
-			if (directionDistances.size() > 0) {
-				it->second = std::accumulate(directionDistances.begin(), directionDistances.end(), 0.0f) /
-							 directionDistances.size();
-			} else {
-				it->second = -1.0f;
-			}
+	DirectionArray<float> getMeanSensorDistances() const {
+		DirectionArray<float> distances;
+		for (int i = 0; i < DirectionArray<float>::size(); i++) {
+			const Category::Direction direction = DirectionArray<float>::directionAt(i);
+			const DistanceHistory &directionDistances = _directionsDistances[direction];
+			distances[direction] = directionDistances.empty() ? -1.0f : directionDistances.mean();
 		}
-		return copy_assigned_tmp_map;
+		return distances;
 	};
 
-	std::map<Category::Direction, float> getMinSensorDistances() const {
-		std::map<Category::Direction, float> copy_assigned_tmp_map = _weighted_moving_averages;
-		for (auto it = copy_assigned_tmp_map.begin(); it != copy_assigned_tmp_map.end(); ++it) {
-			const std::vector<float> &directionDistances = _directionsDistances.at(it->first);
-			if (directionDistances.size() > 0) {
-				it->second = *std::min_element(directionDistances.begin(), directionDistances.end());
-			} else {
-				it->second = -1.0f;
-			}
+	DirectionArray<float> getMinSensorDistances() const {
+		DirectionArray<float> distances;
+		for (int i = 0; i < DirectionArray<float>::size(); i++) {
+			const Category::Direction direction = DirectionArray<float>::directionAt(i);
+			const DistanceHistory &directionDistances = _directionsDistances[direction];
+			distances[direction] = directionDistances.empty() ? -1.0f : directionDistances.min();
 		}
-		return copy_assigned_tmp_map;
+		return distances;
 	};
 
-	std::map<Category::Direction, float> getMaxSensorDistances() const {
-		std::map<Category::Direction, float> copy_assigned_tmp_map = _weighted_moving_averages;
-		for (auto it = copy_assigned_tmp_map.begin(); it != copy_assigned_tmp_map.end(); ++it) {
-			const std::vector<float> &directionDistances = _directionsDistances.at(it->first);
-			if (directionDistances.size() > 0) {
-				it->second = *std::max_element(directionDistances.begin(), directionDistances.end());
-			} else {
-				it->second = -1.0f;
-			}
+	DirectionArray<float> getMaxSensorDistances() const {
+		DirectionArray<float> distances;
+		for (int i = 0; i < DirectionArray<float>::size(); i++) {
+			const Category::Direction direction = DirectionArray<float>::directionAt(i);
+			const DistanceHistory &directionDistances = _directionsDistances[direction];
+			distances[direction] = directionDistances.empty() ? -1.0f : directionDistances.max();
 		}
-		return copy_assigned_tmp_map;
+		return distances;
 	};
 
-	std::map<Category::Direction, float> getWeightedMovingAverageSensorDistances() const {
+	const DirectionArray<float> &getWeightedMovingAverageSensorDistances() const {
 		return _weighted_moving_averages;
 	};
 
+	const OccupancyGrid &getOccupancyGrid() const {
+		return _occupancy_grid;
+	};
+
+	Pose getPose() const {
+		return _odometry.getPose(millis());
+	};
+
+	/**
+	 * @return whether the latest distance of any direction is older than the max sample age (or there is none at all),
+	 *         e. g. because the distance control unit fell behind or does not answer anymore
+	 */
+	bool hasStaleSensorDistances() const {
+		const unsigned long now = millis();
+		for (int i = 0; i < DirectionArray<float>::size(); i++) {
+			const Category::Direction direction = DirectionArray<float>::directionAt(i);
+			if (!_sampled[direction] || now - _sample_millis[direction] > k_max_sample_age_millis) {
+				return true;
+			}
+		}
+		return false;
+	};
+
 private:
 	void updateSensorWeightedMovingAverage(Category::Direction direction, const float distance) {
-		float &weightedMovingAverage = _weighted_moving_averages[direction];
-		weightedMovingAverage = k_weighted_moving_average_alpha * distance +
-								(1 - k_weighted_moving_average_alpha) * weightedMovingAverage;
-		SerialLogger::trace(F("Updated weighted moving average for %s to %f"),
-							Category::getNameFromDirection(direction), weightedMovingAverage);
+		DistanceFilter *distanceFilter = _distance_filters[direction];
+		distanceFilter->put(distance, _sample_millis[direction]);
+		_weighted_moving_averages[direction] = distanceFilter->get();
+		SERIAL_LOGGER_TRACE(F("Updated %s for %s to %f"), distanceFilter->get_name(),
+							Category::getNameFromDirection(direction), _weighted_moving_averages[direction]);
 	};
 
 	const char *k_name;
 	const int k_distances_buffer_size;
-	// https://en.wikipedia.org/wiki/Moving_average#Exponential_moving_average
-	const float k_weighted_moving_average_alpha;
+	const unsigned long k_max_sample_age_millis;
+
+	DirectionArray<DistanceHistory> _directionsDistances;
+	DirectionArray<DistanceFilter *> _distance_filters;
+	// the output of the filter of each direction (an exponential moving average by default)
+	DirectionArray<float> _weighted_moving_averages;
+	// millis of this mcu the latest distance of each direction was measured at
+	DirectionArray<unsigned long> _sample_millis;
+	DirectionArray<bool> _sampled;
 
-	// TODO volatile?! --> not working with vector or map once you try to use their member functions or operators...
-	std::map <Category::Direction, std::vector<float>> _directionsDistances;
-	std::map<Category::Direction, float> _weighted_moving_averages;
+	OdometryEstimator _odometry;
+	DirectionArray<SensorMount> _sensor_mounts;
+	// obstacles around the mower; the distances are projected from the pose they were measured at
+	OccupancyGrid _occupancy_grid;
 };
 
 class RuleBasedMotionStateRoboPilot : public RoboPilot {
 public:
 	RuleBasedMotionStateRoboPilot();
 
-	~RuleBasedMotionStateRoboPilot();
+	MovementDecision makeMovementDecision() override;
+
+private:
+	// the transitions are the MotionStateTable; the machine keeps the current state only
+	MotionStateMachine _motionStateMachine;
+	bool _stale = false;
+};
+
+/**
+ * Mows the lawn in boustrophedon stripes (https://en.wikipedia.org/wiki/Boustrophedon_cell_decomposition) instead of
+ * bouncing around at random, i. e. every cell is mowed once (as far as the odometry allows):
+ * * STRIPE: drive along a row of the CoverageMap (parallel to the x axis of the pose) until an obstacle is ahead or
+ *   the cells ahead are covered already
+ * * TURN and SHIFT: turn on the spot towards the next row, drive over to it and turn back into the opposite direction.
+ *   If an obstacle (e. g. the border of the lawn) stops the shift early, the stripe is mowed where the mower stands.
+ * * TRANSIT: if the next row is covered already (or cannot be reached), plan a path through the cells not blocked by
+ *   mapped obstacles to the closest uncovered cell (see CoverageMap::planPath) and start a new sweep from there. Hence,
+ *   obstacles in the middle of a stripe are mowed around by later sweeps. Obstacles on the way the map did not know of
+ *   yet are detoured; cells no way leads to in time are given up.
+ * * DONE: there is no uncovered cell left that was seen free and is reachable; the mower stops.
+ *
+ * Obstacles are taken from the OccupancyGrid, i. e. the map only knows the surroundings the sensors swept over.
+ */
+class CoveragePlannerRoboPilot : public RoboPilot {
+public:
+	enum Phase {
+		STRIPE,
+		TURN,
+		SHIFT,
+		TRANSIT,
+		DONE
+	};
+
+	explicit CoveragePlannerRoboPilot(const float resolution_cm = DEFAULT_COVERAGE_MAP_RESOLUTION_CM,
+									  const float mower_radius_cm = DEFAULT_MOWER_RADIUS_CM,
+									  const float cut_radius_cm = DEFAULT_CUT_RADIUS_CM);
 
 	MovementDecision makeMovementDecision() override;
 
+	const CoverageMap &getCoverageMap() const {
+		return _coverage_map;
+	};
+
+	Phase get_phase() const { return _phase; };
+
+	static const char *getNameFromPhase(const Phase phase);
+
 private:
-	ErrorMotion *_errorMotion;
-	BackwardMotion *_backwardMotion;
-	LeftTurnMotion *_leftTurnMotion;
-	RightTurnMotion *_rightTurnMotion;
-	PriorityStrategy *_priorityStrategy;
-	IdleMotion *_idleMotion;
-	LowSpeedForwardMotion *_lowSpeedForwardMotion;
-	MidSpeedForwardMotion *_midSpeedForwardMotion;
-	FullSpeedForwardMotion *_fullSpeedForwardMotion;
-
-	MotionState *_currentMotion;
+	// the handler of the current phase; sets the next phase if the current one is over
+	MovementDecision decide(const Pose &pose);
+
+	MovementDecision stripe(const Pose &pose);
+
+	MovementDecision turn(const Pose &pose);
+
+	MovementDecision shift(const Pose &pose);
+
+	MovementDecision transit(const Pose &pose);
+
+	void updateCoverageMap(const Pose &pose);
+
+	bool isBlockedAhead(const Pose &pose) const;
+
+	// drive forward along the heading; turn on the spot first if it is too far off
+	MovementDecision steer(const float heading, const Pose &pose) const;
+
+	MovementDecision rotate(const float heading_error) const;
+
+	void turnThen(const float heading, const Phase phase);
+
+	void endStripe(const Pose &pose);
+
+	void startSweep(const Pose &pose);
+
+	void startTransit(const Pose &pose, const CoverageCell *avoid = nullptr);
+
+	// block the cell the path leads to and plan the next one
+	void giveUpTarget(const Pose &pose);
+
+	void enter(const Phase phase);
+
+	float get_stripe_heading() const { return _stripe_direction > 0 ? 0.0f : (float) M_PI; };
+
+	const float k_mower_radius_cm;
+	const float k_cut_radius_cm;
+
+	CoverageMap _coverage_map;
+	Phase _phase = STRIPE;
+	// once turned
+	Phase _next_phase = STRIPE;
+	float _turn_heading = 0.0f;
+	// +1 mows along the x axis, -1 against it
+	int8_t _stripe_direction = 1;
+	// +1 shifts to rows of larger y, -1 to smaller
+	int8_t _sweep_direction = 1;
+	// y of the current stripe or of the one shifting to
+	float _line = 0.0f;
+	float _shift_start = 0.0f;
+
+	CoverageCell _path[COVERAGE_PLANNER_PATH_LENGTH];
+	int _path_length = 0;
+	int _path_index = 0;
+	// whether the path avoids a cell whose way was blocked
+	bool _detouring = false;
+	// whether the mower heads for a cell it stood on already by what the sonars see right ahead only
+	bool _squeezing = false;
+	unsigned long _transit_deadline_millis = 0;
+	bool _stale = false;
 };
 
 #endif // ROBO_PILOT_H
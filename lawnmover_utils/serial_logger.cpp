@@ -3,6 +3,49 @@
 #include <stdio.h>
 
 SerialLogger::LOG_LEVEL SerialLogger::logLevel = SerialLogger::LOG_LEVEL::INFO;
+SerialLogger::LOG_FORMAT SerialLogger::logFormat = SerialLogger::LOG_FORMAT::TEXT;
+uint8_t *SerialLogger::buffer = nullptr;
+volatile SerialLogger::BufferIndex SerialLogger::head = 0;
+volatile SerialLogger::BufferIndex SerialLogger::tail = 0;
+volatile uint32_t SerialLogger::droppedRecords = 0;
+
+// Producers copy a record into the ring within a critical section; the only consumer is flush (called from the loop)
+#if defined(ARDUINO_ARCH_AVR)
+// log calls of interrupt routines must not enable interrupts on their way out
+#define ENTER_CRITICAL() const uint8_t sreg = SREG; noInterrupts()
+#define EXIT_CRITICAL() SREG = sreg
+#elif defined(ARDUINO_ARCH_ESP32)
+#include <freertos/FreeRTOS.h>
+
+// noInterrupts masks the current core only, but e. g. the PS4 callbacks log from the Bluetooth task on the other core.
+// The spinlock keeps both cores apart and restores the interrupt level of the current core on its way out.
+namespace {
+	portMUX_TYPE putLock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+#define ENTER_CRITICAL() portENTER_CRITICAL(&putLock)
+#define EXIT_CRITICAL() portEXIT_CRITICAL(&putLock)
+#else
+// the host builds (see lawnmover_host) log from a single thread and have no interrupts to mask
+#define ENTER_CRITICAL()
+#define EXIT_CRITICAL()
+#endif
+
+namespace {
+	const uint8_t k_dropped_record_size = 11;
+
+	uint8_t putUint32(uint8_t *record, uint8_t size, const uint32_t value) {
+		record[size++] = value & 0xFF;
+		record[size++] = (value >> 8) & 0xFF;
+		record[size++] = (value >> 16) & 0xFF;
+		record[size++] = (value >> 24) & 0xFF;
+		return size;
+	}
+
+	char formatAt(const char *c, const bool flash) {
+		return flash ? pgm_read_byte(c) : *c;
+	}
+}
 
 
 void SerialLogger::init(const int speed) {
@@ -12,7 +55,33 @@ void SerialLogger::init(const int speed) {
 void SerialLogger::init(const int speed, const SerialLogger::LOG_LEVEL logLevel) {
 	if (logLevel < LOG_LEVEL::NONE) {
 		Serial.begin(speed);
-		SerialLogger::logLevel = logLevel;
+	}
+	SerialLogger::logLevel = logLevel;
+}
+
+void SerialLogger::init(const int speed, const SerialLogger::LOG_LEVEL logLevel,
+						const SerialLogger::LOG_FORMAT logFormat) {
+	init(speed, logLevel);
+	if (logFormat == LOG_FORMAT::BINARY && buffer == nullptr) {
+		buffer = new uint8_t[SERIAL_LOGGER_BUFFER_SIZE];
+	}
+	SerialLogger::logFormat = buffer == nullptr ? LOG_FORMAT::TEXT : logFormat;
+}
+
+void SerialLogger::flush() {
+	if (buffer != nullptr) {
+		const BufferIndex published = head;
+		BufferIndex consumed = tail;
+		int writable = Serial.availableForWrite();
+		while (consumed != published && writable > 0) {
+			// up to the head or the end of the buffer, whatever comes first
+			const int contiguous = (published > consumed ? published : SERIAL_LOGGER_BUFFER_SIZE) - consumed;
+			const int amount = contiguous < writable ? contiguous : writable;
+			Serial.write(buffer + consumed, amount);
+			consumed = (consumed + amount) & (SERIAL_LOGGER_BUFFER_SIZE - 1);
+			writable -= amount;
+		}
+		tail = consumed;
 	}
 }
 
@@ -21,8 +90,12 @@ void SerialLogger::trace(const char *format, ...) {
 		va_list argptr;
 		va_start(argptr, format);
 
-		Serial.print(F("TRACE: "));
-		log(format, argptr);
+		if (logFormat == LOG_FORMAT::BINARY) {
+			record(LOG_LEVEL::TRACE, format, false, argptr);
+		} else {
+			Serial.print(F("TRACE: "));
+			log(format, argptr);
+		}
 		//va_end(argptr);
 	}
 }
@@ -32,8 +105,12 @@ void SerialLogger::debug(const char *format, ...) {
 		va_list argptr;
 		va_start(argptr, format);
 
-		Serial.print(F("DEBUG: "));
-		log(format, argptr);
+		if (logFormat == LOG_FORMAT::BINARY) {
+			record(LOG_LEVEL::DEBUG, format, false, argptr);
+		} else {
+			Serial.print(F("DEBUG: "));
+			log(format, argptr);
+		}
 		//va_end(argptr);
 	}
 }
@@ -43,8 +120,12 @@ void SerialLogger::info(const char *format, ...) {
 		va_list argptr;
 		va_start(argptr, format);
 
-		Serial.print(F("INFO:  "));
-		log(format, argptr);
+		if (logFormat == LOG_FORMAT::BINARY) {
+			record(LOG_LEVEL::INFO, format, false, argptr);
+		} else {
+			Serial.print(F("INFO:  "));
+			log(format, argptr);
+		}
 		//va_end(argptr);
 	}
 }
@@ -54,8 +135,12 @@ void SerialLogger::warn(const char *format, ...) {
 		va_list argptr;
 		va_start(argptr, format);
 
-		Serial.print(F("WARN:  "));
-		log(format, argptr);
+		if (logFormat == LOG_FORMAT::BINARY) {
+			record(LOG_LEVEL::WARNING, format, false, argptr);
+		} else {
+			Serial.print(F("WARN:  "));
+			log(format, argptr);
+		}
 		//va_end(argptr);
 	}
 }
@@ -65,8 +150,12 @@ void SerialLogger::error(const char *format, ...) {
 		va_list argptr;
 		va_start(argptr, format);
 
-		Serial.print(F("ERROR: "));
-		log(format, argptr);
+		if (logFormat == LOG_FORMAT::BINARY) {
+			record(LOG_LEVEL::ERROR, format, false, argptr);
+		} else {
+			Serial.print(F("ERROR: "));
+			log(format, argptr);
+		}
 		//va_end(argptr);
 	}
 }
@@ -76,8 +165,12 @@ void SerialLogger::trace(const __FlashStringHelper *format, ...) {
 		va_list argptr;
 		va_start(argptr, format);
 
-		Serial.print(F("TRACE: "));
-		log(format, argptr);
+		if (logFormat == LOG_FORMAT::BINARY) {
+			record(LOG_LEVEL::TRACE, reinterpret_cast<const char *>(format), true, argptr);
+		} else {
+			Serial.print(F("TRACE: "));
+			log(format, argptr);
+		}
 	}
 }
 
@@ -86,8 +179,12 @@ void SerialLogger::debug(const __FlashStringHelper *format, ...) {
 		va_list argptr;
 		va_start(argptr, format);
 
-		Serial.print(F("DEBUG: "));
-		log(format, argptr);
+		if (logFormat == LOG_FORMAT::BINARY) {
+			record(LOG_LEVEL::DEBUG, reinterpret_cast<const char *>(format), true, argptr);
+		} else {
+			Serial.print(F("DEBUG: "));
+			log(format, argptr);
+		}
 	}
 }
 
@@ -96,8 +193,12 @@ void SerialLogger::info(const __FlashStringHelper *format, ...) {
 		va_list argptr;
 		va_start(argptr, format);
 
-		Serial.print(F("INFO: "));
-		log(format, argptr);
+		if (logFormat == LOG_FORMAT::BINARY) {
+			record(LOG_LEVEL::INFO, reinterpret_cast<const char *>(format), true, argptr);
+		} else {
+			Serial.print(F("INFO: "));
+			log(format, argptr);
+		}
 	}
 }
 
@@ -106,8 +207,12 @@ void SerialLogger::warn(const __FlashStringHelper *format, ...) {
 		va_list argptr;
 		va_start(argptr, format);
 
-		Serial.print(F("WARN: "));
-		log(format, argptr);
+		if (logFormat == LOG_FORMAT::BINARY) {
+			record(LOG_LEVEL::WARNING, reinterpret_cast<const char *>(format), true, argptr);
+		} else {
+			Serial.print(F("WARN: "));
+			log(format, argptr);
+		}
 	}
 }
 
@@ -116,8 +221,12 @@ void SerialLogger::error(const __FlashStringHelper *format, ...) {
 		va_list argptr;
 		va_start(argptr, format);
 
-		Serial.print(F("ERROR: "));
-		log(format, argptr);
+		if (logFormat == LOG_FORMAT::BINARY) {
+			record(LOG_LEVEL::ERROR, reinterpret_cast<const char *>(format), true, argptr);
+		} else {
+			Serial.print(F("ERROR: "));
+			log(format, argptr);
+		}
 	}
 }
 
@@ -129,7 +238,7 @@ void SerialLogger::log(const char *format, va_list argptr) {
 		} else {
 			if (formatSpecifier) {
 				if (*c == 's') {
-					Serial.print((char *) va_arg(argptr, int));
+					Serial.print(va_arg(argptr, char *));
 				} else if (*c == 'd' || *c == 'i') {
 					Serial.print(va_arg(argptr, int), DEC);
 				} else if (*c == 'x') {
@@ -162,7 +271,7 @@ void SerialLogger::log(const __FlashStringHelper *format, va_list argptr) {
 		} else {
 			if (formatSpecifier) {
 				if (c == 's') {
-					Serial.print((char *) va_arg(argptr, int));
+					Serial.print(va_arg(argptr, char *));
 				} else if (c == 'd' || c == 'i') {
 					Serial.print(va_arg(argptr, int), DEC);
 				} else if (c == 'x') {
@@ -186,6 +295,100 @@ void SerialLogger::log(const __FlashStringHelper *format, va_list argptr) {
 	Serial.println();
 }
 
+void SerialLogger::record(const LOG_LEVEL level, const char *format, const bool flash, va_list argptr) {
+	uint8_t record[RECORD_MAX_SIZE];
+	uint8_t size = 2;
+	record[size++] = flash ? level : level | RECORD_INLINE_FORMAT;
+	size = putUint32(record, size, micros());
+	if (flash) {
+		size = putUint32(record, size, reinterpret_cast<uintptr_t>(format));
+	} else {
+		for (const char *c = format; *c != '\0' && size < RECORD_MAX_SIZE - 1; c++) {
+			record[size++] = *c;
+		}
+		record[size++] = '\0';
+	}
+
+	// the arguments as announced by the format, i. e. the very same as the text log consumes
+	bool formatSpecifier = false;
+	bool fits = true;
+	for (const char *c = format; fits && formatAt(c, flash) != '\0'; c++) {
+		const char specifier = formatAt(c, flash);
+		if (specifier == '%') {
+			formatSpecifier = true;
+		} else {
+			if (formatSpecifier) {
+				if (specifier == 's') {
+					const char *value = va_arg(argptr, char *);
+					fits = size < RECORD_MAX_SIZE;
+					for (; fits && value != nullptr && *value != '\0' && size < RECORD_MAX_SIZE - 1; value++) {
+						record[size++] = *value;
+					}
+					if (fits) {
+						record[size++] = '\0';
+					}
+				} else if (specifier == 'd' || specifier == 'i' || specifier == 'x' || specifier == 'b' ||
+						   specifier == 'c' || specifier == 'l' || specifier == 'f') {
+					uint32_t value;
+					if (specifier == 'l') {
+						value = static_cast<uint32_t>(va_arg(argptr, long));
+					} else if (specifier == 'f') {
+						const float f = static_cast<float>(va_arg(argptr, double));
+						memcpy(&value, &f, sizeof value);
+					} else {
+						value = static_cast<uint32_t>(static_cast<long>(va_arg(argptr, int)));
+					}
+					fits = size + 4 <= RECORD_MAX_SIZE;
+					if (fits) {
+						size = putUint32(record, size, value);
+					}
+				}
+			}
+			formatSpecifier = false;
+		}
+	}
+
+	record[0] = RECORD_SYNC;
+	record[1] = size - 2;
+	put(record, size);
+}
+
+void SerialLogger::put(const uint8_t *record, const uint8_t size) {
+	ENTER_CRITICAL();
+	const BufferIndex consumed = tail;
+	BufferIndex produced = head;
+	// one byte stays free to tell a full from an empty buffer
+	const int free = (consumed - produced - 1) & (SERIAL_LOGGER_BUFFER_SIZE - 1);
+	const int required = droppedRecords > 0 ? size + k_dropped_record_size : size;
+	if (required > free) {
+		droppedRecords++;
+	} else {
+		uint8_t dropped[k_dropped_record_size];
+		if (droppedRecords > 0) {
+			uint8_t dropped_size = 2;
+			dropped[dropped_size++] = LOG_LEVEL::NONE;
+			// the micros of the record following the dropped ones
+			memcpy(&dropped[dropped_size], &record[3], 4);
+			dropped_size += 4;
+			dropped_size = putUint32(dropped, dropped_size, droppedRecords);
+			dropped[0] = RECORD_SYNC;
+			dropped[1] = dropped_size - 2;
+			droppedRecords = 0;
+		}
+		for (int i = required - size; i > 0; i--) {
+			buffer[produced] = dropped[k_dropped_record_size - i];
+			produced = (produced + 1) & (SERIAL_LOGGER_BUFFER_SIZE - 1);
+		}
+		for (uint8_t i = 0; i < size; i++) {
+			buffer[produced] = record[i];
+			produced = (produced + 1) & (SERIAL_LOGGER_BUFFER_SIZE - 1);
+		}
+		// publish the record to flush
+		head = produced;
+	}
+	EXIT_CRITICAL();
+}
+
 bool SerialLogger::isBelow(const LOG_LEVEL logLevel) {
-	return SerialLogger::logLevel <= logLevel;
+	return logLevel >= SERIAL_LOGGER_MIN_LEVEL && SerialLogger::logLevel <= logLevel;
 }
@@ -3,6 +3,15 @@
 
 #include <Arduino.h>
 
+// Ring buffer of the binary log records; a power of 2 of at most 256 bytes on 8 bit mcus
+#ifndef SERIAL_LOGGER_BUFFER_SIZE
+#if defined(ARDUINO_ARCH_AVR)
+#define SERIAL_LOGGER_BUFFER_SIZE 128
+#else
+#define SERIAL_LOGGER_BUFFER_SIZE 1024
+#endif
+#endif
+
 class SerialLogger {
 public:
 
@@ -15,12 +24,44 @@ public:
 		NONE
 	};
 
+	/**
+	 * TEXT: Format each log line right away and print it to Serial char by char, i. e. the caller blocks until
+	 * Serial took all of it (roughly 1 ms per char at 9600 baud once the tx buffer of Serial is full).
+	 * BINARY: Put a compact record (level, micros, address of the format string and the raw arguments) into a ring
+	 * buffer. flush() hands the records to Serial later on and lawnmover_host/tools/log_decoder.cpp rebuilds the text
+	 * from the format strings of the firmware elf file. Records not fitting into the ring buffer are dropped and
+	 * counted.
+	 */
+	enum LOG_FORMAT {
+		TEXT,
+		BINARY
+	};
+
+	/**
+	 * A binary record is RECORD_SYNC, the length of the remainder, the level (| RECORD_INLINE_FORMAT), micros and the
+	 * address of the format string followed by the arguments. Format strings which are not F() strings are put into
+	 * the record right away instead of their address (RECORD_INLINE_FORMAT). Integers are 4 bytes little endian, %f is
+	 * a 4 byte float and %s a zero terminated string. Arguments not fitting into RECORD_MAX_SIZE are cut off. A record
+	 * with level NONE holds the amount of records dropped (4 bytes) before it.
+	 */
+	static const uint8_t RECORD_SYNC = 0xA5;
+	static const uint8_t RECORD_INLINE_FORMAT = 0x80;
+	static const uint8_t RECORD_MAX_SIZE = 64;
+
 	SerialLogger() = delete;
 
 	static void init(const int speed);
 
 	static void init(const int speed, const LOG_LEVEL logLevel);
 
+	static void init(const int speed, const LOG_LEVEL logLevel, const LOG_FORMAT logFormat);
+
+	/**
+	 * Hand as many buffered binary records to Serial as it takes without blocking. Call it from the loop; it does
+	 * nothing for LOG_FORMAT::TEXT.
+	 */
+	static void flush();
+
 	static void trace(const char *format, ...);
 
 	static void debug(const char *format, ...);
@@ -41,14 +82,74 @@ public:
 
 	static void error(const __FlashStringHelper *format, ...);
 
+	// whether calls of the given level get logged, i. e. neither the compile-time nor the runtime level filter them
 	static bool isBelow(const LOG_LEVEL logLevel);
 
 private:
+#if SERIAL_LOGGER_BUFFER_SIZE <= 256
+	// loads and stores of a single byte cannot tear on 8 bit mcus either
+	typedef uint8_t BufferIndex;
+#else
+	typedef uint16_t BufferIndex;
+#endif
+
 	static LOG_LEVEL logLevel;
+	static LOG_FORMAT logFormat;
+
+	// Only the producers (any log call) move the head and only flush moves the tail
+	static uint8_t *buffer;
+	static volatile BufferIndex head;
+	static volatile BufferIndex tail;
+	static volatile uint32_t droppedRecords;
 
 	static void log(const char *format, va_list argptr);
 
 	static void log(const __FlashStringHelper *format, va_list argptr);
+
+	static void record(const LOG_LEVEL level, const char *format, const bool flash, va_list argptr);
+
+	static void put(const uint8_t *record, const uint8_t size);
 };
 
+/**
+ * Compile-time minimum log level as a number of SerialLogger::LOG_LEVEL (0 TRACE, 1 DEBUG, 2 INFO, 3 WARNING, 4 ERROR,
+ * 5 NONE). The preprocessor drops any SERIAL_LOGGER_* call below it, i. e. the call, the evaluation of its arguments
+ * and its F() string are not part of the firmware at all. Thus, the arguments of a log call must not have side
+ * effects. Override it per build (e. g. -DSERIAL_LOGGER_MIN_LEVEL=0 to trace); the log level passed to init only
+ * filters the remaining calls.
+ */
+#ifndef SERIAL_LOGGER_MIN_LEVEL
+#define SERIAL_LOGGER_MIN_LEVEL 1
+#endif
+
+#if SERIAL_LOGGER_MIN_LEVEL <= 0
+#define SERIAL_LOGGER_TRACE(...) SerialLogger::trace(__VA_ARGS__)
+#else
+#define SERIAL_LOGGER_TRACE(...) ((void) 0)
+#endif
+
+#if SERIAL_LOGGER_MIN_LEVEL <= 1
+#define SERIAL_LOGGER_DEBUG(...) SerialLogger::debug(__VA_ARGS__)
+#else
+#define SERIAL_LOGGER_DEBUG(...) ((void) 0)
+#endif
+
+#if SERIAL_LOGGER_MIN_LEVEL <= 2
+#define SERIAL_LOGGER_INFO(...) SerialLogger::info(__VA_ARGS__)
+#else
+#define SERIAL_LOGGER_INFO(...) ((void) 0)
+#endif
+
+#if SERIAL_LOGGER_MIN_LEVEL <= 3
+#define SERIAL_LOGGER_WARN(...) SerialLogger::warn(__VA_ARGS__)
+#else
+#define SERIAL_LOGGER_WARN(...) ((void) 0)
+#endif
+
+#if SERIAL_LOGGER_MIN_LEVEL <= 4
+#define SERIAL_LOGGER_ERROR(...) SerialLogger::error(__VA_ARGS__)
+#else
+#define SERIAL_LOGGER_ERROR(...) ((void) 0)
+#endif
+
 #endif // SERIALLOGGER_H
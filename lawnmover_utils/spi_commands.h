@@ -12,83 +12,130 @@
 
 #define COMMUNICATION_START_SEQUENCE_LENGTH 9
 
+// Compact frame (see SpiCommands::getCompactFrameSize), version 1. A legacy frame starts with the low byte of an id
+// (or of the start sequence), which never equals the marker.
+#define COMPACT_FRAME_MARKER (uint8_t) 0xC1
+// Pipelined frame (see SpiCommands::getPipelinedFrameSize), version 2
+#define PIPELINED_FRAME_MARKER (uint8_t) 0xC2
+#define COMPACT_FRAME_HEADER_SIZE 4
+#define COMPACT_FRAME_CRC_SIZE 1
+#define COMPACT_FRAME_CRC_INIT (uint8_t) 0xFF
+
+// commands per slave; their ids are consecutive
 #define ENGINE_COMMANDS 3
-#define LEFT_WHEEL_STEERING_COMMAND (int16_t) 1
-#define RIGHT_WHEEL_STEERING_COMMAND (int16_t) 2
-#define MOTOR_SPEED_COMMAND (int16_t) 3
 #define OBSTACLE_COMMANDS 5
-#define OBSTACLE_FRONT_COMMAND (int16_t) 4
-#define OBSTACLE_FRONT_LEFT_COMMAND (int16_t) 5
-#define OBSTACLE_FRONT_RIGHT_COMMAND (int16_t) 6
-#define OBSTACLE_BACK_LEFT_COMMAND (int16_t) 7
-#define OBSTACLE_BACK_RIGHT_COMMAND (int16_t) 8
 #define GYRO_COMMANDS 0
-#define MAX_ID (int16_t) 8
 
-#define DATA_REQUEST_VALUE_BYTES (long) 0xFFFFFFFF
+#define DATA_REQUEST_VALUE_BYTES (int32_t) 0xFFFFFFFF
 
-// Could not get templates to work...
-class SpiCommand {
-public:
-	SpiCommand() = delete;
+// an age of a distance sample this old or older
+#define DISTANCE_SAMPLE_MAX_AGE_MILLIS (uint16_t) 0xFFFF
 
-	SpiCommand(const int id) :
-			k_id(id) {
-		// nothing to do here...
-	};
+/**
+ * Ids of the spi commands. Add new commands to SpiCommandTable, too.
+ */
+enum SpiCommandId : int16_t {
+	NO_COMMAND = 0,
+	LEFT_WHEEL_STEERING_COMMAND = 1,
+	RIGHT_WHEEL_STEERING_COMMAND = 2,
+	MOTOR_SPEED_COMMAND = 3,
+	OBSTACLE_FRONT_COMMAND = 4,
+	OBSTACLE_FRONT_LEFT_COMMAND = 5,
+	OBSTACLE_FRONT_RIGHT_COMMAND = 6,
+	OBSTACLE_BACK_LEFT_COMMAND = 7,
+	OBSTACLE_BACK_RIGHT_COMMAND = 8,
+	AMOUNT_SPI_COMMANDS
+};
 
-	int getId() {
-		return k_id;
-	};
+enum SpiValueType : uint8_t {
+	NO_VALUE, INT16_VALUE, DISTANCE_SAMPLE_VALUE
+};
 
-private:
-	const int k_id;
+enum SpiCommandDirection : uint8_t {
+	// the master sends the value, the slave echoes it
+	DATA_PUSH,
+	// the master sends DATA_REQUEST_VALUE_BYTES, the slave answers with the value
+	DATA_REQUEST
 };
 
-class LongSpiCommand : public SpiCommand {
-public:
-	using SpiCommand::SpiCommand;
+/**
+ * Value of the obstacle commands: the distance and how long ago the slave measured it (at the time it answered the
+ * request). Both fit into the 4 value bytes of a frame: the distance in mm and the age in ms as little endian uint16
+ * each. Both saturate, i. e. an age of DISTANCE_SAMPLE_MAX_AGE_MILLIS means at least as old.
+ */
+struct DistanceSample {
+	uint16_t distance_millimeters;
+	uint16_t age_millis;
 
-	long interpretBytes(const byte bytes[]) {
-		long value;
-		memcpy(&value, bytes, sizeof(value));
-		return value;
+	static DistanceSample from(const float distance, const unsigned long age_millis) {
+		const float distance_millimeters = distance * 10.0f + 0.5f;
+		DistanceSample sample;
+		sample.distance_millimeters = distance_millimeters <= 0.0f ? 0 : (distance_millimeters >= 65535.0f ? 65535 :
+																		  (uint16_t) distance_millimeters);
+		sample.age_millis = age_millis >= DISTANCE_SAMPLE_MAX_AGE_MILLIS ? DISTANCE_SAMPLE_MAX_AGE_MILLIS
+																		 : (uint16_t) age_millis;
+		return sample;
 	};
-};
-
-class FloatSpiCommand : public SpiCommand {
-public:
-	using SpiCommand::SpiCommand;
 
-	static float interpretBytes(const byte bytes[]) {
-		float value;
-		memcpy(&value, bytes, sizeof(value));
-		return value;
+	// in cm as all distances
+	float getDistance() const {
+		return distance_millimeters / 10.0f;
 	};
 };
 
-class IntegerSpiCommand : public SpiCommand {
+struct SpiCommandSpec {
+	SpiCommandId id;
+	const char *name;
+	SpiValueType type;
+	// bytes the value takes in a compact frame (at most COMMAND_FRAME_VALUE_SIZE)
+	uint8_t value_size;
+	SpiCommandDirection direction;
+};
+
+/**
+ * All spi commands, indexed by their id. Masters and slaves look the commands up by id and keep their callbacks in
+ * arrays indexed by id, too, i. e. dispatching a command takes the same time no matter how many commands there are.
+ */
+class SpiCommandTable {
 public:
-	using SpiCommand::SpiCommand;
+	// by SpiCommandId
+	static constexpr SpiCommandSpec k_commands[AMOUNT_SPI_COMMANDS] = {
+			{NO_COMMAND, "<unknown>", NO_VALUE, 0, DATA_PUSH},
+			{LEFT_WHEEL_STEERING_COMMAND, "LEFT_WHEEL_STEERING", INT16_VALUE, sizeof(int16_t), DATA_PUSH},
+			{RIGHT_WHEEL_STEERING_COMMAND, "RIGHT_WHEEL_STEERING", INT16_VALUE, sizeof(int16_t), DATA_PUSH},
+			{MOTOR_SPEED_COMMAND, "MOTOR_SPEED", INT16_VALUE, sizeof(int16_t), DATA_PUSH},
+			{OBSTACLE_FRONT_COMMAND, "OBSTACLE_FRONT", DISTANCE_SAMPLE_VALUE, sizeof(DistanceSample), DATA_REQUEST},
+			{OBSTACLE_FRONT_LEFT_COMMAND, "OBSTACLE_FRONT_LEFT", DISTANCE_SAMPLE_VALUE, sizeof(DistanceSample),
+					DATA_REQUEST},
+			{OBSTACLE_FRONT_RIGHT_COMMAND, "OBSTACLE_FRONT_RIGHT", DISTANCE_SAMPLE_VALUE, sizeof(DistanceSample),
+					DATA_REQUEST},
+			{OBSTACLE_BACK_LEFT_COMMAND, "OBSTACLE_BACK_LEFT", DISTANCE_SAMPLE_VALUE, sizeof(DistanceSample),
+					DATA_REQUEST},
+			{OBSTACLE_BACK_RIGHT_COMMAND, "OBSTACLE_BACK_RIGHT", DISTANCE_SAMPLE_VALUE, sizeof(DistanceSample),
+					DATA_REQUEST}
+	};
 
-	static int16_t interpretBytes(const byte bytes[]) {
-		int16_t value;
-		memcpy(&value, bytes, sizeof(value));
-		return value;
+	static constexpr bool isKnown(const int16_t id) {
+		return id > NO_COMMAND && id < AMOUNT_SPI_COMMANDS;
 	};
-};
 
-class BoolSpiCommand : public SpiCommand {
-public:
-	using SpiCommand::SpiCommand;
+	// NO_COMMAND if the id is unknown
+	static constexpr const SpiCommandSpec &get(const int16_t id) {
+		return k_commands[isKnown(id) ? id : (int16_t) NO_COMMAND];
+	};
 
-	static bool interpretBytes(const byte bytes[]) {
-		bool value;
-		memcpy(&value, bytes, sizeof(value));
-		return value;
+	// whether each command is at the index of its id and its value fits into a legacy frame
+	static constexpr bool isConsistent(const int id = 0) {
+		return id == AMOUNT_SPI_COMMANDS ||
+			   (k_commands[id].id == id && k_commands[id].value_size <= COMMAND_FRAME_VALUE_SIZE &&
+				(id == NO_COMMAND) == (k_commands[id].type == NO_VALUE) && isConsistent(id + 1));
 	};
+
+	SpiCommandTable() = delete;
 };
 
+static_assert(SpiCommandTable::isConsistent(), "Spi commands must be ordered by id and fit into a frame");
+
 class SpiCommands {
 public:
 	template<typename T>
@@ -99,12 +146,210 @@ public:
 
 	static int verifyIds(const byte rxIdBytes[], const byte txIdBytes[]);
 
-	static const char *getNameFromId(const int16_t id);
+	static const char *getNameFromId(const int16_t id) {
+		return SpiCommandTable::get(id).name;
+	};
+
+	/**
+	 * Bytes the value of a command takes in a compact frame: the size of the type its callbacks interpret, i. e.
+	 * int16_t for the engine commands and DistanceSample for the obstacle commands.
+	 *
+	 * @return 0 if the id is unknown
+	 */
+	static uint8_t getValueSizeFromId(const int16_t id) {
+		return SpiCommandTable::get(id).value_size;
+	};
+
+	/**
+	 * A compact frame holds the commands of amount consecutive ids starting at firstId:
+	 *
+	 *   marker (version) | sequence | first id | amount | value of each id, packed | crc-8 | 0xFF
+	 *
+	 * The slave answers each byte with the one of its own frame, i. e. one byte later: the echo of the header, the
+	 * values (requested ones or the echo of pushed ones) and the crc-8 of its own bytes. The trailing 0xFF clocks out
+	 * this crc (see COMMAND_SPI_RX_OFFSET).
+	 *
+	 * @return the size of the frame or -1 if an id is unknown
+	 */
+	static long getCompactFrameSize(const int16_t firstId, const int amount);
+
+	/**
+	 * A pipelined frame is a compact frame without the trailing byte. The slave does not answer it byte by byte but
+	 * sends the frame its loop staged meanwhile: the answer to the previous frame, i. e. its header, the values
+	 * (requested ones or the echo of pushed ones) and the crc-8. The slave preloads the marker of its answer, thus, the
+	 * master receives it in line with its own bytes.
+	 *
+	 * @return the size of the frame or -1 if an id is unknown
+	 */
+	static long getPipelinedFrameSize(const int16_t firstId, const int amount);
+
+	/**
+	 * Put the header of a compact (COMPACT_FRAME_MARKER) or pipelined (PIPELINED_FRAME_MARKER) frame
+	 *
+	 * @return the crc-8 of the header to continue with the values (see putCompactValueToBuffer)
+	 */
+	static uint8_t putCompactFrameHeader(const uint8_t marker, const uint8_t sequence, const int16_t firstId,
+										 const uint8_t amount, uint8_t *buffer);
+
+	/**
+	 * Put the value of the command id at offset of a compact frame and continue the crc-8 of the frame with its bytes,
+	 * thus, the values must be put in the order of their ids. Values larger than the value size of the id (e. g. int
+	 * for int16_t) keep their leading bytes only.
+	 *
+	 * @return the offset of the next value
+	 */
+	template<typename T>
+	static long putCompactValueToBuffer(const int16_t id, const long offset, const T value, uint8_t *buffer,
+										uint8_t &crc);
+
+	/**
+	 * Put the crc-8 of the header and values and the trailing byte to the end of a compact frame of frameSize bytes
+	 */
+	static void putCompactFrameTrailer(uint8_t *buffer, const long frameSize, const uint8_t crc);
+
+	/**
+	 * Put the crc-8 of the header and values to the end of a pipelined frame of frameSize bytes
+	 */
+	static void putPipelinedFrameTrailer(uint8_t *buffer, const long frameSize, const uint8_t crc);
+
+	// computes the crc-8 of the header and values
+	static void putPipelinedFrameTrailer(uint8_t *buffer, const long frameSize);
+
+	// offset of the value of the command at index from the start of a compact frame
+	static long getCompactValueOffset(const int16_t firstId, const int index);
+
+	// crc-8 with the polynomial 0x07 (table driven as the slaves update it byte by byte in their interrupt routines)
+	static uint8_t updateCrc8(const uint8_t crc, const uint8_t data) {
+		return pgm_read_byte(&CRC8_TABLE[crc ^ data]);
+	};
+
+	static uint8_t updateCrc8(uint8_t crc, const uint8_t *bytes, const long length) {
+		for (long i = 0; i < length; i++) {
+			crc = updateCrc8(crc, bytes[i]);
+		}
+		return crc;
+	};
+
+	static uint8_t computeCrc8(const uint8_t *bytes, const long length) {
+		return updateCrc8(COMPACT_FRAME_CRC_INIT, bytes, length);
+	};
 
 	static uint8_t COMMUNICATION_START_SEQUENCE[];
 
 private:
-	static SpiCommand getCommandFrom(const int id);
+	static const uint8_t CRC8_TABLE[256] PROGMEM;
+};
+
+/**
+ * A legacy command of the master and the answer of the slave read in place, i. e. without copying their bytes. The
+ * slave acks the id of the request with both of its ids and echoes the value of a data push.
+ */
+class LegacyCommandView {
+public:
+	// the answer starts COMMAND_SPI_RX_OFFSET bytes after the request in the rx buffer
+	LegacyCommandView(const uint8_t *request, const uint8_t *answer) : _request(request), _answer(answer) {
+		// nothing to do...
+	};
+
+	int16_t getRequestId() const {
+		return readId(_request);
+	};
+
+	// -1 requests the ack of the id
+	int16_t getRequestAckId() const {
+		return readId(_request + COMMAND_FRAME_ID_SIZE + COMMAND_FRAME_VALUE_SIZE);
+	};
+
+	int16_t getAnswerId() const {
+		return readId(_answer);
+	};
+
+	int16_t getAnswerAckId() const {
+		return readId(_answer + COMMAND_FRAME_ID_SIZE + COMMAND_FRAME_VALUE_SIZE);
+	};
+
+	const uint8_t *getAnswerValueBytes() const {
+		return _answer + COMMAND_FRAME_ID_SIZE;
+	};
+
+	bool echoesValue() const {
+		return memcmp(_answer + COMMAND_FRAME_ID_SIZE, _request + COMMAND_FRAME_ID_SIZE, COMMAND_FRAME_VALUE_SIZE) == 0;
+	};
+
+private:
+	static int16_t readId(const uint8_t *bytes) {
+		int16_t id;
+		memcpy(&id, bytes, sizeof(id));
+		return id;
+	};
+
+	const uint8_t *_request;
+	const uint8_t *_answer;
+};
+
+/**
+ * A compact or pipelined frame of the master and the frame of the slave answering it read in place. The values are
+ * packed in the order of the ids (see SpiCommands::getCompactFrameSize).
+ */
+class CompactFrameView {
+public:
+	// the frame of the slave has its crc at crcIndex
+	CompactFrameView(const uint8_t *request, const uint8_t *answer, const long crcIndex) :
+			_request(request), _answer(answer), k_crc_index(crcIndex) {
+		// nothing to do...
+	};
+
+	// starts the crc-8 of the answer with the header
+	bool echoesHeader(uint8_t &crc) const {
+		crc = COMPACT_FRAME_CRC_INIT;
+		return echoesBytes(0, COMPACT_FRAME_HEADER_SIZE, crc);
+	};
+
+	// with the crc-8 of the header and values of the answer
+	bool hasValidCrc(const uint8_t crc) const {
+		return crc == _answer[k_crc_index];
+	};
+
+	uint8_t getSequence() const {
+		return _request[1];
+	};
+
+	int16_t getFirstId() const {
+		return _request[2];
+	};
+
+	uint8_t getAmount() const {
+		return _request[3];
+	};
+
+	uint8_t getAnswerCrc() const {
+		return _answer[k_crc_index];
+	};
+
+	// of the value at offset from the start of the frame; continues the crc-8 of the answer with the value
+	bool echoesValue(const long offset, const uint8_t valueSize, uint8_t &crc) const {
+		return echoesBytes(offset, valueSize, crc);
+	};
+
+	// of the value at offset from the start of the frame
+	const uint8_t *getAnswerValueBytes(const long offset, const uint8_t valueSize, uint8_t &crc) const {
+		crc = SpiCommands::updateCrc8(crc, _answer + offset, valueSize);
+		return _answer + offset;
+	};
+
+private:
+	bool echoesBytes(const long offset, const long size, uint8_t &crc) const {
+		bool echoes = true;
+		for (long i = offset; i < offset + size; i++) {
+			crc = SpiCommands::updateCrc8(crc, _answer[i]);
+			echoes &= _answer[i] == _request[i];
+		}
+		return echoes;
+	};
+
+	const uint8_t *_request;
+	const uint8_t *_answer;
+	const long k_crc_index;
 };
 
 template<typename T>
@@ -125,4 +370,15 @@ void SpiCommands::putCommandToBuffer(const int16_t commandId, const T commandVal
 	memcpy(buffer, bytes, COMMAND_FRAME_SIZE);
 }
 
+template<typename T>
+long SpiCommands::putCompactValueToBuffer(const int16_t id, const long offset, const T value, uint8_t *buffer,
+										  uint8_t &crc) {
+	const uint8_t value_size = getValueSizeFromId(id);
+	uint8_t *value_bytes = buffer + offset;
+	memset(value_bytes, 0, value_size);
+	memcpy(value_bytes, &value, sizeof value < value_size ? sizeof value : value_size);
+	crc = updateCrc8(crc, value_bytes, value_size);
+	return offset + value_size;
+}
+
 #endif // SPI_COMMANDS_H
@@ -0,0 +1,99 @@
+#ifndef COMMAND_MAILBOX_H
+#define COMMAND_MAILBOX_H
+
+#include <Arduino.h>
+#include <spi_commands.h>
+
+// keeps the compiler from moving memory accesses across it (a single core needs no more)
+#define COMMAND_MAILBOX_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * Lock-free single producer (e. g. the spi interrupt routine), single consumer (the loop) mailbox of the data push
+ * commands of one frame. The producer stages the commands of a frame one by one and publishes them once the frame is
+ * complete. The consumer gets the latest published frame as a whole, i. e. all commands of a snapshot stem from the
+ * very same frame. Frames published before the consumer got to them are overwritten.
+ *
+ * Publishing is a seqlock: the sequence is odd while the producer copies the staged commands and even afterwards. The
+ * consumer retries its copy if the sequence was odd or changed meanwhile, and never blocks the producer. The sequence
+ * is a single byte, thus, loading and storing it is atomic on 8 bit mcus, too.
+ */
+template<uint8_t Capacity>
+class CommandMailbox {
+public:
+	struct Command {
+		int16_t id;
+		uint8_t value_bytes[COMMAND_FRAME_VALUE_SIZE];
+	};
+
+	struct Snapshot {
+		uint8_t amount;
+		Command commands[Capacity];
+	};
+
+	/**
+	 * Producer only: Add a command to the frame being received
+	 *
+	 * @return false if the frame holds more commands than the capacity (the command is dropped)
+	 */
+	bool stage(const int16_t id, const uint8_t *value_bytes) {
+		if (_staged.amount >= Capacity) {
+			return false;
+		}
+		Command &command = _staged.commands[_staged.amount++];
+		command.id = id;
+		memcpy(command.value_bytes, value_bytes, COMMAND_FRAME_VALUE_SIZE);
+		return true;
+	};
+
+	/**
+	 * Producer only: Drop the commands staged so far (e. g. the frame got out of sync)
+	 */
+	void discard() {
+		_staged.amount = 0;
+	};
+
+	/**
+	 * Producer only: Hand the staged commands to the consumer
+	 */
+	void publish() {
+		_sequence++;
+		COMMAND_MAILBOX_BARRIER();
+		copy(_staged, _published);
+		COMMAND_MAILBOX_BARRIER();
+		_sequence++;
+		_staged.amount = 0;
+	};
+
+	/**
+	 * Consumer only: Copy the latest published frame
+	 *
+	 * @return whether the frame is newer than the one consumed last time
+	 */
+	bool consume(Snapshot &snapshot) {
+		uint8_t sequence = _sequence;
+		if (sequence == _consumed_sequence) {
+			return false;
+		}
+		do {
+			sequence = _sequence;
+			COMMAND_MAILBOX_BARRIER();
+			copy(_published, snapshot);
+			COMMAND_MAILBOX_BARRIER();
+		} while ((sequence & 1) != 0 || sequence != _sequence);
+		_consumed_sequence = sequence;
+		return true;
+	};
+
+private:
+	static void copy(const Snapshot &from, Snapshot &to) {
+		to.amount = from.amount;
+		memcpy(to.commands, from.commands, from.amount * sizeof *from.commands);
+	};
+
+	Snapshot _staged = {};
+	Snapshot _published = {};
+	volatile uint8_t _sequence = 0;
+	uint8_t _consumed_sequence = 0;
+};
+
+#endif // COMMAND_MAILBOX_H
@@ -6,23 +6,39 @@
 #include <serial_logger.h>
 #include <spi_commands.h>
 
+#include "command_mailbox.h"
+
 int _commands_size;
 int _buffer_counter = 0;
 uint8_t *_rx_buffer;
 uint8_t *_tx_buffer;
 
-bool _synchronized = false;
-int _amount_data_push_command_callbacks;
-bool (**_data_push_command_callbacks)(int16_t, int16_t);
-int _amount_data_request_command_callbacks;
+volatile bool _synchronized = false;
+CommandMailbox<MAX_DATA_PUSH_COMMANDS_PER_FRAME> _data_push_mailbox;
+// by command id (see SpiCommandTable); nullptr if the slave does not handle the command
+bool (*_data_push_command_callbacks[AMOUNT_SPI_COMMANDS])(int16_t, int16_t) = {};
+bool (*_data_request_command_callbacks[AMOUNT_SPI_COMMANDS])(int16_t, uint8_t *) = {};
 
-bool (**_data_request_command_callbacks)(int16_t, uint8_t *);
+bool SpiSlave::putDataPushCallback(const int16_t id, bool (*callback)(int16_t, int16_t)) {
+	if (!SpiCommandTable::isKnown(id) || SpiCommandTable::get(id).direction != DATA_PUSH) {
+		SERIAL_LOGGER_ERROR(F("%d is no data push command"), id);
+		return false;
+	}
+	_data_push_command_callbacks[id] = callback;
+	return true;
+}
+
+bool SpiSlave::putDataRequestCallback(const int16_t id, bool (*callback)(int16_t, uint8_t *)) {
+	if (!SpiCommandTable::isKnown(id) || SpiCommandTable::get(id).direction != DATA_REQUEST) {
+		SERIAL_LOGGER_ERROR(F("%d is no data request command"), id);
+		return false;
+	}
+	_data_request_command_callbacks[id] = callback;
+	return true;
+}
 
 void SpiSlave::ISRfromArgs(const int sck_pin, const int miso_pin, const int mosi_pin, const int ss_pin,
-						   bool (*data_push_command_callbacks[])(int16_t, int16_t),
-						   const int amount_data_push_command_callbacks,
-						   bool (*data_request_command_callbacks[])(int16_t, uint8_t *),
-						   const int amount_data_request_command_callbacks, const int buffer_length) {
+						   const int buffer_length) {
 	pinMode(sck_pin, INPUT);
 	pinMode(mosi_pin, INPUT);
 	pinMode(miso_pin, OUTPUT);
@@ -47,11 +63,6 @@ void SpiSlave::ISRfromArgs(const int sck_pin, const int miso_pin, const int mosi
 	// turn on interrupts
 	SPCR |= bit(SPIE);
 
-	_data_push_command_callbacks = data_push_command_callbacks;
-	_amount_data_push_command_callbacks = amount_data_push_command_callbacks;
-	_data_request_command_callbacks = data_request_command_callbacks;
-	_amount_data_request_command_callbacks = amount_data_request_command_callbacks;
-
 	_commands_size = buffer_length;
 	_rx_buffer = (uint8_t *) calloc(_commands_size, sizeof *_rx_buffer);
 	_tx_buffer = (uint8_t *) calloc(_commands_size, sizeof *_tx_buffer);
@@ -72,7 +83,7 @@ void synchronize(const uint8_t rx_byte, uint8_t &tx_byte) {
 				_synchronized = true;
 				return;
 			} else {
-				SerialLogger::trace(F("Bad end-of-sequence-byte was %x != %x"), rx_byte,
+				SERIAL_LOGGER_TRACE(F("Bad end-of-sequence-byte was %x != %x"), rx_byte,
 									SpiCommands::COMMUNICATION_START_SEQUENCE[_current_command_cursor]);
 			}
 		} else {
@@ -81,19 +92,30 @@ void synchronize(const uint8_t rx_byte, uint8_t &tx_byte) {
 		}
 	} else {
 		_current_command_cursor = 0;
-		SerialLogger::trace(F("Bad sync-sequence-byte was %x != %x"), rx_byte,
+		SERIAL_LOGGER_TRACE(F("Bad sync-sequence-byte was %x != %x"), rx_byte,
 							SpiCommands::COMMUNICATION_START_SEQUENCE[_current_command_cursor]);
 	}
 	_synchronized = false;
 }
 
+/*
+    Let the callback of a data request command (if any) fill the value bytes
+
+    @return whether the command is a data request the slave answered
+*/
+bool request_data(const int16_t id, uint8_t *value_bytes) {
+	const SpiCommandSpec &command = SpiCommandTable::get(id);
+	bool (*callback)(int16_t, uint8_t *) = _data_request_command_callbacks[command.id];
+	return command.direction == DATA_REQUEST && callback != nullptr && (*callback)(id, value_bytes);
+}
+
 bool check_and_set_id() {
 	memcpy(&_current_command_id, _current_command_id_bytes, sizeof(_current_command_id));
 	if (_current_command_id <= 0) {
-		SerialLogger::error(F("Bad Id Received. %d is unknown"), _current_command_id);
+		SERIAL_LOGGER_ERROR(F("Bad Id Received. %d is unknown"), _current_command_id);
 		return false;
-	} else if (_current_command_id > MAX_ID) {
-		SerialLogger::warn(F("Received bad id %d > %d (max)"), _current_command_id, MAX_ID);
+	} else if (!SpiCommandTable::isKnown(_current_command_id)) {
+		SERIAL_LOGGER_WARN(F("Received unknown id %d"), _current_command_id);
 		return false;
 	} else {
 		return true;
@@ -113,6 +135,14 @@ bool process_partial_command(const uint8_t rx_byte, uint8_t &tx_byte) {
 	} else if (_current_command_cursor < COMMAND_FRAME_ID_SIZE + COMMAND_FRAME_VALUE_SIZE) {
 		uint8_t write_byte = rx_byte;
 		if (_current_command_cursor == COMMAND_FRAME_ID_SIZE) {
+			if (memcmp(_current_command_id_bytes, SpiCommands::COMMUNICATION_START_SEQUENCE,
+					   COMMAND_FRAME_ID_SIZE) == 0) {
+				// the master resynchronizes in-band; the id bytes were echoed as the start sequence is, thus, go on
+				// with it instead of waiting for the next one
+				_synchronized = false;
+				synchronize(rx_byte, tx_byte);
+				return false;
+			}
 			// check&set the id and reset it if it fails
 			if (!check_and_set_id()) {
 				// Bad Req Id received; failure.
@@ -122,10 +152,7 @@ bool process_partial_command(const uint8_t rx_byte, uint8_t &tx_byte) {
 				return false;
 			}
 			// inspect for data request commands
-			for (int i = 0; i < _amount_data_request_command_callbacks && !_current_command_data_request; i++) {
-				_current_command_data_request = (*_data_request_command_callbacks[i])(_current_command_id,
-																					  _current_command_value_bytes);
-			}
+			_current_command_data_request = request_data(_current_command_id, _current_command_value_bytes);
 		}
 		if (_current_command_data_request) {
 			// This is a data request command and a callback filled the value buffer
@@ -156,6 +183,159 @@ bool process_partial_command(const uint8_t rx_byte, uint8_t &tx_byte) {
 	return false;
 }
 
+// state of the compact frame being received (if any)
+bool _compact_frame = false;
+int16_t _compact_first_id = -1;
+uint8_t _compact_amount = 0;
+uint8_t _compact_value_index = 0;
+uint8_t _compact_value_cursor = 0;
+uint8_t _compact_value_size = 0;
+int _compact_crc_cursor = 0;
+uint8_t _compact_rx_crc = COMPACT_FRAME_CRC_INIT;
+uint8_t _compact_tx_crc = COMPACT_FRAME_CRC_INIT;
+bool _compact_frame_valid = false;
+
+void start_compact_value() {
+	_current_command_id = (int16_t) (_compact_first_id + _compact_value_index);
+	_compact_value_size = SpiCommands::getValueSizeFromId(_current_command_id);
+	_compact_value_cursor = 0;
+	_current_command_data_request = false;
+	memset(_current_command_value_bytes, 0, COMMAND_FRAME_VALUE_SIZE);
+	_current_command_data_request = request_data(_current_command_id, _current_command_value_bytes);
+}
+
+/*
+    Answers each byte of a compact frame (see SpiCommands::getCompactFrameSize) with the next byte of the own frame.
+    Pushed values are staged and published only if the crc of the master matches.
+
+    @return whether the frame is complete
+*/
+bool process_compact_frame(const uint8_t rx_byte, uint8_t &tx_byte) {
+	if (_current_command_cursor == 0) {
+		_compact_rx_crc = COMPACT_FRAME_CRC_INIT;
+		_compact_tx_crc = COMPACT_FRAME_CRC_INIT;
+		_compact_frame_valid = false;
+	}
+
+	if (_current_command_cursor < COMPACT_FRAME_HEADER_SIZE) {
+		// echo the marker, the sequence, the first id and the amount
+		if (_current_command_cursor == 2) {
+			_compact_first_id = rx_byte;
+		} else if (_current_command_cursor == 3) {
+			_compact_amount = rx_byte;
+			const long frame_size = SpiCommands::getCompactFrameSize(_compact_first_id, _compact_amount);
+			// unknown ids have no size
+			if (_compact_amount == 0 || frame_size < 0) {
+				// Bad header received; failure.
+				tx_byte = 0;
+				_synchronized = false;
+				_current_command_cursor = 0;
+				return true;
+			}
+			_compact_crc_cursor = frame_size - COMPACT_FRAME_CRC_SIZE - COMMAND_SPI_RX_OFFSET;
+			_compact_value_index = 0;
+			_compact_value_cursor = 0;
+			_data_push_mailbox.discard();
+		}
+		tx_byte = rx_byte;
+	} else if (_current_command_cursor < _compact_crc_cursor) {
+		if (_compact_value_cursor == 0) {
+			start_compact_value();
+		}
+		if (_current_command_data_request) {
+			tx_byte = _current_command_value_bytes[_compact_value_cursor];
+		} else {
+			_current_command_value_bytes[_compact_value_cursor] = rx_byte;
+			tx_byte = rx_byte;
+		}
+		_compact_value_cursor++;
+		if (_compact_value_cursor == _compact_value_size) {
+			if (!_current_command_data_request &&
+				!_data_push_mailbox.stage(_current_command_id, _current_command_value_bytes)) {
+				_synchronized = false;
+				_current_command_cursor = 0;
+				return true;
+			}
+			_compact_value_index++;
+			_compact_value_cursor = 0;
+		}
+	} else if (_current_command_cursor == _compact_crc_cursor) {
+		_compact_frame_valid = rx_byte == _compact_rx_crc;
+		tx_byte = _compact_tx_crc;
+	} else {
+		// For the master to receive the nth byte we need to send a n+1 byte
+		tx_byte = 0;
+		_current_command_cursor = 0;
+		if (_compact_frame_valid) {
+			_data_push_mailbox.publish();
+		} else {
+			// corrupted values must not reach the callbacks; the master retries with the next frame
+			_data_push_mailbox.discard();
+		}
+		return true;
+	}
+	_compact_rx_crc = SpiCommands::updateCrc8(_compact_rx_crc, rx_byte);
+	_compact_tx_crc = SpiCommands::updateCrc8(_compact_tx_crc, tx_byte);
+	_current_command_cursor++;
+	return false;
+}
+
+// Pipelined frames: the interrupt routine fills one rx buffer while the loop may read the other one. The loop stages
+// the answer to the latest frame in the tx buffer the interrupt routine does not send from.
+uint8_t _pipelined_rx_buffers[2][MAX_PIPELINED_FRAME_SIZE];
+uint8_t _pipelined_rx_filling = 0;
+volatile uint8_t _pipelined_rx_published = 0;
+// odd while the interrupt routine hands over a frame (see CommandMailbox)
+volatile uint8_t _pipelined_rx_sequence = 0;
+uint8_t _pipelined_rx_consumed_sequence = 0;
+uint8_t _pipelined_tx_buffers[2][MAX_PIPELINED_FRAME_SIZE];
+// 0xFF if nothing was staged yet
+volatile uint8_t _pipelined_tx_published = 0xFF;
+uint8_t _pipelined_tx_sending = 0xFF;
+bool _pipelined_frame = false;
+int _pipelined_frame_size = MAX_PIPELINED_FRAME_SIZE;
+
+/*
+    Copies the byte received into the rx buffer and answers with the next byte of the staged frame. No callbacks, no
+    crc; the loop does all that (see process_pipelined_frame).
+
+    @return whether the frame is complete
+*/
+bool process_pipelined_frame_byte(const uint8_t rx_byte, uint8_t &tx_byte) {
+	if (_current_command_cursor == 0) {
+		// the marker was preloaded already; keep sending from the same staged frame until the end of this frame
+		_pipelined_tx_sending = _pipelined_tx_published;
+		_pipelined_frame_size = MAX_PIPELINED_FRAME_SIZE;
+	}
+	_pipelined_rx_buffers[_pipelined_rx_filling][_current_command_cursor] = rx_byte;
+	if (_current_command_cursor == 3) {
+		_pipelined_frame_size = SpiCommands::getPipelinedFrameSize(_pipelined_rx_buffers[_pipelined_rx_filling][2],
+																   rx_byte);
+		if (_pipelined_frame_size <= COMPACT_FRAME_HEADER_SIZE ||
+			_pipelined_frame_size > MAX_PIPELINED_FRAME_SIZE) {
+			// Bad header received; failure.
+			tx_byte = 0;
+			_synchronized = false;
+			_current_command_cursor = 0;
+			return true;
+		}
+	}
+	_current_command_cursor++;
+
+	if (_current_command_cursor == _pipelined_frame_size) {
+		_pipelined_rx_sequence++;
+		_pipelined_rx_published = _pipelined_rx_filling;
+		_pipelined_rx_sequence++;
+		_pipelined_rx_filling ^= 1;
+		// preload the marker of the next answer
+		tx_byte = PIPELINED_FRAME_MARKER;
+		_current_command_cursor = 0;
+		return true;
+	}
+	tx_byte = _pipelined_tx_sending < 2 ? _pipelined_tx_buffers[_pipelined_tx_sending][_current_command_cursor] : 0;
+	return false;
+}
+
 bool post_process_spi_interrupt_routine(const uint8_t rx_byte, const uint8_t tx_byte) {
 	SPDR = tx_byte;
 	_rx_buffer[_buffer_counter] = rx_byte;
@@ -165,21 +345,14 @@ bool post_process_spi_interrupt_routine(const uint8_t rx_byte, const uint8_t tx_
 }
 
 /*
-    Call if value received by master
+    Call if value received by master (from the loop; see SpiSlave::processDataPushCommands)
 */
-template<typename V>
-void interpret_data_push_command(const int id, uint8_t *value_bytes, bool (*data_push_callbacks[])(int16_t, V),
-								 const int amount_data_push_callbacks) {
-	bool valid = false;
-	V value;
+void interpret_data_push_command(const int16_t id, uint8_t *value_bytes) {
+	int16_t value;
 	memcpy(&value, value_bytes, sizeof(value));
-	for (int i = 0; i < amount_data_push_callbacks && !valid; i++) {
-		valid = (*data_push_callbacks[i])(id, value);
-	}
-
-	if (!valid) {
-		// Logging (serial printing is faster) must be kept to an absolute minimum for this SPI routine depending on the logging baudrate.
-		SerialLogger::warn(F("Did not receive valid data push command. Cannot interpret value."));
+	bool (*callback)(int16_t, int16_t) = _data_push_command_callbacks[SpiCommandTable::get(id).id];
+	if (callback == nullptr || !(*callback)(id, value)) {
+		SERIAL_LOGGER_WARN(F("Did not receive valid data push command. Cannot interpret value."));
 		_synchronized = false;
 	}
 }
@@ -192,21 +365,113 @@ ISR (SPI_STC_vect) {
 		const uint8_t rx_byte = SPDR;
 		uint8_t tx_byte = 0;
 
-		if (_synchronized) {
+		if (_synchronized && (_pipelined_frame || (_buffer_counter == 0 && _current_command_cursor == 0 &&
+													rx_byte == PIPELINED_FRAME_MARKER))) {
+			_pipelined_frame = true;
+			const bool complete = process_pipelined_frame_byte(rx_byte, tx_byte);
+			post_process_spi_interrupt_routine(rx_byte, tx_byte);
+			if (complete) {
+				_pipelined_frame = false;
+				_buffer_counter = 0;
+			}
+		} else if (_synchronized && (_compact_frame || (_buffer_counter == 0 && _current_command_cursor == 0 &&
+														 rx_byte == COMPACT_FRAME_MARKER))) {
+			_compact_frame = true;
+			const bool complete = process_compact_frame(rx_byte, tx_byte);
+			post_process_spi_interrupt_routine(rx_byte, tx_byte);
+			if (complete) {
+				_compact_frame = false;
+				_buffer_counter = 0;
+			}
+		} else if (_synchronized) {
 			if (process_partial_command(rx_byte, tx_byte) &
 				post_process_spi_interrupt_routine(rx_byte, tx_byte)) {
-				if (!_current_command_data_request) {
-					interpret_data_push_command(_current_command_id, _current_command_value_bytes,
-												_data_push_command_callbacks, _amount_data_push_command_callbacks);
+				if (!_current_command_data_request &&
+					!_data_push_mailbox.stage(_current_command_id, _current_command_value_bytes)) {
+					_synchronized = false;
+				}
+				if (_buffer_counter == 0) {
+					// last command of the frame; the loop takes over
+					_data_push_mailbox.publish();
 				}
 			}
 		} else {
+			_compact_frame = false;
+			_pipelined_frame = false;
+			_data_push_mailbox.discard();
 			synchronize(rx_byte, tx_byte);
 			post_process_spi_interrupt_routine(rx_byte, tx_byte);
 			_buffer_counter = _current_command_cursor;
 		}
 }  // end of interrupt service routine (ISR) SPI_STC_vect
 
+/*
+    Call from the loop: run the callbacks of the latest pipelined frame (if any) and stage its answer
+
+    @return whether there was a new frame
+*/
+bool process_pipelined_frame() {
+	uint8_t sequence = _pipelined_rx_sequence;
+	if (sequence == _pipelined_rx_consumed_sequence) {
+		return false;
+	}
+	uint8_t frame[MAX_PIPELINED_FRAME_SIZE];
+	do {
+		sequence = _pipelined_rx_sequence;
+		COMMAND_MAILBOX_BARRIER();
+		memcpy(frame, _pipelined_rx_buffers[_pipelined_rx_published], MAX_PIPELINED_FRAME_SIZE);
+		COMMAND_MAILBOX_BARRIER();
+	} while ((sequence & 1) != 0 || sequence != _pipelined_rx_sequence);
+	_pipelined_rx_consumed_sequence = sequence;
+
+	const int16_t first_id = frame[2];
+	const uint8_t amount = frame[3];
+	const long frame_size = SpiCommands::getPipelinedFrameSize(first_id, amount);
+	const long crc_index = frame_size - COMPACT_FRAME_CRC_SIZE;
+	if (frame_size < 0 || frame_size > MAX_PIPELINED_FRAME_SIZE ||
+		frame[crc_index] != SpiCommands::computeCrc8(frame, crc_index)) {
+		// no answer; the master notices by the stale answer
+		SERIAL_LOGGER_WARN(F("Discarding pipelined frame %d with bad crc or header"), frame[1]);
+		return false;
+	}
+
+	// stage the answer in the buffer not being sent
+	const uint8_t staging = _pipelined_tx_published == 0 ? 1 : 0;
+	uint8_t *answer = _pipelined_tx_buffers[staging];
+	memcpy(answer, frame, COMPACT_FRAME_HEADER_SIZE);
+	long offset = COMPACT_FRAME_HEADER_SIZE;
+	for (uint8_t i = 0; i < amount; i++) {
+		const int16_t id = (int16_t) (first_id + i);
+		const uint8_t value_size = SpiCommands::getValueSizeFromId(id);
+		uint8_t value_bytes[COMMAND_FRAME_VALUE_SIZE] = {0};
+		if (request_data(id, value_bytes)) {
+			memcpy(answer + offset, value_bytes, value_size);
+		} else {
+			memcpy(value_bytes, frame + offset, value_size);
+			memcpy(answer + offset, value_bytes, value_size);
+			interpret_data_push_command(id, value_bytes);
+		}
+		offset += value_size;
+	}
+	SpiCommands::putPipelinedFrameTrailer(answer, frame_size);
+	_pipelined_tx_published = staging;
+	return true;
+}
+
+bool SpiSlave::processDataPushCommands() {
+	if (process_pipelined_frame()) {
+		return true;
+	}
+	CommandMailbox<MAX_DATA_PUSH_COMMANDS_PER_FRAME>::Snapshot snapshot;
+	if (_data_push_mailbox.consume(snapshot)) {
+		for (uint8_t i = 0; i < snapshot.amount; i++) {
+			interpret_data_push_command(snapshot.commands[i].id, snapshot.commands[i].value_bytes);
+		}
+		return true;
+	}
+	return false;
+}
+
 void SpiSlave::addDebugSlavePrinting(Timer<> &timer, const int interval) {
 	timer.every(interval, [](void *) -> bool {
 		if (SerialLogger::isBelow(SerialLogger::LOG_LEVEL::DEBUG) || !_synchronized) {
@@ -228,9 +493,9 @@ void SpiSlave::addDebugSlavePrinting(Timer<> &timer, const int interval) {
 			}
 			Serial.println();
 			if (_synchronized) {
-				SerialLogger::info(F("Slave is synchronized"));
+				SERIAL_LOGGER_INFO(F("Slave is synchronized"));
 			} else {
-				SerialLogger::info(F("Slave is NOT synchronized"));
+				SERIAL_LOGGER_INFO(F("Slave is NOT synchronized"));
 			}
 		}
 		return true; // to repeat the action - false to stop
@@ -3,13 +3,44 @@
 
 #include <arduino_timer_uno.h>
 
+// data push commands per frame the interrupt routine hands to the loop at most
+#define MAX_DATA_PUSH_COMMANDS_PER_FRAME 4
+// bytes of a pipelined frame at most (the five distance samples take 25)
+#define MAX_PIPELINED_FRAME_SIZE 32
+
 class SpiSlave {
 public:
+	/**
+	 * Register the callback of a data push command (see SpiCommandTable) before calling ISRfromArgs. The callback
+	 * gets the id and the value and returns whether the value is valid.
+	 *
+	 * @return false if the id is unknown or no data push command
+	 */
+	static bool putDataPushCallback(const int16_t id, bool (*callback)(int16_t, int16_t));
+
+	/**
+	 * Register the callback of a data request command (see SpiCommandTable) before calling ISRfromArgs. The callback
+	 * gets the id and the value bytes to fill and returns whether it could answer.
+	 *
+	 * @return false if the id is unknown or no data request command
+	 */
+	static bool putDataRequestCallback(const int16_t id, bool (*callback)(int16_t, uint8_t *));
+
 	static void ISRfromArgs(const int sck_pin, const int miso_pin, const int mosi_pin, const int ss_pin,
-							bool (*data_push_command_callbacks[])(int16_t, int16_t),
-							const int amount_data_push_command_callbacks,
-							bool (*data_request_command_callbacks[])(int16_t, uint8_t *),
-							const int amount_data_request_command_callbacks, const int buffer_length);
+							const int buffer_length);
+
+	/**
+	 * Call the data push callbacks with the commands of the latest complete frame (if not done yet). The interrupt
+	 * routine only stages the commands, thus, call this from the loop. Data request callbacks of legacy and compact
+	 * frames still run in the interrupt routine as their values must be sent right away.
+	 *
+	 * A pipelined frame is handled here as a whole: its data push and data request callbacks run and its answer is
+	 * staged for the interrupt routine to send during the next frame. Thus, call this from the loop of slaves with
+	 * data requests only, too.
+	 *
+	 * @return whether there was a new frame
+	 */
+	static bool processDataPushCommands();
 
 	static void addDebugSlavePrinting(Timer<> &timer, const int interval);
 
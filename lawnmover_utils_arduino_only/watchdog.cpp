@@ -3,7 +3,8 @@
 Watchdog *Watchdog::getFromScheduled(const int validation_interval, const int valid_threshold,
 									 void (*safety_backup_routine)(void), Timer<> &timer) {
 	Watchdog *watchdog = new Watchdog(validation_interval, valid_threshold, safety_backup_routine);
-	timer.every(watchdog->getValidationInterval(), [](Watchdog *watchdog) -> bool {
+	timer.every(watchdog->getValidationInterval(), [](void *opaque) -> bool {
+		Watchdog *watchdog = static_cast<Watchdog *>(opaque);
 		if (!watchdog->validate()) {
 			watchdog->execSafetyProcedure();
 		}